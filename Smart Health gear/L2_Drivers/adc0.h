@@ -20,6 +20,7 @@
  * @file
  * @ingroup Drivers
  *
+ * 20261017 : Added burst mode reading of many conversions of one channel
  * 20131202 : Enclosed adc conversion inside critical section
  * 20131101 : Fix possible divide by zero.  i was set to 0 during loop init
  */
@@ -44,6 +45,14 @@ void adc0_init(void);
  */
 uint16_t adc0_get_reading(uint8_t channel_num);
 
+/**
+ * Runs count back-to-back conversions of one channel in burst mode
+ * @returns the sum of the 12-bit readings (count * 4095 at most), 0 for an invalid channel
+ * @note The CPU waits on the conversions without interrupts, about 11 us each at 6 Mhz ADC clock.
+ *       The ADC is locked for the whole burst just like adc0_get_reading().
+ */
+uint32_t adc0_get_burst_sum(uint8_t channel_num, uint16_t count);
+
 
 
 #ifdef __cplusplus
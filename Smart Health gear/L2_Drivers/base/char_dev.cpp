@@ -21,6 +21,7 @@
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "FreeRTOS.h"
 #include "task.h"
@@ -36,13 +37,20 @@ bool CharDev::put(const char* pString, unsigned int timeout)
         return false;
     }
 
-    while(*pString) {
-        if(!putChar(*pString++, timeout)) {
-            return false;
-        }
+    const uint32_t len = strlen(pString);
+    return (len == write(pString, len, timeout));
+}
+
+uint32_t CharDev::write(const void *pData, uint32_t n, unsigned int timeout)
+{
+    const char *pChars = (const char*) pData;
+    uint32_t sent = 0;
+
+    while (sent < n && putChar(pChars[sent], timeout)) {
+        sent++;
     }
 
-    return true;
+    return sent;
 }
 
 void CharDev::putline(const char* pBuff, unsigned int timeout)
@@ -66,6 +66,13 @@ class CharDev
          */
         virtual bool flush(void) { return true; }
 
+        /**
+         * Outputs n bytes, put() and printf() go through this.  The default sends one
+         * char at a time through putChar(), drivers with a buffer copy the whole span.
+         * @returns the number of bytes written, less than n upon timeout
+         */
+        virtual uint32_t write(const void *pData, uint32_t n, unsigned int timeout=portMAX_DELAY);
+
         /**
          * @{ Output a null-terminated string
          * puts() will also output newline chars "\r\n" at the end of the string
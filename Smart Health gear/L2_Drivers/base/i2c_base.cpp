@@ -40,14 +40,67 @@
 
 void I2C_Base::handleInterrupt()
 {
-    /* If transfer finished (not busy), then give the signal */
+    /* If transfer finished (not busy), start the next one and then give the signal */
     if (busy != i2cStateMachine()) {
         long higherPriorityTaskWaiting = 0;
-        xSemaphoreGiveFromISR(mTransferCompleteSignal, &higherPriorityTaskWaiting);
+        finishCurrent(&higherPriorityTaskWaiting);
         portEND_SWITCHING_ISR(higherPriorityTaskWaiting);
     }
 }
 
+bool I2C_Base::submit(Transaction *pTrx)
+{
+    if (mDisableOperation || !pTrx) {
+        return false;
+    }
+
+    /* An empty segment would stop after the address, like checkDeviceResponse() */
+    for (uint32_t i = 0; i < pTrx->segmentCount; i++) {
+        if (0 == pTrx->pSegments[i].length || 0 == pTrx->pSegments[i].pData) {
+            return false;
+        }
+    }
+
+    pTrx->error = 0;
+    pTrx->done = false;
+    pTrx->pNext = 0;
+
+    /* Masking the interrupt (instead of a critical section) also works from an ISR */
+    const UBaseType_t savedMask = portSET_INTERRUPT_MASK_FROM_ISR();
+    {
+        ++mTransferCount;
+        if (mpQueueTail) {
+            mpQueueTail->pNext = pTrx;
+        }
+        else {
+            mpQueueHead = pTrx;
+        }
+        mpQueueTail = pTrx;
+
+        if (++mQueueDepth > mMaxQueueDepth) {
+            mMaxQueueDepth = mQueueDepth;
+        }
+        if (0 == mpCurrent) {
+            startNext();
+        }
+    }
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(savedMask);
+
+    return true;
+}
+
+void I2C_Base::resetStats(void)
+{
+    const UBaseType_t savedMask = portSET_INTERRUPT_MASK_FROM_ISR();
+    {
+        mStatsDevices = 0;
+        mBusyUs = 0;
+        mMaxQueueDepth = mQueueDepth;
+        mStatsStartUs = sys_get_uptime_us();
+    }
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(savedMask);
+}
+
 void I2C_Base:: initSlave()
 {
 
@@ -122,42 +175,141 @@ bool I2C_Base::writeRegisters(uint8_t deviceAddress, uint8_t firstReg, uint8_t*
 bool I2C_Base::transfer(uint8_t deviceAddress, uint8_t firstReg, uint8_t* pData, uint32_t transferSize)
 {
     bool status = false;
+    Transaction trx;
+
     if(mDisableOperation || !pData) {
         return status;
     }
+    trx.set(deviceAddress, firstReg, pData, transferSize);
+
+    // The data was read into pData once this returns true
+    status = submitAndWait(&trx);
+
+    return status;
+}
+
+bool I2C_Base::transferBatch(uint8_t deviceAddress, const Segment *pSegments, uint32_t count)
+{
+    bool status = false;
+    Transaction trx;
+
+    if (mDisableOperation || !pSegments || 0 == count || count > kMaxBatchSegments) {
+        return status;
+    }
+    trx.setBatch(deviceAddress, pSegments, count);
+
+    /* Same as transfer(), the batch is one transaction of the queue */
+    status = submitAndWait(&trx);
+
+    return status;
+}
+
+bool I2C_Base::submitAndWait(Transaction *pTrx)
+{
+    bool status = false;
 
     // If scheduler not running, perform polling transaction
-    if(taskSCHEDULER_RUNNING != xTaskGetSchedulerState())
+    if (taskSCHEDULER_RUNNING != xTaskGetSchedulerState())
     {
-        i2cKickOffTransfer(deviceAddress, firstReg, pData, transferSize);
+        if (!submit(pTrx)) {
+            return status;
+        }
 
         // Wait for transfer to finish
         const uint64_t timeout = sys_get_uptime_ms() + I2C_TIMEOUT_MS;
-        while (!xSemaphoreTake(mTransferCompleteSignal, 0)) {
+        while (!pTrx->done) {
             if (sys_get_uptime_ms() > timeout) {
+                cancel(pTrx);
                 break;
             }
         }
 
-        status = (0 == mTransaction.error);
+        return (pTrx->done && 0 == pTrx->error);
     }
-    else if (xSemaphoreTake(mI2CMutex, OS_MS(I2C_TIMEOUT_MS)))
-    {
-        // Clear potential stale signal and start the transfer
-        xSemaphoreTake(mTransferCompleteSignal, 0);
-        i2cKickOffTransfer(deviceAddress, firstReg, pData, transferSize);
 
-        // Wait for transfer to finish and copy the data if it was read mode
-        if (xSemaphoreTake(mTransferCompleteSignal, OS_MS(I2C_TIMEOUT_MS))) {
-            status = (0 == mTransaction.error);
-        }
+    /* Each waiting call has a signal of its own and nothing is held during the wait,
+     * so a slow transaction only delays the ones queued behind it on the bus.
+     */
+    if (!xSemaphoreTake(mFreeWaitSignals, OS_MS(I2C_TIMEOUT_MS))) {
+        return status;
+    }
+    uint32_t slot = 0;
+    taskENTER_CRITICAL();
+    while (mWaitSignalsInUse & (1 << slot)) {
+        ++slot;
+    }
+    mWaitSignalsInUse |= (1 << slot);
+    taskEXIT_CRITICAL();
 
-        xSemaphoreGive(mI2CMutex);
+    pTrx->signal = mWaitSignals[slot];
+    if (submit(pTrx)) {
+        if (xSemaphoreTake(pTrx->signal, OS_MS(I2C_TIMEOUT_MS))) {
+            status = (0 == pTrx->error);
+        }
+        else {
+            cancel(pTrx);
+            // The interrupt may have given the signal just before the cancel
+            xSemaphoreTake(pTrx->signal, 0);
+        }
     }
 
+    taskENTER_CRITICAL();
+    mWaitSignalsInUse &= ~(1 << slot);
+    taskEXIT_CRITICAL();
+    xSemaphoreGive(mFreeWaitSignals);
+
     return status;
 }
 
+bool I2C_Base::setDeviceSpeed(uint8_t deviceAddress, uint32_t speedInKhz)
+{
+    const uint8_t addr = I2C_WRITE_ADDR(deviceAddress);
+    uint32_t i = 0;
+
+    if (0 == mPclk) {
+        return false;
+    }
+    for (i = 0; i < mSpeedProfiles && mSpeedProfile[i].address != addr; i++) {
+        ;
+    }
+    if (i == kMaxSpeedProfiles) {
+        return false;
+    }
+
+    uint16_t sclh = 0;
+    uint16_t scll = 0;
+    getClockDividers(speedInKhz, &sclh, &scll);
+
+    /* The interrupt reads the table before every START */
+    const UBaseType_t savedMask = portSET_INTERRUPT_MASK_FROM_ISR();
+    {
+        mSpeedProfile[i].address = addr;
+        mSpeedProfile[i].sclh = sclh;
+        mSpeedProfile[i].scll = scll;
+        if (i == mSpeedProfiles) {
+            ++mSpeedProfiles;
+        }
+    }
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(savedMask);
+
+    return true;
+}
+
+uint32_t I2C_Base::getDeviceSpeed(uint8_t deviceAddress) const
+{
+    const uint8_t addr = I2C_WRITE_ADDR(deviceAddress);
+    uint32_t dividers = mBusSclh + mBusScll;
+
+    for (uint32_t i = 0; i < mSpeedProfiles; i++) {
+        if (mSpeedProfile[i].address == addr) {
+            dividers = mSpeedProfile[i].sclh + mSpeedProfile[i].scll;
+            break;
+        }
+    }
+
+    return dividers ? (mPclk / dividers / 1000) : 0;
+}
+
 bool I2C_Base::checkDeviceResponse(uint8_t deviceAddress)
 {
     uint8_t dummyReg = 0;
@@ -171,13 +323,30 @@ bool I2C_Base::checkDeviceResponse(uint8_t deviceAddress)
 
 I2C_Base::I2C_Base(LPC_I2C_TypeDef* pI2CBaseAddr) :
         mpI2CRegs(pI2CBaseAddr),
-        mDisableOperation(false)
+        mDisableOperation(false),
+        mTransferCount(0),
+        mpCurrent(0),
+        mpQueueHead(0),
+        mpQueueTail(0),
+        mQueueDepth(0),
+        mMaxQueueDepth(0),
+        mCurrentStartUs(0),
+        mBusyUs(0),
+        mStatsStartUs(0),
+        mStatsDevices(0),
+        mPclk(0),
+        mBusSclh(0),
+        mBusScll(0),
+        mSpeedProfiles(0)
 {
-    mI2CMutex = xSemaphoreCreateMutex();
-    mTransferCompleteSignal = xSemaphoreCreateBinary();
+    mFreeWaitSignals = xSemaphoreCreateCounting(I2C_MAX_WAITERS, I2C_MAX_WAITERS);
+    mWaitSignalsInUse = 0;
+    for (uint32_t i = 0; i < I2C_MAX_WAITERS; i++) {
+        mWaitSignals[i] = xSemaphoreCreateBinary();
 
-    /// Binary semaphore needs to be taken after creating it
-    xSemaphoreTake(mTransferCompleteSignal, 0);
+        /// Binary semaphore needs to be taken after creating it
+        xSemaphoreTake(mWaitSignals[i], 0);
+    }
 
     if((unsigned int)mpI2CRegs == LPC_I2C0_BASE)
     {
@@ -210,24 +379,13 @@ bool I2C_Base::init(uint32_t pclk, uint32_t busRateInKhz)
 
     mpI2CRegs->I2CONCLR = 0x6C;           // Clear ALL I2C Flags
 
-    /**
-     * Per I2C high speed mode:
-     * HS mode master devices generate a serial clock signal with a HIGH to LOW ratio of 1 to 2.
-     * So to be able to optimize speed, we use different duty cycle for high/low
-     *
-     * Compute the I2C clock dividers.
-     * The LOW period can be longer than the HIGH period because the rise time
-     * of SDA/SCL is an RC curve, whereas the fall time is a sharper curve.
-     */
-    const uint32_t percent_high = 40;
-    const uint32_t percent_low = (100 - percent_high);
-    const uint32_t freq_hz = (busRateInKhz > 1000) ? (100 * 1000) : (busRateInKhz * 1000);
- //   const uint32_t half_clock_divider = (pclk / freq_hz) /2;
-    const uint32_t half_clock_divider = (pclk / freq_hz);
-    u0_dbg_printf("%x freq:", freq_hz);
+    // Compute the I2C clock dividers, setDeviceSpeed() uses the same computation
+    mPclk = pclk;
+    getClockDividers(busRateInKhz, &mBusSclh, &mBusScll);
+    u0_dbg_printf("%x freq:", busRateInKhz * 1000);
     u0_dbg_printf("\n %x pclk:", pclk);
-    mpI2CRegs->I2SCLH = (half_clock_divider * percent_high) / 100;
-    mpI2CRegs->I2SCLL = (half_clock_divider * percent_low ) / 100;
+    mpI2CRegs->I2SCLH = mBusSclh;
+    mpI2CRegs->I2SCLL = mBusScll;
 
     u0_dbg_printf("\n %x sclh:", mpI2CRegs->I2SCLH);
     u0_dbg_printf("\n %x scll:", mpI2CRegs->I2SCLL);
@@ -256,11 +414,199 @@ void I2C_Base::i2cKickOffTransfer(uint8_t devAddr, uint8_t regStart, uint8_t* pB
     mTransaction.firstReg  = regStart;
     mTransaction.trxSize   = len;
     mTransaction.pMasterData   = pBytes;
+    mTransaction.regSent   = false;
 
     // Send START, I2C State Machine will finish the rest.
     mpI2CRegs->I2CONSET = 0x20;
 }
 
+void I2C_Base::startNext(void)
+{
+    Transaction *pTrx = mpQueueHead;
+    if (0 == pTrx) {
+        return;
+    }
+
+    mpQueueHead = pTrx->pNext;
+    if (0 == mpQueueHead) {
+        mpQueueTail = 0;
+    }
+    --mQueueDepth;
+
+    mpCurrent = pTrx;
+    mCurrentStartUs = sys_get_uptime_us();
+    applyDeviceSpeed(pTrx->deviceAddress);
+
+    if (pTrx->segmentCount > 0)
+    {
+        /* The first segment starts like a single transfer, the state machine runs the others */
+        const Segment *pSeg = pTrx->pSegments;
+        uint8_t addr = pTrx->deviceAddress;
+        if (pSeg->read) {
+            I2C_SET_READ_MODE(addr);
+        }
+        else {
+            I2C_SET_WRITE_MODE(addr);
+        }
+        mTransaction.segmentsLeft = pTrx->segmentCount - 1;
+        mTransaction.pNextSegment = pSeg + 1;
+        i2cKickOffTransfer(addr, pSeg->firstReg, pSeg->pData, pSeg->length);
+    }
+    else
+    {
+        mTransaction.segmentsLeft = 0;
+        mTransaction.pNextSegment = 0;
+        i2cKickOffTransfer(pTrx->deviceAddress, pTrx->firstReg, pTrx->pData, pTrx->length);
+    }
+}
+
+void I2C_Base::loadNextSegment(void)
+{
+    const Segment *pSeg = mTransaction.pNextSegment;
+
+    if (pSeg->read) {
+        I2C_SET_READ_MODE(mTransaction.slaveAddr);
+    }
+    else {
+        I2C_SET_WRITE_MODE(mTransaction.slaveAddr);
+    }
+    mTransaction.firstReg    = pSeg->firstReg;
+    mTransaction.trxSize     = pSeg->length;
+    mTransaction.pMasterData = pSeg->pData;
+    mTransaction.regSent     = false;
+
+    --mTransaction.segmentsLeft;
+    ++mTransaction.pNextSegment;
+}
+
+void I2C_Base::getClockDividers(uint32_t busRateInKhz, uint16_t *pSclh, uint16_t *pScll) const
+{
+    /**
+     * Per I2C high speed mode:
+     * HS mode master devices generate a serial clock signal with a HIGH to LOW ratio of 1 to 2.
+     * So to be able to optimize speed, we use different duty cycle for high/low
+     *
+     * The LOW period can be longer than the HIGH period because the rise time
+     * of SDA/SCL is an RC curve, whereas the fall time is a sharper curve.
+     */
+    const uint32_t percent_high = 40;
+    const uint32_t percent_low = (100 - percent_high);
+    const uint32_t freq_hz = (busRateInKhz > 1000 || 0 == busRateInKhz) ? (100 * 1000) : (busRateInKhz * 1000);
+    const uint32_t half_clock_divider = (mPclk / freq_hz);
+
+    *pSclh = (half_clock_divider * percent_high) / 100;
+    *pScll = (half_clock_divider * percent_low ) / 100;
+}
+
+void I2C_Base::applyDeviceSpeed(uint8_t deviceAddress)
+{
+    const uint8_t addr = I2C_WRITE_ADDR(deviceAddress);
+    uint16_t sclh = mBusSclh;
+    uint16_t scll = mBusScll;
+
+    for (uint32_t i = 0; i < mSpeedProfiles; i++) {
+        if (mSpeedProfile[i].address == addr) {
+            sclh = mSpeedProfile[i].sclh;
+            scll = mSpeedProfile[i].scll;
+            break;
+        }
+    }
+
+    if (mpI2CRegs->I2SCLH != sclh || mpI2CRegs->I2SCLL != scll) {
+        mpI2CRegs->I2SCLH = sclh;
+        mpI2CRegs->I2SCLL = scll;
+    }
+}
+
+void I2C_Base::finishCurrent(long *pHigherPriorityTaskWaiting)
+{
+    Transaction *pTrx = mpCurrent;
+    if (0 == pTrx) {
+        return;
+    }
+
+    const uint32_t busyUs = (uint32_t) sys_get_uptime_us() - mCurrentStartUs;
+    pTrx->error = mTransaction.error;
+    addStats(pTrx->deviceAddress, busyUs, 0 != pTrx->error);
+
+    /* Keep the bus going before telling anyone, the STOP is already sent */
+    mpCurrent = 0;
+    startNext();
+
+    pTrx->done = true;
+    if (pTrx->callback) {
+        pTrx->callback(pTrx);
+    }
+    if (pTrx->signal) {
+        xSemaphoreGiveFromISR(pTrx->signal, pHigherPriorityTaskWaiting);
+    }
+}
+
+void I2C_Base::cancel(Transaction *pTrx)
+{
+    const UBaseType_t savedMask = portSET_INTERRUPT_MASK_FROM_ISR();
+    if (pTrx == mpCurrent)
+    {
+        /* The bus is stuck with this transaction : STOP and go on with the next one */
+        mpI2CRegs->I2CONSET = 0x10;
+        mpI2CRegs->I2CONCLR = 0x28;
+        addStats(pTrx->deviceAddress, (uint32_t) sys_get_uptime_us() - mCurrentStartUs, true);
+        mpCurrent = 0;
+        startNext();
+    }
+    else
+    {
+        /* Still queued, or already done */
+        Transaction *pPrev = 0;
+        for (Transaction *p = mpQueueHead; 0 != p; pPrev = p, p = p->pNext) {
+            if (p != pTrx) {
+                continue;
+            }
+            if (pPrev) {
+                pPrev->pNext = p->pNext;
+            }
+            else {
+                mpQueueHead = p->pNext;
+            }
+            if (mpQueueTail == p) {
+                mpQueueTail = pPrev;
+            }
+            --mQueueDepth;
+            break;
+        }
+    }
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(savedMask);
+}
+
+void I2C_Base::addStats(uint8_t deviceAddress, uint32_t busyUs, bool failed)
+{
+    const uint8_t addr = I2C_WRITE_ADDR(deviceAddress);
+    uint32_t i = 0;
+
+    mBusyUs += busyUs;
+    for (i = 0; i < mStatsDevices && mDeviceStats[i].address != addr; i++) {
+        ;
+    }
+    if (i == mStatsDevices)
+    {
+        /* New device, counted with the last device once the table is full */
+        if (mStatsDevices < kMaxStatsDevices) {
+            ++mStatsDevices;
+            mDeviceStats[i].address = addr;
+            mDeviceStats[i].transfers = 0;
+            mDeviceStats[i].errors = 0;
+            mDeviceStats[i].busyUs = 0;
+        }
+        else {
+            i = kMaxStatsDevices - 1;
+        }
+    }
+
+    ++mDeviceStats[i].transfers;
+    mDeviceStats[i].errors += failed ? 1 : 0;
+    mDeviceStats[i].busyUs += busyUs;
+}
+
 /*
  * I2CONSET bits
  * 0x04 AA
@@ -308,6 +654,9 @@ I2C_Base::mStateMachineStatus_t I2C_Base::i2cStateMachine()
      * start --> slaveAddressAcked --> dataAcked --> repeatStart --> readAckedBySlave
      *  For 2+ bytes:  dataAvailableAckSent --> ... (dataAvailableAckSent) --> dataAvailableNackSent --> (stop)
      *  For 1  byte :  dataAvailableNackSent --> (stop)
+     *
+     * Batch : instead of the (stop) of a segment, a repeat start begins the next segment.
+     *  repeatStart --> slaveAddressAcked --> ... with the write address since the register is not sent yet.
      ***********************************************************************************************************
      */
 
@@ -327,6 +676,16 @@ I2C_Base::mStateMachineStatus_t I2C_Base::i2cStateMachine()
                                     state = readComplete;                   \
                                 else                                        \
                                     state = writeComplete;
+
+    /* End of a segment : repeat start into the next segment of a batch, or stop */
+    #define setEnd()            if (mTransaction.segmentsLeft > 0) {        \
+                                    loadNextSegment();                      \
+                                    setSTARTFlag();                         \
+                                    clearSIFlag();                          \
+                                }                                           \
+                                else {                                      \
+                                    setStop();                              \
+                                }
   //  u0_dbg_printf("%x state\n",mpI2CRegs->I2STAT);
   //  u0_dbg_printf("%x data\n",mpI2CRegs->I2DAT);
     if(mpI2CRegs->I2STAT == 0x50)
@@ -353,7 +712,13 @@ I2C_Base::mStateMachineStatus_t I2C_Base::i2cStateMachine()
            // u0_dbg_printf("started: \n");
             break;
         case repeatStart:
-            mpI2CRegs->I2DAT = I2C_READ_ADDR(mTransaction.slaveAddr);
+            // Read after the register is sent, otherwise the next segment of a batch begins
+            if (mTransaction.regSent) {
+                mpI2CRegs->I2DAT = I2C_READ_ADDR(mTransaction.slaveAddr);
+            }
+            else {
+                mpI2CRegs->I2DAT = I2C_WRITE_ADDR(mTransaction.slaveAddr);
+            }
             clearSIFlag();
             break;
 
@@ -366,6 +731,7 @@ I2C_Base::mStateMachineStatus_t I2C_Base::i2cStateMachine()
             }
             else {
                 mpI2CRegs->I2DAT = mTransaction.firstReg;
+                mTransaction.regSent = true;
                 clearSIFlag();
             }
             break;
@@ -378,7 +744,7 @@ I2C_Base::mStateMachineStatus_t I2C_Base::i2cStateMachine()
             }
             else {
                 if(0 == mTransaction.trxSize) {
-                    setStop();
+                    setEnd();
                   //  u0_dbg_printf("entered stop \n");
                 }
                 else {
@@ -423,7 +789,7 @@ I2C_Base::mStateMachineStatus_t I2C_Base::i2cStateMachine()
         case dataAvailableNackSent: // Read last-byte from Slave
         	// mtempLSB = mpI2CRegs->I2DAT;
             *mTransaction.pMasterData = mpI2CRegs->I2DAT;
-            setStop();
+            setEnd();
             break;
 
         case arbitrationLost:
@@ -20,6 +20,10 @@
  * @file  i2c_base.hpp
  * @brief Provides I2C Base class functionality for I2C peripherals
  *
+ * 20261017 : transfer() waits on a completion signal of its own instead of holding a mutex.
+ * 20261017 : Batches of segments on one device with repeated starts, and per-device SCL rate.
+ * 20261017 : Queued transactions : submit() returns right away and the interrupt
+ *            chains the next transaction, with per-device and bus usage statistics.
  * 20140212 : Improved the driver by not having internal memory to copy the
  *            transaction's data.  The buffer supplied from the user is used directly.
  * 20131211 : Used timeout for read/write semaphore (instead of portMAX_DELAY)
@@ -35,16 +39,23 @@
 #include "task.h"       // xTaskGetSchedulerState()
 #include "semphr.h"     // Semaphores used in I2C
 #include "LPC17xx.h"
+#include "lpc_sys.h"    // sys_get_uptime_us()
 
 
 
 /**
  * Define the maximum timeout for r/w operation (in case error occurs)
  * This is the timeout for read transaction to finish and if FreeRTOS is running,
- * then this is the timeout for the mutex to be obtained.
+ * then this is also the timeout to get a completion signal (see I2C_MAX_WAITERS).
  */
 #define I2C_TIMEOUT_MS          1000
 
+/**
+ * transfer() calls that can wait at the same time, each on a completion signal of its
+ * own.  One more caller waits for a signal to be free, not for the other transfers.
+ */
+#define I2C_MAX_WAITERS         4
+
 
 /**
  * I2C Base class that can be used to write drivers for all I2C peripherals.
@@ -63,11 +74,113 @@
  *      }
  *   }
  *  @endcode
+ *
+ *  Every transaction goes through a queue of the bus.  submit() adds a Transaction
+ *  and returns, the interrupt starts the next queued transaction as soon as the
+ *  previous one ends, and reports the end through a callback and/or a semaphore.
+ *  readRegisters() and writeRegisters() submit a transaction and wait for it on
+ *  a signal of their own, so tasks only wait on each other through the queue.
+ *
+ *  @code
+ *      static uint8_t xyz[6];
+ *      static I2C_Base::Transaction trx;
+ *      trx.set(0x38 | 1, 0x01, xyz, sizeof(xyz));   // odd address : read
+ *      trx.signal = mySemaphore;
+ *      I2C2::getInstance().submit(&trx);
+ *      // ... other work, then take mySemaphore and check trx.error
+ *  @endcode
  * @ingroup Drivers
  */
 class I2C_Base
 {
     public:
+        struct Transaction;
+
+        /// One read or write of a batch, see transferBatch()
+        typedef struct {
+            uint8_t firstReg;   ///< The first register to read or write
+            bool read;          ///< true to read into pData, false to write pData
+            uint8_t *pData;     ///< The bytes to write, or the buffer of the bytes read
+            uint32_t length;    ///< The number of bytes, at least 1
+        } Segment;
+
+        /**
+         * Called from the I2C interrupt at the end of a submitted transaction, the
+         * next transaction is already started.  It can submit() another transaction.
+         */
+        typedef void (*DoneFunc)(Transaction *pTrx);
+
+        /// One queued I2C transaction, it must stay valid until it is done
+        struct Transaction
+        {
+            uint8_t deviceAddress;      ///< The device address, odd to read and even to write
+            uint8_t firstReg;           ///< The first register to read or write
+            uint8_t *pData;             ///< The bytes to write, or the buffer of the bytes read
+            uint32_t length;            ///< The number of bytes, 0 to only check the device response
+            DoneFunc callback;          ///< Called from the interrupt at the end, can be NULL
+            SemaphoreHandle_t signal;   ///< Given from the interrupt at the end, can be NULL
+            void *pArg;                 ///< Free for the submitter
+            volatile uint8_t error;     ///< I2C status upon error, 0 upon success
+            volatile bool done;         ///< Set at the end, before the callback and the signal
+            const Segment *pSegments;   ///< If not NULL, the segments run instead of firstReg/pData/length
+            uint32_t segmentCount;      ///< Number of pSegments
+            Transaction *pNext;         ///< Used by the queue
+
+            /// Sets the transfer and clears the callback, the signal and the status
+            inline void set(uint8_t addr, uint8_t reg, uint8_t *pBytes, uint32_t len)
+            {
+                deviceAddress = addr;
+                firstReg = reg;
+                pData = pBytes;
+                length = len;
+                callback = 0;
+                signal = 0;
+                error = 0;
+                done = false;
+                pSegments = 0;
+                segmentCount = 0;
+                pNext = 0;
+            }
+
+            /// Sets a batch of segments on one device, the address mode comes from each segment
+            inline void setBatch(uint8_t addr, const Segment *pSegs, uint32_t count)
+            {
+                set(addr, 0, 0, 0);
+                pSegments = pSegs;
+                segmentCount = count;
+            }
+        };
+
+        /// Transactions and bus time of one device address, see getDeviceStats()
+        typedef struct {
+            uint8_t address;    ///< The device address (write address)
+            uint32_t transfers; ///< Transactions that ended
+            uint32_t errors;    ///< Transactions that failed or timed out
+            uint32_t busyUs;    ///< Time on the bus, from the start to the end of the transactions
+        } DeviceStats;
+
+        /// Devices for which statistics are kept, others are counted in the last entry
+        static const uint32_t kMaxStatsDevices = 8;
+
+        /// Devices that can have their own SCL rate, see setDeviceSpeed()
+        static const uint32_t kMaxSpeedProfiles = 4;
+
+        /**
+         * Queues a transaction, it starts right away if the bus is idle.
+         * @returns false if the I2C is disabled, pTrx is NULL or one of its segments is empty
+         * @note This can be called from an interrupt, such as from a DoneFunc
+         */
+        bool submit(Transaction *pTrx);
+
+        /** @{ Statistics since resetStats(), for the "i2c stats" command */
+        inline uint32_t getStatsDeviceCount(void) const { return mStatsDevices; }
+        inline const DeviceStats& getDeviceStats(uint32_t i) const { return mDeviceStats[i]; }
+        inline uint64_t getBusyUs(void) const { return mBusyUs; }
+        inline uint64_t getStatsUs(void) const { return sys_get_uptime_us() - mStatsStartUs; }
+        inline uint32_t getMaxQueueDepth(void) const { return mMaxQueueDepth; }
+        void resetStats(void);
+        /** @} */
+
         /**
          * When the I2C interrupt occurs, this function should be called to handle
          * future action to take due to the interrupt cause.
@@ -97,6 +210,43 @@ class I2C_Base
         /// @copydoc transfer()
         bool writeRegisters(uint8_t deviceAddress, uint8_t firstReg, uint8_t* pData, uint32_t transferSize);
 
+        /**
+         * Runs several reads and writes on one device as a single transaction : the bus
+         * is taken once, and each segment follows the previous one with a repeated start
+         * instead of a STOP and a new START.  The registers need not be contiguous.
+         *
+         * @code
+         *      uint8_t status = 0, mode = 0x03, leds[] = { 0x24, 0x24 };
+         *      const I2C_Base::Segment init[] = {
+         *          { 0x00, true,  &status, 1 },    // Read and clear the status
+         *          { 0x09, false, &mode,   1 },    // Then write the mode
+         *          { 0x0C, false, leds,    2 },    // And registers 0x0C and 0x0D
+         *      };
+         *      I2C1::getInstance().transferBatch(0xAE, init, 3);
+         * @endcode
+         *
+         * @param deviceAddress  The device address, the read/write bit comes from each segment
+         * @param pSegments      The segments, in the order they go on the bus
+         * @param count          The number of segments, up to kMaxBatchSegments
+         * @returns true if all the segments were successful, the batch stops at the first error
+         */
+        bool transferBatch(uint8_t deviceAddress, const Segment *pSegments, uint32_t count);
+
+        /// Segments of one transferBatch(), a limit to catch a bad count
+        static const uint32_t kMaxBatchSegments = 32;
+
+        /**
+         * Uses another SCL rate for one device, such as 400Khz for a fast-mode device on a
+         * bus that runs at 100Khz for slower devices.  The rate changes between transactions.
+         * @param deviceAddress  The device address (read or write address)
+         * @param speedInKhz     The SCL rate for this device, up to 1000Khz
+         * @returns false before init(), or if kMaxSpeedProfiles devices already have a rate
+         */
+        bool setDeviceSpeed(uint8_t deviceAddress, uint32_t speedInKhz);
+
+        /// @returns the SCL rate used for the device, which is the bus rate unless setDeviceSpeed() is used
+        uint32_t getDeviceSpeed(uint8_t deviceAddress) const;
+
         /**
          * This function can be used to check if an I2C device responds to its address,
          * which can therefore be used to discover all I2C hardware devices.
@@ -107,6 +257,9 @@ class I2C_Base
          * @returns true if I2C device with given address is ready
          */
         bool checkDeviceResponse(uint8_t deviceAddress);
+
+        /// @returns the number of transactions started on this bus (used to measure bus load)
+        inline uint32_t getTransferCount(void) const { return mTransferCount; }
         void initSlave();
 
         void display();
@@ -138,8 +291,34 @@ class I2C_Base
         LPC_I2C_TypeDef* mpI2CRegs;    ///< Pointer to I2C memory map
         IRQn_Type        mIRQ;         ///< IRQ of this I2C
         bool mDisableOperation;        ///< Tracks if I2C is disabled by disableOperation()
-        SemaphoreHandle_t mI2CMutex;   ///< I2C Mutex used when FreeRTOS is running
-        SemaphoreHandle_t mTransferCompleteSignal; ///< Signal that indicates read is complete
+        uint32_t mTransferCount;       ///< Number of transactions submitted
+        SemaphoreHandle_t mWaitSignals[I2C_MAX_WAITERS]; ///< Completion signals of waiting transfer() calls
+        SemaphoreHandle_t mFreeWaitSignals;   ///< Counts the mWaitSignals that are not in use
+        uint32_t mWaitSignalsInUse;           ///< Bit i is set while mWaitSignals[i] is in use
+
+        Transaction *mpCurrent;        ///< Transaction on the bus, NULL when idle
+        Transaction *mpQueueHead;      ///< Next transaction to start
+        Transaction *mpQueueTail;      ///< Last transaction to start
+        uint32_t mQueueDepth;          ///< Transactions in the queue, not counting mpCurrent
+        uint32_t mMaxQueueDepth;       ///< Watermark of mQueueDepth
+        uint32_t mCurrentStartUs;      ///< When mpCurrent was started
+        uint64_t mBusyUs;              ///< Time with a transaction on the bus
+        uint64_t mStatsStartUs;        ///< When the statistics were reset
+        uint32_t mStatsDevices;        ///< Entries used in mDeviceStats
+        DeviceStats mDeviceStats[kMaxStatsDevices]; ///< Per-device statistics
+
+        /// SCL dividers of a device that does not use the bus rate
+        typedef struct {
+            uint8_t address;    ///< The device address (write address)
+            uint16_t sclh;      ///< I2SCLH value
+            uint16_t scll;      ///< I2SCLL value
+        } SpeedProfile;
+
+        uint32_t mPclk;                ///< Peripheral clock given to init(), 0 before it
+        uint16_t mBusSclh;             ///< I2SCLH of the bus rate
+        uint16_t mBusScll;             ///< I2SCLL of the bus rate
+        uint32_t mSpeedProfiles;       ///< Entries used in mSpeedProfile
+        SpeedProfile mSpeedProfile[kMaxSpeedProfiles]; ///< Devices with their own rate
 
         /**
          * The status of I2C is returned from the I2C function that handles state machine
@@ -160,6 +339,9 @@ class I2C_Base
             uint8_t firstReg;   ///< 1st Register to Read or Write
             uint8_t error;      ///< Error if any occurred within I2C
             uint8_t *pMasterData;  ///< Buffer of the I2C Read or Write
+            bool regSent;       ///< firstReg is sent, a repeated start is for the read address
+            uint32_t segmentsLeft;          ///< Segments of the batch after this one
+            const Segment *pNextSegment;    ///< Next segment of the batch
         } mI2CTransaction_t;
 
         /// The I2C Input Output frame that contains I2C transaction information
@@ -186,6 +368,9 @@ class I2C_Base
          */
         bool transfer(uint8_t deviceAddress, uint8_t firstReg, uint8_t* pData, uint32_t transferSize);
 
+        /// Submits pTrx and waits for it (polls it before the scheduler runs), cancels it upon timeout
+        bool submitAndWait(Transaction *pTrx);
+
         /**
          * This is the entry point for an I2C transaction
          * @param devAddr   The address of the I2C Device
@@ -195,6 +380,27 @@ class I2C_Base
          */
         void i2cKickOffTransfer(uint8_t devAddr, uint8_t regStart, uint8_t* pBytes, uint32_t len);
 
+        /// Starts the first queued transaction, called with the interrupt masked or from it
+        void startNext(void);
+
+        /// Makes the next segment of the batch the one to run after the repeated start
+        void loadNextSegment(void);
+
+        /// Computes the I2SCLH and I2SCLL values of an SCL rate
+        void getClockDividers(uint32_t busRateInKhz, uint16_t *pSclh, uint16_t *pScll) const;
+
+        /// Sets the SCL rate of the device before its START, the bus is idle at this point
+        void applyDeviceSpeed(uint8_t deviceAddress);
+
+        /// Ends mpCurrent : statistics, then the next transaction, then the callback and signal
+        void finishCurrent(long *pHigherPriorityTaskWaiting);
+
+        /// Takes back a transaction that timed out, stopping the bus if it is on it
+        void cancel(Transaction *pTrx);
+
+        /// Counts a transaction that ended in the statistics of its device
+        void addStats(uint8_t deviceAddress, uint32_t busyUs, bool failed);
+
         uint8_t mtempMSB;
         uint8_t mtempLSB;
 };
@@ -30,49 +30,183 @@
 
 bool UartDev::getChar(char* pInputChar, unsigned int timeout)
 {
-    if (!pInputChar || !mRxQueue) {
+    if (!pInputChar) {
         return false;
     }
-    else if (taskSCHEDULER_RUNNING == xTaskGetSchedulerState()) {
-        return xQueueReceive(mRxQueue, pInputChar, timeout);
+
+    return (1 == read(pInputChar, 1, timeout));
+}
+
+bool UartDev::putChar(char out, unsigned int timeout)
+{
+    return (1 == write(&out, 1, timeout));
+}
+
+uint32_t UartDev::write(const void *pData, uint32_t n, unsigned int timeout)
+{
+    const uint8_t *pBytes = (const uint8_t*) pData;
+    uint32_t sent = 0;
+
+    if (!pBytes) {
+        return 0;
     }
-    else {
+    /* If OS not running, just send data using polling and return */
+    else if (taskSCHEDULER_RUNNING != xTaskGetSchedulerState()) {
+        for (sent = 0; sent < n; sent++) {
+            mpUARTRegBase->THR = pBytes[sent];
+            while(! (mpUARTRegBase->LSR & (1 << 6)));
+        }
+        return sent;
+    }
+    else if (0 == mTxRing.getCapacity()) {
+        return 0;
+    }
+
+    TimeOut_t timeOut;
+    TickType_t ticksLeft = timeout;
+    vTaskSetTimeOutState(&timeOut);
+
+    while (true)
+    {
+        /* Copy what fits, and if the transmitter is not busy, send out the oldest chars.
+         * The transmitter empty interrupt empties out the ring thereafter.
+         */
+        taskENTER_CRITICAL();
+        sent += mTxRing.write(pBytes + sent, n - sent);
+        if (isTxDma()) {
+            startTxDma();
+        }
+        else {
+            fillTxFifo();
+        }
+        taskEXIT_CRITICAL();
+
+        if (sent == n) {
+            break;
+        }
+
+        /* Ring is full : sleep until there is room for the rest, or for half the ring */
+        const uint32_t half = mTxRing.getCapacity() / 2;
+        mTxWakeLevel = (n - sent < half) ? n - sent : half;
+        if (mTxRing.getFree() >= mTxWakeLevel) {
+            mTxWakeLevel = 0;
+            continue;
+        }
+        if (xTaskCheckForTimeOut(&timeOut, &ticksLeft) || !xSemaphoreTake(mTxSignal, ticksLeft)) {
+            mTxWakeLevel = 0;
+            break;
+        }
+    }
+
+    return sent;
+}
+
+uint32_t UartDev::read(void *pData, uint32_t n, unsigned int timeout)
+{
+    uint32_t got = 0;
+
+    if (!pData || 0 == n || 0 == mRxRing.getCapacity()) {
+        return 0;
+    }
+    else if (taskSCHEDULER_RUNNING != xTaskGetSchedulerState()) {
         unsigned int timeout_of_char = sys_get_uptime_ms() + timeout;
-        while (! xQueueReceive(mRxQueue, pInputChar, 0)) {
+        while (0 == (got = readRing(pData, n))) {
             if (sys_get_uptime_ms() > timeout_of_char) {
-                return false;
+                break;
             }
         }
+        return got;
     }
-    return true;
+
+    TimeOut_t timeOut;
+    TickType_t ticksLeft = timeout;
+    vTaskSetTimeOutState(&timeOut);
+
+    while (true)
+    {
+        taskENTER_CRITICAL();
+        got = readRing(pData, n);
+        taskEXIT_CRITICAL();
+
+        if (got > 0) {
+            break;
+        }
+
+        /* The Rx DMA empties the FIFO by itself : sleep on the Rx data interrupt until
+         * the first byte is in, then look at the DMA position every tick until n bytes
+         * are in, or until nothing more came in for a tick (idle line).
+         */
+        if (isRxDma())
+        {
+            taskENTER_CRITICAL();
+            setRxDmaWake(true);
+            syncRxDma();
+            const bool empty = mRxRing.isEmpty();
+            taskEXIT_CRITICAL();
+
+            const bool timedOut = empty && (xTaskCheckForTimeOut(&timeOut, &ticksLeft) ||
+                                            !xSemaphoreTake(mRxSignal, ticksLeft));
+            taskENTER_CRITICAL();
+            setRxDmaWake(false);
+            taskEXIT_CRITICAL();
+            /* The interrupt may have given the signal after the ring was seen not empty */
+            xSemaphoreTake(mRxSignal, 0);
+            if (timedOut) {
+                break;
+            }
+
+            uint32_t count = mRxRing.getCount();
+            uint32_t lastCount = 0;
+            while (count < n && count != lastCount && !xTaskCheckForTimeOut(&timeOut, &ticksLeft)) {
+                vTaskDelay(1);
+                lastCount = count;
+
+                taskENTER_CRITICAL();
+                syncRxDma();
+                taskEXIT_CRITICAL();
+                count = mRxRing.getCount();
+            }
+            continue;
+        }
+
+        /* Nothing yet : sleep until n bytes are in, or the line ends or goes idle.
+         * Data that came in before the wake level was set is picked up right away.
+         */
+        mRxWakeLevel = (n < mRxRing.getCapacity()) ? n : mRxRing.getCapacity();
+        if (!mRxRing.isEmpty()) {
+            mRxWakeLevel = 0;
+            continue;
+        }
+        if (xTaskCheckForTimeOut(&timeOut, &ticksLeft) || !xSemaphoreTake(mRxSignal, ticksLeft)) {
+            mRxWakeLevel = 0;
+            break;
+        }
+    }
+
+    return got;
 }
 
-bool UartDev::putChar(char out, unsigned int timeout)
+bool UartDev::writeAsync(const void *pData, uint32_t n, TxDoneFunc done, void *pArg)
 {
-    /* If OS not running, just send data using polling and return */
-    if (taskSCHEDULER_RUNNING != xTaskGetSchedulerState()) {
-        mpUARTRegBase->THR = out;
-        while(! (mpUARTRegBase->LSR & (1 << 6)));
-        return true;
-    }
+    bool started = false;
 
-    /* FreeRTOS running, so send to queue and if queue is full, return false */
-    if(! xQueueSend(mTxQueue, &out, timeout)) {
+    if (!isTxDma() || !pData || 0 == n || n > GPDMA_MAX_TRANSFERS) {
         return false;
     }
 
-    /* If transmitter is not busy, send out the oldest char from the queue,
-     * and let the transmitter empty interrupt empty out the queue thereafter.
-     */
-    const int uart_tx_is_idle = (1 << 6);
-    if (mpUARTRegBase->LSR & uart_tx_is_idle)
-    {
-        if (xQueueReceive(mTxQueue, &out, 0)) {
-            mpUARTRegBase->THR = out;
-        }
+    /* Only when idle, so that the bytes already in the Tx ring go out first */
+    taskENTER_CRITICAL();
+    if (0 == mTxDmaLen && mTxRing.isEmpty()) {
+        mTxAsync = true;
+        mpTxAsyncDone = done;
+        mpTxAsyncArg = pArg;
+        mTxDmaLen = n;
+        startTxDmaFrom(pData, n);
+        started = true;
     }
+    taskEXIT_CRITICAL();
 
-    return true;
+    return started;
 }
 
 bool UartDev::flush(void)
@@ -108,6 +242,21 @@ void UartDev::setBaudRate(unsigned int baudRate)
     mpUARTRegBase->LCR = 3; // Disable DLAB and set 8bit per char
 }
 
+void UartDev::fillTxFifo(void)
+{
+    const uint32_t txFifoEmpty = (1 << 5);
+    const unsigned char hwTxFifoSize = 16;
+    uint8_t buff[hwTxFifoSize];
+
+    if (mpUARTRegBase->LSR & txFifoEmpty)
+    {
+        const uint32_t n = mTxRing.read(buff, sizeof(buff));
+        for (uint32_t i = 0; i < n; i++) {
+            mpUARTRegBase->THR = buff[i];
+        }
+    }
+}
+
 void UartDev::handleInterrupt()
 {
     /**
@@ -118,12 +267,23 @@ void UartDev::handleInterrupt()
     const uint16_t dataAvailable    = (2 << 1);
     const uint16_t dataTimeout      = (6 << 1);
 
-    long higherPriorityTaskWoken = 0;
     long switchRequired = 0;
-    char c = 0;
-    unsigned charsSent = 0;
 
     uint16_t reasonForInterrupt = (mpUARTRegBase->IIR & 0xE);
+    ++mInterruptCount;
+
+    /* Rx DMA mode : the data interrupt is only enabled while read() waits for its first
+     * byte.  The DMA may have emptied the FIFO already, so the DMA position tells.
+     */
+    if (isRxDma() && 0 != mRxWakeLevel)
+    {
+        syncRxDma(true);
+        if (!mRxRing.isEmpty()) {
+            setRxDmaWake(false);
+            xSemaphoreGiveFromISR(mRxSignal, &switchRequired);
+        }
+    }
+
     {
         /**
          * If multiple sources of interrupt arise, let this interrupt exit, and re-enter
@@ -133,23 +293,21 @@ void UartDev::handleInterrupt()
         {
             case transmitterEmpty:
             {
-                if(uxQueueMessagesWaitingFromISR(mTxQueue) > mTxQWatermark) {
-                    mTxQWatermark = uxQueueMessagesWaitingFromISR(mTxQueue);
+                const uint32_t pending = mTxRing.getCount();
+                if(pending > mTxQWatermark) {
+                    mTxQWatermark = pending;
                 }
 
                 /**
                  * When THRE (Transmit Holding Register Empty) interrupt occurs,
                  * we can send as many bytes as the hardware FIFO supports (16)
                  */
-                const unsigned char hwTxFifoSize = 16;
-                for(charsSent=0;
-                        charsSent < hwTxFifoSize && xQueueReceiveFromISR(mTxQueue, &c, &higherPriorityTaskWoken);
-                        charsSent++)
-                {
-                    mpUARTRegBase->THR = c;
-                    if(higherPriorityTaskWoken) {
-                        switchRequired = 1;
-                    }
+                fillTxFifo();
+
+                const uint32_t level = mTxWakeLevel;
+                if(0 != level && mTxRing.getFree() >= level) {
+                    mTxWakeLevel = 0;
+                    xSemaphoreGiveFromISR(mTxSignal, &switchRequired);
                 }
             }
             break;
@@ -157,23 +315,44 @@ void UartDev::handleInterrupt()
             case dataAvailable:
             case dataTimeout:
             {
+                /* The Rx DMA reads RBR, handled above */
+                if (isRxDma()) {
+                    break;
+                }
                 mLastActivityTime = xTaskGetTickCountFromISR();
+
+                /* An idle line (char timeout) ends the data just like a newline */
+                bool endOfData = (dataTimeout == reasonForInterrupt);
+                const unsigned char hwRxFifoSize = 16;
+                uint8_t buff[hwRxFifoSize];
+                uint32_t n = 0;
+
                 /**
-                 * While receive Hardware FIFO not empty, keep queuing the data.
-                 * Even if xQueueSendFromISR() Fails (Queue is full), we still need to
-                 * read RBR register otherwise interrupt will not clear
+                 * While receive Hardware FIFO not empty, keep copying the data.
+                 * Even if the ring is full, we still need to read RBR register
+                 * otherwise interrupt will not clear
                  */
                 while (0 != (mpUARTRegBase->LSR & (1 << 0)))
                 {
-                    c = mpUARTRegBase->RBR;
-                    xQueueSendFromISR(mRxQueue, &c, &higherPriorityTaskWoken);
-                    if(higherPriorityTaskWoken) {
-                        switchRequired = 1;
+                    const uint8_t c = mpUARTRegBase->RBR;
+                    endOfData |= ('\n' == c || '\r' == c);
+                    buff[n++] = c;
+                    if (hwRxFifoSize == n) {
+                        mRxOverflow += n - mRxRing.write(buff, n);
+                        n = 0;
                     }
                 }
+                mRxOverflow += n - mRxRing.write(buff, n);
+
+                const uint32_t count = mRxRing.getCount();
+                if(count > mRxQWatermark) {
+                    mRxQWatermark = count;
+                }
 
-                if(uxQueueMessagesWaitingFromISR(mRxQueue) > mRxQWatermark) {
-                    mRxQWatermark = uxQueueMessagesWaitingFromISR(mRxQueue);
+                const uint32_t level = mRxWakeLevel;
+                if(0 != level && (endOfData || count >= level)) {
+                    mRxWakeLevel = 0;
+                    xSemaphoreGiveFromISR(mRxSignal, &switchRequired);
                 }
             }
             break;
@@ -193,18 +372,32 @@ void UartDev::handleInterrupt()
 ///////////////
 UartDev::UartDev(unsigned int* pUARTBaseAddr) : CharDev(),
         mpUARTRegBase((LPC_UART_TypeDef*) pUARTBaseAddr),
-        mRxQueue(0),
-        mTxQueue(0),
+        mRxSignal(0),
+        mTxSignal(0),
+        mRxWakeLevel(0),
+        mTxWakeLevel(0),
         mPeripheralClock(0),
         mRxQWatermark(0),
         mTxQWatermark(0),
-        mLastActivityTime(0)
+        mRxOverflow(0),
+        mLastActivityTime(0),
+        mInterruptCount(0),
+        mTxDmaCount(0),
+        mTxDmaChannel(-1),
+        mRxDmaChannel(-1),
+        mTxDmaRequest(0),
+        mTxDmaLen(0),
+        mTxAsync(false),
+        mpTxAsyncDone(0),
+        mpTxAsyncArg(0),
+        mRxDmaPos(0),
+        mRxDmaLaps(0)
 {
 
 }
 
 bool UartDev::init(unsigned int pclk, unsigned int baudRate,
-                   int rxQSize, int txQSize)
+                   int rxQSize, int txQSize, bool useDma)
 {
     mPeripheralClock = pclk;
 
@@ -245,13 +438,235 @@ bool UartDev::init(unsigned int pclk, unsigned int baudRate,
     // Set minimum queue size?
     if (rxQSize < 9) rxQSize = 8;
     if (txQSize < 9) txQSize = 8;
+    // The circular Rx DMA runs over the whole ring in one 12-bit transfer
+    if (useDma && rxQSize > 2048) rxQSize = 2048;
+
+    // Create the receive and transmit rings, and the semaphores to wake up their tasks
+    if (!mRxRing.getCapacity()) mRxRing.init(rxQSize);
+    if (!mTxRing.getCapacity()) mTxRing.init(txQSize);
+    if (!mRxSignal) {
+        mRxSignal = xSemaphoreCreateBinary();
+        xSemaphoreTake(mRxSignal, 0);
+    }
+    if (!mTxSignal) {
+        mTxSignal = xSemaphoreCreateBinary();
+        xSemaphoreTake(mTxSignal, 0);
+    }
+
+    if (useDma && mRxRing.getCapacity() && mTxRing.getCapacity()) {
+        initDma();
+    }
+
+    // Enable Rx/Tx and line status Interrupts, the DMA replaces the Rx/Tx interrupts
+    mpUARTRegBase->IER = (isRxDma() ? 0 : (1 << 0)) | (isTxDma() ? 0 : (1 << 1)) | (1 << 2); // B0:Rx, B1: Tx
+
+    return (0 != mRxRing.getCapacity() && 0 != mTxRing.getCapacity() && 0 != mRxSignal && 0 != mTxSignal);
+}
+
+/////////////
+// Private //
+/////////////
+uint32_t UartDev::readRing(void *pData, uint32_t n)
+{
+    if (isRxDma()) {
+        syncRxDma();
+    }
+    return mRxRing.read(pData, n);
+}
+
+void UartDev::initDma(void)
+{
+    uint8_t rxRequest = 0;
+
+    if (LPC_UART0_BASE == (unsigned int) mpUARTRegBase) {
+        mTxDmaRequest = gpdma_uart0_tx;
+        rxRequest = gpdma_uart0_rx;
+    }
+    else if (LPC_UART2_BASE == (unsigned int) mpUARTRegBase) {
+        mTxDmaRequest = gpdma_uart2_tx;
+        rxRequest = gpdma_uart2_rx;
+    }
+    else {
+        mTxDmaRequest = gpdma_uart3_tx;
+        rxRequest = gpdma_uart3_rx;
+    }
+
+    gpdma_init();
+    const bool rxStarted = isRxDma();
+    if (mTxDmaChannel < 0) {
+        mTxDmaChannel = gpdma_alloc_channel(txDmaDone, this);
+    }
+    if (mRxDmaChannel < 0) {
+        mRxDmaChannel = gpdma_alloc_channel(rxDmaLap, this);
+    }
+
+    /* DMA mode, with the Rx trigger level at 1 char so that the Rx DMA moves every byte right away */
+    if (isRxDma()) {
+        mpUARTRegBase->FCR = (1 << 0) | (1 << 3);
+    }
+    else if (isTxDma()) {
+        mpUARTRegBase->FCR = (1 << 0) | (1 << 3) | (1 << 6);
+    }
+    if (!isRxDma() || rxStarted) {
+        return;
+    }
 
-    // Create the receive and transmit queues
-    if (!mRxQueue) mRxQueue = xQueueCreate(rxQSize, sizeof(char));
-    if (!mTxQueue) mTxQueue = xQueueCreate(txQSize, sizeof(char));
+    /* The Rx channel never ends : its item reloads the same run over the whole ring,
+     * and interrupts at the end of each run to count the laps.
+     */
+    LPC_GPDMACH_TypeDef *pChannel = gpdma_get_channel(mRxDmaChannel);
+    mRxLli.src = (uint32_t) &(mpUARTRegBase->RBR);
+    mRxLli.dst = (uint32_t) mRxRing.getBuffer();
+    mRxLli.next = (uint32_t) &mRxLli;
+    mRxLli.control = mRxRing.getCapacity() | GPDMA_CTRL_DST_INCR | GPDMA_CTRL_TC_INT;
+    mRxDmaPos = 0;
+    mRxDmaLaps = 0;
+
+    pChannel->DMACCSrcAddr = mRxLli.src;
+    pChannel->DMACCDestAddr = mRxLli.dst;
+    pChannel->DMACCLLI = mRxLli.next;
+    pChannel->DMACCControl = mRxLli.control;
+    pChannel->DMACCConfig = GPDMA_CFG_SRC_PERIPH(rxRequest) | GPDMA_CFG_P_TO_M | GPDMA_CFG_TC_INT;
+    pChannel->DMACCConfig |= GPDMA_CFG_ENABLE;
+}
+
+void UartDev::syncRxDma(bool fromIsr)
+{
+    const uint32_t capacity = mRxRing.getCapacity();
+    const uint32_t mask = capacity - 1;
+    const uint32_t bit = (1 << mRxDmaChannel);
+    LPC_GPDMACH_TypeDef *pChannel = gpdma_get_channel(mRxDmaChannel);
+    uint32_t laps = 0;
+    uint32_t lapEnded = 0;
+    uint32_t index = 0;
+
+    /* The index alone cannot tell nothing from a whole ring, so the position is
+     * laps * capacity + index.  A lap whose interrupt did not run yet (the caller
+     * masks it) is still set in the raw status.  Look again if a lap ended or the
+     * DMA interrupt ran while looking.
+     */
+    do {
+        laps = mRxDmaLaps;
+        lapEnded = LPC_GPDMA->DMACRawIntTCStat & bit;
+        index = pChannel->DMACCDestAddr - (uint32_t) mRxRing.getBuffer();
+    } while (laps != mRxDmaLaps || lapEnded != (LPC_GPDMA->DMACRawIntTCStat & bit));
+
+    /* At the end of a run the address is past the ring until the item reloads it */
+    if (lapEnded && index < capacity) {
+        ++laps;
+    }
+    const uint32_t pos = laps * capacity + index;
+    uint32_t n = pos - mRxDmaPos;
 
-    // Enable Rx/Tx and line status Interrupts:
-    mpUARTRegBase->IER = (1 << 0) | (1 << 1) | (1 << 2); // B0:Rx, B1: Tx
+    /* Zero, or "behind" while the last run ends before its status is set : next time */
+    if ((int32_t) n <= 0) {
+        return;
+    }
+    mRxDmaPos = pos;
+    mLastActivityTime = fromIsr ? xTaskGetTickCountFromISR() : xTaskGetTickCount();
 
-    return (0 != mRxQueue && 0 != mTxQueue);
+    /* More than a whole ring since last time : the bytes in the ring and the first ones
+     * of the new ring were written over.  Only the last capacity bytes are left.
+     */
+    if (n > capacity) {
+        const uint32_t lost = n - capacity;
+        mRxOverflow += mRxRing.getCount() + lost;
+        mRxRing.skip(mRxRing.getCount());
+        mRxRing.commit(lost & mask);
+        mRxRing.skip(lost & mask);
+        n = capacity;
+    }
+
+    /* The DMA does not stop when the ring is full, it wrote over the oldest bytes */
+    const uint32_t room = mRxRing.getFree();
+    if (n > room) {
+        mRxRing.skip(n - room);
+        mRxOverflow += n - room;
+    }
+    mRxRing.commit(n);
+
+    if (mRxRing.getCount() > mRxQWatermark) {
+        mRxQWatermark = mRxRing.getCount();
+    }
+}
+
+void UartDev::setRxDmaWake(bool enable)
+{
+    /* IER is also written by the interrupt, read() calls this in a critical section */
+    mRxWakeLevel = enable ? 1 : 0;
+    if (enable) {
+        mpUARTRegBase->IER |= (1 << 0);
+    }
+    else {
+        mpUARTRegBase->IER &= ~(1 << 0);
+    }
+}
+
+void UartDev::startTxDma(void)
+{
+    uint32_t len = 0;
+    const uint8_t *pSpan = mTxRing.peekSpan(&len);
+
+    if (0 != mTxDmaLen || 0 == len) {
+        return;
+    }
+
+    const uint32_t pending = mTxRing.getCount();
+    if (pending > mTxQWatermark) {
+        mTxQWatermark = pending;
+    }
+
+    mTxDmaLen = (len > GPDMA_MAX_TRANSFERS) ? GPDMA_MAX_TRANSFERS : len;
+    startTxDmaFrom(pSpan, mTxDmaLen);
+}
+
+void UartDev::startTxDmaFrom(const void *pData, uint32_t n)
+{
+    LPC_GPDMACH_TypeDef *pChannel = gpdma_get_channel(mTxDmaChannel);
+
+    pChannel->DMACCSrcAddr = (uint32_t) pData;
+    pChannel->DMACCDestAddr = (uint32_t) &(mpUARTRegBase->THR);
+    pChannel->DMACCLLI = 0;
+    pChannel->DMACCControl = n | GPDMA_CTRL_SRC_INCR | GPDMA_CTRL_TC_INT;
+    pChannel->DMACCConfig = GPDMA_CFG_DST_PERIPH(mTxDmaRequest) | GPDMA_CFG_M_TO_P |
+                            GPDMA_CFG_ERR_INT | GPDMA_CFG_TC_INT;
+    pChannel->DMACCConfig |= GPDMA_CFG_ENABLE;
+}
+
+void UartDev::handleTxDmaDone(bool failed)
+{
+    long switchRequired = 0;
+
+    ++mTxDmaCount;
+    if (mTxAsync) {
+        mTxAsync = false;
+        mTxDmaLen = 0;
+        if (mpTxAsyncDone) {
+            mpTxAsyncDone(failed, mpTxAsyncArg);
+        }
+    }
+    else {
+        /* The bytes are in the UART FIFO (or lost upon error), make room for the writer */
+        mTxRing.skip(mTxDmaLen);
+        mTxDmaLen = 0;
+    }
+    startTxDma();
+
+    const uint32_t level = mTxWakeLevel;
+    if (0 != level && mTxRing.getFree() >= level) {
+        mTxWakeLevel = 0;
+        xSemaphoreGiveFromISR(mTxSignal, &switchRequired);
+    }
+    portEND_SWITCHING_ISR(switchRequired);
+}
+
+void UartDev::txDmaDone(char failed, void *pArg)
+{
+    ((UartDev*) pArg)->handleTxDmaDone(0 != failed);
+}
+
+void UartDev::rxDmaLap(char failed, void *pArg)
+{
+    /* The channel reloads its item by itself, only the lap is counted here */
+    ++((UartDev*) pArg)->mRxDmaLaps;
 }
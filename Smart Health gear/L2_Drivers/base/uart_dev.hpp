@@ -20,6 +20,8 @@
  * @file
  * @brief Provides UART Base class functionality for UART peripherals
  *
+ *  20261017 : Byte rings instead of per-char queues, added write() and read()
+ *  20261017 : Optional GPDMA mode
  *  12012013 : Split functionality to char_dev.hpp and inherited this object
  *  10102013 : Make init() public, and protect from re-init leaking memory through xQueueCreate()
  *  05122013 : Added version history
@@ -33,6 +35,8 @@
 #include "task.h"
 
 #include "char_dev.hpp"
+#include "byte_ring.hpp"
+#include "gpdma.h"
 #include "LPC17xx.h"
 
 
@@ -55,12 +59,36 @@
  *   }
  *  @endcode
  *
+ *  The interrupt and the tasks exchange data through two ByteRing objects.
+ *  The interrupt moves a whole FIFO at a time and wakes a waiting task only once
+ *  enough data (or room) is there, a line ends, or the receive line goes idle,
+ *  instead of one queue operation per character.  Tasks copy into and out of the
+ *  rings in a short critical section so that more than one task can use the UART.
+ *
+ *  In DMA mode (see init()) the UART interrupt reports line errors, and wakes a
+ *  reader waiting for its first byte :
+ *   - Tx : a GPDMA channel sends the contiguous bytes of the Tx ring, and its
+ *     completion interrupt starts the next span, instead of one interrupt per 16 bytes.
+ *     writeAsync() sends the caller's buffer without copying it.
+ *   - Rx : a GPDMA channel fills the Rx ring as a circular buffer forever, and its
+ *     interrupt at the end of each lap counts the laps so that a whole ring received
+ *     between two looks is not mistaken for nothing.  read()
+ *     sleeps on the Rx data interrupt, enabled only while it waits, until the
+ *     first byte is in.  It then looks at the DMA position every tick and returns
+ *     once n bytes are in, or once nothing came in for a tick (idle line).
+ *
  *  @warning This class hasn't been tested for UART1 due to different memory map.
  *  @ingroup Drivers
  */
 class UartDev : public CharDev
 {
     public:
+        /**
+         * Called from the DMA interrupt once writeAsync() is done
+         * @param failed  true upon DMA error
+         * @param pArg    The argument given to writeAsync()
+         */
+        typedef void (*TxDoneFunc)(bool failed, void *pArg);
 
         /// Reset the baud-rate after UART has been initialized
         void setBaudRate(unsigned int baudRate);
@@ -83,6 +111,35 @@ class UartDev : public CharDev
          */
         bool putChar(char out, unsigned int timeout=portMAX_DELAY);
 
+        /**
+         * Outputs n bytes, copied into the transmit ring in contiguous spans
+         * @param   timeout The time to wait in OS ticks for room in the ring
+         * @returns the number of bytes written, less than n upon timeout
+         */
+        uint32_t write(const void *pData, uint32_t n, unsigned int timeout=portMAX_DELAY);
+
+        /**
+         * Reads up to n bytes.  If nothing was received yet, this waits until n bytes
+         * are in, a line ends ('\n' or '\r'), or the line goes idle for 4 chars.
+         * @param   timeout The time to wait in OS ticks for the first byte
+         * @returns the number of bytes read, 0 upon timeout
+         */
+        uint32_t read(void *pData, uint32_t n, unsigned int timeout=portMAX_DELAY);
+
+        /**
+         * DMA mode only : starts sending the caller's buffer and returns right away.
+         * @param pData  The bytes to send, which must stay valid until done() is called
+         * @param n      The number of bytes, up to GPDMA_MAX_TRANSFERS
+         * @param done   The callback from the DMA interrupt at the end, can be NULL
+         * @returns false if not in Tx DMA mode, or if the transmitter is busy
+         */
+        bool writeAsync(const void *pData, uint32_t n, TxDoneFunc done, void *pArg);
+
+        /** @{ DMA mode, each direction falls back to the interrupt if no DMA channel was free */
+        inline bool isTxDma() const { return mTxDmaChannel >= 0; }
+        inline bool isRxDma() const { return mRxDmaChannel >= 0; }
+        /** @} */
+
         /// Flushed all pending transmission of the uart queue
         bool flush(void);
 
@@ -90,10 +147,13 @@ class UartDev : public CharDev
          * @{ Get the Rx and Tx queue information
          * Watermarks provide the queue's usage to access the capacity usage
          */
-        inline unsigned int getRxQueueSize() const { return uxQueueMessagesWaiting(mRxQueue); }
-        inline unsigned int getTxQueueSize() const { return uxQueueMessagesWaiting(mTxQueue); }
+        inline unsigned int getRxQueueSize() const { return mRxRing.getCount(); }
+        inline unsigned int getTxQueueSize() const { return mTxRing.getCount(); }
         inline unsigned int getRxQueueWatermark() const { return mRxQWatermark; }
         inline unsigned int getTxQueueWatermark() const { return mTxQWatermark; }
+        inline unsigned int getRxOverflowCount() const { return mRxOverflow; }
+        inline unsigned int getInterruptCount() const { return mInterruptCount; }
+        inline unsigned int getTxDmaCount() const { return mTxDmaCount; }
         /** @} */
 
         /**
@@ -118,15 +178,17 @@ class UartDev : public CharDev
          * Parent class should call this method before initializing Pin-Connect-Block
          * @param pclk      The system peripheral clock for this UART
          * @param baudRate  The baud rate to set
-         * @param rxQSize   The receive queue size
-         * @param txQSize   The transmit queue size
+         * @param rxQSize   The receive queue size, rounded up to a power of 2
+         * @param txQSize   The transmit queue size, rounded up to a power of 2
+         * @param useDma    true to move the data by GPDMA instead of the FIFO interrupts.
+         *                  The Rx queue size is then limited to 2048.
          * @post    Sets 8-bit mode, no parity, no flow control.
          * @warning This will not initialize the PINS, so user needs to do pin
          *          selection because LPC's same UART hardware, such as UART2
          *          is available on multiple pins.
          * @note If the txQSize is too small, functions performing printf will start to block.
          */
-        bool init(unsigned int pclk, unsigned int baudRate, int rxQSize=32, int txQSize=32);
+        bool init(unsigned int pclk, unsigned int baudRate, int rxQSize=32, int txQSize=32, bool useDma=false);
 
         /**
          * Protected constructor that requires parent class to provide UART's
@@ -138,13 +200,48 @@ class UartDev : public CharDev
     private:
         UartDev(); /** Disallowed constructor */
 
+        /// Sends up to 16 bytes of the Tx ring if the hardware FIFO is empty
+        void fillTxFifo(void);
+
+        /// Copies up to n bytes out of the Rx ring, after taking in what the Rx DMA wrote
+        uint32_t readRing(void *pData, uint32_t n);
+
+        /** @{ DMA mode */
+        void initDma(void);
+        void syncRxDma(bool fromIsr=false);             ///< Adds the bytes the Rx DMA wrote to the ring
+        void setRxDmaWake(bool enable);                 ///< Enables the Rx data interrupt for a waiting reader
+        void startTxDma(void);                          ///< Sends the next span of the Tx ring if idle
+        void startTxDmaFrom(const void *pData, uint32_t n);
+        void handleTxDmaDone(bool failed);
+        static void txDmaDone(char failed, void *pArg); ///< GPDMA handler, pArg is the UartDev
+        static void rxDmaLap(char failed, void *pArg);  ///< GPDMA handler at the end of each Rx lap
+        /** @} */
+
         LPC_UART_TypeDef* mpUARTRegBase;///< Pointer to UART's memory map
-        QueueHandle_t mRxQueue;         ///< Queue for UARTs receive buffer
-        QueueHandle_t mTxQueue;         ///< Queue for UARTs transmit buffer
+        ByteRing mRxRing;               ///< UARTs receive buffer, filled by the interrupt
+        ByteRing mTxRing;               ///< UARTs transmit buffer, emptied by the interrupt
+        SemaphoreHandle_t mRxSignal;    ///< Given by the interrupt when the reader can run
+        SemaphoreHandle_t mTxSignal;    ///< Given by the interrupt when the writer can run
+        volatile uint32_t mRxWakeLevel; ///< Rx bytes the waiting reader wants, 0 if none waits
+        volatile uint32_t mTxWakeLevel; ///< Tx room the waiting writer wants, 0 if none waits
         uint32_t mPeripheralClock;      ///< Peripheral clock as given by constructor
         uint16_t mRxQWatermark;         ///< Watermark of Rx Queue
         uint16_t mTxQWatermark;         ///< Watermark of Tx Queue
+        volatile uint32_t mRxOverflow;  ///< Bytes received while the Rx ring was full
         TickType_t mLastActivityTime;   ///< updated each time last rx interrupt occurs
+
+        volatile uint32_t mInterruptCount;  ///< handleInterrupt() calls
+        volatile uint32_t mTxDmaCount;      ///< Tx DMA runs completed
+        int8_t mTxDmaChannel;               ///< GPDMA channel for Tx, -1 without Tx DMA
+        int8_t mRxDmaChannel;               ///< GPDMA channel for Rx, -1 without Rx DMA
+        uint8_t mTxDmaRequest;              ///< GPDMA request line of the UART Tx
+        volatile uint32_t mTxDmaLen;        ///< Bytes of the running Tx DMA, 0 when idle
+        volatile bool mTxAsync;             ///< The running Tx DMA is a writeAsync()
+        TxDoneFunc mpTxAsyncDone;           ///< Callback of the running writeAsync()
+        void *mpTxAsyncArg;                 ///< Argument of mpTxAsyncDone
+        uint32_t mRxDmaPos;                 ///< Bytes the Rx DMA wrote, as taken in by syncRxDma()
+        volatile uint32_t mRxDmaLaps;       ///< Rx DMA runs over the whole ring, counted by rxDmaLap()
+        gpdma_lli_t mRxLli;                 ///< Rx DMA item that links to itself (circular)
 };
 
 
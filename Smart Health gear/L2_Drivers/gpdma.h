@@ -0,0 +1,93 @@
+/**
+ * @file
+ * @brief Shared GPDMA channels and the one GPDMA interrupt
+ * @ingroup Drivers
+ *
+ * 20261017 : First version, DMA_IRQHandler() moved here from spi_dma.c
+ */
+#ifndef GPDMA_H__
+#define GPDMA_H__
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include <stdint.h>
+#include "LPC17xx.h"
+
+
+
+#define GPDMA_NUM_CHANNELS          8       ///< Channels of the GPDMA, 0 has the highest priority
+#define GPDMA_FIRST_SHARED_CHANNEL  3       ///< 0 to 2 are fixed for SSP1 and SSP0 in spi_dma.c
+#define GPDMA_MAX_TRANSFERS         0xFFF   ///< 12-bit transfer size of one channel run
+
+/** @{ Bits of DMACCControl */
+#define GPDMA_CTRL_SRC_INCR         (1 << 26)   ///< Increment the source address
+#define GPDMA_CTRL_DST_INCR         (1 << 27)   ///< Increment the destination address
+#define GPDMA_CTRL_TC_INT           (1UL << 31) ///< Terminal count interrupt at the end of this run
+/** @} */
+
+/** @{ Bits of DMACCConfig */
+#define GPDMA_CFG_ENABLE            (1 << 0)    ///< Channel enable, set after the rest is written
+#define GPDMA_CFG_SRC_PERIPH(p)     ((p) << 1)  ///< Peripheral that requests the reads
+#define GPDMA_CFG_DST_PERIPH(p)     ((p) << 6)  ///< Peripheral that requests the writes
+#define GPDMA_CFG_M_TO_P            (1 << 11)   ///< Memory to peripheral
+#define GPDMA_CFG_P_TO_M            (2 << 11)   ///< Peripheral to memory
+#define GPDMA_CFG_ERR_INT           (1 << 14)   ///< Error interrupt enable
+#define GPDMA_CFG_TC_INT            (1 << 15)   ///< Terminal count interrupt enable
+/** @} */
+
+/// DMA request lines of the UARTs (DMAREQSEL left at 0 selects the UART, not the timer match)
+typedef enum {
+    gpdma_uart0_tx = 8,
+    gpdma_uart0_rx = 9,
+    gpdma_uart2_tx = 12,
+    gpdma_uart2_rx = 13,
+    gpdma_uart3_tx = 14,
+    gpdma_uart3_rx = 15,
+} gpdma_request_t;
+
+/// Linked list item, a channel that links to its own item runs forever (circular buffer)
+typedef struct {
+    uint32_t src;       ///< DMACCSrcAddr of the next run
+    uint32_t dst;       ///< DMACCDestAddr of the next run
+    uint32_t next;      ///< DMACCLLI of the next run, the address of a gpdma_lli_t or 0
+    uint32_t control;   ///< DMACCControl of the next run
+} gpdma_lli_t;
+
+/**
+ * Called from the DMA interrupt at the terminal count or error of a channel.
+ * The interrupt status of the channel is already cleared.
+ * @param failed  Non-zero upon DMA error
+ * @param pArg    The argument given to gpdma_alloc_channel() or gpdma_attach()
+ */
+typedef void (*gpdma_handler_t)(char failed, void *pArg);
+
+/// Powers up and enables the GPDMA and its interrupt, can be called by every driver
+void gpdma_init(void);
+
+/**
+ * Attaches the interrupt handler of a fixed channel.
+ * @param channel  The channel, below GPDMA_FIRST_SHARED_CHANNEL
+ */
+void gpdma_attach(uint32_t channel, gpdma_handler_t handler, void *pArg);
+
+/**
+ * Reserves one of the free channels from GPDMA_FIRST_SHARED_CHANNEL, the highest
+ * numbered (lowest priority) first.
+ * @param handler  The interrupt handler of the channel, can be NULL if it does not interrupt
+ * @returns the channel, or -1 if all of them are in use
+ * @note Channels are taken at init time and never given back
+ */
+int gpdma_alloc_channel(gpdma_handler_t handler, void *pArg);
+
+/// @returns the registers of a channel
+static inline LPC_GPDMACH_TypeDef* gpdma_get_channel(uint32_t channel)
+{
+    return (LPC_GPDMACH_TypeDef*) (LPC_GPDMACH0_BASE + channel * 0x20);
+}
+
+
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* GPDMA_H__ */
@@ -88,6 +88,45 @@ static inline void adc0_start_conversion(uint8_t channel_num)
     LPC_ADC->ADCR |= (1 << channel_num) | start_conversion;
 }
 
+static uint32_t adc0_burst(uint8_t channel_num, uint16_t count)
+{
+    const uint32_t twelve_bits = 0x0FFF;
+    const uint32_t done = (1UL << 31);
+    const uint32_t burst = (1 << 16);
+    const uint32_t channel_masks = 0xFF;
+    const uint32_t start_conversion_masks = (7 << 24);
+    const uint32_t global_done_interrupt = (1 << 8);
+    const volatile uint32_t *data_reg = &(LPC_ADC->ADDR0) + channel_num;
+    uint32_t sum = 0;
+
+    // No interrupt for the burst conversions, we poll the channel's own DONE bit
+    LPC_ADC->ADINTEN = 0;
+    (void) *data_reg;
+
+    // Burst mode needs START bits to be 000
+    LPC_ADC->ADCR &= ~(channel_masks | start_conversion_masks);
+    LPC_ADC->ADCR |= (1 << channel_num) | burst;
+    while (count--) {
+        uint32_t reading;
+        while (!((reading = *data_reg) & done)) {
+            ;
+        }
+        sum += (reading >> 4) & twelve_bits;
+    }
+    LPC_ADC->ADCR &= ~burst;
+
+    // Burst conversions are back-to-back so one is always in progress here, let it finish
+    // and clear its DONE flags before ADC_IRQHandler() can see them
+    while (!(*data_reg & done)) {
+        ;
+    }
+    (void) LPC_ADC->ADGDR;
+    NVIC_ClearPendingIRQ(ADC_IRQn);
+    LPC_ADC->ADINTEN = global_done_interrupt;
+
+    return sum;
+}
+
 uint16_t adc0_get_reading(uint8_t channel_num)
 {
     uint16_t result = 0;
@@ -116,3 +155,27 @@ uint16_t adc0_get_reading(uint8_t channel_num)
 
     return result;
 }
+
+uint32_t adc0_get_burst_sum(uint8_t channel_num, uint16_t count)
+{
+    uint32_t sum = 0;
+    const uint8_t max_channels = 8;
+
+    if (channel_num >= max_channels) {
+        sum = 0;
+    }
+    else if (taskSCHEDULER_RUNNING == xTaskGetSchedulerState())
+    {
+        xSemaphoreTake(g_adc_mutex, portMAX_DELAY);
+        {
+            sum = adc0_burst(channel_num, count);
+        }
+        xSemaphoreGive(g_adc_mutex);
+    }
+    else
+    {
+        sum = adc0_burst(channel_num, count);
+    }
+
+    return sum;
+}
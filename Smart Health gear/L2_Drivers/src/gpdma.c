@@ -0,0 +1,62 @@
+#include "gpdma.h"
+#include "lpc_sys.h"
+
+
+
+/// Interrupt handler of every channel, NULL if the channel does not interrupt
+static gpdma_handler_t g_handlers[GPDMA_NUM_CHANNELS] = { 0 };
+static void *g_handler_args[GPDMA_NUM_CHANNELS] = { 0 };
+static uint8_t g_used_mask = 0;
+
+void gpdma_init(void)
+{
+    if (LPC_GPDMA->DMACConfig & 1) {
+        return;
+    }
+
+    lpc_pconp(pconp_gpdma, true);
+    LPC_GPDMA->DMACConfig = 1;
+    while (!(LPC_GPDMA->DMACConfig & 1));
+    NVIC_EnableIRQ(DMA_IRQn);
+}
+
+void gpdma_attach(uint32_t channel, gpdma_handler_t handler, void *pArg)
+{
+    if (channel < GPDMA_FIRST_SHARED_CHANNEL) {
+        g_handler_args[channel] = pArg;
+        g_handlers[channel] = handler;
+    }
+}
+
+int gpdma_alloc_channel(gpdma_handler_t handler, void *pArg)
+{
+    int channel = 0;
+
+    for (channel = GPDMA_NUM_CHANNELS - 1; channel >= GPDMA_FIRST_SHARED_CHANNEL; channel--) {
+        if (!(g_used_mask & (1 << channel))) {
+            g_used_mask |= (1 << channel);
+            g_handler_args[channel] = pArg;
+            g_handlers[channel] = handler;
+            return channel;
+        }
+    }
+
+    return -1;
+}
+
+void DMA_IRQHandler(void)
+{
+    const uint32_t failed_mask = LPC_GPDMA->DMACIntErrStat;
+    const uint32_t done_mask = LPC_GPDMA->DMACIntTCStat;
+    const uint32_t mask = failed_mask | done_mask;
+    uint32_t channel = 0;
+
+    LPC_GPDMA->DMACIntErrClr = failed_mask;
+    LPC_GPDMA->DMACIntTCClear = done_mask;
+
+    for (channel = 0; channel < GPDMA_NUM_CHANNELS; channel++) {
+        if ((mask & (1 << channel)) && g_handlers[channel]) {
+            g_handlers[channel]((failed_mask & (1 << channel)) ? 1 : 0, g_handler_args[channel]);
+        }
+    }
+}
@@ -17,6 +17,8 @@
  */
 
 #include "LPC17xx.h"
+#include "ssp0.h"
+#include "gpdma.h"
 
 
 
@@ -24,6 +26,9 @@
 #define SPI_DMA_RX_NUM      1    ///< DMA Channel number for SSP Rx
 #define SSP1_TX_CHAN        2UL  ///< DMA source for TX of SSP1
 #define SSP1_RX_CHAN        3UL  ///< DMA source for RX of SSP1
+#define SSP0_DMA_TX_NUM     2    ///< DMA Channel number for SSP0 Tx
+#define SSP0_TX_CHAN        0UL  ///< DMA source for TX of SSP0
+#define DMA_MAX_TRANSFERS   0xFFF ///< 12-bit transfer size of one channel run
 
 
 
@@ -33,6 +38,9 @@
 #if !(SPI_DMA_RX_NUM>=0 && SPI_DMA_RX_NUM<=7)
 #error "SPI_DMA_RX_NUM must be between 0 and 7"
 #endif
+#if !(SSP0_DMA_TX_NUM>=0 && SSP0_DMA_TX_NUM<=7)
+#error "SSP0_DMA_TX_NUM must be between 0 and 7"
+#endif
 
 
 enum {
@@ -46,9 +54,7 @@ enum {
 void ssp1_dma_init()
 {
     // Power up and enable GPDMA
-    lpc_pconp(pconp_gpdma, true);
-    LPC_GPDMA->DMACConfig = 1;
-    while (!(LPC_GPDMA->DMACConfig & 1));
+    gpdma_init();
 }
 
 unsigned ssp1_dma_transfer_block(unsigned char* pBuffer, uint32_t num_bytes, char is_write_op)
@@ -186,3 +192,92 @@ unsigned ssp1_dma_transfer_block(unsigned char* pBuffer, uint32_t num_bytes, cha
     return 0;
 }
 
+
+
+/// State of the SSP0 transmit DMA, the channel is re-armed by the interrupt every DMA_MAX_TRANSFERS
+static const uint16_t *gpSsp0Words = 0;
+static uint32_t gSsp0WordsLeft = 0;
+static char gSsp0Repeat = 0;
+static volatile char gSsp0Busy = 0;
+static ssp0_dma_done_t gSsp0Done = 0;
+
+/// Starts the next part of the SSP0 transfer, at most DMA_MAX_TRANSFERS words
+static void ssp0_dma_start_next(void)
+{
+    LPC_GPDMACH_TypeDef *pDmaTxChannel = (LPC_GPDMACH_TypeDef *)
+                                          (LPC_GPDMACH0_BASE + SSP0_DMA_TX_NUM*0x20);
+    const uint32_t num_words = (gSsp0WordsLeft > DMA_MAX_TRANSFERS) ? DMA_MAX_TRANSFERS : gSsp0WordsLeft;
+
+    LPC_GPDMA->DMACIntTCClear = (1 << SSP0_DMA_TX_NUM);
+    LPC_GPDMA->DMACIntErrClr  = (1 << SSP0_DMA_TX_NUM);
+
+    /**
+     * Half-words to the 16-bit SSP0 DR, 4 at a time since the SSP requests a
+     * burst when half of its TX FIFO is empty.  A fill sends the same word.
+     */
+    pDmaTxChannel->DMACCSrcAddr  = (uint32_t)(gpSsp0Words);
+    pDmaTxChannel->DMACCDestAddr = (uint32_t)(&(LPC_SSP0->DR));
+    pDmaTxChannel->DMACCLLI = 0;
+    pDmaTxChannel->DMACCControl = num_words | DST_BURST_4_BYTES | SRC_WIDTH_2_BYTES | DST_WIDTH_2_BYTES |
+                                  (gSsp0Repeat ? 0 : SRC_INCR_BIT) | TCIE_BIT;
+    pDmaTxChannel->DMACCConfig = (SSP0_TX_CHAN << 6) | M_TO_P_BIT | ER_INTR_BIT | TC_INTR_BIT;
+    pDmaTxChannel->DMACCConfig |= 1;
+
+    if (!gSsp0Repeat) {
+        gpSsp0Words += num_words;
+    }
+    gSsp0WordsLeft -= num_words;
+}
+
+/// Runs from the DMA interrupt at the end of each part of the SSP0 transfer
+static void ssp0_dma_isr(char failed, void *pArg)
+{
+    (void) pArg;
+    if (!failed && gSsp0WordsLeft) {
+        ssp0_dma_start_next();
+        return;
+    }
+
+    /* The last words may still be in the SSP FIFO, the callback's owner waits for it */
+    LPC_SSP0->DMACR &= ~(1 << 1);
+    gSsp0WordsLeft = 0;
+    gSsp0Busy = 0;
+    if (gSsp0Done) {
+        gSsp0Done(failed);
+    }
+}
+
+void ssp0_dma_init(void)
+{
+    // Power up and enable GPDMA, the SSP0 channel completes by interrupt
+    gpdma_init();
+    gpdma_attach(SSP0_DMA_TX_NUM, ssp0_dma_isr, 0);
+}
+
+unsigned ssp0_dma_write_start(const uint16_t* pWords, uint32_t num_words, char repeat, ssp0_dma_done_t done)
+{
+    LPC_GPDMACH_TypeDef *pDmaTxChannel = (LPC_GPDMACH_TypeDef *)
+                                          (LPC_GPDMACH0_BASE + SSP0_DMA_TX_NUM*0x20);
+
+    if (0 == num_words) {
+        return 1;
+    }
+    if (gSsp0Busy || (pDmaTxChannel->DMACCConfig & 1)) {
+        return 2;
+    }
+
+    gpSsp0Words = pWords;
+    gSsp0WordsLeft = num_words;
+    gSsp0Repeat = repeat;
+    gSsp0Done = done;
+    gSsp0Busy = 1;
+
+    ssp0_dma_start_next();
+    LPC_SSP0->DMACR |= (1 << 1); // TX: B1
+    return 0;
+}
+
+char ssp0_dma_is_busy(void)
+{
+    return gSsp0Busy;
+}
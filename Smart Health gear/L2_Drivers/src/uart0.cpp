@@ -36,7 +36,7 @@ extern "C"
     }
 }
 
-bool Uart0::init(unsigned int baudRate, int rxQSize, int txQSize)
+bool Uart0::init(unsigned int baudRate, int rxQSize, int txQSize, bool useDma)
 {
     // Configure PINSEL for UART0
     LPC_PINCON->PINSEL0 &= ~(0xF << 4); // Clear values
@@ -46,7 +46,7 @@ bool Uart0::init(unsigned int baudRate, int rxQSize, int txQSize)
     lpc_pclk(pclk_uart0, clkdiv_1);
     const unsigned int pclk = sys_get_cpu_clock();
 
-    return UartDev::init(pclk, baudRate, rxQSize, txQSize);
+    return UartDev::init(pclk, baudRate, rxQSize, txQSize, useDma);
 }
 
 Uart0::Uart0() : UartDev((unsigned int*)LPC_UART0_BASE)
@@ -36,7 +36,7 @@
     }
 }*/
 
-bool Uart2::init(unsigned int baudRate, int rxQSize, int txQSize)
+bool Uart2::init(unsigned int baudRate, int rxQSize, int txQSize, bool useDma)
 {
     // Configure PINSEL for UART2.
     // UART2 RX/TX is at P0.10 and P0.11 or P2.8 and P2.9
@@ -48,7 +48,7 @@ bool Uart2::init(unsigned int baudRate, int rxQSize, int txQSize)
     lpc_pclk(pclk_uart2, clkdiv_1);
     const unsigned int pclk = sys_get_cpu_clock();
 
-    return UartDev::init(pclk, baudRate, rxQSize, txQSize);
+    return UartDev::init(pclk, baudRate, rxQSize, txQSize, useDma);
 }
 
 Uart2::Uart2() : UartDev((unsigned int*)LPC_UART2_BASE)
@@ -36,7 +36,7 @@ extern "C"
     }
 }
 
-bool Uart3::init(unsigned int baudRate, int rxQSize, int txQSize)
+bool Uart3::init(unsigned int baudRate, int rxQSize, int txQSize, bool useDma)
 {
     // Configure PINSEL for UART3.
     // UART3 RX/TX is at P4.28 and P4.29
@@ -47,7 +47,7 @@ bool Uart3::init(unsigned int baudRate, int rxQSize, int txQSize)
     lpc_pclk(pclk_uart3, clkdiv_1);
     const unsigned int pclk = sys_get_cpu_clock();
 
-    return UartDev::init(pclk, baudRate, rxQSize, txQSize);
+    return UartDev::init(pclk, baudRate, rxQSize, txQSize, useDma);
 }
 
 Uart3::Uart3() : UartDev((unsigned int*)LPC_UART3_BASE)
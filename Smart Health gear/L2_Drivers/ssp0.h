@@ -74,6 +74,32 @@ static inline void ssp0_exchange_data(void *data, int len)
     ssp_exchange_data(LPC_SSP0, data, len);
 }
 
+/**
+ * Called from the DMA interrupt once the last word of ssp0_dma_write_start() is
+ * in the SSP0 FIFO.
+ * @param failed   Non-zero upon DMA error
+ */
+typedef void (*ssp0_dma_done_t)(char failed);
+
+/// Powers up the GPDMA and enables its interrupt for the SSP0 transmit channel
+void ssp0_dma_init(void);
+
+/**
+ * Starts sending 16-bit words over SSP0 by DMA and returns right away
+ * @param pWords     The words to send, which must stay valid until the end
+ * @param num_words  The number of words, the transfer is split every 4095 words
+ * @param repeat     Non-zero to send pWords[0] num_words times (fill)
+ * @param done       The callback from the DMA interrupt at the end, can be NULL
+ *
+ * @pre   SSP0 is set to 16-bit frames and CS is driven by the caller
+ * @note  The received words are not read, flush the RX FIFO at the end
+ * @return 0 upon success, or non-zero if num_words is 0 or a transfer is running
+ */
+unsigned ssp0_dma_write_start(const uint16_t* pWords, uint32_t num_words, char repeat, ssp0_dma_done_t done);
+
+/// @returns non-zero while ssp0_dma_write_start() is running
+char ssp0_dma_is_busy(void);
+
 
 
 #ifdef __cplusplus
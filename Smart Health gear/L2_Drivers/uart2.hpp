@@ -43,8 +43,9 @@ class Uart2 : public UartDev, public SingletonTemplate<Uart2>
          * Initializes UART2 at the given @param baudRate
          * @param rxQSize   The size of the receive queue  (optional, defaults to 32)
          * @param txQSize   The size of the transmit queue (optional, defaults to 64)
+         * @param useDma    Move the data by GPDMA instead of the FIFO interrupts (optional)
          */
-        bool init(unsigned int baudRate, int rxQSize=32, int txQSize=64);
+        bool init(unsigned int baudRate, int rxQSize=32, int txQSize=64, bool useDma=false);
 
     private:
         Uart2();  ///< Private constructor of this Singleton class
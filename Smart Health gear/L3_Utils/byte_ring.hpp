@@ -0,0 +1,276 @@
+/**
+ * @file
+ * @brief Header-only single-producer single-consumer byte ring for an ISR and a task
+ * @ingroup Utilities
+ *
+ * Version: 20261017    Initial
+ */
+#ifndef BYTE_RING_HPP__
+#define BYTE_RING_HPP__
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+
+/**
+ * Byte ring shared by exactly one producer and one consumer, for example a UART
+ * receive interrupt and the task that reads the data.  No lock is needed : only
+ * the producer moves mHead and only the consumer moves mTail.  Both are free
+ * running counters, so the count is (mHead - mTail) even after they wrap, and
+ * the capacity is rounded up to a power of 2 to index the buffer with a mask.
+ *
+ * write() and read() copy up to two contiguous spans with memcpy() instead of
+ * moving one byte at a time, and the index is published only after the copy.
+ * Both sides run on the same core, so a compiler barrier is enough to keep the
+ * copy before the index store.
+ *
+ * @code
+ *      ByteRing rx;
+ *      rx.init(64);
+ *
+ *      // Interrupt (producer)
+ *      rx.put(c);
+ *
+ *      // Task (consumer)
+ *      char buff[16];
+ *      uint32_t n = rx.read(buff, sizeof(buff));
+ * @endcode
+ *
+ * @warning Each side must stay in one context : if two tasks write, or a task
+ *          and an interrupt both read, they have to be serialized by the caller.
+ */
+class ByteRing
+{
+    public:
+        ByteRing() : mpBuff(0), mMask(0), mHead(0), mTail(0) { }
+        ~ByteRing() { free(mpBuff); }
+
+        /**
+         * Allocates the buffer, this can only be done once.
+         * @param size  Bytes to hold, rounded up to the next power of 2
+         * @returns false if the memory could not be allocated, or already initialized
+         */
+        inline bool init(uint32_t size)
+        {
+            if (0 != mpBuff || 0 == size) {
+                return false;
+            }
+
+            uint32_t capacity = 1;
+            while (capacity < size) {
+                capacity <<= 1;
+            }
+            mpBuff = (uint8_t*) malloc(capacity);
+            mMask = capacity - 1;
+            return (0 != mpBuff);
+        }
+
+        /** @{ Size information, accurate for the side that calls it */
+        inline uint32_t getCapacity(void) const { return mpBuff ? mMask + 1 : 0; }
+        inline uint32_t getCount(void) const    { return mHead - mTail; }
+        inline uint32_t getFree(void) const     { return getCapacity() - getCount(); }
+        inline bool isEmpty(void) const         { return mHead == mTail; }
+        /** @} */
+
+        /**
+         * Producer : copies as many bytes as there is room for.
+         * @returns the number of bytes written, less than n if the ring is full
+         */
+        inline uint32_t write(const void *pData, uint32_t n)
+        {
+            const uint32_t head = mHead;
+            const uint32_t room = getCapacity() - (head - mTail);
+            if (n > room) {
+                n = room;
+            }
+            copyIn(head & mMask, (const uint8_t*) pData, n);
+            barrier();
+            mHead = head + n;
+            return n;
+        }
+
+        /**
+         * Consumer : copies up to n bytes out of the ring.
+         * @returns the number of bytes read, less than n if the ring ran empty
+         */
+        inline uint32_t read(void *pData, uint32_t n)
+        {
+            const uint32_t tail = mTail;
+            const uint32_t count = mHead - tail;
+            if (n > count) {
+                n = count;
+            }
+            copyOut(tail & mMask, (uint8_t*) pData, n);
+            barrier();
+            mTail = tail + n;
+            return n;
+        }
+
+        /// Producer : writes one byte, @returns false if the ring is full
+        inline bool put(uint8_t byte)
+        {
+            const uint32_t head = mHead;
+            if (head - mTail > mMask || 0 == mpBuff) {
+                return false;
+            }
+            mpBuff[head & mMask] = byte;
+            barrier();
+            mHead = head + 1;
+            return true;
+        }
+
+        /// Consumer : reads one byte, @returns false if the ring is empty
+        inline bool get(uint8_t *pByte)
+        {
+            const uint32_t tail = mTail;
+            if (mHead == tail) {
+                return false;
+            }
+            *pByte = mpBuff[tail & mMask];
+            barrier();
+            mTail = tail + 1;
+            return true;
+        }
+
+        /** @{ Zero-copy access, for a DMA that reads or writes the buffer itself */
+        inline uint8_t* getBuffer(void) const { return mpBuff; }
+
+        /// Consumer : @returns the oldest bytes, with in *pLen how many of them are contiguous
+        inline const uint8_t* peekSpan(uint32_t *pLen) const
+        {
+            const uint32_t tail = mTail;
+            const uint32_t count = mHead - tail;
+            const uint32_t index = tail & mMask;
+            *pLen = (count < mMask + 1 - index) ? count : mMask + 1 - index;
+            return mpBuff + index;
+        }
+
+        /// Consumer : drops n bytes (up to getCount()), once the peekSpan() bytes are used
+        inline void skip(uint32_t n)
+        {
+            barrier();
+            mTail = mTail + n;
+        }
+
+        /// Producer : adds n bytes (up to getFree()) that are already stored after the head
+        inline void commit(uint32_t n)
+        {
+            barrier();
+            mHead = mHead + n;
+        }
+        /** @} */
+
+    private:
+        /// Keeps the compiler from moving the buffer access across the index update
+        static inline void barrier(void) { __asm__ __volatile__("" ::: "memory"); }
+
+        inline void copyIn(uint32_t index, const uint8_t *pSrc, uint32_t n)
+        {
+            /* memcpy() must not see a NULL pointer, even for 0 bytes */
+            if (0 == n) {
+                return;
+            }
+            const uint32_t first = (n < mMask + 1 - index) ? n : mMask + 1 - index;
+            memcpy(mpBuff + index, pSrc, first);
+            memcpy(mpBuff, pSrc + first, n - first);
+        }
+
+        inline void copyOut(uint32_t index, uint8_t *pDst, uint32_t n)
+        {
+            if (0 == n) {
+                return;
+            }
+            const uint32_t first = (n < mMask + 1 - index) ? n : mMask + 1 - index;
+            memcpy(pDst, mpBuff + index, first);
+            memcpy(pDst + first, mpBuff, n - first);
+        }
+
+        ByteRing(const ByteRing&);              ///< Disallowed, the buffer is owned
+        ByteRing& operator=(const ByteRing&);   ///< Disallowed, the buffer is owned
+
+        uint8_t *mpBuff;            ///< Buffer of mMask + 1 bytes
+        uint32_t mMask;             ///< Capacity - 1
+        volatile uint32_t mHead;    ///< Bytes ever written, only moved by the producer
+        volatile uint32_t mTail;    ///< Bytes ever read, only moved by the consumer
+};
+
+#ifdef TESTING
+#include <assert.h>
+static inline void test_ByteRing(void)
+{
+    ByteRing r;
+    uint8_t in[100], out[100];
+    uint8_t next_in = 0, next_out = 0;
+    uint32_t seed = 5;
+
+    assert(0 == r.getCapacity() && 0 == r.write(in, 1) && !r.put(1));
+    assert(r.init(20) && !r.init(20));
+    assert(32 == r.getCapacity() && r.isEmpty() && 32 == r.getFree());
+
+    /* Random span sizes so that both copies wrap at every position */
+    for (int i = 0; i < 5000; i++) {
+        seed = seed * 1103515245 + 12345;
+        const uint32_t n = (seed >> 16) % 40;
+        const uint32_t before = r.getCount();
+        if ((seed >> 8) & 1) {
+            for (uint32_t k = 0; k < n; k++) {
+                in[k] = next_in + k;
+            }
+            const uint32_t wrote = r.write(in, n);
+            assert(wrote == ((n < 32 - before) ? n : 32 - before));
+            next_in += wrote;
+            assert(r.getCount() == before + wrote);
+        }
+        else {
+            const uint32_t got = r.read(out, n);
+            assert(got == ((n < before) ? n : before));
+            for (uint32_t k = 0; k < got; k++) {
+                assert(out[k] == (uint8_t) (next_out + k));
+            }
+            next_out += got;
+            assert(r.getCount() == before - got);
+        }
+    }
+
+    /* Single bytes through a full ring */
+    uint8_t b = 0;
+    while (r.get(&b)) {
+        assert(b == next_out++);
+    }
+    for (int k = 0; k < 32; k++) {
+        assert(r.put(next_in++));
+    }
+    assert(!r.put(0) && 0 == r.getFree() && 0 == r.write(in, 5));
+    assert(32 == r.read(out, 100) && out[31] == (uint8_t) (next_in - 1) && r.isEmpty());
+
+    /* Zero-copy : the span stops at the end of the buffer, commit() takes bytes stored in place */
+    uint32_t len = 0;
+    next_out = next_in;
+    assert(r.peekSpan(&len) && 0 == len);
+    for (int round = 0; round < 20; round++) {
+        const uint32_t n = 5 + round % 7;
+        for (uint32_t k = 0; k < n; k++) {
+            r.getBuffer()[(uint8_t) (next_in + k) & 31] = next_in + k;
+        }
+        r.commit(n);
+        next_in += n;
+
+        const uint8_t *span = r.peekSpan(&len);
+        const uint32_t count = r.getCount();
+        assert(len > 0 && len <= count && span[0] == next_out);
+        assert(len == count || span + len == r.getBuffer() + 32);
+        r.skip(len);
+        next_out += len;
+        if (len < count) {
+            const uint32_t first = len;
+            assert(r.peekSpan(&len) == r.getBuffer() && len == count - first);
+        }
+    }
+}
+#endif /* #ifdef TESTING */
+
+
+
+#endif /* #ifndef BYTE_RING_HPP__ */
@@ -0,0 +1,285 @@
+/**
+ * @file
+ * @brief Header-only FIR filter stages that can be chained into one pass
+ * @ingroup Utilities
+ *
+ * Version: 20261017    Initial
+ */
+#ifndef FIR_FILTER_HPP__
+#define FIR_FILTER_HPP__
+
+#include <stdint.h>
+
+
+
+/**
+ * @{ Filter stages
+ * Every stage takes one sample at a time :
+ *  - push(in, out) returns true once the stage has produced an output in out
+ *  - kDelay is the number of inputs consumed before the first output
+ *  - reset() discards all the history
+ *
+ * Window sizes and coefficients are template parameters, so the compiler sees
+ * them as constants and can unroll the inner loops.  Integer division truncates
+ * like the hand written loops did, so results are bit-exact with them.
+ */
+
+/// N point moving average, kept as a running sum
+template <uint32_t N>
+class MovingAverageStage
+{
+    public:
+        static const uint32_t kTaps = N;
+        static const uint32_t kDelay = N - 1;
+
+        MovingAverageStage() { reset(); }
+
+        inline void reset(void)
+        {
+            mSum = 0;
+            mHead = 0;
+            mCount = 0;
+            for (uint32_t i = 0; i < N; i++) {
+                mHist[i] = 0;
+            }
+        }
+
+        inline bool push(int32_t in, int32_t& out)
+        {
+            mSum += in - mHist[mHead];
+            mHist[mHead] = in;
+            mHead = (mHead + 1 == N) ? 0 : (mHead + 1);
+
+            if (mCount < kDelay) {
+                ++mCount;
+                return false;
+            }
+            out = mSum / (int32_t) N;
+            return true;
+        }
+
+    private:
+        int32_t mHist[N];   ///< Last N inputs
+        int32_t mSum;       ///< Sum of mHist
+        uint32_t mHead;     ///< Oldest input of mHist
+        uint32_t mCount;    ///< Inputs seen until the window was full
+};
+
+/// Difference of two consecutive samples (x[n] - x[n-1])
+class DifferenceStage
+{
+    public:
+        static const uint32_t kDelay = 1;
+
+        DifferenceStage() { reset(); }
+
+        inline void reset(void) { mPrev = 0; mPrimed = false; }
+
+        inline bool push(int32_t in, int32_t& out)
+        {
+            const bool ready = mPrimed;
+            out = in - mPrev;
+            mPrev = in;
+            mPrimed = true;
+            return ready;
+        }
+
+    private:
+        int32_t mPrev;      ///< Previous input
+        bool mPrimed;       ///< True once mPrev holds a real sample
+};
+
+/// Sign inversion, used to flip a waveform so that valleys become peaks
+class NegateStage
+{
+    public:
+        static const uint32_t kDelay = 0;
+
+        inline void reset(void) { }
+
+        inline bool push(int32_t in, int32_t& out)
+        {
+            out = -in;
+            return true;
+        }
+};
+
+/// Helper to add the coefficients of FirStage at compile time
+template <int32_t... C> struct FirCoeffSum;
+template <> struct FirCoeffSum<> { static const int32_t value = 0; };
+template <int32_t First, int32_t... Rest> struct FirCoeffSum<First, Rest...>
+{
+    static const int32_t value = First + FirCoeffSum<Rest...>::value;
+};
+
+/**
+ * FIR filter normalized by the sum of its coefficients : out = sum(C[k] * x[n-N+1+k]) / sum(C)
+ * The oldest sample is multiplied by the first coefficient.
+ */
+template <int32_t... C>
+class FirStage
+{
+    public:
+        static const uint32_t kTaps = sizeof...(C);
+        static const uint32_t kDelay = kTaps - 1;
+        static const int32_t kSum = FirCoeffSum<C...>::value;
+
+        FirStage() { reset(); }
+
+        inline void reset(void)
+        {
+            mCount = 0;
+            for (uint32_t i = 0; i < kTaps; i++) {
+                mHist[i] = 0;
+            }
+        }
+
+        inline bool push(int32_t in, int32_t& out)
+        {
+            static const int32_t coeffs[kTaps] = { C... };
+
+            /* Shift register rather than a ring, so every tap has a fixed coefficient */
+            int32_t s = 0;
+            for (uint32_t i = 0; i < kTaps - 1; i++) {
+                mHist[i] = mHist[i + 1];
+                s += mHist[i] * coeffs[i];
+            }
+            mHist[kTaps - 1] = in;
+            s += in * coeffs[kTaps - 1];
+
+            if (mCount < kDelay) {
+                ++mCount;
+                return false;
+            }
+            out = s / kSum;
+            return true;
+        }
+
+    private:
+        int32_t mHist[kTaps];   ///< Last kTaps inputs, oldest first
+        uint32_t mCount;        ///< Inputs seen until the window was full
+};
+/** @} */
+
+
+
+/**
+ * Chain of filter stages that runs them all for every input sample, so each sample
+ * goes through the whole chain while it is still in a register and there is no
+ * intermediate buffer between the stages.
+ *
+ * @code
+ *      typedef FilterChain<MovingAverageStage<4>, DifferenceStage, FirStage<1, 2, 1> > Chain;
+ *      Chain chain;
+ *      int32_t out;
+ *
+ *      for (int i = 0; i < n; i++) {
+ *          if (chain.push(in[i], out)) {
+ *              // out is the output for in[i - Chain::kDelay]
+ *          }
+ *      }
+ * @endcode
+ */
+template <typename... Stages> class FilterChain;
+
+/// Empty chain, passes the input through
+template <>
+class FilterChain<>
+{
+    public:
+        static const uint32_t kDelay = 0;
+
+        inline void reset(void) { }
+
+        inline bool push(int32_t in, int32_t& out)
+        {
+            out = in;
+            return true;
+        }
+};
+
+template <typename First, typename... Rest>
+class FilterChain<First, Rest...>
+{
+    public:
+        static const uint32_t kDelay = First::kDelay + FilterChain<Rest...>::kDelay;
+
+        inline void reset(void)
+        {
+            mFirst.reset();
+            mRest.reset();
+        }
+
+        inline bool push(int32_t in, int32_t& out)
+        {
+            int32_t mid;
+            return mFirst.push(in, mid) && mRest.push(mid, out);
+        }
+
+    private:
+        First mFirst;                   ///< This stage
+        FilterChain<Rest...> mRest;     ///< The stages after this one
+};
+
+
+
+#ifdef TESTING
+#include <assert.h>
+static inline void test_FilterChain(void)
+{
+    const int n = 64;
+    int32_t x[n], ma[n], dx[n], ref[n];
+    uint32_t seed = 1;
+
+    for (int i = 0; i < n; i++) {
+        seed = seed * 1103515245 + 12345;
+        x[i] = (int32_t) ((seed >> 8) % 4000) - 2000;
+    }
+
+    /* Separate passes, as the hand written loops do them */
+    for (int i = 0; i < n - 3; i++) {
+        ma[i] = (x[i] + x[i + 1] + x[i + 2] + x[i + 3]) / 4;
+    }
+    for (int i = 0; i < n - 4; i++) {
+        dx[i] = ma[i + 1] - ma[i];
+    }
+    for (int i = 0; i < n - 5; i++) {
+        dx[i] = (dx[i] + dx[i + 1]) / 2;
+    }
+    for (int i = 0; i < n - 9; i++) {
+        int32_t s = 0;
+        s -= dx[i] * 41 + dx[i + 1] * 276 + dx[i + 2] * 512 + dx[i + 3] * 276 + dx[i + 4] * 41;
+        ref[i] = s / 1146;
+    }
+
+    /* Same filter in one pass */
+    typedef FilterChain<MovingAverageStage<4>, DifferenceStage, MovingAverageStage<2>,
+                        FirStage<41, 276, 512, 276, 41>, NegateStage> Chain;
+    assert(9 == Chain::kDelay);
+    assert(1146 == (FirStage<41, 276, 512, 276, 41>::kSum));
+
+    Chain chain;
+    int outputs = 0;
+    for (int i = 0; i < n; i++) {
+        int32_t out = 0;
+        if (chain.push(x[i], out)) {
+            assert(i - (int) Chain::kDelay == outputs);
+            assert(ref[outputs] == out);
+            ++outputs;
+        }
+    }
+    assert(n - 9 == outputs);
+
+    /* Reset brings the chain back to the same state */
+    chain.reset();
+    int32_t out = 0;
+    for (int i = 0; i < 10; i++) {
+        assert((i >= 9) == chain.push(x[i], out));
+    }
+    assert(ref[0] == out);
+}
+#endif /* #ifdef TESTING */
+
+
+
+#endif /* #ifndef FIR_FILTER_HPP__ */
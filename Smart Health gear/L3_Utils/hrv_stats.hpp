@@ -0,0 +1,311 @@
+/**
+ * @file
+ * @brief Header-only heart rate variability statistics over a rolling window
+ * @ingroup Utilities
+ *
+ * Version: 20261017    Initial
+ */
+#ifndef HRV_STATS_HPP__
+#define HRV_STATS_HPP__
+
+#include <stdint.h>
+
+
+
+/**
+ * Rolling SDNN, RMSSD and pNN50 of beat-to-beat (RR) intervals in fixed memory.
+ *
+ * Intervals are summed into blocks of kBlockMs by the time of the beat that ends
+ * them.  Every block keeps the count, sum and sum of squares of its intervals,
+ * and the sum of squares and NN50 count of the successive differences, so an
+ * interval costs O(1) and the statistics cost O(kBlocks), however long the
+ * window is.  The window is the current block and the blocks before it, so it
+ * moves in steps of kBlockMs.
+ *
+ * Intervals outside kMinRrMs..kMaxRrMs, or that differ from the previous one by
+ * more than kMaxChangePct (a missed or extra beat) are rejected.  No successive
+ * difference is taken across a rejected interval or breakSequence().
+ *
+ * @code
+ *      HrvStats hrv;
+ *      hrv.setWindow(2);                   // 2 minutes
+ *      hrv.addInterval(beat_ms, rr_ms);    // for every beat
+ *
+ *      HrvStats::Result r;
+ *      hrv.compute(r);                     // r.rmssdX10 is RMSSD in tenths of msec
+ * @endcode
+ */
+class HrvStats
+{
+    public:
+        /** @{ Limits */
+        static const uint32_t kBlockMs = 10000;
+        static const uint32_t kMinWindowMin = 1;
+        static const uint32_t kMaxWindowMin = 5;
+        static const uint32_t kBlocks = (kMaxWindowMin * 60000) / kBlockMs;
+        static const uint32_t kMinRrMs = 300;       ///< 200 bpm
+        static const uint32_t kMaxRrMs = 2000;      ///< 30 bpm
+        static const uint32_t kMaxChangePct = 30;
+        static const uint32_t kNn50Ms = 50;
+        /** @} */
+
+        /// Statistics over the window
+        typedef struct {
+            uint32_t intervals;     ///< Number of RR intervals
+            uint32_t meanRr;        ///< Mean RR interval (msec)
+            uint32_t sdnnX10;       ///< Standard deviation of RR (0.1 msec)
+            uint32_t rmssdX10;      ///< Root mean square of successive differences (0.1 msec)
+            uint32_t pnn50X10;      ///< Successive differences above 50 msec (0.1 %)
+        } Result;
+
+        HrvStats() : mWindowBlocks(kBlocks) { reset(); }
+
+        /// Discards all the intervals, the window length is kept
+        inline void reset(void)
+        {
+            for (uint32_t i = 0; i < kBlocks; i++) {
+                clearBlock(mBlocks[i]);
+            }
+            mBlock = 0;
+            mPrevRr = 0;
+            mAccepted = 0;
+            mRejected = 0;
+        }
+
+        /**
+         * Sets the window length.
+         * @returns false if minutes is not kMinWindowMin to kMaxWindowMin
+         */
+        inline bool setWindow(uint32_t minutes)
+        {
+            if (minutes < kMinWindowMin || minutes > kMaxWindowMin) {
+                return false;
+            }
+            mWindowBlocks = (minutes * 60000) / kBlockMs;
+            return true;
+        }
+        inline uint32_t getWindow(void) const { return (mWindowBlocks * kBlockMs) / 60000; }
+
+        /// The next interval does not follow the previous one (ie: sensor restarted)
+        inline void breakSequence(void) { mPrevRr = 0; }
+
+        /**
+         * Adds one RR interval.
+         * @param timeMs  Time of the beat that ends the interval, never going back
+         * @param rrMs    The interval
+         * @returns false if the interval was rejected
+         */
+        inline bool addInterval(uint32_t timeMs, uint32_t rrMs)
+        {
+            advance(timeMs / kBlockMs);
+
+            Block& b = mBlocks[mBlock % kBlocks];
+            const uint32_t diff = (rrMs > mPrevRr) ? (rrMs - mPrevRr) : (mPrevRr - rrMs);
+            if (rrMs < kMinRrMs || rrMs > kMaxRrMs || 0xFF == b.count ||
+                (0 != mPrevRr && diff * 100 > mPrevRr * kMaxChangePct))
+            {
+                mPrevRr = 0;
+                ++mRejected;
+                return false;
+            }
+
+            b.count++;
+            b.sum += rrMs;
+            b.sumSq += rrMs * rrMs;
+            if (0 != mPrevRr) {
+                b.diffs++;
+                b.diffSq += diff * diff;
+                b.nn50 += (diff > kNn50Ms) ? 1 : 0;
+            }
+            if (1 == b.count) {
+                b.firstHasDiff = (0 != mPrevRr);
+                b.firstDiffSq = b.firstHasDiff ? (diff * diff) : 0;
+                b.firstNn50 = b.firstHasDiff && (diff > kNn50Ms);
+            }
+            mPrevRr = rrMs;
+            ++mAccepted;
+            return true;
+        }
+
+        /**
+         * Computes the statistics over the window.
+         * SDNN needs 2 intervals, RMSSD and pNN50 need 1 difference; they are 0 otherwise.
+         */
+        inline void compute(Result& r) const
+        {
+            uint64_t count = 0, sum = 0, sumSq = 0, diffs = 0, diffSq = 0, nn50 = 0;
+            bool first = true;
+
+            const uint32_t blocks = (mWindowBlocks <= mBlock) ? mWindowBlocks : (mBlock + 1);
+            for (uint32_t n = mBlock + 1 - blocks; n <= mBlock; n++) {
+                const Block& b = mBlocks[n % kBlocks];
+                if (0 == b.count) {
+                    continue;
+                }
+                count += b.count;
+                sum += b.sum;
+                sumSq += b.sumSq;
+                diffs += b.diffs;
+                diffSq += b.diffSq;
+                nn50 += b.nn50;
+
+                // The first difference of the window is against an interval outside it
+                if (first && b.firstHasDiff) {
+                    diffs -= 1;
+                    diffSq -= b.firstDiffSq;
+                    nn50 -= b.firstNn50 ? 1 : 0;
+                }
+                first = false;
+            }
+
+            r.intervals = (uint32_t) count;
+            r.meanRr = (count > 0) ? (uint32_t) (sum / count) : 0;
+            r.sdnnX10 = (count > 1) ? isqrt((100 * (count * sumSq - sum * sum)) / (count * (count - 1))) : 0;
+            r.rmssdX10 = (diffs > 0) ? isqrt((100 * diffSq) / diffs) : 0;
+            r.pnn50X10 = (diffs > 0) ? (uint32_t) ((1000 * nn50) / diffs) : 0;
+        }
+
+        /** @{ Intervals taken and rejected since reset() */
+        inline uint32_t getAccepted(void) const { return mAccepted; }
+        inline uint32_t getRejected(void) const { return mRejected; }
+        /** @} */
+
+        /// @returns floor(sqrt(x))
+        static inline uint32_t isqrt(uint64_t x)
+        {
+            uint64_t root = 0;
+            uint64_t bit = (uint64_t) 1 << 62;
+
+            while (bit > x) {
+                bit >>= 2;
+            }
+            while (0 != bit) {
+                if (x >= root + bit) {
+                    x -= root + bit;
+                    root = (root >> 1) + bit;
+                }
+                else {
+                    root >>= 1;
+                }
+                bit >>= 2;
+            }
+            return (uint32_t) root;
+        }
+
+    private:
+        /// Sums of the intervals ending within one kBlockMs (at most 255 of them)
+        typedef struct {
+            uint32_t sum;           ///< Sum of RR
+            uint32_t sumSq;         ///< Sum of RR^2
+            uint32_t diffSq;        ///< Sum of successive differences^2
+            uint32_t firstDiffSq;   ///< Difference^2 of the first interval to its predecessor
+            uint8_t  count;         ///< Number of intervals
+            uint8_t  diffs;         ///< Number of successive differences
+            uint8_t  nn50;          ///< Differences above kNn50Ms
+            bool     firstNn50;     ///< First difference is above kNn50Ms
+            bool     firstHasDiff;  ///< First interval has a difference to its predecessor
+        } Block;
+
+        static inline void clearBlock(Block& b)
+        {
+            b.sum = b.sumSq = b.diffSq = b.firstDiffSq = 0;
+            b.count = b.diffs = b.nn50 = 0;
+            b.firstNn50 = b.firstHasDiff = false;
+        }
+
+        /// Moves the current block up to block number n, clearing the blocks skipped
+        inline void advance(uint32_t n)
+        {
+            if (n <= mBlock) {
+                return;
+            }
+            const uint32_t steps = (n - mBlock < kBlocks) ? (n - mBlock) : kBlocks;
+            for (uint32_t i = 1; i <= steps; i++) {
+                clearBlock(mBlocks[(n - steps + i) % kBlocks]);
+            }
+            mBlock = n;
+        }
+
+        Block mBlocks[kBlocks];     ///< Ring of blocks, block number n is at n % kBlocks
+        uint32_t mBlock;            ///< Number of the current block (time / kBlockMs)
+        uint32_t mWindowBlocks;     ///< Blocks in the window
+        uint32_t mPrevRr;           ///< Last interval taken, 0 after a break
+        uint32_t mAccepted;
+        uint32_t mRejected;
+};
+
+#ifdef TESTING
+#include <assert.h>
+#include <math.h>
+static inline void test_HrvStats(void)
+{
+    const int n = 600;
+    uint32_t timeMs[n], rr[n];
+    bool taken[n], follows[n];
+    uint32_t seed = 7, t = 0, prev = 0;
+
+    /* About 10 minutes of beats around 800 msec, with a few artifacts */
+    HrvStats hrv;
+    for (int i = 0; i < n; i++) {
+        seed = seed * 1103515245 + 12345;
+        rr[i] = 700 + ((seed >> 8) % 200);
+        if (50 == (i % 97)) {
+            rr[i] *= 2;     /* missed beat */
+        }
+        t += rr[i];
+        timeMs[i] = t;
+        follows[i] = (0 != prev);
+        taken[i] = hrv.addInterval(timeMs[i], rr[i]);
+        prev = taken[i] ? rr[i] : 0;
+        if (50 == (i % 97)) {
+            assert(!taken[i]);
+        }
+
+        /* Same statistics computed over the intervals of the window */
+        for (uint32_t w = HrvStats::kMinWindowMin; w <= HrvStats::kMaxWindowMin; w++) {
+            const uint32_t blocks = (w * 60000) / HrvStats::kBlockMs;
+            const uint32_t current = timeMs[i] / HrvStats::kBlockMs;
+            double sum = 0, sumSq = 0, diffSq = 0;
+            uint32_t count = 0, diffs = 0, nn50 = 0;
+            bool inWindow = false;
+            for (int j = 0; j <= i; j++) {
+                if (!taken[j] || timeMs[j] / HrvStats::kBlockMs + blocks <= current) {
+                    continue;
+                }
+                sum += rr[j];
+                sumSq += (double) rr[j] * rr[j];
+                count++;
+                if (inWindow && follows[j]) {
+                    const double d = (double) rr[j] - rr[j - 1];
+                    diffSq += d * d;
+                    diffs++;
+                    nn50 += (fabs(d) > HrvStats::kNn50Ms) ? 1 : 0;
+                }
+                inWindow = true;
+            }
+
+            HrvStats::Result r;
+            assert(hrv.setWindow(w));
+            hrv.compute(r);
+            assert(count == r.intervals);
+            if (count > 1) {
+                const double sd = sqrt((sumSq - sum * sum / count) / (count - 1));
+                assert(fabs(sd * 10 - r.sdnnX10) <= 1.0);
+            }
+            if (diffs > 0) {
+                assert(fabs(sqrt(diffSq / diffs) * 10 - r.rmssdX10) <= 1.0);
+                assert((1000 * nn50) / diffs == r.pnn50X10);
+            }
+            else {
+                assert(0 == r.rmssdX10 && 0 == r.pnn50X10);
+            }
+        }
+    }
+    assert(!hrv.setWindow(0) && !hrv.setWindow(6));
+    assert(5 == HrvStats::isqrt(35) && 6 == HrvStats::isqrt(36));
+}
+#endif /* #ifdef TESTING */
+
+
+
+#endif /* #ifndef HRV_STATS_HPP__ */
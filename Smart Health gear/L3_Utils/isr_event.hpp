@@ -0,0 +1,119 @@
+/**
+ * @file
+ * @brief Provides an ISR to task event with missed event count and wake-up latency histogram
+ *
+ * 20261017 : First version
+ */
+#ifndef ISR_EVENT_HPP_
+#define ISR_EVENT_HPP_
+
+#include <stdint.h>
+
+#include "FreeRTOS.h"
+#include "semphr.h"
+
+
+
+/**
+ * ISR to task event.  The task blocks on wait() and the interrupt wakes it up using
+ * signalFromIsr(), so the task does not need to spin on a volatile flag.
+ *
+ * Every event keeps statistics that can be seen from the terminal ("events" command) :
+ *  - Number of signals from the ISR
+ *  - Number of missed events (ISR signaled again before the task consumed the previous one)
+ *  - Number of wait() timeouts
+ *  - Histogram of the latency between the ISR and the task waking up
+ *
+ * @code
+ *      IsrEvent gSampleReady("sample");
+ *
+ *      void my_isr(void)
+ *      {
+ *          gSampleReady.signalFromIsr();
+ *      }
+ *
+ *      bool run(void *p)
+ *      {
+ *          if (gSampleReady.wait(OS_MS(100))) {
+ *              // Read the sample
+ *          }
+ *      }
+ * @endcode
+ *
+ * @note The events should be global objects since they register themselves to a
+ *       list that is walked by the terminal command, and they are never unregistered.
+ */
+class IsrEvent
+{
+    public:
+        /// Number of latency histogram buckets
+        static const uint8_t kLatencyBuckets = 8;
+
+        /**
+         * Constructor
+         * @param pName  The name to show for this event, must be a string literal or global
+         */
+        IsrEvent(const char *pName);
+
+        /**
+         * Signals the event from an ISR, and yields to the waiting task if needed.
+         * If the previous event was not consumed by the task yet, the missed event
+         * count is incremented.
+         * @returns false if the previous event was not yet consumed
+         */
+        bool signalFromIsr(void);
+
+        /**
+         * Waits for the event.
+         * @param timeout  The time to wait in OS ticks, use OS_MS() to convert from ms
+         * @returns true if the event occurred, or false upon timeout
+         */
+        bool wait(TickType_t timeout = portMAX_DELAY);
+
+        /// @returns the name of this event
+        inline const char* getName(void) const { return mpName; }
+
+        /** @{ Statistics */
+        inline uint32_t getSignalCount(void) const  { return mSignalCount;  }
+        inline uint32_t getMissedCount(void) const  { return mMissedCount;  }
+        inline uint32_t getTimeoutCount(void) const { return mTimeoutCount; }
+        inline uint32_t getMaxLatencyUs(void) const { return mMaxLatencyUs; }
+
+        /**
+         * @returns the number of wake-ups in the given latency bucket.
+         * Bucket N counts latencies less than getBucketLimitUs(N), and the last
+         * bucket counts everything above the previous one.
+         */
+        inline uint32_t getLatencyCount(uint8_t bucket) const
+        { return (bucket < kLatencyBuckets) ? mLatency[bucket] : 0; }
+
+        /// @returns the upper limit of a latency bucket in microseconds
+        static inline uint32_t getBucketLimitUs(uint8_t bucket) { return (16 << bucket); }
+
+        /// Clears all the statistics of this event
+        void resetStats(void);
+        /** @} */
+
+        /** @{ Walk the list of all events */
+        static inline IsrEvent* getFirst(void) { return spFirst; }
+        inline IsrEvent* getNext(void) const { return mpNext; }
+        /** @} */
+
+    private:
+        /// Adds the wake-up latency to the histogram
+        void addLatency(uint32_t us);
+
+        SemaphoreHandle_t mSignal;          ///< Binary semaphore given by the ISR
+        const char *mpName;                 ///< Name of this event
+        volatile uint32_t mSignalTimeUs;    ///< Time of the last signal that was not consumed
+        volatile uint32_t mSignalCount;     ///< Number of signals from the ISR
+        volatile uint32_t mMissedCount;     ///< Number of signals while previous was pending
+        uint32_t mTimeoutCount;             ///< Number of wait() timeouts
+        uint32_t mMaxLatencyUs;             ///< Worst wake-up latency
+        uint32_t mLatency[kLatencyBuckets]; ///< Wake-up latency histogram
+
+        IsrEvent *mpNext;                   ///< Next event of the list
+        static IsrEvent *spFirst;           ///< First event of the list
+};
+
+#endif /* ISR_EVENT_HPP_ */
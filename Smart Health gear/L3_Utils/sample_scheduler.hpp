@@ -0,0 +1,163 @@
+/**
+ * @file
+ * @brief Periodic sampling jobs dispatched from one hardware timer in phase-staggered slots
+ *
+ * 20261017 : First version
+ */
+#ifndef SAMPLE_SCHEDULER_HPP_
+#define SAMPLE_SCHEDULER_HPP_
+
+#include <stdint.h>
+
+#include "FreeRTOS.h"
+#include "semphr.h"
+#include "lpc_timers.h"
+
+
+
+/**
+ * A periodic sampling job.  The sampling task blocks on wait() and the scheduler's
+ * timer interrupt wakes it up in the job's slot : every periodMs, phaseMs after the
+ * start of the period.  Jobs that use the same bus are given different phases so
+ * that their transfers never start in the same slot.
+ *
+ * Every job keeps statistics that can be seen from the terminal ("jobs" command) :
+ *  - Number of slots dispatched and wake-ups
+ *  - Overruns : the slot came again before the task consumed the previous one
+ *  - Latency from the slot to the task waking up, and the jitter (max - min latency)
+ *
+ * @code
+ *      SampleJob gAccelJob("accel", 10, 0);    // 100 Hz, at 0, 10, 20 ... msec
+ *      SampleJob gTempJob("temp", 250, 5);     // 4 Hz, at 5, 255, 505 ... msec
+ *
+ *      bool run(void *p)
+ *      {
+ *          if (gAccelJob.wait(OS_MS(100))) {
+ *              // Read the sample, it was due at gAccelJob.getSlotTimeUs()
+ *          }
+ *      }
+ * @endcode
+ *
+ * @note The jobs should be global objects since they register themselves to a
+ *       list that is walked by the timer interrupt, and they are never unregistered.
+ */
+class SampleJob
+{
+    public:
+        /**
+         * Constructor
+         * @param pName     The name to show for this job, must be a string literal or global
+         * @param periodMs  Time between two samples, in scheduler slots (msec)
+         * @param phaseMs   Slot of the sample within the period, kept below periodMs
+         */
+        SampleJob(const char *pName, uint32_t periodMs, uint32_t phaseMs);
+
+        /**
+         * Waits for the next slot of this job.
+         * @param timeout  The time to wait in OS ticks, use OS_MS() to convert from ms
+         * @returns true if the slot came, or false upon timeout
+         */
+        bool wait(TickType_t timeout = portMAX_DELAY);
+
+        /// @returns the time (uptime in us) of the slot that ended the last wait()
+        inline uint32_t getSlotTimeUs(void) const { return mWokenSlotUs; }
+
+        /**
+         * Changes the period, the phase is kept if it fits in the new period.
+         * The next slot is the next one at phaseMs within the new period.
+         * @returns false if periodMs is 0
+         */
+        bool setPeriod(uint32_t periodMs);
+
+        /** @{ Configuration */
+        inline const char* getName(void) const     { return mpName;     }
+        inline uint32_t getPeriodMs(void) const     { return mPeriodMs;  }
+        inline uint32_t getPhaseMs(void) const      { return mPhaseMs;   }
+        /** @} */
+
+        /** @{ Statistics */
+        inline uint32_t getSlotCount(void) const    { return mSlotCount;    }
+        inline uint32_t getRunCount(void) const     { return mRunCount;     }
+        inline uint32_t getOverrunCount(void) const { return mOverrunCount; }
+        inline uint32_t getTimeoutCount(void) const { return mTimeoutCount; }
+        inline uint32_t getMinLatencyUs(void) const { return mRunCount ? mMinLatencyUs : 0; }
+        inline uint32_t getMaxLatencyUs(void) const { return mMaxLatencyUs; }
+        inline uint32_t getAvgLatencyUs(void) const { return mRunCount ? (uint32_t) (mSumLatencyUs / mRunCount) : 0; }
+        inline uint32_t getJitterUs(void) const     { return getMaxLatencyUs() - getMinLatencyUs(); }
+
+        /// Clears all the statistics of this job
+        void resetStats(void);
+        /** @} */
+
+        /** @{ Walk the list of all jobs */
+        static inline SampleJob* getFirst(void) { return spFirst; }
+        inline SampleJob* getNext(void) const { return mpNext; }
+        /** @} */
+
+    private:
+        friend class SampleScheduler;
+
+        /// Counts down to the job's next slot, and wakes up the task in that slot
+        void dispatchFromIsr(uint32_t nowUs, long *pWoken);
+
+        SemaphoreHandle_t mSignal;          ///< Binary semaphore given by the timer interrupt
+        const char *mpName;                 ///< Name of this job
+        volatile uint32_t mPeriodMs;        ///< Slots between two samples
+        volatile uint32_t mPhaseMs;         ///< Slot within the period
+        volatile uint32_t mCountdownMs;     ///< Slots to go before the next slot of this job
+        volatile uint32_t mSlotUs;          ///< Time of the last slot that was not consumed
+        uint32_t mWokenSlotUs;              ///< Time of the slot that ended the last wait()
+        volatile uint32_t mSlotCount;       ///< Slots dispatched
+        volatile uint32_t mOverrunCount;    ///< Slots dispatched while the previous was pending
+        uint32_t mRunCount;                 ///< Successful wait()
+        uint32_t mTimeoutCount;             ///< wait() timeouts
+        uint32_t mMinLatencyUs;             ///< Best slot to wake-up latency
+        uint32_t mMaxLatencyUs;             ///< Worst slot to wake-up latency
+        uint64_t mSumLatencyUs;             ///< For the average latency
+
+        SampleJob *mpNext;                  ///< Next job of the list
+        static SampleJob *spFirst;          ///< First job of the list
+};
+
+/**
+ * The timer that dispatches all SampleJob objects, one slot every millisecond.
+ *
+ * @code
+ *      SampleScheduler::init(lpc_timer2);
+ *
+ *      extern "C" void TIMER2_IRQHandler()
+ *      {
+ *          SampleScheduler::handleInterrupt();
+ *      }
+ * @endcode
+ */
+class SampleScheduler
+{
+    public:
+        /// Length of one slot
+        static const uint32_t kSlotUs = 1000;
+
+        /**
+         * Starts the timer, the application routes its interrupt to handleInterrupt()
+         * @returns false if already started
+         */
+        static bool init(lpc_timer_t timer);
+
+        /// Clears the timer interrupt and wakes up the jobs due in this slot
+        static void handleInterrupt(void);
+
+        /** @{ Statistics */
+        static uint64_t getSlot(void);
+        static inline uint32_t getMaxIsrUs(void)   { return sMaxIsrUs;   }
+        static inline void resetStats(void)        { sMaxIsrUs = 0;      }
+        /** @} */
+
+    private:
+        friend class SampleJob;
+
+        static LPC_TIM_TypeDef *spTimer;    ///< Timer registers, NULL until init()
+        static volatile uint64_t sSlot;     ///< Slots since init(), the next one to dispatch
+        static volatile uint32_t sMaxIsrUs; ///< Longest handleInterrupt()
+};
+
+#endif /* SAMPLE_SCHEDULER_HPP_ */
@@ -335,6 +335,8 @@ class scheduler_task
          */
         inline void setQueueSetBlockTime(TickType_t t) { mQueueSetBlockTime = t; }
         inline QueueSetHandle_t getQueueSetSelection(void) { return mQueueSetType; }
+        /// @returns the queue set, to select the members that came after getQueueSetSelection()
+        inline QueueSetHandle_t getQueueSet(void) { return mQueueSet; }
         /** @} */
     #endif
 
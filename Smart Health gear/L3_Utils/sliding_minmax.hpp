@@ -0,0 +1,159 @@
+/**
+ * @file
+ * @brief Header-only minimum and maximum over a sliding window of samples
+ * @ingroup Utilities
+ *
+ * Version: 20261017    Initial
+ */
+#ifndef SLIDING_MINMAX_HPP__
+#define SLIDING_MINMAX_HPP__
+
+#include <stdint.h>
+
+
+
+/**
+ * Minimum and maximum of the last N samples, updated one sample at a time.
+ *
+ * Two monotonic queues hold the samples that can still become the minimum
+ * (increasing values) or the maximum (decreasing values) of the window.  A new
+ * sample removes the queued samples it dominates from the back, and the sample
+ * leaving the window is removed from the front, so push() is O(1) amortized
+ * and getMin() / getMax() are O(1), instead of sorting the window.
+ *
+ * For equal values the newest one is kept, which does not change the result.
+ *
+ * @code
+ *      SlidingMinMax<int16_t, 10> x;
+ *      x.push(sample);             // for every sample
+ *      if (x.isFull()) {
+ *          mid = (x.getMin() + x.getMax()) / 2;
+ *      }
+ * @endcode
+ */
+template <typename T, uint32_t N>
+class SlidingMinMax
+{
+    public:
+        static const uint32_t kSize = N;
+
+        SlidingMinMax() { reset(); }
+
+        /// Discards all the samples
+        inline void reset(void)
+        {
+            mCount = 0;
+            mMin.reset();
+            mMax.reset();
+        }
+
+        /// Adds one sample, the oldest one leaves the window once N samples are in
+        inline void push(const T& value)
+        {
+            // mCount is the index of this sample, samples before first leave the window
+            const uint32_t first = (mCount >= N) ? (mCount - N + 1) : 0;
+
+            mMin.dropOlderThan(first);
+            while (!mMin.isEmpty() && !(mMin.back().value < value)) {
+                mMin.popBack();
+            }
+            mMin.pushBack(mCount, value);
+
+            mMax.dropOlderThan(first);
+            while (!mMax.isEmpty() && !(value < mMax.back().value)) {
+                mMax.popBack();
+            }
+            mMax.pushBack(mCount, value);
+
+            ++mCount;
+        }
+
+        /** @{ Extremes of the window, undefined before the first push() */
+        inline const T& getMin(void) const { return mMin.front().value; }
+        inline const T& getMax(void) const { return mMax.front().value; }
+        /** @} */
+
+        /// @returns true once N samples have been pushed
+        inline bool isFull(void) const { return mCount >= N; }
+        /// @returns the samples pushed since reset()
+        inline uint32_t getCount(void) const { return mCount; }
+
+    private:
+        typedef struct {
+            uint32_t index;     ///< Sample number since reset()
+            T value;
+        } Entry;
+
+        /// Ring of at most N entries with sample numbers in increasing order
+        class Queue
+        {
+            public:
+                inline void reset(void) { mHead = 0; mSize = 0; }
+                inline bool isEmpty(void) const { return 0 == mSize; }
+                inline const Entry& front(void) const { return mEntries[mHead]; }
+                inline const Entry& back(void) const { return mEntries[wrap(mHead + mSize - 1)]; }
+                inline void popBack(void) { --mSize; }
+
+                inline void pushBack(uint32_t index, const T& value)
+                {
+                    Entry& e = mEntries[wrap(mHead + mSize)];
+                    e.index = index;
+                    e.value = value;
+                    ++mSize;
+                }
+
+                /// Removes the entries of samples before number first
+                inline void dropOlderThan(uint32_t first)
+                {
+                    while (0 != mSize && mEntries[mHead].index < first) {
+                        mHead = wrap(mHead + 1);
+                        --mSize;
+                    }
+                }
+
+            private:
+                static inline uint32_t wrap(uint32_t i) { return (i >= N) ? (i - N) : i; }
+
+                Entry mEntries[N];
+                uint32_t mHead;     ///< Oldest entry
+                uint32_t mSize;     ///< Entries in use
+        };
+
+        Queue mMin;         ///< Increasing values, the front is the minimum
+        Queue mMax;         ///< Decreasing values, the front is the maximum
+        uint32_t mCount;    ///< Samples pushed since reset()
+};
+
+#ifdef TESTING
+#include <assert.h>
+static inline void test_SlidingMinMax(void)
+{
+    const int n = 500;
+    const uint32_t w = 7;
+    int16_t x[n];
+    uint32_t seed = 11;
+
+    SlidingMinMax<int16_t, w> mm;
+    for (int i = 0; i < n; i++) {
+        seed = seed * 1103515245 + 12345;
+        /* Runs of equal values and long slopes, not only noise */
+        x[i] = (i % 50 < 10) ? 3 : (int16_t) ((seed >> 16) % 64) - 32 + ((i % 100 < 50) ? i % 50 : 50 - i % 50);
+        mm.push(x[i]);
+
+        int16_t lo = x[i], hi = x[i];
+        for (int j = i; j >= 0 && j > i - (int) w; j--) {
+            lo = (x[j] < lo) ? x[j] : lo;
+            hi = (x[j] > hi) ? x[j] : hi;
+        }
+        assert(lo == mm.getMin() && hi == mm.getMax());
+        assert(mm.isFull() == (i + 1 >= (int) w));
+    }
+    mm.reset();
+    mm.push(-5);
+    assert(-5 == mm.getMin() && -5 == mm.getMax() && !mm.isFull());
+}
+#endif /* #ifdef TESTING */
+
+
+
+#endif /* #ifndef SLIDING_MINMAX_HPP__ */
@@ -0,0 +1,83 @@
+#include <string.h>
+
+#include "../isr_event.hpp"
+#include "task.h"
+#include "lpc_sys.h"
+
+
+
+IsrEvent *IsrEvent::spFirst = 0;
+
+IsrEvent::IsrEvent(const char *pName) :
+        mpName(pName),
+        mSignalTimeUs(0),
+        mSignalCount(0),
+        mMissedCount(0),
+        mTimeoutCount(0),
+        mMaxLatencyUs(0),
+        mpNext(spFirst)
+{
+    memset(mLatency, 0, sizeof(mLatency));
+    mSignal = xSemaphoreCreateBinary();
+
+    /// Binary semaphore needs to be taken after creating it
+    xSemaphoreTake(mSignal, 0);
+
+    spFirst = this;
+}
+
+bool IsrEvent::signalFromIsr(void)
+{
+    long higherPriorityTaskWaiting = 0;
+    const uint32_t now = (uint32_t) sys_get_uptime_us();
+
+    ++mSignalCount;
+
+    /* Give fails if the semaphore is still given, which means the task has not
+     * consumed the previous event.  Keep the time of the older event in that case.
+     */
+    if (!xSemaphoreGiveFromISR(mSignal, &higherPriorityTaskWaiting)) {
+        ++mMissedCount;
+        return false;
+    }
+
+    mSignalTimeUs = now;
+    portEND_SWITCHING_ISR(higherPriorityTaskWaiting);
+    return true;
+}
+
+bool IsrEvent::wait(TickType_t timeout)
+{
+    if (!xSemaphoreTake(mSignal, timeout)) {
+        ++mTimeoutCount;
+        return false;
+    }
+
+    addLatency((uint32_t) sys_get_uptime_us() - mSignalTimeUs);
+    return true;
+}
+
+void IsrEvent::resetStats(void)
+{
+    taskENTER_CRITICAL();
+    mSignalCount = 0;
+    mMissedCount = 0;
+    taskEXIT_CRITICAL();
+
+    mTimeoutCount = 0;
+    mMaxLatencyUs = 0;
+    memset(mLatency, 0, sizeof(mLatency));
+}
+
+void IsrEvent::addLatency(uint32_t us)
+{
+    uint8_t bucket = 0;
+    while (bucket < (kLatencyBuckets - 1) && us >= getBucketLimitUs(bucket)) {
+        ++bucket;
+    }
+    ++mLatency[bucket];
+
+    if (us > mMaxLatencyUs) {
+        mMaxLatencyUs = us;
+    }
+}
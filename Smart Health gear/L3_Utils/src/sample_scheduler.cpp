@@ -0,0 +1,152 @@
+#include "../sample_scheduler.hpp"
+#include "task.h"
+#include "lpc_sys.h"
+
+
+
+SampleJob *SampleJob::spFirst = 0;
+LPC_TIM_TypeDef *SampleScheduler::spTimer = 0;
+volatile uint64_t SampleScheduler::sSlot = 0;
+volatile uint32_t SampleScheduler::sMaxIsrUs = 0;
+
+SampleJob::SampleJob(const char *pName, uint32_t periodMs, uint32_t phaseMs) :
+        mpName(pName),
+        mPeriodMs(periodMs ? periodMs : 1),
+        mPhaseMs(phaseMs % (periodMs ? periodMs : 1)),
+        /* Jobs are global objects, built before the timer starts at slot 0 */
+        mCountdownMs(mPhaseMs),
+        mSlotUs(0),
+        mWokenSlotUs(0),
+        mSlotCount(0),
+        mOverrunCount(0),
+        mRunCount(0),
+        mTimeoutCount(0),
+        mMinLatencyUs(0xFFFFFFFF),
+        mMaxLatencyUs(0),
+        mSumLatencyUs(0),
+        mpNext(spFirst)
+{
+    mSignal = xSemaphoreCreateBinary();
+
+    /// Binary semaphore needs to be taken after creating it
+    xSemaphoreTake(mSignal, 0);
+
+    spFirst = this;
+}
+
+bool SampleJob::wait(TickType_t timeout)
+{
+    if (!xSemaphoreTake(mSignal, timeout)) {
+        ++mTimeoutCount;
+        return false;
+    }
+
+    mWokenSlotUs = mSlotUs;
+    const uint32_t us = (uint32_t) sys_get_uptime_us() - mWokenSlotUs;
+    ++mRunCount;
+    mSumLatencyUs += us;
+    if (us < mMinLatencyUs) {
+        mMinLatencyUs = us;
+    }
+    if (us > mMaxLatencyUs) {
+        mMaxLatencyUs = us;
+    }
+    return true;
+}
+
+bool SampleJob::setPeriod(uint32_t periodMs)
+{
+    if (0 == periodMs) {
+        return false;
+    }
+
+    /* The next slot keeps the phase against the slot count, so that the
+     * jobs stay staggered.  The timer interrupt is masked meanwhile.
+     */
+    taskENTER_CRITICAL();
+    mPeriodMs = periodMs;
+    mPhaseMs = mPhaseMs % periodMs;
+    const uint32_t position = (uint32_t) (SampleScheduler::sSlot % periodMs);
+    mCountdownMs = (mPhaseMs + periodMs - position) % periodMs;
+    taskEXIT_CRITICAL();
+    return true;
+}
+
+void SampleJob::resetStats(void)
+{
+    taskENTER_CRITICAL();
+    mSlotCount = 0;
+    mOverrunCount = 0;
+    taskEXIT_CRITICAL();
+
+    mRunCount = 0;
+    mTimeoutCount = 0;
+    mMinLatencyUs = 0xFFFFFFFF;
+    mMaxLatencyUs = 0;
+    mSumLatencyUs = 0;
+}
+
+void SampleJob::dispatchFromIsr(uint32_t nowUs, long *pWoken)
+{
+    /* A countdown instead of (slot % period) : no division in the interrupt,
+     * and no phase shift when a 32-bit slot count would wrap (49.7 days).
+     */
+    if (0 != mCountdownMs) {
+        --mCountdownMs;
+        return;
+    }
+    mCountdownMs = mPeriodMs - 1;
+
+    ++mSlotCount;
+
+    /* Give fails if the semaphore is still given, which means the task has not
+     * consumed the previous slot.  Keep the time of the older slot in that case.
+     */
+    if (!xSemaphoreGiveFromISR(mSignal, pWoken)) {
+        ++mOverrunCount;
+        return;
+    }
+    mSlotUs = nowUs;
+}
+
+bool SampleScheduler::init(lpc_timer_t timer)
+{
+    if (0 != spTimer) {
+        return false;
+    }
+
+    // One timer tick per microsecond, match and reset every slot
+    lpc_timer_enable(timer, 1);
+    spTimer = lpc_timer_get_struct(timer);
+    spTimer->MR0 = kSlotUs;
+    spTimer->MCR = (1 << 0) | (1 << 1);
+    NVIC_EnableIRQ(lpc_timer_get_irq_num(timer));
+    return true;
+}
+
+uint64_t SampleScheduler::getSlot(void)
+{
+    /* Two loads on this core, the interrupt must not come in between */
+    taskENTER_CRITICAL();
+    const uint64_t slot = sSlot;
+    taskEXIT_CRITICAL();
+    return slot;
+}
+
+void SampleScheduler::handleInterrupt(void)
+{
+    long higherPriorityTaskWaiting = 0;
+    const uint32_t now = (uint32_t) sys_get_uptime_us();
+
+    spTimer->IR = (1 << 0);
+    for (SampleJob *job = SampleJob::getFirst(); 0 != job; job = job->getNext()) {
+        job->dispatchFromIsr(now, &higherPriorityTaskWaiting);
+    }
+    ++sSlot;
+
+    const uint32_t us = (uint32_t) sys_get_uptime_us() - now;
+    if (us > sMaxIsrUs) {
+        sMaxIsrUs = us;
+    }
+    portEND_SWITCHING_ISR(higherPriorityTaskWaiting);
+}
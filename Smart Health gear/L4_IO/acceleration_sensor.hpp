@@ -44,6 +44,14 @@ class Acceleration_Sensor : private i2c2_device, public SingletonTemplate<Accele
         int16_t getY();  ///< @returns Y-Axis value
         int16_t getZ();  ///< @returns Z-Axis value
 
+        /**
+         * Reads all three axes in one I2C transaction instead of three
+         * @param xyz   X, Y and Z values, same as getX(), getY() and getZ()
+         * @returns true if successful, xyz is all zeros otherwise
+         * @note The sensor (MMA8452Q) has no sample FIFO, so each call reads the latest sample
+         */
+        bool getXYZ(int16_t xyz[3]);
+
     private:
         /// Private constructor of this Singleton class
        // Acceleration_Sensor() : i2c2_device(I2CAddr_AccelerationSensor)
@@ -56,6 +56,12 @@ protected:
         mI2C.writeReg(mOurAddr, reg, data);
     }
 
+    /// Reads count registers of this device starting from reg, @returns true if successful
+    inline bool readRegisters(unsigned char reg, uint8_t *pData, uint32_t count)
+    {
+        return mI2C.readRegisters(mOurAddr, reg, pData, count);
+    }
+
     /// @returns true if the device responds to its address
     inline bool checkDeviceResponse()
     {
@@ -0,0 +1,61 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+
+/**
+ * @file
+ * @brief MMA8452Q acceleration sensor, on its own so that host tests can build it
+ *        against a simulated I2C bus (see host/accel_burst_test.cpp)
+ */
+
+#include <stdint.h>
+#include "acceleration_sensor.hpp"
+
+
+
+bool Acceleration_Sensor::init()
+{
+    const unsigned char activeModeWith100Hz = (1 << 0) | (3 << 3); // Active Mode @ 100Hz
+
+    writeReg(Ctrl_Reg1, activeModeWith100Hz);
+    const char whoAmIReg = readReg(WhoAmI);
+
+    return (mWhoAmIExpectedValue == whoAmIReg);
+}
+int16_t Acceleration_Sensor::getX()
+{
+    return (int16_t)get16BitRegister(X_MSB) / 16;
+}
+int16_t Acceleration_Sensor::getY()
+{
+    return (int16_t)get16BitRegister(Y_MSB) / 16;
+}
+int16_t Acceleration_Sensor::getZ()
+{
+    return (int16_t)get16BitRegister(Z_MSB) / 16;
+}
+bool Acceleration_Sensor::getXYZ(int16_t xyz[3])
+{
+    // X_MSB to Z_LSB are consecutive, the sensor auto-increments the register address
+    uint8_t buff[6] = {0};
+    const bool ok = readRegisters(X_MSB, &buff[0], sizeof(buff));
+
+    for (int i = 0; i < 3; i++) {
+        xyz[i] = ok ? (int16_t)((buff[2*i] << 8) | buff[2*i + 1]) / 16 : 0;
+    }
+    return ok;
+}
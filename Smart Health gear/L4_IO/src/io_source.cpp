@@ -115,30 +115,6 @@ static const unsigned char LED_DISPLAY_CHARMAP[128] =
 
 
 
-bool Acceleration_Sensor::init()
-{
-    const unsigned char activeModeWith100Hz = (1 << 0) | (3 << 3); // Active Mode @ 100Hz
-
-    writeReg(Ctrl_Reg1, activeModeWith100Hz);
-    const char whoAmIReg = readReg(WhoAmI);
-
-    return (mWhoAmIExpectedValue == whoAmIReg);
-}
-int16_t Acceleration_Sensor::getX()
-{
-    return (int16_t)get16BitRegister(X_MSB) / 16;
-}
-int16_t Acceleration_Sensor::getY()
-{
-    return (int16_t)get16BitRegister(Y_MSB) / 16;
-}
-int16_t Acceleration_Sensor::getZ()
-{
-    return (int16_t)get16BitRegister(Z_MSB) / 16;
-}
-
-
-
 /**
  * The design of the IR Sensor is as follows:
  *  Timer1 captures falling edges of CAP1.0 and timestamps are saved when this happens.
@@ -8,7 +8,17 @@
 #ifndef L5_APPLICATION_THERMISTOR_HPP_
 #define L5_APPLICATION_THERMISTOR_HPP_
 
-static const float resistance_array[241]={277.2, 263.6, 250.1, 236.8, 224, 211.5, 199.6, 188.1, 177.3, 167,
+#include <stdint.h>
+
+// Thermistor resistance (kOhm) from -40 C (index 0) to 200 C (index 240), 1 C apart.
+// The thermistor is the low side of a divider with a 10 kOhm resistor to 3.3V.
+#define THERMISTOR_MIN_C            (-40)
+#define THERMISTOR_POINTS           (241)
+#define THERMISTOR_PULLUP_KOHM      (10.0f)
+// ADC codes of the table are kept with 8 fraction bits
+#define THERMISTOR_CODE_SHIFT       (8)
+
+static constexpr float resistance_array[THERMISTOR_POINTS]={277.2, 263.6, 250.1, 236.8, 224, 211.5, 199.6, 188.1, 177.3, 167,
 		157.2,
 		148.1,
 		139.4,
@@ -241,6 +251,144 @@ static const float resistance_array[241]={277.2, 263.6, 250.1, 236.8, 224, 211.5
 		0.0631,
 		0.0619};
 
+/*----------------------------------------------------------------------------
+Function    :  thermistor_code_q8 ()
+Inputs      :  f_kohm - thermistor resistance
+Processing  :  This function gives the 12-bit ADC code read across the thermistor
+			   at this resistance : code = 4096 * R / (R + 10k)
+Outputs     :  None
+Returns     :  ADC code with THERMISTOR_CODE_SHIFT fraction bits
+Notes       :  Only used at compile time to build thermistor_table
+----------------------------------------------------------------------------*/
+constexpr uint32_t thermistor_code_q8(float f_kohm)
+{
+	return (uint32_t)((4096.0f * (1 << THERMISTOR_CODE_SHIFT) * f_kohm) / (f_kohm + THERMISTOR_PULLUP_KOHM) + 0.5f);
+}
+
+/**
+ * ADC code of every point of resistance_array, built by the compiler.
+ * Codes go down as the temperature goes up.
+ */
+typedef struct {
+	uint32_t aun_code[THERMISTOR_POINTS];
+} thermistor_table_t;
+
+/// @{ Index list 0 .. N-1 used to expand resistance_array at compile time
+template <uint32_t... I> struct thermistor_indexes { };
+template <uint32_t N, uint32_t... I> struct thermistor_make_indexes : thermistor_make_indexes<N - 1, N - 1, I...> { };
+template <uint32_t... I> struct thermistor_make_indexes<0, I...> { typedef thermistor_indexes<I...> type; };
+/// @}
+
+template <uint32_t... I>
+constexpr thermistor_table_t thermistor_make_table(thermistor_indexes<I...>)
+{
+	return thermistor_table_t { { thermistor_code_q8(resistance_array[I])... } };
+}
+
+static constexpr thermistor_table_t thermistor_table =
+		thermistor_make_table(thermistor_make_indexes<THERMISTOR_POINTS>::type());
+
+/*----------------------------------------------------------------------------
+Function    :  thermistor_code_to_centi_celsius ()
+Inputs      :  un_code - ADC code across the thermistor with THERMISTOR_CODE_SHIFT
+			   fraction bits, ie: the average of oversampled readings
+Processing  :  This function binary searches the two table points around the
+			   code and interpolates linearly between them
+Outputs     :  None
+Returns     :  Temperature in 0.01 C, clamped to -40.00 .. 200.00 C
+Notes       :  Integer only, 8 steps of the search
+----------------------------------------------------------------------------*/
+static inline int32_t thermistor_code_to_centi_celsius(uint32_t un_code)
+{
+	const uint32_t *pun_table = thermistor_table.aun_code;
+
+	if(un_code >= pun_table[0])
+		return THERMISTOR_MIN_C * 100;
+	if(un_code <= pun_table[THERMISTOR_POINTS - 1])
+		return (THERMISTOR_MIN_C + THERMISTOR_POINTS - 1) * 100;
+
+	// pun_table[n_low] > un_code >= pun_table[n_high]
+	int32_t n_low = 0, n_high = THERMISTOR_POINTS - 1;
+	while(n_high - n_low > 1)
+	{
+		const int32_t n_mid = (n_low + n_high) / 2;
+		if(pun_table[n_mid] > un_code)
+			n_low = n_mid;
+		else
+			n_high = n_mid;
+	}
+
+	const uint32_t un_span = pun_table[n_low] - pun_table[n_high];
+	const uint32_t un_frac = ((pun_table[n_low] - un_code) * 100 + un_span / 2) / un_span;
+	return (THERMISTOR_MIN_C + n_low) * 100 + (int32_t)un_frac;
+}
+
+/*----------------------------------------------------------------------------
+Function    :  thermistor_adc_to_centi_celsius ()
+Inputs      :  us_code - 12-bit ADC reading across the thermistor
+Processing  :  This function converts one reading with the code table
+Outputs     :  None
+Returns     :  Temperature in 0.01 C, clamped to -40.00 .. 200.00 C
+Notes       :  None
+----------------------------------------------------------------------------*/
+static inline int32_t thermistor_adc_to_centi_celsius(uint16_t us_code)
+{
+	return thermistor_code_to_centi_celsius((uint32_t)us_code << THERMISTOR_CODE_SHIFT);
+}
+
+/*----------------------------------------------------------------------------
+Function    :  thermistor_centi_to_celsius ()
+Inputs      :  n_centi - temperature in 0.01 C
+Processing  :  This function rounds to the nearest degree
+Outputs     :  None
+Returns     :  Temperature in C
+Notes       :  None
+----------------------------------------------------------------------------*/
+static inline int32_t thermistor_centi_to_celsius(int32_t n_centi)
+{
+	return (n_centi >= 0) ? (n_centi + 50) / 100 : -((50 - n_centi) / 100);
+}
+
+#ifdef TESTING
+#include <assert.h>
+#include <math.h>
+static inline void test_thermistor(void)
+{
+	int32_t n_prev = 0x7FFFFFFF;
+	float f_max_error = 0;
+
+	for(uint32_t code = 1; code < 4095; code++)
+	{
+		const int32_t n_centi = thermistor_adc_to_centi_celsius(code);
+
+		// the temperature never goes up with the ADC code
+		assert(n_centi <= n_prev);
+		n_prev = n_centi;
+
+		// reference : float resistance, then the table interpolated on resistance
+		const float f_r = THERMISTOR_PULLUP_KOHM * code / (4096.0f - code);
+		if(f_r > resistance_array[0] || f_r < resistance_array[THERMISTOR_POINTS - 1])
+			continue;
+		int i = 1;
+		while(f_r < resistance_array[i])
+			i++;
+		const float f_r1 = resistance_array[i - 1], f_r2 = resistance_array[i];
+		const float f_ref = (THERMISTOR_MIN_C + i - 1) + (f_r - f_r1) / (f_r2 - f_r1);
+		const float f_error = fabsf(f_ref * 100 - n_centi);
+		if(f_error > f_max_error)
+			f_max_error = f_error;
+	}
 
+	// within 0.02 C of the resistance table from -40 C to 200 C (0.019 C at worst)
+	assert(f_max_error <= 2.0f);
+	assert(2500 == thermistor_adc_to_centi_celsius(2048));
+	assert(-4000 == thermistor_adc_to_centi_celsius(4095));
+	assert(20000 == thermistor_adc_to_centi_celsius(0));
+	// a code half way between two readings lands between their temperatures
+	const int32_t n_half = thermistor_code_to_centi_celsius((2048 << THERMISTOR_CODE_SHIFT) + (1 << (THERMISTOR_CODE_SHIFT - 1)));
+	assert(n_half <= 2500 && n_half >= thermistor_adc_to_centi_celsius(2049));
+	assert(37 == thermistor_centi_to_celsius(3650) && -2 == thermistor_centi_to_celsius(-150));
+}
+#endif /* #ifdef TESTING */
 
 #endif /* L5_APPLICATION_THERMISTOR_HPP_ */
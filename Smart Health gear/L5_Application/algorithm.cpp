@@ -17,17 +17,15 @@ $Revision      : 1.0 $
 /*                       INCLUDE FILES                                      */
 /****************************************************************************/
 #include "algorithm.hpp"
-#include <stdio.h>
-#include "utilities.h"
-#include "display.hpp"
 
 
 /****************************************************************************/
 /*                        VARIABLES AND MACROS                              */
 /****************************************************************************/
-extern volatile bool start;
-QueueHandle_t oxygen_data = NULL;
-QueueHandle_t heart_data  = NULL;
+// No RTOS or board dependency here, so the file also builds on a PC (see host/ppg_replay.cpp)
+static  int32_t an_dx[ BUFFER_SIZE-MA4_SIZE]; // flipped, filtered derivative of ir
+static  int32_t an_x[ BUFFER_SIZE]; //ir, 4 pt MA
+static  int32_t an_y[ BUFFER_SIZE]; //red, 4 pt MA
 
 
 /*----------------------------------------------------------------------------
@@ -53,9 +51,9 @@ void maxim_heart_rate_and_oxygen_saturation(uint32_t *pun_ir_buffer,  int32_t n_
     int32_t k ,n_i_ratio_count;
     int32_t i, s, m, n_exact_ir_valley_locs_count ,n_middle_idx;
     int32_t n_th1, n_npks,n_c_min;
-    int32_t an_ir_valley_locs[15] ;
-    int32_t an_exact_ir_valley_locs[15] ;
-    int32_t an_dx_peak_locs[15] ;
+    int32_t an_ir_valley_locs[PEAK_MAX_CANDIDATES] ;
+    int32_t an_exact_ir_valley_locs[PEAK_MAX_CANDIDATES] ;
+    int32_t an_dx_peak_locs[PEAK_MAX_CANDIDATES] ;
     int32_t n_peak_interval_sum;
 
     int32_t n_y_ac, n_x_ac;
@@ -64,36 +62,34 @@ void maxim_heart_rate_and_oxygen_saturation(uint32_t *pun_ir_buffer,  int32_t n_
     int32_t n_y_dc_max_idx, n_x_dc_max_idx;
     int32_t an_ratio[5],n_ratio_average;
     int32_t n_nume,  n_denom ;
+    int32_t n_ma, n_dx, n_dx2, n_red_ma;
+    MovingAverageStage<MA4_SIZE> ir_ma4, red_ma4;
+    DifferenceStage diff;
+    MovingAverageStage<2> ma2;
+    HammingStage hamm;
+
     // remove DC of ir signal
     un_ir_mean =0;
     for (k=0 ; k<n_ir_buffer_length ; k++ ) un_ir_mean += pun_ir_buffer[k] ;
     un_ir_mean =un_ir_mean/n_ir_buffer_length ;
-    for (k=0 ; k<n_ir_buffer_length ; k++ )  an_x[k] =  pun_ir_buffer[k] - un_ir_mean ;
-
-    // 4 pt Moving Average
-    for(k=0; k< BUFFER_SIZE-MA4_SIZE; k++){
-        n_denom= ( an_x[k]+an_x[k+1]+ an_x[k+2]+ an_x[k+3]);
-        an_x[k]=  n_denom/(int32_t)4;
-    }
-
-    // get difference of smoothed IR signal
-
-    for( k=0; k<BUFFER_SIZE-MA4_SIZE-1;  k++)
-        an_dx[k]= (an_x[k+1]- an_x[k]);
-
-    // 2-pt Moving Average to an_dx
-    for(k=0; k< BUFFER_SIZE-MA4_SIZE-2; k++){
-        an_dx[k] =  ( an_dx[k]+an_dx[k+1])/2 ;
-    }
 
-    // hamming window
-    // flip wave form so that we can detect valley with peak detector
-    for ( i=0 ; i<BUFFER_SIZE-HAMMING_SIZE-MA4_SIZE-2 ;i++){
-        s= 0;
-        for( k=i; k<i+ HAMMING_SIZE ;k++){
-            s -= an_dx[k] *auw_hamm[k-i] ;
-                     }
-        an_dx[i]= s/ (int32_t)1146; // divide by sum of auw_hamm
+    // DC removal, 4 pt MA, difference, 2-pt MA and hamming window in one pass.
+    // Input k gives MA4 index k-3, difference k-4, 2-pt MA k-5 and hamming k-9.
+    // The last HAMMING_SIZE entries of an_dx are left without the hamming window
+    // and the very last one without the 2-pt MA, as the separate passes did.
+    for (k=0 ; k<BUFFER_SIZE-1 ; k++)
+    {
+        if (!ir_ma4.push((int32_t)(pun_ir_buffer[k] - un_ir_mean), n_ma) || !diff.push(n_ma, n_dx))
+            continue;
+        if (k-MA4_SIZE == BUFFER_SIZE-MA4_SIZE-2)
+            an_dx[k-MA4_SIZE] = n_dx;
+        if (!ma2.push(n_dx, n_dx2))
+            continue;
+        if (k-MA4_SIZE-1 >= BUFFER_SIZE-HAMMING_SIZE-MA4_SIZE-2)
+            an_dx[k-MA4_SIZE-1] = n_dx2;
+        // flip wave form so that we can detect valley with peak detector
+        if (hamm.push(n_dx2, s) && k-MA4_SIZE-HAMMING_SIZE < BUFFER_SIZE-HAMMING_SIZE-MA4_SIZE-2)
+            an_dx[k-MA4_SIZE-HAMMING_SIZE] = -s;
     }
 
 
@@ -103,14 +99,14 @@ void maxim_heart_rate_and_oxygen_saturation(uint32_t *pun_ir_buffer,  int32_t n_
     }
     n_th1= n_th1/ ( BUFFER_SIZE-HAMMING_SIZE);
     // peak location is acutally index for sharpest location of raw signal since we flipped the signal
-    maxim_find_peaks( an_dx_peak_locs, &n_npks, an_dx, BUFFER_SIZE-HAMMING_SIZE, n_th1, 8, 5 );//peak_height, peak_distance, max_num_peaks
+    maxim_find_peaks( an_dx_peak_locs, &n_npks, an_dx, BUFFER_SIZE-HAMMING_SIZE, n_th1, PEAK_MIN_DISTANCE, PEAK_MAX_HR_PEAKS );//peak_height, peak_distance, max_num_peaks
 
     n_peak_interval_sum =0;
     if (n_npks>=2){
         for (k=1; k<n_npks; k++)
             n_peak_interval_sum += (an_dx_peak_locs[k]-an_dx_peak_locs[k -1]);
         n_peak_interval_sum=n_peak_interval_sum/(n_npks-1);
-        *pn_heart_rate=(int32_t)(6000/n_peak_interval_sum);// beats per minutes
+        *pn_heart_rate=(int32_t)((FS*60)/n_peak_interval_sum);// beats per minutes
         *pch_hr_valid  = 1;
     }
     else  {
@@ -124,12 +120,8 @@ void maxim_heart_rate_and_oxygen_saturation(uint32_t *pun_ir_buffer,  int32_t n_
 
     // raw value : RED(=y) and IR(=X)
     // we need to assess DC and AC value of ir and red PPG.
-    for (k=0 ; k<n_ir_buffer_length ; k++ )  {
-        an_x[k] =  pun_ir_buffer[k] ;
-        an_y[k] =  pun_red_buffer[k] ;
-    }
 
-    // find precise min near an_ir_valley_locs
+    // find precise min near an_ir_valley_locs (raw ir)
     n_exact_ir_valley_locs_count =0;
     for(k=0 ; k<n_npks ;k++){
         un_only_once =1;
@@ -137,11 +129,11 @@ void maxim_heart_rate_and_oxygen_saturation(uint32_t *pun_ir_buffer,  int32_t n_
         n_c_min= 16777216;//2^24;
         if (m+5 <  BUFFER_SIZE-HAMMING_SIZE  && m-5 >0){
             for(i= m-5;i<m+5; i++)
-                if (an_x[i]<n_c_min){
+                if ((int32_t)pun_ir_buffer[i]<n_c_min){
                     if (un_only_once >0){
                        un_only_once =0;
                    }
-                   n_c_min= an_x[i] ;
+                   n_c_min= pun_ir_buffer[i] ;
                    an_exact_ir_valley_locs[k]=i;
                 }
             if (un_only_once ==0)
@@ -153,10 +145,18 @@ void maxim_heart_rate_and_oxygen_saturation(uint32_t *pun_ir_buffer,  int32_t n_
        *pch_spo2_valid  = 0;
        return;
     }
-    // 4 pt MA
-    for(k=0; k< BUFFER_SIZE-MA4_SIZE; k++){
-        an_x[k]=( an_x[k]+an_x[k+1]+ an_x[k+2]+ an_x[k+3])/(int32_t)4;
-        an_y[k]=( an_y[k]+an_y[k+1]+ an_y[k+2]+ an_y[k+3])/(int32_t)4;
+    // 4 pt MA of ir and red in one pass, the last MA4_SIZE samples stay raw
+    ir_ma4.reset();
+    for(k=0; k< n_ir_buffer_length; k++){
+        an_x[k] = pun_ir_buffer[k];
+        an_y[k] = pun_red_buffer[k];
+        if (k < BUFFER_SIZE-1){
+            ir_ma4.push(pun_ir_buffer[k], n_ma);
+            if (red_ma4.push(pun_red_buffer[k], n_red_ma)){
+                an_x[k-MA4_SIZE+1] = n_ma;
+                an_y[k-MA4_SIZE+1] = n_red_ma;
+            }
+        }
     }
 
     //using an_exact_ir_valley_locs , find ir-red DC andir-red AC for SPO2 calibration ratio
@@ -230,74 +230,17 @@ Processing  :  This function finds at most MAX_NUM peaks above MIN_HEIGHT
 			   separated by at least MIN_DISTANCE
 Outputs     :  None
 Returns     :  None
-Notes       :  None
+Notes       :  pn_locs must hold PEAK_MAX_CANDIDATES entries, see peak_detect.hpp
 ----------------------------------------------------------------------------*/
 void maxim_find_peaks(int32_t *pn_locs, int32_t *pn_npks, int32_t *pn_x, int32_t n_size, int32_t n_min_height, int32_t n_min_distance, int32_t n_max_num)
 {
-    maxim_peaks_above_min_height( pn_locs, pn_npks, pn_x, n_size, n_min_height );
-    maxim_remove_close_peaks( pn_locs, pn_npks, pn_x, n_min_distance );
-    *pn_npks = min( *pn_npks, n_max_num );
-}
-/*----------------------------------------------------------------------------
-Function    :  maxim_peaks_above_min_height ()
-Inputs      :  int32_t *pn_locs, int32_t *pn_npks, int32_t  *pn_x, int32_t n_size, int32_t n_min_height
-Processing  :  This function finds at most MAX_NUM peaks above MIN_HEIGHT
-			   separated by at least MIN_DISTANCE
-Outputs     :  None
-Returns     :  None
-Notes       :  None
-----------------------------------------------------------------------------*/
-void maxim_peaks_above_min_height(int32_t *pn_locs, int32_t *pn_npks, int32_t  *pn_x, int32_t n_size, int32_t n_min_height)
-{
-    int32_t i = 1, n_width;
-    *pn_npks = 0;
-
-    while (i < n_size-1){
-        if (pn_x[i] > n_min_height && pn_x[i] > pn_x[i-1]){            // find left edge of potential peaks
-            n_width = 1;
-            while (i+n_width < n_size && pn_x[i] == pn_x[i+n_width])    // find flat peaks
-                n_width++;
-            if (pn_x[i] > pn_x[i+n_width] && (*pn_npks) < 15 ){                            // find right edge of peaks
-                pn_locs[(*pn_npks)++] = i;
-                // for flat peaks, peak location is left edge
-                i += n_width+1;
-            }
-            else
-                i += n_width;
-        }
-        else
-            i++;
-    }
-}
-
-/*----------------------------------------------------------------------------
-Function    :  maxim_remove_close_peaks ()
-Inputs      :  int32_t *pn_locs, int32_t *pn_npks, int32_t *pn_x, int32_t n_min_distance
-Processing  :  This function Removes peaks separated by less than MIN_DISTANCE
-Outputs     :  None
-Returns     :  None
-Notes       :  None
-----------------------------------------------------------------------------*/
-void maxim_remove_close_peaks(int32_t *pn_locs, int32_t *pn_npks, int32_t *pn_x, int32_t n_min_distance)
-{
-
-    int32_t i, j, n_old_npks, n_dist;
-
-    /* Order peaks from large to small */
-    maxim_sort_indices_descend( pn_x, pn_locs, *pn_npks );
-
-    for ( i = -1; i < *pn_npks; i++ ){
-        n_old_npks = *pn_npks;
-        *pn_npks = i+1;
-        for ( j = i+1; j < n_old_npks; j++ ){
-            n_dist =  pn_locs[j] - ( i == -1 ? -1 : pn_locs[i] ); // lag-zero peak of autocorr is at index -1
-            if ( n_dist > n_min_distance || n_dist < -n_min_distance )
-                pn_locs[(*pn_npks)++] = pn_locs[j];
-        }
-    }
+    int32_t an_heights[PEAK_MAX_CANDIDATES];
+    int32_t an_order[PEAK_MAX_CANDIDATES];
+    uint8_t auch_state[PEAK_MAX_CANDIDATES];
 
-    // Resort indices longo ascending order
-    maxim_sort_ascend( pn_locs, *pn_npks );
+    *pn_npks = peak_find_candidates( pn_x, n_size, n_min_height, pn_locs, an_heights, PEAK_MAX_CANDIDATES );
+    *pn_npks = peak_suppress_close( pn_locs, an_heights, *pn_npks, n_min_distance, an_order, auch_state );
+    *pn_npks = min( *pn_npks, n_max_num );
 }
 
 /*----------------------------------------------------------------------------
@@ -319,25 +262,6 @@ void maxim_sort_ascend(int32_t *pn_x,int32_t n_size)
     }
 }
 
-/*----------------------------------------------------------------------------
-Function    :  maxim_sort_indices_descend ()
-Inputs      :  int32_t *pn_x, int32_t *pn_indx, int32_t n_size
-Processing  :  This function Sort indices according to descending order (insertion sort algorithm)
-Outputs     :  None
-Returns     :  None
-Notes       :  None
-----------------------------------------------------------------------------*/
-void maxim_sort_indices_descend(int32_t *pn_x, int32_t *pn_indx, int32_t n_size)
-{
-    int32_t i, j, n_temp;
-    for (i = 1; i < n_size; i++) {
-        n_temp = pn_indx[i];
-        for (j = i; j > 0 && pn_x[n_temp] > pn_x[pn_indx[j-1]]; j--)
-            pn_indx[j] = pn_indx[j-1];
-        pn_indx[j] = n_temp;
-    }
-}
-
 
 
 
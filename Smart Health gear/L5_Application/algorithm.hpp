@@ -62,10 +62,14 @@
 * ownership rights.
 *******************************************************************************
 */
-#include "LPC17xx.h"
 #ifndef ALGORITHM_H_
 #define ALGORITHM_H_
 
+#include <stdint.h>
+
+#include "fir_filter.hpp"
+#include "peak_detect.hpp"
+
 //#include "eint.h"
 #define true 1
 #define false 0
@@ -88,16 +92,14 @@ const uint8_t uch_spo2_table[184]={ 95, 95, 95, 96, 96, 96, 97, 97, 97, 97, 97,
                             49, 48, 47, 46, 45, 44, 43, 42, 41, 40, 39, 38, 37, 36, 35, 34, 33, 31, 30, 29,
                             28, 27, 26, 25, 23, 22, 21, 20, 19, 17, 16, 15, 14, 12, 11, 10, 9, 7, 6, 5,
                             3, 2, 1 } ;
-static  int32_t an_dx[ BUFFER_SIZE-MA4_SIZE]; // delta
-static  int32_t an_x[ BUFFER_SIZE]; //ir
-static  int32_t an_y[ BUFFER_SIZE]; //red
+// Same taps as auw_hamm, as a filter stage
+typedef FirStage<41, 276, 512, 276, 41> HammingStage;
+// difference of smoothed IR signal, 2-pt MA and hamming window, flipped so that valleys show up as peaks
+typedef FilterChain<DifferenceStage, MovingAverageStage<2>, HammingStage, NegateStage> IrDerivativeChain;
 
 
 void maxim_heart_rate_and_oxygen_saturation(uint32_t *pun_ir_buffer ,  int32_t n_ir_buffer_length, uint32_t *pun_red_buffer ,   int32_t *pn_spo2, int8_t *pch_spo2_valid ,  int32_t *pn_heart_rate , int8_t  *pch_hr_valid);
 void maxim_find_peaks( int32_t *pn_locs, int32_t *pn_npks,  int32_t *pn_x, int32_t n_size, int32_t n_min_height, int32_t n_min_distance, int32_t n_max_num );
-void maxim_peaks_above_min_height( int32_t *pn_locs, int32_t *pn_npks,  int32_t *pn_x, int32_t n_size, int32_t n_min_height );
-void maxim_remove_close_peaks( int32_t *pn_locs, int32_t *pn_npks,   int32_t  *pn_x, int32_t n_min_distance );
 void maxim_sort_ascend( int32_t *pn_x, int32_t n_size );
-void maxim_sort_indices_descend(  int32_t  *pn_x, int32_t *pn_indx, int32_t n_size);
 
 #endif /* ALGORITHM_H_ */
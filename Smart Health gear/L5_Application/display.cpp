@@ -29,6 +29,7 @@ $Revision      : 1.0 $
 #include "lpc_timers.h"
 #include <sstream>
 #include "uart3.hpp"
+#include "sample_scheduler.hpp"
 extern "C"
 {
 	#include "gpio.h"
@@ -43,16 +44,55 @@ using namespace std;
 char buff[50] = {ZERO};
 // acquire the UART3 instance to push the data out over to the Bluetooth Application
 Uart3& uart_3 = Uart3::getInstance();
-// pointer to 100 millisecond pointer
-LPC_TIM_TypeDef *Hundred_millisec_timer_ptr    = NULL;
+// Signaled every 100 msec by the sampling scheduler to update the software timers
+SampleJob hundred_ms_job("display", HUNDRED_MS_PERIOD, HUNDRED_MS_PHASE);
 // Instance of RTC to load the current time.
 rtc_t mytime;
-// Global variable to hold the data acquired through Queues.
-int32_t Queue_data              = ZERO;
 // Display Screens
 volatile screens watch_skins    = clock_screen;
 volatile screens previous_skins = clock_screen;
 
+/******************************** Widgets ************************************/
+// Heart next to the heart rate label while there is a reading, 7 x 6
+static const uint16_t heart_bitmap[6] = {0x36, 0x7F, 0x7F, 0x3E, 0x1C, 0x08};
+
+// Sensor screen : lines, labels, heart and readings
+static BoxWidget sensor_lines[] = {
+	BoxWidget(5,0,1,250,ILI9340_WHITE),   BoxWidget(142,0,1,250,ILI9340_WHITE),
+	BoxWidget(235,0,1,250,ILI9340_WHITE), BoxWidget(5,0,231,1,ILI9340_WHITE),
+	BoxWidget(5,50,231,1,ILI9340_WHITE),  BoxWidget(5,100,231,1,ILI9340_WHITE),
+	BoxWidget(5,150,231,1,ILI9340_WHITE), BoxWidget(5,200,231,1,ILI9340_WHITE),
+	BoxWidget(5,250,231,1,ILI9340_WHITE)
+};
+static TextField sensor_labels[] = {
+	TextField(12,20,2,ILI9340_YELLOW,12,"Heart Rate"),
+	TextField(12,70,2,ILI9340_YELLOW,12,"Blood Oxygen"),
+	TextField(12,120,2,ILI9340_YELLOW,12,"Body Temp"),
+	TextField(12,170,2,ILI9340_YELLOW,12,"step count"),
+	TextField(12,220,2,ILI9340_YELLOW,12,"HRV (ms)")
+};
+static IconWidget heart_icon(118,22,2,ILI9340_RED,heart_bitmap,7,6);
+static NumberField BS_field(148,20,2,ILI9340_YELLOW,8);
+static NumberField OX_field(148,70,2,ILI9340_YELLOW,8);
+static NumberField BT_field(148,120,2,ILI9340_YELLOW,8);
+static NumberField ST_field(148,170,2,ILI9340_YELLOW,8);
+static NumberField HV_field(148,220,2,ILI9340_YELLOW,8);
+static Widget *sensor_list[] = {
+	&sensor_lines[0], &sensor_lines[1], &sensor_lines[2], &sensor_lines[3], &sensor_lines[4],
+	&sensor_lines[5], &sensor_lines[6], &sensor_lines[7], &sensor_lines[8],
+	&sensor_labels[0], &sensor_labels[1], &sensor_labels[2], &sensor_labels[3], &sensor_labels[4],
+	&heart_icon, &BS_field, &OX_field, &BT_field, &ST_field, &HV_field
+};
+static WidgetScreen sensor_widgets(sensor_list, sizeof(sensor_list) / sizeof(sensor_list[0]), ILI9340_BLACK);
+
+// Clock screen : time, date and year, the comma covers the end of the date
+static TextField time_field(40,70,6,ILI9340_CYAN,5);
+static TextField date_field(10,130,3,ILI9340_GREEN,8);
+static TextField comma_field(120,130,3,ILI9340_GREEN,1,",");
+static TextField year_field(150,130,3,ILI9340_MAGENTA,4);
+static Widget *clock_list[] = { &time_field, &date_field, &comma_field, &year_field };
+static WidgetScreen clock_widgets(clock_list, sizeof(clock_list) / sizeof(clock_list[0]), ILI9340_BLACK);
+
 /************************** Semaphores and Mutexs ****************************/
 // Semaphores to signal events to update display clock
 SemaphoreHandle_t triggerOneSecond	           = NULL;
@@ -75,9 +115,12 @@ SemaphoreHandle_t BS_REFRESH	               = NULL;
 SemaphoreHandle_t O2_REFRESH	      		   = NULL;
 SemaphoreHandle_t BT_REFRESH				   = NULL;
 SemaphoreHandle_t ST_REFRESH     			   = NULL;
+SemaphoreHandle_t HV_REFRESH     			   = NULL;
 
 // Mutex for mutual exclusion of LCD Refresh.
 SemaphoreHandle_t screen_change	     		   = NULL;
+// Semaphore to wake up the display task after a screen change
+SemaphoreHandle_t screen_event	     		   = NULL;
 
 /****************************************************************************/
 /*                       FUNCTION DECLARATAIONS                             */
@@ -86,8 +129,6 @@ SemaphoreHandle_t screen_change	     		   = NULL;
 void callback_parameters();
 // Function to update all the software timers every 100 msec
 void Update_timer();
-// Timer 3 Interrupt
-void Timer3_100ms_init(void);
 // Routine to configure Power to drive LCD
 void LCDPower();
 
@@ -117,182 +158,372 @@ Notes       :  None
 ----------------------------------------------------------------------------*/
 display_Task :: display_Task(uint8_t priority) :scheduler_task("display", 10240, priority)
 {
-
-	SSP0_power(ON);
-	// clear the settings
-	LPC_SC->PCLKSEL1 &= ~(0b11<<10);
-	// set PCLK = CLK
-	LPC_SC->PCLKSEL1 |= (0b01<<10);
-	// SCK1
-	GPIOSetMode(0,15,FUNC3);
-	// MISO
-	GPIOSetMode(0,17,FUNC3);
-	// MOSI
-	GPIOSetMode(0,18,FUNC3);
-	// SCK speed = CPU / 2 = 24 Mhz
-    LPC_SSP0->CPSR = 2;
-	// set the data transfer to 8 bits.
-	LPC_SSP0->CR0  =   0b0111;
-	// Turn on SSP module
-	SSP0_enable();
-	// CS
-	GPIOSetDir(0,29,OUTPUT);
-	// RESET
-	GPIOSetDir(0,30,OUTPUT);
-	// DC/RS
-	GPIOSetDir(1,19,OUTPUT);
-	// LED pin
-	GPIOSetDir(1,28,OUTPUT);
-	// Turn on the power to LED driver circuit
-	GPIOSetValue(1,28,1);
+	initSpi();
 }
 /*----------------------------------------------------------------------------
 Function    :  display_Task (run)
 Inputs      :  None
-Processing  :  This function is run function for the display_Task. It de-queues
-			   data from sensor queues, maintains the display state and refreshes
-			   the display to display current time and sensor values.
+Processing  :  This function is run function for the display_Task. The scheduler
+			   wakes it up when any member of its queue set has something : a
+			   sensor reading, an RR interval or HRV, a refresh signal, the second
+			   tick or a screen change. Everything that is already waiting is taken
+			   before the screen is refreshed, so a burst of events costs one
+			   refresh and one BT frame.
 Outputs     :  None
 Returns     :  None
-Notes       :  None
+Notes       :  Members are only taken after they are selected from the set
 ----------------------------------------------------------------------------*/
 bool display_Task::run(void* p)
 {
+	bool b_second = false;
+	uint32_t un_burst = 0;
 
-	// Display initial  sensor values ( All 0's)
-	xSemaphoreGive(BS_REFRESH);
-	xSemaphoreGive(O2_REFRESH);
-	xSemaphoreGive(BT_REFRESH);
-	xSemaphoreGive(ST_REFRESH);
+	for(QueueSetMemberHandle_t member = getQueueSetSelection(); member != NULL;
+		member = xQueueSelectFromSet(getQueueSet(), 0))
+	{
+		un_burst++;
+		// if a second has elapsed, the clock is checked once for the burst
+		if(member == triggerOneSecond)
+		{
+			xSemaphoreTake(triggerOneSecond,0);
+			b_second = true;
+		}
+		else
+		{
+			takeEvent(member);
+		}
+	}
+	wakeups++;
+	events += un_burst;
+	max_burst = (un_burst > max_burst) ? un_burst : max_burst;
 
+	 // Check if the task has right to change the screen
+	 if(xSemaphoreTake(screen_change,portMAX_DELAY))
+	 {
+		switch(watch_skins)
+		{
+		  // Screen has to be changed to Clock screen
+		  case clock_screen:
+			 if(previous_skins == sensor_screen )
+			{
+				 // Store the Previous screen state
+				 previous_skins = clock_screen;
+				 // Clear sensor Screen to display black background
+				 if(retained)
+				 {
+					 clearScrn();
+					 clock_widgets.invalidate();
+				 }
+				 else
+				 {
+					 clearScrn1();
+				 }
+				 // Display clock Screen
+				 displayScrn2();
+			}
+			// if a second has elapsed,check whether minutes, hours,
+			// days, months or years have changed along with it
+			if(b_second)
+			{
+				minute_check();
+			}
+			// Year has changed
+			if(xSemaphoreTake(triggerOneYear,0))
+			{
+				event = YEAR_EVENT;
+				displayScrn2();
+			}
+			// Month has changed
+			else if( xSemaphoreTake(triggerOneMonth,0))
+			{
+				event = MONTH_EVENT;
+				displayScrn2();
+			}
+			// Day has changed
+			else if( xSemaphoreTake(triggerOneDay,0))
+			{
+				event = DAY_EVENT;
+				displayScrn2();
+			}
+			// Hour has changed
+			else if( xSemaphoreTake(triggerOneHour,0))
+			{
+				event = HOUR_EVENT;
+				displayScrn2();
+			}
+			// Minute has changed
+			else if( xSemaphoreTake(triggerOneMin,0))
+			{
+				event = MINUTE_EVENT;
+				displayScrn2();
+			}
+			else if(retained)
+			{
+				// Repaint the damage of 'lcdbench' or a mode change
+				paintWidgets(clock_widgets);
+			}
+			break;
 
-	while(1)
-	{
-			 // Check if the task has right to change the screen
-			 if(xSemaphoreTake(screen_change,100))
-			 {
-				switch(watch_skins)
+			// Screen has to be changed to sensor screen
+		case sensor_screen:
+			if(previous_skins == clock_screen )
+			{
+				// Clear Watch Screen to display black background
+				if(retained)
 				{
-				  // Screen has to be changed to Clock screen
-				  case clock_screen:
-					 if(previous_skins == sensor_screen )
-					{
-						 // Store the Previous screen state
-						 previous_skins = clock_screen;
-						 // Clear sensor Screen to display black background
-						 clearScrn1();
-						 // Display clock Screen
-						 displayScrn2();
-					}
-					// if a second has elapsed,check whether minutes, hours,
-					// days, months or years have changed along with it
-					if( xSemaphoreTake(triggerOneSecond,0))
-					{
-						minute_check();
-					}
-					// Year has changed
-					if(xSemaphoreTake(triggerOneYear,0))
-					{
-						event = YEAR_EVENT;
-						displayScrn2();
-					}
-					// Month has changed
-					else if( xSemaphoreTake(triggerOneMonth,0))
-					{
-						event = MONTH_EVENT;
-						displayScrn2();
-					}
-					// Day has changed
-					else if( xSemaphoreTake(triggerOneDay,0))
-					{
-						event = DAY_EVENT;
-						displayScrn2();
-					}
-					// Hour has changed
-					else if( xSemaphoreTake(triggerOneHour,0))
-					{
-						event = HOUR_EVENT;
-						displayScrn2();
-					}
-					// Minute has changed
-					else if( xSemaphoreTake(triggerOneMin,0))
-					{
-						event = MINUTE_EVENT;
-						displayScrn2();
-					}
-					break;
-
-					// Screen has to be changed to sensor screen
-				case sensor_screen:
-					if(previous_skins == clock_screen )
-					{
-						// Clear Watch Screen to display black background
-						clearScrn2();
-						// Store the Previous screen state
-						previous_skins = sensor_screen;
-					}
-					// Display sensor Screen
-					displayScrn1();
-					 break;
-					 // Future implementation
-				case warning_screen:
-					break;
+					clearScrn();
+					sensor_widgets.invalidate();
 				}
-				// Release lock
-				xSemaphoreGive(screen_change);
-
-			// if Heart rate value has changed
-			if(xQueueReceive(heart_data,&Queue_data,100))
-			{
-				// Update the value
-				if(BS != Queue_data)
+				else
 				{
-					BS = Queue_data;
-					// Signal to update it on next refresh
-					xSemaphoreGive(BS_REFRESH);
+					clearScrn2();
 				}
+				// Store the Previous screen state
+				previous_skins = sensor_screen;
 			}
-			// if Oxygen value has changed
-			if(xQueueReceive(oxygen_data,&Queue_data,100))
+			// Display sensor Screen
+			displayScrn1();
+			 break;
+			 // Future implementation
+		case warning_screen:
+			break;
+		}
+		// Readings are only timed to the sensor screen, the clock does not show them
+		addLatency();
+		// Release lock
+		xSemaphoreGive(screen_change);
+	}
+
+	// Push the data out over Uart- HC05 for android application
+	sendVitals();
+	return 1;
+}
+/*----------------------------------------------------------------------------
+Function    :  takeEvent()
+Inputs      :  member - queue or semaphore selected from the queue set
+Processing  :  This function takes one item of the member : readings update the
+			   values and the fields to refresh, RR intervals and HRV go out over
+			   BT, the refresh signals of the button task mark their fields.
+Outputs     :  None
+Returns     :  None
+Notes       :  A screen change only wakes up the task
+----------------------------------------------------------------------------*/
+void display_Task::takeEvent(QueueSetMemberHandle_t member)
+{
+	static SemaphoreHandle_t *refresh_signals[] = {
+		&BS_REFRESH, &O2_REFRESH, &BT_REFRESH, &ST_REFRESH, &HV_REFRESH
+	};
+	rr_event_t rr_event;
+	hrv_t hrv_event;
+
+	if(member == heart_data)
+	{
+		takeReading(heart_data, BS, FIELD_BS);
+	}
+	else if(member == oxygen_data)
+	{
+		takeReading(oxygen_data, OX, FIELD_OX);
+	}
+	else if(member == temp_data)
+	{
+		takeReading(temp_data, BT, FIELD_BT);
+	}
+	else if(member == step_data)
+	{
+		takeReading(step_data, ST, FIELD_ST);
+	}
+	// Every RR interval is streamed in a VLINK_RR frame, or as "$time+rr+valid+~"
+	else if(member == rr_data)
+	{
+		if(!xQueueReceive(rr_data,&rr_event,0))
+		{
+			// nothing
+		}
+		else if(bt_binary)
+		{
+			sendFrame(bt_encoder.encodeRr(rr_event.un_time_ms, rr_event.us_rr_ms, rr_event.uch_valid, bt_frame));
+		}
+		else
+		{
+			bt_bytes += uart_3.printf("$%u+%4u+%u+~",(unsigned)rr_event.un_time_ms,
+					(unsigned)rr_event.us_rr_ms,(unsigned)rr_event.uch_valid);
+		}
+	}
+	// if HRV has been updated (once per beat)
+	else if(member == hrv_data)
+	{
+		if(xQueueReceive(hrv_data,&hrv_event,0))
+		{
+			// Only RMSSD is displayed
+			if(HV.us_rmssd_x10 / 10 != hrv_event.us_rmssd_x10 / 10)
 			{
-				// Update the value
-				if(OX != Queue_data)
-				{
-					OX = Queue_data;
-					// Signal to update it on next refresh
-					xSemaphoreGive(O2_REFRESH);
-				}
+				refresh |= (1 << FIELD_HV);
 			}
-			// if Temperature value has changed
-			if(xQueueReceive(temp_data,&Queue_data,50))
+			HV = hrv_event;
+			// "%sdnn+rmssd+pnn50+window+~", in 0.1 msec / 0.1 % and minutes, the binary
+			// records carry them with the other vitals
+			if(!bt_binary)
 			{
-				// Update the value
-				if(BT != Queue_data)
-				{
-					BT = Queue_data;
-					// Signal to update it on next refresh
-					xSemaphoreGive(BT_REFRESH);
-				}
+				bt_bytes += uart_3.printf("%%%5u+%5u+%4u+%u+~",(unsigned)HV.us_sdnn_x10,
+						(unsigned)HV.us_rmssd_x10,(unsigned)HV.us_pnn50_x10,(unsigned)HV.uch_window_min);
 			}
-			// if Number of steps has changed
-			if(xQueueReceive(step_data,&Queue_data,100))
+		}
+	}
+	else if(member == screen_event)
+	{
+		xSemaphoreTake(screen_event,0);
+	}
+	else
+	{
+		for(uint8_t f = 0; f < sizeof(refresh_signals) / sizeof(refresh_signals[0]); f++)
+		{
+			if(member == *refresh_signals[f] && xSemaphoreTake(*refresh_signals[f],0))
 			{
-				// Update the value
-				if(ST != Queue_data)
-				{
-					ST = Queue_data;
-					// Signal to update it on next refresh
-					xSemaphoreGive(ST_REFRESH);
-				}
+				refresh |= (1 << f);
 			}
+		}
+	}
+}
+/*----------------------------------------------------------------------------
+Function    :  takeReading()
+Inputs      :  queue    - sensor queue selected from the queue set
+			   uch_field - field of the sensor screen showing it
+Processing  :  This function takes the reading and keeps its sample time until
+			   the field is painted. A reading that replaces one not painted yet
+			   is counted as coalesced.
+Outputs     :  value - value shown on the field
+Returns     :  None
+Notes       :  An unchanged value is not repainted and not timed
+----------------------------------------------------------------------------*/
+void display_Task::takeReading(QueueHandle_t queue, int32_t &value, uint8_t uch_field)
+{
+	reading_t reading;
+	if(!xQueueReceive(queue,&reading,0) || value == reading.n_value)
+	{
+		return;
+	}
+	if(reading_us[uch_field])
+	{
+		coalesced++;
+	}
+	value = reading.n_value;
+	reading_us[uch_field] = reading.un_time_us ? reading.un_time_us : 1;
+	// Signal to update it on next refresh
+	refresh |= (1 << uch_field);
+}
+/*----------------------------------------------------------------------------
+Function    :  addLatency()
+Inputs      :  None
+Processing  :  This function waits for the pixels in flight and adds the time
+			   from the sample to now of every reading painted on the sensor screen
+Outputs     :  None
+Returns     :  None
+Notes       :  Readings taken while the clock is shown are dropped from the statistics
+----------------------------------------------------------------------------*/
+void display_Task::addLatency(void)
+{
+	const bool b_shown = (sensor_screen == watch_skins);
+	if(b_shown)
+	{
+		waitPixels();
+	}
+	const uint32_t un_now_us = (uint32_t)sys_get_uptime_us();
 
-			// Push the data out over Uart- HC05 for android application
-			uart_3.printf("#%3d+%3d+%3d+%4d+~",BS, OX, BT, ST);
-			// Sleep for 100 ticks so that lower priority tasks can run
-			vTaskDelay(100);
+	for(uint8_t f = 0; f < FIELD_READINGS; f++)
+	{
+		if(b_shown && reading_us[f])
+		{
+			const uint32_t un_us = un_now_us - reading_us[f];
+			latency_count++;
+			latency_sum_us += un_us;
+			latency_min_us = (un_us < latency_min_us) ? un_us : latency_min_us;
+			latency_max_us = (un_us > latency_max_us) ? un_us : latency_max_us;
 		}
+		reading_us[f] = 0;
 	}
-	return 1;
+}
+
+void display_Task::resetLatency(void)
+{
+	latency_count = 0;
+	latency_min_us = 0xFFFFFFFF;
+	latency_max_us = 0;
+	latency_sum_us = 0;
+	wakeups = 0;
+	events = 0;
+	max_burst = 0;
+	coalesced = 0;
+}
+/*----------------------------------------------------------------------------
+Function    :  sendVitals()
+Inputs      :  None
+Processing  :  This function adds the vitals to the encoder, which sends a
+			   record only if a value changed or a keyframe is due, and ends the
+			   batch once its window has elapsed. It keeps the history, serves a
+			   history request of the phone one frame per wake-up, and sends the
+			   ASCII frame instead in ASCII mode.
+Outputs     :  None
+Returns     :  None
+Notes       :  The task wakes up at least every second, a batch window ends on
+			   the first wake-up after it
+----------------------------------------------------------------------------*/
+void display_Task::sendVitals(void)
+{
+	const uint32_t un_now_ms = (uint32_t)sys_get_uptime_ms();
+	vitals_t vitals;
+	vitals.an_value[VLINK_HEART_RATE] = BS;
+	vitals.an_value[VLINK_OXYGEN]     = OX;
+	vitals.an_value[VLINK_BODY_TEMP]  = BT;
+	vitals.an_value[VLINK_STEPS]      = ST;
+	vitals.an_value[VLINK_RMSSD_X10]  = HV.us_rmssd_x10;
+	vitals.an_value[VLINK_SDNN_X10]   = HV.us_sdnn_x10;
+	vitals.an_value[VLINK_PNN50_X10]  = HV.us_pnn50_x10;
+	bt_history.add(vitals, un_now_ms);
+
+	if(!bt_binary)
+	{
+		bt_bytes += uart_3.printf("#%3d+%3d+%3d+%4d+~",BS, OX, BT, ST);
+		return;
+	}
+
+	// History request of the phone
+	uint8_t auc_rx[16];
+	uint32_t un_rx;
+	while(0 != (un_rx = uart_3.read(auc_rx, sizeof(auc_rx), 0)))
+	{
+		for(uint32_t i = 0; i < un_rx; i++)
+		{
+			if(bt_decoder.feed(auc_rx[i]) && VLINK_HISTORY_REQUEST == bt_decoder.getType())
+			{
+				bt_history_next = 0;
+			}
+		}
+	}
+
+	sendFrame(bt_encoder.addVitals(vitals, un_now_ms, bt_frame));
+	if(bt_encoder.flushDue(un_now_ms))
+	{
+		sendFrame(bt_encoder.flush(un_now_ms, bt_frame));
+	}
+
+	// One history frame per wake-up, so that the screen is not held up
+	const uint32_t un_len = bt_encoder.encodeHistory(bt_history, bt_history_next, bt_frame);
+	if(un_len)
+	{
+		sendFrame(un_len);
+		xSemaphoreGive(screen_event);
+	}
+}
+
+void display_Task::sendFrame(uint32_t un_len)
+{
+	bt_bytes += uart_3.write(bt_frame, un_len);
+}
+
+void display_Task::requestHistory(void)
+{
+	bt_history_next = 0;
+	xSemaphoreGive(screen_event);
 }
 /*----------------------------------------------------------------------------
 Function    :  button_Task (constructor)
@@ -303,7 +534,7 @@ Outputs     :  None
 Returns     :  None
 Notes       :  None
 ----------------------------------------------------------------------------*/
-button_Task :: button_Task(uint8_t priority) :scheduler_task("display", 1024, priority)
+button_Task :: button_Task(uint8_t priority) :scheduler_task("button", 1024, priority)
 {
 	   // Configure the interrupt for navigation Button to display Sensor Screen
 	  eint3_enable_port2(5,eint_rising_edge,callback_parameters);
@@ -328,7 +559,9 @@ bool button_Task :: init()
 /*----------------------------------------------------------------------------
 Function    :  button_Task (run)
 Inputs      :  None
-Processing  :  This function creates is a run function for button tasks
+Processing  :  This function creates is a run function for button tasks. It sleeps
+			   until the 100 msec scheduler slot, updates the software timers and
+			   then handles the button and screen timeout events.
 Outputs     :  None
 Returns     :  None
 Notes       :  None
@@ -337,6 +570,12 @@ bool button_Task :: run(void *p)
 {
 	while(1)
 	{
+		// Sleep until the next 100 msec tick
+		if(hundred_ms_job.wait(OS_MS(HUNDRED_MS_TIMEOUT)))
+		{
+			// update timers
+			Update_timer();
+		}
 
 		// Has Sensor screen button pressed?
 		if(xSemaphoreTake(sensor_debounce,0))
@@ -355,10 +594,9 @@ bool button_Task :: run(void *p)
 				xSemaphoreGive(O2_REFRESH);
 				xSemaphoreGive(BT_REFRESH);
 				xSemaphoreGive(ST_REFRESH);
+				xSemaphoreGive(HV_REFRESH);
 				// Release the Lock
 				xSemaphoreGive(screen_change);
-				// Sleep so that RTOS can schedule another sensor task.
-				vTaskDelay(100);
 			}
 		}
 		// Screen time has occurred?
@@ -372,16 +610,11 @@ bool button_Task :: run(void *p)
 				watch_skins = clock_screen;
 				// Release the Lock
 				xSemaphoreGive(screen_change);
-				// Sleep so that RTOS can schedule another sensor task.
-				vTaskDelay(100);
+				// Wake up the display to draw the clock
+				xSemaphoreGive(screen_event);
 			}
 
 		}
-		else
-		{
-			// No events, Sleep
-			vTaskDelay(200);
-		}
 	}
 
 	return 1;
@@ -569,6 +802,7 @@ bool display_Task::init(void)
 
 	  // Make the background black
 	  clearScrn();
+	  clock_widgets.invalidate();
 	  // Display Clock at the begining of the product.
 	  displayScrn2();
 
@@ -593,24 +827,37 @@ bool display_Task::init(void)
 
 	 // Create a Mutex to provide mutually exclusive access to LCD refresh
 	 screen_change     = xSemaphoreCreateMutex();
+	 // Create a binary semaphore to wake up the display after a screen change
+	 screen_event      = xSemaphoreCreateBinary();
 
 	 // Create a binary semaphores to signal sensor parameters display refresh
 	 BS_REFRESH        = xSemaphoreCreateBinary();
 	 O2_REFRESH        = xSemaphoreCreateBinary();
 	 BT_REFRESH        = xSemaphoreCreateBinary();
 	 ST_REFRESH        = xSemaphoreCreateBinary();
-
-	 // Create a Queue of depth 1 to get data from Oxymeter sensor
-	 oxygen_data = xQueueCreate(1,sizeof(int32_t));
-	 // Create a Queue of depth 1 to get data from Heart rate sensor
-	 heart_data  = xQueueCreate(1,sizeof(int32_t));
-	 // Create a Queue of depth 1 to get data from Body Temperature sensor
-	 temp_data   = xQueueCreate(1,sizeof(int32_t));
-	 // Create a Queue of depth 1 to get data from Accelerometer sensor
-	 step_data	 = xQueueCreate(1,sizeof(int32_t));
-
-	 // Initialize 100ms timer
-	 Timer3_100ms_init();
+	 HV_REFRESH        = xSemaphoreCreateBinary();
+
+	 // Create a Queue to get data from Oxymeter sensor
+	 oxygen_data = xQueueCreate(READING_QUEUE_DEPTH,sizeof(reading_t));
+	 // Create a Queue to get data from Heart rate sensor
+	 heart_data  = xQueueCreate(READING_QUEUE_DEPTH,sizeof(reading_t));
+	 // Create a Queue to get data from Body Temperature sensor
+	 temp_data   = xQueueCreate(READING_QUEUE_DEPTH,sizeof(reading_t));
+	 // Create a Queue to get data from Accelerometer sensor
+	 step_data	 = xQueueCreate(READING_QUEUE_DEPTH,sizeof(reading_t));
+	 // Create a Queue for the RR intervals of the heart rate task
+	 rr_data	 = xQueueCreate(RR_QUEUE_DEPTH,sizeof(rr_event_t));
+	 // Create a Queue for the HRV, updated on every beat
+	 hrv_data	 = xQueueCreate(READING_QUEUE_DEPTH,sizeof(hrv_t));
+
+	 // The task sleeps until any of these has something, all of them are empty here.
+	 // FreeRTOS 8.1 posts to the set again when a full queue is overwritten, so
+	 // the members are sent to without xQueueOverwrite().
+	 initQueueSet(DISPLAY_SET_LENGTH, 13,
+			 	  heart_data, oxygen_data, temp_data, step_data, hrv_data, rr_data,
+			 	  BS_REFRESH, O2_REFRESH, BT_REFRESH, ST_REFRESH, HV_REFRESH,
+			 	  triggerOneSecond, screen_event);
+	 setQueueSetBlockTime(portMAX_DELAY);
 
 	 // Get the current time from RTC
 	 minute = rtc_getmin();
@@ -625,170 +872,6 @@ bool display_Task::init(void)
      return 1;
 }
 
-/*----------------------------------------------------------------------------
-Function    :  clearminute()
-Inputs      :  None
-Processing  :  This function clears minute field
-Outputs     :  None
-Returns     :  None
-Notes       :  None
-----------------------------------------------------------------------------*/
-void display_Task::clearminute(void)
-{
-	fillRect(130,70,70,47,ILI9340_BLACK);
-}
-/*----------------------------------------------------------------------------
-Function    :  clearhour()
-Inputs      :  None
-Processing  :  This function clears hours field
-Outputs     :  None
-Returns     :  None
-Notes       :  None
-----------------------------------------------------------------------------*/
-void display_Task::clearhour(void)
-{
-	fillRect(40,70,160,47,ILI9340_BLACK);
-}
-/*----------------------------------------------------------------------------
-Function    :  clearday()
-Inputs      :  None
-Processing  :  This function clears days field
-Outputs     :  None
-Returns     :  None
-Notes       :  None
-----------------------------------------------------------------------------*/
-void display_Task::clearday(void)
-{
-	fillRect(85,130,40,25,ILI9340_BLACK);
-	clearhour();
-}
-/*----------------------------------------------------------------------------
-Function    :  clearmonth()
-Inputs      :  None
-Processing  :  This function clears months field
-Outputs     :  None
-Returns     :  None
-Notes       :  None
-----------------------------------------------------------------------------*/
-void display_Task::clearmonth(void)
-{
-	fillRect(10,130,110,25,ILI9340_BLACK);
-	clearhour();
-}
-/*----------------------------------------------------------------------------
-Function    :  clearscrn1()
-Inputs      :  None
-Processing  :  This function clears sensor screen
-Outputs     :  None
-Returns     :  None
-Notes       :  None
-----------------------------------------------------------------------------*/
-void display_Task::clearScrn1(void)
-{
-	drawFastVLine(5,0,200,ILI9340_BLACK);
-	drawFastVLine(142,0,200,ILI9340_BLACK);
-	drawFastVLine(235,0,200,ILI9340_BLACK);
-
-	drawFastHLine(5,0,231,ILI9340_BLACK);
-	drawFastHLine(5,50,231,ILI9340_BLACK);
-	drawFastHLine(5,100,231,ILI9340_BLACK);
-	drawFastHLine(5,150,231,ILI9340_BLACK);
-	drawFastHLine(5,200,231,ILI9340_BLACK);
-	drawString("Heart Rate",12,20,2,ILI9340_BLACK);
-	drawString("Blood Oxygen",12,70,2,ILI9340_BLACK);
-	drawString("Body Temp",12,120,2,ILI9340_BLACK);
-	drawString("step count",12,170,2,ILI9340_BLACK);
-	// Clear the readings
-	fillRect(148,20,235,190,ILI9340_BLACK);
-
-}
-/*----------------------------------------------------------------------------
-Function    :  clearscrn2()
-Inputs      :  None
-Processing  :  This function clears entire screen
-Outputs     :  None
-Returns     :  None
-Notes       :  None
-----------------------------------------------------------------------------*/
-void display_Task::clearScrn2(void)
-{
-	fillRect(25,70,200,85,ILI9340_BLACK);
-}
-/*----------------------------------------------------------------------------
-Function    :  clearOX()
-Inputs      :  None
-Processing  :  This function clears Oxygen parameters
-Outputs     :  None
-Returns     :  None
-Notes       :  None
-----------------------------------------------------------------------------*/
-void display_Task::clearOX(void)
-{
-	fillRect(145,55,86,35,ILI9340_BLACK);
-}
-/*----------------------------------------------------------------------------
-Function    :  clearBS()
-Inputs      :  None
-Processing  :  This function clears Bits per second parameters
-Outputs     :  None
-Returns     :  None
-Notes       :  None
-----------------------------------------------------------------------------*/
-void display_Task::clearBS(void)
-{
-	fillRect(145,15,86,35,ILI9340_BLACK);
-}
-/*----------------------------------------------------------------------------
-Function    :  clearBT()
-Inputs      :  None
-Processing  :  This function clears Body Temperature parameters
-Outputs     :  None
-Returns     :  None
-Notes       :  None
-----------------------------------------------------------------------------*/
-void display_Task::clearBT(void)
-{
-	fillRect(145,105,86,35,ILI9340_BLACK);
-}
-/*----------------------------------------------------------------------------
-Function    :  clearST()
-Inputs      :  None
-Processing  :  This function clears Step parameters
-Outputs     :  None
-Returns     :  None
-Notes       :  None
-----------------------------------------------------------------------------*/
-void display_Task::clearST(void)
-{
-	fillRect(145,165,86,35,ILI9340_BLACK);
-}
-/*----------------------------------------------------------------------------
-Function    :  clearScrn()
-Inputs      :  None
-Processing  :  This function clears entire the screen
-Outputs     :  None
-Returns     :  None
-Notes       :  None
-----------------------------------------------------------------------------*/
-void display_Task::clearScrn(void)
-{
-	fillRect(0,0,240,320,ILI9340_BLACK);
-}
-/*----------------------------------------------------------------------------
-Function    :  clearScrn3()
-Inputs      :  None
-Processing  :  This function clears Step parameters
-Outputs     :  None
-Returns     :  None
-Notes       :  None
-----------------------------------------------------------------------------*/
-void display_Task::clearScrn3(void)
-{
-	drawTriangle(120,10,240,190,10,190,ILI9340_BLACK);
-	drawString("!",110,50,4,ILI9340_BLACK);
-	drawString("ALERT",90,90,3,ILI9340_BLACK);
-	fillRect(75,125,115,55,ILI9340_BLACK);
-}
 /*----------------------------------------------------------------------------
 Function    :  displayScrn3()
 Inputs      :  None
@@ -814,24 +897,38 @@ Notes       :  None
 ----------------------------------------------------------------------------*/
 void display_Task::displayScrn1(void)
 {
+	// The fields compare the readings with what they show, the refresh mask is not needed
+	if(retained)
+	{
+		refresh = 0;
+		BS_field.setValue(BS);
+		OX_field.setValue(OX);
+		BT_field.setValue(BT);
+		ST_field.setValue(ST);
+		HV_field.setValue(HV.us_rmssd_x10 / 10);
+		heart_icon.setVisible(BS > 0);
+		paintWidgets(sensor_widgets);
+		return;
+	}
 
-
-	drawFastVLine(5,0,200,ILI9340_WHITE);
-	drawFastVLine(142,0,200,ILI9340_WHITE);
-	drawFastVLine(235,0,200,ILI9340_WHITE);
+	drawFastVLine(5,0,250,ILI9340_WHITE);
+	drawFastVLine(142,0,250,ILI9340_WHITE);
+	drawFastVLine(235,0,250,ILI9340_WHITE);
 
 	drawFastHLine(5,0,231,ILI9340_WHITE);
 	drawFastHLine(5,50,231,ILI9340_WHITE);
 	drawFastHLine(5,100,231,ILI9340_WHITE);
 	drawFastHLine(5,150,231,ILI9340_WHITE);
 	drawFastHLine(5,200,231,ILI9340_WHITE);
+	drawFastHLine(5,250,231,ILI9340_WHITE);
 	drawString("Heart Rate",12,20,2,ILI9340_YELLOW);
 	drawString("Blood Oxygen",12,70,2,ILI9340_YELLOW);
 	drawString("Body Temp",12,120,2,ILI9340_YELLOW);
 	drawString("step count",12,170,2,ILI9340_YELLOW);
+	drawString("HRV (ms)",12,220,2,ILI9340_YELLOW);
 
 	// Is there any change in BPS?
-	if(xSemaphoreTake(BS_REFRESH,50))
+	if(refresh & (1 << FIELD_BS))
 	{
 		itoa(BS,buff,10);
 		clearBS();
@@ -839,7 +936,7 @@ void display_Task::displayScrn1(void)
 	}
 
 	// Is there any change in Oxygen?
-	if(xSemaphoreTake(O2_REFRESH,50))
+	if(refresh & (1 << FIELD_OX))
 	{
 		itoa(OX,buff,10);
 		clearOX();
@@ -847,19 +944,27 @@ void display_Task::displayScrn1(void)
 	}
 
 	// Is there any change in Body Temp?
-	if(xSemaphoreTake(BT_REFRESH,50))
+	if(refresh & (1 << FIELD_BT))
 	{
 		itoa(BT,buff,10);
 		clearBT();
 		drawString(buff,148,120,2,ILI9340_YELLOW);
 	}
 	// Is there any change in Steps?
-	if(xSemaphoreTake(ST_REFRESH,50))
+	if(refresh & (1 << FIELD_ST))
 	{
 		itoa(ST,buff,10);
 		clearST();
 		drawString(buff,148,170,2,ILI9340_YELLOW);
 	}
+	// Is there any change in HRV (RMSSD)?
+	if(refresh & (1 << FIELD_HV))
+	{
+		itoa(HV.us_rmssd_x10 / 10,buff,10);
+		clearHV();
+		drawString(buff,148,220,2,ILI9340_YELLOW);
+	}
+	refresh = 0;
 }
 /*----------------------------------------------------------------------------
 Function    :  displayScrn2()
@@ -871,6 +976,15 @@ Notes       :  None
 ----------------------------------------------------------------------------*/
 void display_Task::displayScrn2(void)
 {
+	// Only the characters that changed are repainted
+	if(retained)
+	{
+		time_field.setText(trim(rtc_get_date_time_str(),12,17));
+		date_field.setText(trim(rtc_get_date_time_str(),4,12));
+		year_field.setText(trim(rtc_get_date_time_str(),21,25));
+		paintWidgets(clock_widgets);
+		return;
+	}
 
 	switch(event)
 	{
@@ -1023,53 +1137,6 @@ void Update_timer()
  	}
 
 }
-/*----------------------------------------------------------------------------
-Function    :  Timer3_100ms_init()
-Inputs      :  None
-Processing  :  This function updates software timers, de-bounce timers
-Outputs     :  None
-Returns     :  None
-Notes       :  None
-----------------------------------------------------------------------------*/
-void Timer3_100ms_init(void)
-{
-	 	 const lpc_timer_t hundred_ms_timer_source = (lpc_timer_t) Hundered_ms_timer;
-	 	 // set timer resolution for 100 micro-second
-	     const uint32_t Thousand_micro_second = 1000;
-	     // Initialize the timer structure pointer
-	     Hundred_millisec_timer_ptr = lpc_timer_get_struct(hundred_ms_timer_source);
-	     // enable the timer for a precision of one milli second to increment TC count
-	     lpc_timer_enable(hundred_ms_timer_source, Thousand_micro_second);
-	     // Stop on Interrupt , No auto re-start
-	     Hundred_millisec_timer_ptr->MCR = 0b11;
-	     //  timeout is 100msec
-	     Hundred_millisec_timer_ptr->MR0 = 100;
-	     // enable LPC timer
-	     lpc_timer_enable(hundred_ms_timer_source, Thousand_micro_second);
-	     // Get the IRQ number for timer interrupt
-	     const IRQn_Type timer_irq = lpc_timer_get_irq_num(hundred_ms_timer_source);
-	     // Enable timer interrupt
-	     NVIC_EnableIRQ(timer_irq);
-}
-/*----------------------------------------------------------------------------
-Function    :  TIMER3_IRQHandler()
-Inputs      :  None
-Processing  :  This function is ISR for timer 3 interrupt, it calls update timers
-Outputs     :  None
-Returns     :  None
-Notes       :  None
-----------------------------------------------------------------------------*/
-extern "C"
-{
-	void TIMER3_IRQHandler()
-	{
-		// clear the interrupt
-		Hundred_millisec_timer_ptr->IR =0b1;
-		// update timers
-		Update_timer();
-	}
-}
-
 /*----------------------------------------------------------------------------
 Function    :  UART3_init()
 Inputs      :  None
@@ -1081,169 +1148,9 @@ Notes       :  None
 void display_Task :: UART3_init(void)
 {
 	 // Set UART3 Baudrate to 9600
-	 uart_3.init(9600);
+	 uart_3.init(9600, 32, 64, SYS_CFG_UART3_DMA);
 }
 
-/*----------------------------------------------------------------------------
-Function    :  UART3_init()
-Inputs      :  None
-Processing  :  This function Powers on SSP0 interface
-Outputs     :  None
-Returns     :  None
-Notes       :  None
-----------------------------------------------------------------------------*/
-void display_Task::SSP0_power(uint8_t mode)
-{
-	if(mode)
-	{
-		LPC_SC->PCONP |= (mode<<21);
-	}
-	else
-	{
-		LPC_SC->PCONP &= ~(mode<<21);
-	}
-}
-/*----------------------------------------------------------------------------
-Function    :  SSP0_byte_transfer()
-Inputs      :  uint8_t send_byte
-Processing  :  This function Powers on SSP0 interface
-Outputs     :  None
-Returns     :  None
-Notes       :  None
-----------------------------------------------------------------------------*/
-uint8_t display_Task::SSP0_byte_transfer (uint8_t send_byte)
-{
-
-	while (SSP0_TXfull());
-    LPC_SSP0->DR = send_byte;
-
-    while(SSP0_busy());
-
-    return LPC_SSP0->DR;
-
-}
-/*----------------------------------------------------------------------------
-Function    :  SSP0_enable()
-Inputs      :  None
-Processing  :  This function Enables SSP0 interface
-Outputs     :  None
-Returns     :  None
-Notes       :  None
-----------------------------------------------------------------------------*/
-void display_Task::SSP0_enable  (void)
-{
-	LPC_SSP0->CR1 |=   (0b1   << 1);
-}
-/*----------------------------------------------------------------------------
-Function    :  SSP0_disable()
-Inputs      :  None
-Processing  :  This function Disables SSP0 interface
-Outputs     :  None
-Returns     :  None
-Notes       :  None
-----------------------------------------------------------------------------*/
-void display_Task::SSP0_disable (void)
-{
-	LPC_SSP0->CR1 &=  ~(0b1   << 1);
-}
-/*----------------------------------------------------------------------------
-Function    :  SSP0_TXfull()
-Inputs      :  None
-Processing  :  This function checks whether the transmit queue is full?
-Outputs     :  None
-Returns     :  True, if busy, False if not full
-Notes       :  None
-----------------------------------------------------------------------------*/
-bool display_Task::SSP0_TXfull(void)
-{
-	uint32_t mask = (0b1<<1);
-	bool return_val = !(LPC_SSP0->SR & mask);
-	return (return_val);
-}
-/*----------------------------------------------------------------------------
-Function    :  SSP0_busy()
-Inputs      :  None
-Processing  :  This function checks whether the SSP interface is busy
-Outputs     :  None
-Returns     :  True, if busy, False if not full
-Notes       :  None
-----------------------------------------------------------------------------*/
-bool display_Task::SSP0_busy(void)
-{
-	return (((LPC_SSP0->SR ) & (0b01 << 4)));
-}
-/*----------------------------------------------------------------------------
-Function    :  display_CS_assert()
-Inputs      :  None
-Processing  :  This function asserts CS
-Outputs     :  None
-Returns     :  None
-Notes       :  None
-----------------------------------------------------------------------------*/
-void display_Task::display_CS_assert(void)
-{
-	GPIOSetValue(0,29,HIGH);
-}
-/*----------------------------------------------------------------------------
-Function    :  display_CS_dessert()
-Inputs      :  None
-Processing  :  This function desserts CS
-Outputs     :  None
-Returns     :  None
-Notes       :  None
-----------------------------------------------------------------------------*/
-void display_Task::display_CS_dessert(void)
-{
-	GPIOSetValue(0,29,LOW);
-}
-/*----------------------------------------------------------------------------
-Function    :  display_RST_assert()
-Inputs      :  None
-Processing  :  This function asserts RST
-Outputs     :  None
-Returns     :  None
-Notes       :  None
-----------------------------------------------------------------------------*/
-void display_Task::display_RST_assert(void)
-{
-	GPIOSetValue(0,30,HIGH);
-}
-/*----------------------------------------------------------------------------
-Function    :  display_RST_dessert()
-Inputs      :  None
-Processing  :  This function desserts RST
-Outputs     :  None
-Returns     :  None
-Notes       :  None
-----------------------------------------------------------------------------*/
-void display_Task::display_RST_dessert(void)
-{
-	GPIOSetValue(0,30,LOW);
-}
-/*----------------------------------------------------------------------------
-Function    :  display_DC_assert()
-Inputs      :  None
-Processing  :  This function makes D/C High
-Outputs     :  None
-Returns     :  None
-Notes       :  None
-----------------------------------------------------------------------------*/
-void display_Task::display_DC_assert(void)
-{
-	GPIOSetValue(1,19,HIGH);
-}
-/*----------------------------------------------------------------------------
-Function    :  display_DC_dessert()
-Inputs      :  None
-Processing  :  This function makes D/C low
-Outputs     :  None
-Returns     :  None
-Notes       :  None
-----------------------------------------------------------------------------*/
-void display_Task::display_DC_dessert(void)
-{
-	GPIOSetValue(1,19,LOW);
-}
 
 /*----------------------------------------------------------------------------
 Function    :  reverse()
@@ -1314,205 +1221,44 @@ Notes       :  code sample taken from http://www.geeksforgeeks.org
      return str;
  }
 
- /****************************************************************************/
- /*                      ADA FRUIT GFX Library for ILI9430                   */
- /****************************************************************************/
 
-void display_Task::setAddrWindow(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1)
+void display_Task::paintWidgets(WidgetScreen &screen)
 {
+    widget_rect_t r;
 
-  writecommand(ILI9340_CASET); // Column addr set
-  writedata(x0 >> 8);
-  writedata(x0 & 0xFF);     // XSTART
-  writedata(x1 >> 8);
-  writedata(x1 & 0xFF);     // XEND
-
-  writecommand(ILI9340_PASET); // Row addr set
-  writedata(y0>>8);
-  writedata(y0);     // YSTART
-  writedata(y1>>8);
-  writedata(y1);     // YEND
-
-  writecommand(ILI9340_RAMWR); // write to RAM
-}
-
-void display_Task::drawPixel(int16_t x, int16_t y, uint16_t color)
-{
-
-	  if((x < 0) ||(x >= 240) || (y < 0) || (y >= 320)) return;
-
-	  setAddrWindow(x,y,x+1,y+1);
-
-	  //digitalWrite(_dc, HIGH);
-	  display_DC_assert();
-	  //digitalWrite(_cs, LOW);
-	  display_CS_dessert();
-
-	  SSP0_byte_transfer(color >> 8);
-	  SSP0_byte_transfer(color);
-
-	  //digitalWrite(_cs, HIGH);
-	  display_CS_assert();
-	//  printf("pixel executed \n");
-}
-
-int display_Task::drawChar(int16_t x, int16_t y, unsigned char c,
-		  uint16_t color, uint16_t bg, uint8_t size)
-{
-
-//		    if(!gfxFont) { // 'Classic' built-in font
-
-		        if((x >= _width)            || // Clip right
-		           (y >= _height)           || // Clip bottom
-		           ((x + 6 * size - 1) < 0) || // Clip left
-		           ((y + 8 * size - 1) < 0))   // Clip top
-		            return 1;
-
-		        if((c >= 176)) c++; // Handle 'classic' charset behavior
-
-		    //    startWrite();
-		        for(int8_t i=0; i<5; i++ ) { // Char bitmap = 5 columns
-		            uint8_t line = pgm_read_byte(&font[c * 5 + i]);
-		            for(int8_t j=0; j<8; j++, line >>= 1) {
-		                if(line & 1) {
-		                    if(size == 1)
-		                    	drawPixel(x+i, y+j, color);
-		                    else
-		                        writeFillRect(x+i*size, y+j*size, size, size, color);
-		                } else if(bg != color) {
-		                    if(size == 1)
-		                    	drawPixel(x+i, y+j, bg);
-		                    else
-		                        writeFillRect(x+i*size, y+j*size, size, size, bg);
-		                }
-		            }
-		        }
-		        if(bg != color) { // If opaque, draw vertical line for last column
-		            if(size == 1) writeFastVLine(x+5, y, 8, bg);
-		            else          writeFillRect(x+5*size, y, size, 8*size, bg);
-		        }
-
-		        return((5.0+0.4)*size);
-		  //      endWrite();
-}
-
-void display_Task::writeFillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
-{
-
-    // Overwrite in subclasses if desired!
-    fillRect(x,y,w,h,color);
-
-}
-
-
-void display_Task::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
-{
-    for (int16_t i=x; i<x+w; i++) {
-        writeFastVLine(i, y, h, color);
-    }
-
-}
-
-
-void display_Task::writeFastVLine(int16_t x, int16_t y,
-        int16_t h, uint16_t color)
-{
-	drawFastVLine(x, y, h, color);
-
-}
-
-void display_Task::drawFastVLine(int16_t x, int16_t y,
-        int16_t h, uint16_t color)
-{
-	writeLine(x, y, x, y+h-1, color);
-}
-
-void display_Task::drawFastHLine(int16_t x, int16_t y,
-        int16_t h, uint16_t color)
-{
-	writeLine(x, y, x+h-1, y, color);
-}
-
-void display_Task::writeLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1,
-        uint16_t color) {
-    int16_t steep = abs(y1 - y0) > abs(x1 - x0);
-    if (steep) {
-        _swap_int16_t(x0, y0);
-        _swap_int16_t(x1, y1);
-    }
-
-    if (x0 > x1) {
-        _swap_int16_t(x0, x1);
-        _swap_int16_t(y0, y1);
-    }
-
-    int16_t dx, dy;
-    dx = x1 - x0;
-    dy = abs(y1 - y0);
-
-    int16_t err = dx / 2;
-    int16_t ystep;
-
-    if (y0 < y1) {
-        ystep = 1;
-    } else {
-        ystep = -1;
-    }
-
-    for (; x0<=x1; x0++) {
-        if (steep) {
-        	drawPixel(y0, x0, color);
-        } else {
-        	drawPixel(x0, y0, color);
-        }
-        err -= dy;
-        if (err < 0) {
-            y0 += ystep;
-            err += dx;
+    // The strips alternate over all rectangles, the last one of the previous paint may be in flight
+    waitPixels();
+    for(int16_t i = 0; screen.popDamage(r); )
+    {
+        const int16_t strip_rows = TEXT_STRIP_PIXELS / r.w;
+        for(int16_t y = 0; y < r.h; y += strip_rows, i ^= 1)
+        {
+            const int16_t rows = (r.h - y < strip_rows) ? (r.h - y) : strip_rows;
+            const widget_rect_t s = { r.x, (int16_t) (r.y + y), r.w, rows };
+            screen.render(s, strip[i], text);
+            drawPixels(s.x, s.y, s.w, s.h, strip[i]);
         }
     }
 }
 
-
-void display_Task::drawString(const char *string, int poX, int poY, int size,uint16_t color)
+void display_Task::setRetained(bool enable)
 {
-    int sumX = 0;
-
-    while(*string)
+    // The screen was drawn without the widgets, they repaint all of it
+    if(enable && !retained)
     {
-        int xPlus = drawChar(poX, poY, *string,color, ILI9340_BLACK,  size);
-        sumX += xPlus;
-        *string++;
-        poX += xPlus;
+        redrawScreen();
     }
-
+    retained = enable;
 }
-void  display_Task::writecommand(uint8_t command_byte)
-{
-	// DC- low
-	display_DC_dessert();
-	//CS- low
-	display_CS_dessert();
-	// SSP exchange
-    SSP0_byte_transfer(command_byte);
-	//CS- HIGH
-	display_CS_assert();
 
-}
-void  display_Task::writedata(uint8_t data_byte)
+void display_Task::redrawScreen(void)
 {
-
-	// DC- HIGH
-	display_DC_assert();
-	//CS- low
-	display_CS_dessert();
-	// SSP exchange
-	SSP0_byte_transfer(data_byte);
-	//CS- HIGH
-	display_CS_assert();
-
+    ((sensor_screen == watch_skins) ? sensor_widgets : clock_widgets).invalidate();
+    // The display task repaints them when it wakes up
+    xSemaphoreGive(screen_event);
 }
 
+
 char * trim(char * str,uint8_t start, uint8_t end)
 {
 
@@ -1534,28 +1280,6 @@ char * trim(char * str,uint8_t start, uint8_t end)
 
 }
 
-void display_Task::drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1,
-        uint16_t color)
-{
-    // Update in subclasses if desired!
-    if(x0 == x1){
-        if(y0 > y1) _swap_int16_t(y0, y1);
-        drawFastVLine(x0, y0, y1 - y0 + 1, color);
-    } else if(y0 == y1){
-        if(x0 > x1) _swap_int16_t(x0, x1);
-        drawFastHLine(x0, y0, x1 - x0 + 1, color);
-    } else {
-
-        writeLine(x0, y0, x1, y1, color);
-
-    }
-}
-void display_Task::drawTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint16_t color)
-{
-    drawLine(x0, y0, x1, y1, color);
-    drawLine(x1, y1, x2, y2, color);
-    drawLine(x2, y2, x0, y0, color);
-}
 
 /*===================================================================
 // $Log: $1.0 AVD:Added comments to increase the readability
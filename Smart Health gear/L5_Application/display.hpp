@@ -18,6 +18,10 @@ $Revision      : 1.0 $
 #include "scheduler_task.hpp"
 #include "FreeRTOS.h"
 #include "queue.h"
+#include "semphr.h"
+#include "lcd_screen.hpp"
+#include "widgets.hpp"
+#include "vitals_link.hpp"
 #include "task.h"
 #include "stdint.h"
 #include <stdio.h>
@@ -25,8 +29,28 @@ $Revision      : 1.0 $
 /****************************************************************************/
 /*                        MACRO Definitions                                 */
 /****************************************************************************/
-// Timer for 1ms timeout
-#define  Hundered_ms_timer    (3)
+// Software timers tick every 100 msec, in slot 7 of the sampling scheduler so the
+// display wake-up does not land on the accelerometer or temperature slots
+#define  HUNDRED_MS_PERIOD    (100)
+#define  HUNDRED_MS_PHASE     (7)
+// A missed tick is noticed after 200 msec
+#define  HUNDRED_MS_TIMEOUT   (200)
+// Sensor readings waiting for the display, the latest of a burst is shown
+#define  READING_QUEUE_DEPTH  (4)
+// RR intervals waiting for the BT link (about 3 beats/sec at most)
+#define  RR_QUEUE_DEPTH       (8)
+// Semaphores of the display queue set : the refresh signals, the second and the screen change
+#define  DISPLAY_SEMAPHORES   (7)
+// The display queue set holds one handle for every item of its members
+#define  DISPLAY_SET_LENGTH   (5 * READING_QUEUE_DEPTH + RR_QUEUE_DEPTH + DISPLAY_SEMAPHORES)
+// Fields of the sensor screen, bits of the refresh mask
+#define  FIELD_BS             (0)
+#define  FIELD_OX             (1)
+#define  FIELD_BT             (2)
+#define  FIELD_ST             (3)
+#define  FIELD_HV             (4)
+#define  FIELD_READINGS       (4)
+#define  FIELD_ALL            (0x1F)
 // Standard Definitions
 #define SET 	         (1)
 #define RESET            (0)
@@ -42,352 +66,38 @@ $Revision      : 1.0 $
 #define DAY_EVENT	     (2)
 #define HOUR_EVENT	     (1)
 #define MINUTE_EVENT     (0)
-#define pgm_read_byte(addr) (*(const unsigned char *)(addr))
-#define _swap_int16_t(a, b) { int16_t t = a; a = b; b = t; }
 
-/************************** ILI9340 GFX Library ************************/
-/************************* Standard ASCII 5x7 font ********************/
-static const unsigned char font[]  =
-{
-	0x00, 0x00, 0x00, 0x00, 0x00,
-	0x3E, 0x5B, 0x4F, 0x5B, 0x3E,
-	0x3E, 0x6B, 0x4F, 0x6B, 0x3E,
-	0x1C, 0x3E, 0x7C, 0x3E, 0x1C,
-	0x18, 0x3C, 0x7E, 0x3C, 0x18,
-	0x1C, 0x57, 0x7D, 0x57, 0x1C,
-	0x1C, 0x5E, 0x7F, 0x5E, 0x1C,
-	0x00, 0x18, 0x3C, 0x18, 0x00,
-	0xFF, 0xE7, 0xC3, 0xE7, 0xFF,
-	0x00, 0x18, 0x24, 0x18, 0x00,
-	0xFF, 0xE7, 0xDB, 0xE7, 0xFF,
-	0x30, 0x48, 0x3A, 0x06, 0x0E,
-	0x26, 0x29, 0x79, 0x29, 0x26,
-	0x40, 0x7F, 0x05, 0x05, 0x07,
-	0x40, 0x7F, 0x05, 0x25, 0x3F,
-	0x5A, 0x3C, 0xE7, 0x3C, 0x5A,
-	0x7F, 0x3E, 0x1C, 0x1C, 0x08,
-	0x08, 0x1C, 0x1C, 0x3E, 0x7F,
-	0x14, 0x22, 0x7F, 0x22, 0x14,
-	0x5F, 0x5F, 0x00, 0x5F, 0x5F,
-	0x06, 0x09, 0x7F, 0x01, 0x7F,
-	0x00, 0x66, 0x89, 0x95, 0x6A,
-	0x60, 0x60, 0x60, 0x60, 0x60,
-	0x94, 0xA2, 0xFF, 0xA2, 0x94,
-	0x08, 0x04, 0x7E, 0x04, 0x08,
-	0x10, 0x20, 0x7E, 0x20, 0x10,
-	0x08, 0x08, 0x2A, 0x1C, 0x08,
-	0x08, 0x1C, 0x2A, 0x08, 0x08,
-	0x1E, 0x10, 0x10, 0x10, 0x10,
-	0x0C, 0x1E, 0x0C, 0x1E, 0x0C,
-	0x30, 0x38, 0x3E, 0x38, 0x30,
-	0x06, 0x0E, 0x3E, 0x0E, 0x06,
-	0x00, 0x00, 0x00, 0x00, 0x00,
-	0x00, 0x00, 0x5F, 0x00, 0x00,
-	0x00, 0x07, 0x00, 0x07, 0x00,
-	0x14, 0x7F, 0x14, 0x7F, 0x14,
-	0x24, 0x2A, 0x7F, 0x2A, 0x12,
-	0x23, 0x13, 0x08, 0x64, 0x62,
-	0x36, 0x49, 0x56, 0x20, 0x50,
-	0x00, 0x08, 0x07, 0x03, 0x00,
-	0x00, 0x1C, 0x22, 0x41, 0x00,
-	0x00, 0x41, 0x22, 0x1C, 0x00,
-	0x2A, 0x1C, 0x7F, 0x1C, 0x2A,
-	0x08, 0x08, 0x3E, 0x08, 0x08,
-	0x00, 0x80, 0x70, 0x30, 0x00,
-	0x08, 0x08, 0x08, 0x08, 0x08,
-	0x00, 0x00, 0x60, 0x60, 0x00,
-	0x20, 0x10, 0x08, 0x04, 0x02,
-	0x3E, 0x51, 0x49, 0x45, 0x3E,
-	0x00, 0x42, 0x7F, 0x40, 0x00,
-	0x72, 0x49, 0x49, 0x49, 0x46,
-	0x21, 0x41, 0x49, 0x4D, 0x33,
-	0x18, 0x14, 0x12, 0x7F, 0x10,
-	0x27, 0x45, 0x45, 0x45, 0x39,
-	0x3C, 0x4A, 0x49, 0x49, 0x31,
-	0x41, 0x21, 0x11, 0x09, 0x07,
-	0x36, 0x49, 0x49, 0x49, 0x36,
-	0x46, 0x49, 0x49, 0x29, 0x1E,
-	0x00, 0x00, 0x14, 0x00, 0x00,
-	0x00, 0x40, 0x34, 0x00, 0x00,
-	0x00, 0x08, 0x14, 0x22, 0x41,
-	0x14, 0x14, 0x14, 0x14, 0x14,
-	0x00, 0x41, 0x22, 0x14, 0x08,
-	0x02, 0x01, 0x59, 0x09, 0x06,
-	0x3E, 0x41, 0x5D, 0x59, 0x4E,
-	0x7C, 0x12, 0x11, 0x12, 0x7C,
-	0x7F, 0x49, 0x49, 0x49, 0x36,
-	0x3E, 0x41, 0x41, 0x41, 0x22,
-	0x7F, 0x41, 0x41, 0x41, 0x3E,
-	0x7F, 0x49, 0x49, 0x49, 0x41,
-	0x7F, 0x09, 0x09, 0x09, 0x01,
-	0x3E, 0x41, 0x41, 0x51, 0x73,
-	0x7F, 0x08, 0x08, 0x08, 0x7F,
-	0x00, 0x41, 0x7F, 0x41, 0x00,
-	0x20, 0x40, 0x41, 0x3F, 0x01,
-	0x7F, 0x08, 0x14, 0x22, 0x41,
-	0x7F, 0x40, 0x40, 0x40, 0x40,
-	0x7F, 0x02, 0x1C, 0x02, 0x7F,
-	0x7F, 0x04, 0x08, 0x10, 0x7F,
-	0x3E, 0x41, 0x41, 0x41, 0x3E,
-	0x7F, 0x09, 0x09, 0x09, 0x06,
-	0x3E, 0x41, 0x51, 0x21, 0x5E,
-	0x7F, 0x09, 0x19, 0x29, 0x46,
-	0x26, 0x49, 0x49, 0x49, 0x32,
-	0x03, 0x01, 0x7F, 0x01, 0x03,
-	0x3F, 0x40, 0x40, 0x40, 0x3F,
-	0x1F, 0x20, 0x40, 0x20, 0x1F,
-	0x3F, 0x40, 0x38, 0x40, 0x3F,
-	0x63, 0x14, 0x08, 0x14, 0x63,
-	0x03, 0x04, 0x78, 0x04, 0x03,
-	0x61, 0x59, 0x49, 0x4D, 0x43,
-	0x00, 0x7F, 0x41, 0x41, 0x41,
-	0x02, 0x04, 0x08, 0x10, 0x20,
-	0x00, 0x41, 0x41, 0x41, 0x7F,
-	0x04, 0x02, 0x01, 0x02, 0x04,
-	0x40, 0x40, 0x40, 0x40, 0x40,
-	0x00, 0x03, 0x07, 0x08, 0x00,
-	0x20, 0x54, 0x54, 0x78, 0x40,
-	0x7F, 0x28, 0x44, 0x44, 0x38,
-	0x38, 0x44, 0x44, 0x44, 0x28,
-	0x38, 0x44, 0x44, 0x28, 0x7F,
-	0x38, 0x54, 0x54, 0x54, 0x18,
-	0x00, 0x08, 0x7E, 0x09, 0x02,
-	0x18, 0xA4, 0xA4, 0x9C, 0x78,
-	0x7F, 0x08, 0x04, 0x04, 0x78,
-	0x00, 0x44, 0x7D, 0x40, 0x00,
-	0x20, 0x40, 0x40, 0x3D, 0x00,
-	0x7F, 0x10, 0x28, 0x44, 0x00,
-	0x00, 0x41, 0x7F, 0x40, 0x00,
-	0x7C, 0x04, 0x78, 0x04, 0x78,
-	0x7C, 0x08, 0x04, 0x04, 0x78,
-	0x38, 0x44, 0x44, 0x44, 0x38,
-	0xFC, 0x18, 0x24, 0x24, 0x18,
-	0x18, 0x24, 0x24, 0x18, 0xFC,
-	0x7C, 0x08, 0x04, 0x04, 0x08,
-	0x48, 0x54, 0x54, 0x54, 0x24,
-	0x04, 0x04, 0x3F, 0x44, 0x24,
-	0x3C, 0x40, 0x40, 0x20, 0x7C,
-	0x1C, 0x20, 0x40, 0x20, 0x1C,
-	0x3C, 0x40, 0x30, 0x40, 0x3C,
-	0x44, 0x28, 0x10, 0x28, 0x44,
-	0x4C, 0x90, 0x90, 0x90, 0x7C,
-	0x44, 0x64, 0x54, 0x4C, 0x44,
-	0x00, 0x08, 0x36, 0x41, 0x00,
-	0x00, 0x00, 0x77, 0x00, 0x00,
-	0x00, 0x41, 0x36, 0x08, 0x00,
-	0x02, 0x01, 0x02, 0x04, 0x02,
-	0x3C, 0x26, 0x23, 0x26, 0x3C,
-	0x1E, 0xA1, 0xA1, 0x61, 0x12,
-	0x3A, 0x40, 0x40, 0x20, 0x7A,
-	0x38, 0x54, 0x54, 0x55, 0x59,
-	0x21, 0x55, 0x55, 0x79, 0x41,
-	0x22, 0x54, 0x54, 0x78, 0x42, // a-umlaut
-	0x21, 0x55, 0x54, 0x78, 0x40,
-	0x20, 0x54, 0x55, 0x79, 0x40,
-	0x0C, 0x1E, 0x52, 0x72, 0x12,
-	0x39, 0x55, 0x55, 0x55, 0x59,
-	0x39, 0x54, 0x54, 0x54, 0x59,
-	0x39, 0x55, 0x54, 0x54, 0x58,
-	0x00, 0x00, 0x45, 0x7C, 0x41,
-	0x00, 0x02, 0x45, 0x7D, 0x42,
-	0x00, 0x01, 0x45, 0x7C, 0x40,
-	0x7D, 0x12, 0x11, 0x12, 0x7D, // A-umlaut
-	0xF0, 0x28, 0x25, 0x28, 0xF0,
-	0x7C, 0x54, 0x55, 0x45, 0x00,
-	0x20, 0x54, 0x54, 0x7C, 0x54,
-	0x7C, 0x0A, 0x09, 0x7F, 0x49,
-	0x32, 0x49, 0x49, 0x49, 0x32,
-	0x3A, 0x44, 0x44, 0x44, 0x3A, // o-umlaut
-	0x32, 0x4A, 0x48, 0x48, 0x30,
-	0x3A, 0x41, 0x41, 0x21, 0x7A,
-	0x3A, 0x42, 0x40, 0x20, 0x78,
-	0x00, 0x9D, 0xA0, 0xA0, 0x7D,
-	0x3D, 0x42, 0x42, 0x42, 0x3D, // O-umlaut
-	0x3D, 0x40, 0x40, 0x40, 0x3D,
-	0x3C, 0x24, 0xFF, 0x24, 0x24,
-	0x48, 0x7E, 0x49, 0x43, 0x66,
-	0x2B, 0x2F, 0xFC, 0x2F, 0x2B,
-	0xFF, 0x09, 0x29, 0xF6, 0x20,
-	0xC0, 0x88, 0x7E, 0x09, 0x03,
-	0x20, 0x54, 0x54, 0x79, 0x41,
-	0x00, 0x00, 0x44, 0x7D, 0x41,
-	0x30, 0x48, 0x48, 0x4A, 0x32,
-	0x38, 0x40, 0x40, 0x22, 0x7A,
-	0x00, 0x7A, 0x0A, 0x0A, 0x72,
-	0x7D, 0x0D, 0x19, 0x31, 0x7D,
-	0x26, 0x29, 0x29, 0x2F, 0x28,
-	0x26, 0x29, 0x29, 0x29, 0x26,
-	0x30, 0x48, 0x4D, 0x40, 0x20,
-	0x38, 0x08, 0x08, 0x08, 0x08,
-	0x08, 0x08, 0x08, 0x08, 0x38,
-	0x2F, 0x10, 0xC8, 0xAC, 0xBA,
-	0x2F, 0x10, 0x28, 0x34, 0xFA,
-	0x00, 0x00, 0x7B, 0x00, 0x00,
-	0x08, 0x14, 0x2A, 0x14, 0x22,
-	0x22, 0x14, 0x2A, 0x14, 0x08,
-	0x55, 0x00, 0x55, 0x00, 0x55, // #176 (25% block) missing in old code
-	0xAA, 0x55, 0xAA, 0x55, 0xAA, // 50% block
-	0xFF, 0x55, 0xFF, 0x55, 0xFF, // 75% block
-	0x00, 0x00, 0x00, 0xFF, 0x00,
-	0x10, 0x10, 0x10, 0xFF, 0x00,
-	0x14, 0x14, 0x14, 0xFF, 0x00,
-	0x10, 0x10, 0xFF, 0x00, 0xFF,
-	0x10, 0x10, 0xF0, 0x10, 0xF0,
-	0x14, 0x14, 0x14, 0xFC, 0x00,
-	0x14, 0x14, 0xF7, 0x00, 0xFF,
-	0x00, 0x00, 0xFF, 0x00, 0xFF,
-	0x14, 0x14, 0xF4, 0x04, 0xFC,
-	0x14, 0x14, 0x17, 0x10, 0x1F,
-	0x10, 0x10, 0x1F, 0x10, 0x1F,
-	0x14, 0x14, 0x14, 0x1F, 0x00,
-	0x10, 0x10, 0x10, 0xF0, 0x00,
-	0x00, 0x00, 0x00, 0x1F, 0x10,
-	0x10, 0x10, 0x10, 0x1F, 0x10,
-	0x10, 0x10, 0x10, 0xF0, 0x10,
-	0x00, 0x00, 0x00, 0xFF, 0x10,
-	0x10, 0x10, 0x10, 0x10, 0x10,
-	0x10, 0x10, 0x10, 0xFF, 0x10,
-	0x00, 0x00, 0x00, 0xFF, 0x14,
-	0x00, 0x00, 0xFF, 0x00, 0xFF,
-	0x00, 0x00, 0x1F, 0x10, 0x17,
-	0x00, 0x00, 0xFC, 0x04, 0xF4,
-	0x14, 0x14, 0x17, 0x10, 0x17,
-	0x14, 0x14, 0xF4, 0x04, 0xF4,
-	0x00, 0x00, 0xFF, 0x00, 0xF7,
-	0x14, 0x14, 0x14, 0x14, 0x14,
-	0x14, 0x14, 0xF7, 0x00, 0xF7,
-	0x14, 0x14, 0x14, 0x17, 0x14,
-	0x10, 0x10, 0x1F, 0x10, 0x1F,
-	0x14, 0x14, 0x14, 0xF4, 0x14,
-	0x10, 0x10, 0xF0, 0x10, 0xF0,
-	0x00, 0x00, 0x1F, 0x10, 0x1F,
-	0x00, 0x00, 0x00, 0x1F, 0x14,
-	0x00, 0x00, 0x00, 0xFC, 0x14,
-	0x00, 0x00, 0xF0, 0x10, 0xF0,
-	0x10, 0x10, 0xFF, 0x10, 0xFF,
-	0x14, 0x14, 0x14, 0xFF, 0x14,
-	0x10, 0x10, 0x10, 0x1F, 0x00,
-	0x00, 0x00, 0x00, 0xF0, 0x10,
-	0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
-	0xF0, 0xF0, 0xF0, 0xF0, 0xF0,
-	0xFF, 0xFF, 0xFF, 0x00, 0x00,
-	0x00, 0x00, 0x00, 0xFF, 0xFF,
-	0x0F, 0x0F, 0x0F, 0x0F, 0x0F,
-	0x38, 0x44, 0x44, 0x38, 0x44,
-	0xFC, 0x4A, 0x4A, 0x4A, 0x34, // sharp-s or beta
-	0x7E, 0x02, 0x02, 0x06, 0x06,
-	0x02, 0x7E, 0x02, 0x7E, 0x02,
-	0x63, 0x55, 0x49, 0x41, 0x63,
-	0x38, 0x44, 0x44, 0x3C, 0x04,
-	0x40, 0x7E, 0x20, 0x1E, 0x20,
-	0x06, 0x02, 0x7E, 0x02, 0x02,
-	0x99, 0xA5, 0xE7, 0xA5, 0x99,
-	0x1C, 0x2A, 0x49, 0x2A, 0x1C,
-	0x4C, 0x72, 0x01, 0x72, 0x4C,
-	0x30, 0x4A, 0x4D, 0x4D, 0x30,
-	0x30, 0x48, 0x78, 0x48, 0x30,
-	0xBC, 0x62, 0x5A, 0x46, 0x3D,
-	0x3E, 0x49, 0x49, 0x49, 0x00,
-	0x7E, 0x01, 0x01, 0x01, 0x7E,
-	0x2A, 0x2A, 0x2A, 0x2A, 0x2A,
-	0x44, 0x44, 0x5F, 0x44, 0x44,
-	0x40, 0x51, 0x4A, 0x44, 0x40,
-	0x40, 0x44, 0x4A, 0x51, 0x40,
-	0x00, 0x00, 0xFF, 0x01, 0x03,
-	0xE0, 0x80, 0xFF, 0x00, 0x00,
-	0x08, 0x08, 0x6B, 0x6B, 0x08,
-	0x36, 0x12, 0x36, 0x24, 0x36,
-	0x06, 0x0F, 0x09, 0x0F, 0x06,
-	0x00, 0x00, 0x18, 0x18, 0x00,
-	0x00, 0x00, 0x10, 0x10, 0x00,
-	0x30, 0x40, 0xFF, 0x01, 0x01,
-	0x00, 0x1F, 0x01, 0x01, 0x1E,
-	0x00, 0x19, 0x1D, 0x17, 0x12,
-	0x00, 0x3C, 0x3C, 0x3C, 0x3C,
-	0x00, 0x00, 0x00, 0x00, 0x00  // #255 NBSP
-};
-
-/*********************** display command ********************************/
-
-#define ILI9340_TFTWIDTH  240
-#define ILI9340_TFTHEIGHT 320
-
-#define ILI9340_NOP     0x00
-#define ILI9340_SWRESET 0x01
-#define ILI9340_RDDID   0x04
-#define ILI9340_RDDST   0x09
-
-#define ILI9340_SLPIN   0x10
-#define ILI9340_SLPOUT  0x11
-#define ILI9340_PTLON   0x12
-#define ILI9340_NORON   0x13
-
-#define ILI9340_RDMODE  0x0A
-#define ILI9340_RDMADCTL  0x0B
-#define ILI9340_RDPIXFMT  0x0C
-#define ILI9340_RDIMGFMT  0x0A
-#define ILI9340_RDSELFDIAG  0x0F
-
-#define ILI9340_INVOFF  0x20
-#define ILI9340_INVON   0x21
-#define ILI9340_GAMMASET 0x26
-#define ILI9340_DISPOFF 0x28
-#define ILI9340_DISPON  0x29
-
-#define ILI9340_CASET   0x2A
-#define ILI9340_PASET   0x2B
-#define ILI9340_RAMWR   0x2C
-#define ILI9340_RAMRD   0x2E
-
-#define ILI9340_PTLAR   0x30
-#define ILI9340_MADCTL  0x36
-
-
-#define ILI9340_MADCTL_MY  0x80
-#define ILI9340_MADCTL_MX  0x40
-#define ILI9340_MADCTL_MV  0x20
-#define ILI9340_MADCTL_ML  0x10
-#define ILI9340_MADCTL_RGB 0x00
-#define ILI9340_MADCTL_BGR 0x08
-#define ILI9340_MADCTL_MH  0x04
-
-#define ILI9340_PIXFMT  0x3A
-
-#define ILI9340_FRMCTR1 0xB1
-#define ILI9340_FRMCTR2 0xB2
-#define ILI9340_FRMCTR3 0xB3
-#define ILI9340_INVCTR  0xB4
-#define ILI9340_DFUNCTR 0xB6
-
-#define ILI9340_PWCTR1  0xC0
-#define ILI9340_PWCTR2  0xC1
-#define ILI9340_PWCTR3  0xC2
-#define ILI9340_PWCTR4  0xC3
-#define ILI9340_PWCTR5  0xC4
-#define ILI9340_VMCTR1  0xC5
-#define ILI9340_VMCTR2  0xC7
-
-#define ILI9340_RDID1   0xDA
-#define ILI9340_RDID2   0xDB
-#define ILI9340_RDID3   0xDC
-#define ILI9340_RDID4   0xDD
-
-#define ILI9340_GMCTRP1 0xE0
-#define ILI9340_GMCTRN1 0xE1
-
-// Color definitions
-#define	ILI9340_BLACK   0x0000
-#define	ILI9340_BLUE    0x001F
-#define	ILI9340_RED     0xF800
-#define	ILI9340_GREEN   0x07E0
-#define ILI9340_CYAN    0x07FF
-#define ILI9340_MAGENTA 0xF81F
-#define ILI9340_YELLOW  0xFFE0
-#define ILI9340_WHITE   0xFFFF
-
-// Display dimensions
-#define _width  240
-#define _height 320
+/****************************************************************************/
+/*                        Type Definitions                                  */
+/****************************************************************************/
+// One sensor reading on heart_data, oxygen_data, temp_data or step_data, with the
+// time it was sampled so the display can measure the latency to the pixels
+typedef struct {
+	int32_t  n_value;
+	uint32_t un_time_us;      // uptime of the sample
+} reading_t;
+
+// One beat-to-beat (RR) interval, sent on rr_data for every beat
+typedef struct {
+	uint32_t un_time_ms;      // uptime of the beat that ends the interval
+	uint32_t un_beat;         // beat number since the heart rate task started
+	uint16_t us_rr_ms;        // interval from the previous beat
+	uint8_t  uch_valid;       // 0 if rejected as an artifact (missed or extra beat)
+	uint8_t  uch_reserved;
+} rr_event_t;
+
+// Heart rate variability over the window, latest value on hrv_data
+typedef struct {
+	uint32_t un_time_ms;      // uptime of the last beat
+	uint16_t us_rr_ms;        // last RR interval
+	uint16_t us_mean_rr_ms;   // mean RR interval
+	uint16_t us_sdnn_x10;     // SDNN in 0.1 msec
+	uint16_t us_rmssd_x10;    // RMSSD in 0.1 msec
+	uint16_t us_pnn50_x10;    // pNN50 in 0.1 %
+	uint16_t us_intervals;    // RR intervals in the window
+	uint8_t  uch_window_min;  // window length in minutes (1 to 5)
+	uint8_t  uch_reserved;
+} hrv_t;
 /****************************************************************************/
 /*                       Global variables                                   */
 /****************************************************************************/
@@ -404,12 +114,18 @@ static int32_t OX =0;
 static int32_t BS =0;
 static int32_t BT =0;
 static int32_t ST =0;
+static hrv_t   HV = {0};
 
 // Sensor Queues
 extern QueueHandle_t oxygen_data;
 extern QueueHandle_t heart_data;
 extern QueueHandle_t temp_data;
 extern QueueHandle_t step_data;
+extern QueueHandle_t rr_data;
+extern QueueHandle_t hrv_data;
+
+// Mutex for mutual exclusion of LCD Refresh
+extern SemaphoreHandle_t screen_change;
 
 // state machine
 typedef enum {clock_screen,sensor_screen,warning_screen} screens;
@@ -419,7 +135,7 @@ typedef enum {clock_screen,sensor_screen,warning_screen} screens;
 /****************************************************************************/
 
 /********************************* Display Task ******************************/
-class display_Task : public scheduler_task
+class display_Task : public scheduler_task, public LcdScreen
 {
 public:
 	uint8_t event = 0;
@@ -427,60 +143,78 @@ public:
 	bool init(void);					   ///< Init
     bool run(void *p);                     ///< The main loop
 
-    // Library calls , referenced from https://github.com/adafruit/Adafruit-GFX-Library
-    void setAddrWindow(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1);
-    void drawPixel(int16_t x, int16_t y, uint16_t color);
-    int drawChar(int16_t x, int16_t y, unsigned char c,
-  		  uint16_t color, uint16_t bg, uint8_t size);
-    void writeFillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
-    void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
-    void writeFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color);
-    void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color);
-    void drawFastHLine(int16_t x, int16_t y, int16_t h, uint16_t color);
-    void writeLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1,uint16_t color);
-    void drawString(const char *string, int poX, int poY, int size,uint16_t color);
-    void drawTriangle(int16_t x0, int16_t y0,
-            int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint16_t color);
-    void drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1,
-            uint16_t color);
-
-    void writecommand(uint8_t command_byte);
-    void writedata(uint8_t command_byte);
-
     // Display Refresh functions
-    void clearScrn(void);
-    void clearScrn1(void);
-    void clearScrn2(void);
-    void clearScrn3(void);
     void displayScrn1(void);
     void displayScrn2(void);
     void displayScrn3(void);
     void minute_check (void);
-    void clearminute(void);
-    void clearhour(void);
-    void clearday(void);
-    void clearmonth(void);
-    void clearOX(void);
-    void clearBS(void);
-    void clearBT(void);
-    void clearST(void);
-
 
+    // false to redraw the screens without the widgets (the original refresh)
+    void setRetained(bool enable);
+    // Repaints all widgets of the screen shown, after drawing over it
+    void redrawScreen(void);
+
+    // Sensor to pixel latency of the readings painted on the sensor screen
+    uint32_t getLatencyCount(void) const    { return latency_count; }
+    uint32_t getMinLatencyUs(void) const    { return latency_count ? latency_min_us : 0; }
+    uint32_t getMaxLatencyUs(void) const    { return latency_max_us; }
+    uint32_t getAvgLatencyUs(void) const    { return latency_count ? (uint32_t) (latency_sum_us / latency_count) : 0; }
+    // Wake-ups of the event loop, the events they took, the largest burst and the
+    // readings replaced by a newer one before they were painted
+    uint32_t getWakeups(void) const         { return wakeups; }
+    uint32_t getEvents(void) const          { return events; }
+    uint32_t getMaxBurst(void) const        { return max_burst; }
+    uint32_t getCoalesced(void) const       { return coalesced; }
+    void resetLatency(void);
+
+    // false to send the vitals to the phone as the ASCII frames ("#hr+o2+temp+steps+~")
+    void setBtBinary(bool enable)           { bt_binary = enable; }
+    bool getBtBinary(void) const            { return bt_binary; }
+    VitalsEncoder& getBtEncoder(void)       { return bt_encoder; }
+    const VitalsDecoder& getBtDecoder(void) const { return bt_decoder; }
+    const VitalsHistory& getBtHistory(void) const { return bt_history; }
+    // Bytes written to UART3 in both modes
+    uint32_t getBtBytes(void) const         { return bt_bytes; }
+    void resetBtBytes(void)                 { bt_bytes = 0; }
+    // Sends the history to the phone, as when it asks for it
+    void requestHistory(void);
 
 private:
-    // Routines to configure SSP0 to communicate with LCD
-    void SSP0_power   (uint8_t);
-    void SSP0_enable  (void);
-    void SSP0_disable (void);
-    void display_CS_assert   (void);
-    void display_CS_dessert  (void);
-    void display_RST_assert   (void);
-    void display_RST_dessert  (void);
-    void display_DC_assert   (void);
-    void display_DC_dessert  (void);
-    bool SSP0_TXfull  (void);
-    bool SSP0_busy    (void);
-    uint8_t SSP0_byte_transfer(uint8_t);
+    // Repaints the damage of the widgets of a screen
+    void paintWidgets(WidgetScreen &screen);
+    // Takes the item of a queue set member that was selected
+    void takeEvent(QueueSetMemberHandle_t member);
+    // Takes a reading, the field is refreshed if the value changed
+    void takeReading(QueueHandle_t queue, int32_t &value, uint8_t uch_field);
+    // Adds the latency of the readings painted since they were taken
+    void addLatency(void);
+    // Sends the vitals over the HC-05, reads the requests of the phone
+    void sendVitals(void);
+    // Writes a frame of bt_frame to UART3
+    void sendFrame(uint32_t un_len);
+
+    bool retained = true;        // screens drawn by the widgets
+
+    // Fields to repaint (FIELD_ bits) and sample time of the readings not painted yet
+    uint8_t refresh = FIELD_ALL;
+    uint32_t reading_us[FIELD_READINGS] = {0};
+    uint32_t latency_count = 0;
+    uint32_t latency_min_us = 0xFFFFFFFF;
+    uint32_t latency_max_us = 0;
+    uint64_t latency_sum_us = 0;
+    uint32_t wakeups = 0;
+    uint32_t events = 0;
+    uint32_t max_burst = 0;
+    uint32_t coalesced = 0;
+
+    // Bluetooth link : frames to the phone, requests from it and the history it can ask for
+    VitalsEncoder bt_encoder;
+    VitalsDecoder bt_decoder;
+    VitalsHistory bt_history;
+    uint8_t bt_frame[VLINK_MAX_FRAME];
+    uint32_t bt_history_next = 0xFFFFFFFF;  // next entry of the history transfer, none if past the end
+    bool bt_binary = true;
+    uint32_t bt_bytes = 0;
 
     // Routine to configure UART3 interface.
     void UART3_init(void);
@@ -108,4 +108,43 @@ CMD_HANDLER_FUNC(binSemaHandler);
 CMD_HANDLER_FUNC(i2cTaskHandlerTrial);
 
 CMD_HANDLER_FUNC(smartHealthHandler);
+
+// Heart rate algorithm benchmark: batch vs streaming engine
+CMD_HANDLER_FUNC(hrBenchHandler);
+
+// MAX30102 FIFO wakeups and I2C transactions per second
+CMD_HANDLER_FUNC(hrFifoHandler);
+CMD_HANDLER_FUNC(accBenchHandler);
+CMD_HANDLER_FUNC(accRecordHandler);
+CMD_HANDLER_FUNC(stepReplayHandler);
+
+// IR derivative filter benchmark: separate passes vs fused filter chain
+CMD_HANDLER_FUNC(firBenchHandler);
+
+// Close-peak suppression benchmark: insertion sort vs heap ordered sweep
+CMD_HANDLER_FUNC(peakBenchHandler);
+
+// Record raw MAX30102 samples to a file, and replay a trace through the heart rate algorithm
+CMD_HANDLER_FUNC(ppgRecordHandler);
+CMD_HANDLER_FUNC(ppgReplayHandler);
+
+// Heart rate sample rate (25, 50, 100 or 200 sps)
+CMD_HANDLER_FUNC(hrRateHandler);
+CMD_HANDLER_FUNC(hrvHandler);
+CMD_HANDLER_FUNC(spo2GateHandler);
+CMD_HANDLER_FUNC(hrSpoolHandler);
+CMD_HANDLER_FUNC(spoolRunHandler);
+CMD_HANDLER_FUNC(tempBenchHandler);
+CMD_HANDLER_FUNC(tempHandler);
+
+// LCD SPI traffic, per pixel vs bulk address windows
+CMD_HANDLER_FUNC(lcdBenchHandler);
+CMD_HANDLER_FUNC(lcdRateHandler);
+CMD_HANDLER_FUNC(lcdLatencyHandler);
+CMD_HANDLER_FUNC(btLinkHandler);
+CMD_HANDLER_FUNC(uartBenchHandler);
+
+// ISR to task event statistics
+CMD_HANDLER_FUNC(isrEventHandler);
+CMD_HANDLER_FUNC(sampleJobHandler);
 #endif /* HANDLERS_HPP_ */
@@ -0,0 +1,786 @@
+/*****************************************************************************
+$Work file     : lcd_screen.cpp $
+Description    : This file contains the ILI9340 LCD driver on SSP0 and the
+				 screen clear routines, moved out of display.cpp.
+Project(s)     : Smart Health Gear
+Compiler       : Cross ARM GCC
+OS			   : RTOS
+Original Author: $ Aniket Dali
+$Author        : $ agent
+$Date          : $ 17 Oct 2026
+$Revision      : 1.0 $
+*****************************************************************************/
+/****************************************************************************/
+/*                       INCLUDE FILES                                      */
+/****************************************************************************/
+#include "lcd_screen.hpp"
+#include "LPC17xx.h"
+#include "ssp0.h"
+#include "task.h"
+#include "stdlib.h"
+extern "C"
+{
+	#include "gpio.h"
+}
+
+
+/****************************************************************************/
+/*                        VARIABLES AND MACROS                              */
+/****************************************************************************/
+// Semaphore given by the DMA interrupt at the end of the pixels sent to the LCD
+SemaphoreHandle_t pixels_done	     		   = NULL;
+
+/****************************************************************************/
+/*                       FUNCTION DECLARATAIONS                             */
+/****************************************************************************/
+// callback of the SSP0 DMA at the end of the pixels
+void pixels_sent(char failed);
+
+/****************************************************************************/
+/*                       FUNCTION DEFINITIONS                               */
+/****************************************************************************/
+/*----------------------------------------------------------------------------
+Function    :  LcdScreen (Constructor)
+Inputs      :  None
+Processing  :  This function is Constructor for the LcdScreen, the text is
+			   rendered with the 5x7 font
+Outputs     :  None
+Returns     :  None
+Notes       :  The hardware is set up by initSpi()
+----------------------------------------------------------------------------*/
+LcdScreen :: LcdScreen() : text(font)
+{
+}
+/*----------------------------------------------------------------------------
+Function    :  initSpi()
+Inputs      :  None
+Processing  :  This function configures the SSP interface and port pins to
+			   interact with LCD module ILI9341
+Outputs     :  None
+Returns     :  None
+Notes       :  None
+----------------------------------------------------------------------------*/
+void LcdScreen::initSpi(void)
+{
+	SSP0_power(1);
+	// clear the settings
+	LPC_SC->PCLKSEL1 &= ~(0b11<<10);
+	// set PCLK = CLK
+	LPC_SC->PCLKSEL1 |= (0b01<<10);
+	// SCK1
+	GPIOSetMode(0,15,FUNC3);
+	// MISO
+	GPIOSetMode(0,17,FUNC3);
+	// MOSI
+	GPIOSetMode(0,18,FUNC3);
+	// SCK speed = CPU / 2 = 24 Mhz
+    LPC_SSP0->CPSR = 2;
+	// set the data transfer to 8 bits.
+	LPC_SSP0->CR0  =   0b0111;
+	// Turn on SSP module
+	SSP0_enable();
+	// Pixels are sent by DMA once the scheduler runs
+	ssp0_dma_init();
+	pixels_done = xSemaphoreCreateBinary();
+	xSemaphoreTake(pixels_done, 0);
+	// CS
+	GPIOSetDir(0,29,OUTPUT);
+	// RESET
+	GPIOSetDir(0,30,OUTPUT);
+	// DC/RS
+	GPIOSetDir(1,19,OUTPUT);
+	// LED pin
+	GPIOSetDir(1,28,OUTPUT);
+	// Turn on the power to LED driver circuit
+	GPIOSetValue(1,28,1);
+}
+/*----------------------------------------------------------------------------
+Function    :  UART3_init()
+Inputs      :  None
+Processing  :  This function Powers on SSP0 interface
+Outputs     :  None
+Returns     :  None
+Notes       :  None
+----------------------------------------------------------------------------*/
+void LcdScreen::SSP0_power(uint8_t mode)
+{
+	if(mode)
+	{
+		LPC_SC->PCONP |= (mode<<21);
+	}
+	else
+	{
+		LPC_SC->PCONP &= ~(mode<<21);
+	}
+}
+/*----------------------------------------------------------------------------
+Function    :  SSP0_byte_transfer()
+Inputs      :  uint8_t send_byte
+Processing  :  This function Powers on SSP0 interface
+Outputs     :  None
+Returns     :  None
+Notes       :  None
+----------------------------------------------------------------------------*/
+uint8_t LcdScreen::SSP0_byte_transfer (uint8_t send_byte)
+{
+
+	while (SSP0_TXfull());
+    LPC_SSP0->DR = send_byte;
+    spi_bytes++;
+
+    while(SSP0_busy());
+
+    return LPC_SSP0->DR;
+
+}
+/*----------------------------------------------------------------------------
+Function    :  SSP0_enable()
+Inputs      :  None
+Processing  :  This function Enables SSP0 interface
+Outputs     :  None
+Returns     :  None
+Notes       :  None
+----------------------------------------------------------------------------*/
+void LcdScreen::SSP0_enable  (void)
+{
+	LPC_SSP0->CR1 |=   (0b1   << 1);
+}
+/*----------------------------------------------------------------------------
+Function    :  SSP0_disable()
+Inputs      :  None
+Processing  :  This function Disables SSP0 interface
+Outputs     :  None
+Returns     :  None
+Notes       :  None
+----------------------------------------------------------------------------*/
+void LcdScreen::SSP0_disable (void)
+{
+	LPC_SSP0->CR1 &=  ~(0b1   << 1);
+}
+/*----------------------------------------------------------------------------
+Function    :  SSP0_TXfull()
+Inputs      :  None
+Processing  :  This function checks whether the transmit queue is full?
+Outputs     :  None
+Returns     :  True, if busy, False if not full
+Notes       :  None
+----------------------------------------------------------------------------*/
+bool LcdScreen::SSP0_TXfull(void)
+{
+	uint32_t mask = (0b1<<1);
+	bool return_val = !(LPC_SSP0->SR & mask);
+	return (return_val);
+}
+/*----------------------------------------------------------------------------
+Function    :  SSP0_busy()
+Inputs      :  None
+Processing  :  This function checks whether the SSP interface is busy
+Outputs     :  None
+Returns     :  True, if busy, False if not full
+Notes       :  None
+----------------------------------------------------------------------------*/
+bool LcdScreen::SSP0_busy(void)
+{
+	return (((LPC_SSP0->SR ) & (0b01 << 4)));
+}
+/*----------------------------------------------------------------------------
+Function    :  display_CS_assert()
+Inputs      :  None
+Processing  :  This function asserts CS
+Outputs     :  None
+Returns     :  None
+Notes       :  None
+----------------------------------------------------------------------------*/
+void LcdScreen::display_CS_assert(void)
+{
+	GPIOSetValue(0,29,HIGH);
+}
+/*----------------------------------------------------------------------------
+Function    :  display_CS_dessert()
+Inputs      :  None
+Processing  :  This function desserts CS
+Outputs     :  None
+Returns     :  None
+Notes       :  None
+----------------------------------------------------------------------------*/
+void LcdScreen::display_CS_dessert(void)
+{
+	GPIOSetValue(0,29,LOW);
+	spi_transactions++;
+}
+/*----------------------------------------------------------------------------
+Function    :  display_RST_assert()
+Inputs      :  None
+Processing  :  This function asserts RST
+Outputs     :  None
+Returns     :  None
+Notes       :  None
+----------------------------------------------------------------------------*/
+void LcdScreen::display_RST_assert(void)
+{
+	GPIOSetValue(0,30,HIGH);
+}
+/*----------------------------------------------------------------------------
+Function    :  display_RST_dessert()
+Inputs      :  None
+Processing  :  This function desserts RST
+Outputs     :  None
+Returns     :  None
+Notes       :  None
+----------------------------------------------------------------------------*/
+void LcdScreen::display_RST_dessert(void)
+{
+	GPIOSetValue(0,30,LOW);
+}
+/*----------------------------------------------------------------------------
+Function    :  display_DC_assert()
+Inputs      :  None
+Processing  :  This function makes D/C High
+Outputs     :  None
+Returns     :  None
+Notes       :  None
+----------------------------------------------------------------------------*/
+void LcdScreen::display_DC_assert(void)
+{
+	GPIOSetValue(1,19,HIGH);
+}
+/*----------------------------------------------------------------------------
+Function    :  display_DC_dessert()
+Inputs      :  None
+Processing  :  This function makes D/C low
+Outputs     :  None
+Returns     :  None
+Notes       :  None
+----------------------------------------------------------------------------*/
+void LcdScreen::display_DC_dessert(void)
+{
+	GPIOSetValue(1,19,LOW);
+}
+
+ /****************************************************************************/
+ /*                      ADA FRUIT GFX Library for ILI9430                   */
+ /****************************************************************************/
+
+void LcdScreen::setAddrWindow(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1)
+{
+
+  writecommand(ILI9340_CASET); // Column addr set
+  writedata(x0 >> 8);
+  writedata(x0 & 0xFF);     // XSTART
+  writedata(x1 >> 8);
+  writedata(x1 & 0xFF);     // XEND
+
+  writecommand(ILI9340_PASET); // Row addr set
+  writedata(y0>>8);
+  writedata(y0);     // YSTART
+  writedata(y1>>8);
+  writedata(y1);     // YEND
+
+  writecommand(ILI9340_RAMWR); // write to RAM
+}
+
+void LcdScreen::drawPixel(int16_t x, int16_t y, uint16_t color)
+{
+
+	  if((x < 0) ||(x >= 240) || (y < 0) || (y >= 320)) return;
+
+	  setAddrWindow(x,y,x+1,y+1);
+
+	  //digitalWrite(_dc, HIGH);
+	  display_DC_assert();
+	  //digitalWrite(_cs, LOW);
+	  display_CS_dessert();
+
+	  SSP0_byte_transfer(color >> 8);
+	  SSP0_byte_transfer(color);
+
+	  //digitalWrite(_cs, HIGH);
+	  display_CS_assert();
+	//  printf("pixel executed \n");
+}
+
+int LcdScreen::drawChar(int16_t x, int16_t y, unsigned char c,
+		  uint16_t color, uint16_t bg, uint8_t size)
+{
+
+//		    if(!gfxFont) { // 'Classic' built-in font
+
+		        if((x >= _width)            || // Clip right
+		           (y >= _height)           || // Clip bottom
+		           ((x + 6 * size - 1) < 0) || // Clip left
+		           ((y + 8 * size - 1) < 0))   // Clip top
+		            return 1;
+
+		        if((c >= 176)) c++; // Handle 'classic' charset behavior
+
+		    //    startWrite();
+		        for(int8_t i=0; i<5; i++ ) { // Char bitmap = 5 columns
+		            uint8_t line = pgm_read_byte(&font[c * 5 + i]);
+		            // Fill each run of same color pixels of the column at once
+		            for(int8_t j=0; j<8; ) {
+		                bool set = line & 1;
+		                int8_t n = 0;
+		                do {
+		                    line >>= 1;
+		                    n++;
+		                } while((j+n < 8) && ((line & 1) == set));
+		                if(set || (bg != color))
+		                    writeFillRect(x+i*size, y+j*size, size, n*size, set ? color : bg);
+		                j += n;
+		            }
+		        }
+		        if(bg != color) { // If opaque, draw vertical line for last column
+		            writeFillRect(x+5*size, y, size, 8*size, bg);
+		        }
+
+		        return((5.0+0.4)*size);
+		  //      endWrite();
+}
+
+void LcdScreen::writeFillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+{
+
+    // Overwrite in subclasses if desired!
+    fillRect(x,y,w,h,color);
+
+}
+
+
+void LcdScreen::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+{
+    if(per_pixel) {
+        for (int16_t i=x; i<x+w; i++) {
+            writeFastVLine(i, y, h, color);
+        }
+        return;
+    }
+
+    // Clip to the screen
+    if(x < 0) { w += x; x = 0; }
+    if(y < 0) { h += y; y = 0; }
+    if(x + w > _width)  w = _width - x;
+    if(y + h > _height) h = _height - y;
+    if((w <= 0) || (h <= 0)) return;
+
+    // One address window for the whole rectangle, it waits for the previous DMA
+    setAddrWindow(x, y, x+w-1, y+h-1);
+    if(use_dma && (taskSCHEDULER_RUNNING == xTaskGetSchedulerState())) {
+        dma_fill = color;
+        startPixels(&dma_fill, (uint32_t) w * h, true);
+    } else {
+        writePixels(&color, (uint32_t) w * h, true);
+    }
+}
+
+void LcdScreen::drawPixels(int16_t x, int16_t y, int16_t w, int16_t h, const uint16_t *pixels)
+{
+    if((w <= 0) || (h <= 0)) return;
+
+    setAddrWindow(x, y, x+w-1, y+h-1);
+    if(use_dma && (taskSCHEDULER_RUNNING == xTaskGetSchedulerState())) {
+        startPixels(pixels, (uint32_t) w * h, false);
+    } else {
+        writePixels(pixels, (uint32_t) w * h, false);
+    }
+}
+
+void LcdScreen::writePixels(const uint16_t *pixels, uint32_t count, bool repeat)
+{
+    display_DC_assert();
+    display_CS_dessert();
+    spi_bytes += 2 * count;
+
+    // Keep the transmit FIFO full, CS stays low for all the pixels
+    while(count--) {
+        while (SSP0_TXfull());
+        LPC_SSP0->DR = *pixels >> 8;
+        while (SSP0_TXfull());
+        LPC_SSP0->DR = *pixels & 0xFF;
+        if(!repeat) pixels++;
+    }
+    endPixels();
+}
+
+void LcdScreen::startPixels(const uint16_t *pixels, uint32_t count, bool repeat)
+{
+    display_DC_assert();
+    display_CS_dessert();
+    spi_bytes += 2 * count;
+
+    // 16-bit frames, SSP0 sends the high byte of each pixel first
+    LPC_SSP0->CR0 = 0b1111;
+    dma_active = true;
+    if(0 != ssp0_dma_write_start(pixels, count, repeat, pixels_sent)) {
+        endPixels();
+    }
+}
+
+bool LcdScreen::waitPixels(TickType_t timeout)
+{
+    if(!dma_active) return true;
+    if(!xSemaphoreTake(pixels_done, timeout)) return false;
+
+    endPixels();
+    return true;
+}
+
+void LcdScreen::endPixels(void)
+{
+    // The last pixels are still shifted out after the FIFO is written
+    while(SSP0_busy());
+
+    // The received bytes are not needed, flush them and clear the overrun
+    while(LPC_SSP0->SR & (0b1 << 2)) {
+        (void) LPC_SSP0->DR;
+    }
+    LPC_SSP0->ICR = (0b1 << 0);
+
+    LPC_SSP0->CR0 = 0b0111;
+    dma_active = false;
+    display_CS_assert();
+}
+
+void pixels_sent(char failed)
+{
+    // A failed transfer leaves the window as it was until the next refresh
+    long higherPriorityTaskWaiting = 0;
+    xSemaphoreGiveFromISR(pixels_done, &higherPriorityTaskWaiting);
+    portEND_SWITCHING_ISR(higherPriorityTaskWaiting);
+}
+
+void LcdScreen::writeFastVLine(int16_t x, int16_t y,
+        int16_t h, uint16_t color)
+{
+	drawFastVLine(x, y, h, color);
+
+}
+
+void LcdScreen::drawFastVLine(int16_t x, int16_t y,
+        int16_t h, uint16_t color)
+{
+	if(per_pixel) writeLine(x, y, x, y+h-1, color);
+	else          fillRect(x, y, 1, h, color);
+}
+
+void LcdScreen::drawFastHLine(int16_t x, int16_t y,
+        int16_t h, uint16_t color)
+{
+	if(per_pixel) writeLine(x, y, x+h-1, y, color);
+	else          fillRect(x, y, h, 1, color);
+}
+
+void LcdScreen::writeLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1,
+        uint16_t color) {
+    int16_t steep = abs(y1 - y0) > abs(x1 - x0);
+    if (steep) {
+        _swap_int16_t(x0, y0);
+        _swap_int16_t(x1, y1);
+    }
+
+    if (x0 > x1) {
+        _swap_int16_t(x0, x1);
+        _swap_int16_t(y0, y1);
+    }
+
+    int16_t dx, dy;
+    dx = x1 - x0;
+    dy = abs(y1 - y0);
+
+    int16_t err = dx / 2;
+    int16_t ystep;
+
+    if (y0 < y1) {
+        ystep = 1;
+    } else {
+        ystep = -1;
+    }
+
+    for (; x0<=x1; x0++) {
+        if (steep) {
+        	drawPixel(y0, x0, color);
+        } else {
+        	drawPixel(x0, y0, color);
+        }
+        err -= dy;
+        if (err < 0) {
+            y0 += ystep;
+            err += dx;
+        }
+    }
+}
+
+
+void LcdScreen::drawString(const char *string, int poX, int poY, int size,uint16_t color)
+{
+    // One character at a time on the per pixel path, or if the box does not fit the raster
+    if(per_pixel || (poX < 0) || (poY < 0) || (size < 1) || (size > TEXT_MAX_SCALE))
+    {
+        int sumX = 0;
+
+        while(*string)
+        {
+            int xPlus = drawChar(poX, poY, *string,color, ILI9340_BLACK,  size);
+            sumX += xPlus;
+            *string++;
+            poX += xPlus;
+        }
+        return;
+    }
+
+    int16_t w = TextRaster::getWidth(string, size);
+    int16_t h = 8 * size;
+    if(poX + w > _width)  w = _width - poX;
+    if(poY + h > _height) h = _height - poY;
+    if((w <= 0) || (h <= 0)) return;
+
+    // Black text on the black background only clears the box
+    if(ILI9340_BLACK == color)
+    {
+        fillRect(poX, poY, w, h, ILI9340_BLACK);
+        return;
+    }
+
+    // The strips alternate, the last one of the previous string may still be in flight
+    const int16_t strip_rows = (TEXT_STRIP_PIXELS / w < h) ? (TEXT_STRIP_PIXELS / w) : h;
+    waitPixels();
+    for(int16_t y = 0, i = 0; y < h; y += strip_rows, i ^= 1)
+    {
+        const int16_t rows = (h - y < strip_rows) ? (h - y) : strip_rows;
+        text.renderRows(string, size, color, ILI9340_BLACK, 0, y, w, rows, w, strip[i]);
+        drawPixels(poX, poY + y, w, rows, strip[i]);
+    }
+}
+void  LcdScreen::writecommand(uint8_t command_byte)
+{
+	// Pixels in flight use the SPI in 16-bit frames
+	waitPixels();
+	// DC- low
+	display_DC_dessert();
+	//CS- low
+	display_CS_dessert();
+	// SSP exchange
+    SSP0_byte_transfer(command_byte);
+	//CS- HIGH
+	display_CS_assert();
+
+}
+void  LcdScreen::writedata(uint8_t data_byte)
+{
+	waitPixels();
+	// DC- HIGH
+	display_DC_assert();
+	//CS- low
+	display_CS_dessert();
+	// SSP exchange
+	SSP0_byte_transfer(data_byte);
+	//CS- HIGH
+	display_CS_assert();
+
+}
+
+void LcdScreen::drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1,
+        uint16_t color)
+{
+    // Update in subclasses if desired!
+    if(x0 == x1){
+        if(y0 > y1) _swap_int16_t(y0, y1);
+        drawFastVLine(x0, y0, y1 - y0 + 1, color);
+    } else if(y0 == y1){
+        if(x0 > x1) _swap_int16_t(x0, x1);
+        drawFastHLine(x0, y0, x1 - x0 + 1, color);
+    } else {
+
+        writeLine(x0, y0, x1, y1, color);
+
+    }
+}
+void LcdScreen::drawTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint16_t color)
+{
+    drawLine(x0, y0, x1, y1, color);
+    drawLine(x1, y1, x2, y2, color);
+    drawLine(x2, y2, x0, y0, color);
+}
+
+/*----------------------------------------------------------------------------
+Function    :  clearminute()
+Inputs      :  None
+Processing  :  This function clears minute field
+Outputs     :  None
+Returns     :  None
+Notes       :  None
+----------------------------------------------------------------------------*/
+void LcdScreen::clearminute(void)
+{
+	fillRect(130,70,70,47,ILI9340_BLACK);
+}
+/*----------------------------------------------------------------------------
+Function    :  clearhour()
+Inputs      :  None
+Processing  :  This function clears hours field
+Outputs     :  None
+Returns     :  None
+Notes       :  None
+----------------------------------------------------------------------------*/
+void LcdScreen::clearhour(void)
+{
+	fillRect(40,70,160,47,ILI9340_BLACK);
+}
+/*----------------------------------------------------------------------------
+Function    :  clearday()
+Inputs      :  None
+Processing  :  This function clears days field
+Outputs     :  None
+Returns     :  None
+Notes       :  None
+----------------------------------------------------------------------------*/
+void LcdScreen::clearday(void)
+{
+	fillRect(85,130,40,25,ILI9340_BLACK);
+	clearhour();
+}
+/*----------------------------------------------------------------------------
+Function    :  clearmonth()
+Inputs      :  None
+Processing  :  This function clears months field
+Outputs     :  None
+Returns     :  None
+Notes       :  None
+----------------------------------------------------------------------------*/
+void LcdScreen::clearmonth(void)
+{
+	fillRect(10,130,110,25,ILI9340_BLACK);
+	clearhour();
+}
+/*----------------------------------------------------------------------------
+Function    :  clearscrn1()
+Inputs      :  None
+Processing  :  This function clears sensor screen
+Outputs     :  None
+Returns     :  None
+Notes       :  None
+----------------------------------------------------------------------------*/
+void LcdScreen::clearScrn1(void)
+{
+	drawFastVLine(5,0,250,ILI9340_BLACK);
+	drawFastVLine(142,0,250,ILI9340_BLACK);
+	drawFastVLine(235,0,250,ILI9340_BLACK);
+
+	drawFastHLine(5,0,231,ILI9340_BLACK);
+	drawFastHLine(5,50,231,ILI9340_BLACK);
+	drawFastHLine(5,100,231,ILI9340_BLACK);
+	drawFastHLine(5,150,231,ILI9340_BLACK);
+	drawFastHLine(5,200,231,ILI9340_BLACK);
+	drawFastHLine(5,250,231,ILI9340_BLACK);
+	drawString("Heart Rate",12,20,2,ILI9340_BLACK);
+	drawString("Blood Oxygen",12,70,2,ILI9340_BLACK);
+	drawString("Body Temp",12,120,2,ILI9340_BLACK);
+	drawString("step count",12,170,2,ILI9340_BLACK);
+	drawString("HRV (ms)",12,220,2,ILI9340_BLACK);
+	// Clear the readings
+	fillRect(148,20,235,240,ILI9340_BLACK);
+
+}
+/*----------------------------------------------------------------------------
+Function    :  clearscrn2()
+Inputs      :  None
+Processing  :  This function clears entire screen
+Outputs     :  None
+Returns     :  None
+Notes       :  None
+----------------------------------------------------------------------------*/
+void LcdScreen::clearScrn2(void)
+{
+	fillRect(25,70,200,85,ILI9340_BLACK);
+}
+/*----------------------------------------------------------------------------
+Function    :  clearOX()
+Inputs      :  None
+Processing  :  This function clears Oxygen parameters
+Outputs     :  None
+Returns     :  None
+Notes       :  None
+----------------------------------------------------------------------------*/
+void LcdScreen::clearOX(void)
+{
+	fillRect(145,55,86,35,ILI9340_BLACK);
+}
+/*----------------------------------------------------------------------------
+Function    :  clearBS()
+Inputs      :  None
+Processing  :  This function clears Bits per second parameters
+Outputs     :  None
+Returns     :  None
+Notes       :  None
+----------------------------------------------------------------------------*/
+void LcdScreen::clearBS(void)
+{
+	fillRect(145,15,86,35,ILI9340_BLACK);
+}
+/*----------------------------------------------------------------------------
+Function    :  clearBT()
+Inputs      :  None
+Processing  :  This function clears Body Temperature parameters
+Outputs     :  None
+Returns     :  None
+Notes       :  None
+----------------------------------------------------------------------------*/
+void LcdScreen::clearBT(void)
+{
+	fillRect(145,105,86,35,ILI9340_BLACK);
+}
+/*----------------------------------------------------------------------------
+Function    :  clearST()
+Inputs      :  None
+Processing  :  This function clears Step parameters
+Outputs     :  None
+Returns     :  None
+Notes       :  None
+----------------------------------------------------------------------------*/
+void LcdScreen::clearST(void)
+{
+	fillRect(145,165,86,35,ILI9340_BLACK);
+}
+/*----------------------------------------------------------------------------
+Function    :  clearHV()
+Inputs      :  None
+Processing  :  This function clears Heart rate variability parameters
+Outputs     :  None
+Returns     :  None
+Notes       :  None
+----------------------------------------------------------------------------*/
+void LcdScreen::clearHV(void)
+{
+	fillRect(145,215,86,35,ILI9340_BLACK);
+}
+/*----------------------------------------------------------------------------
+Function    :  clearScrn()
+Inputs      :  None
+Processing  :  This function clears entire the screen
+Outputs     :  None
+Returns     :  None
+Notes       :  None
+----------------------------------------------------------------------------*/
+void LcdScreen::clearScrn(void)
+{
+	fillRect(0,0,240,320,ILI9340_BLACK);
+}
+/*----------------------------------------------------------------------------
+Function    :  clearScrn3()
+Inputs      :  None
+Processing  :  This function clears Step parameters
+Outputs     :  None
+Returns     :  None
+Notes       :  None
+----------------------------------------------------------------------------*/
+void LcdScreen::clearScrn3(void)
+{
+	drawTriangle(120,10,240,190,10,190,ILI9340_BLACK);
+	drawString("!",110,50,4,ILI9340_BLACK);
+	drawString("ALERT",90,90,3,ILI9340_BLACK);
+	fillRect(75,125,115,55,ILI9340_BLACK);
+}
+
+/*===================================================================
+// $Log: $1.0 Moved the LCD driver out of display.cpp
+//
+//--------------------------------------------------------------------*/
@@ -51,11 +51,16 @@ Notes       :  None
 ----------------------------------------------------------------------------*/
 int main()
 {
+	// One msec slots for the accelerometer, temperature and display timer jobs
+	SampleScheduler::init((lpc_timer_t) one_ms_timer);
 	scheduler_add_task(new heartRate(PRIORITY_LOW));
+	// Writes the 'hrspool' file for the heart rate task
+	scheduler_add_task(new spoolWriter(PRIORITY_LOW));
 	scheduler_add_task(new display_Task(PRIORITY_MEDIUM));
 	scheduler_add_task(new button_Task(PRIORITY_MEDIUM));
 	scheduler_add_task(new tempMeasure(PRIORITY_LOW));
     scheduler_add_task(new orient_compute(PRIORITY_LOW));
+    scheduler_add_task(new terminalTask(PRIORITY_HIGH));
     scheduler_start();
     return 0;
 }
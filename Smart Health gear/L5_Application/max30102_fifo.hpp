@@ -0,0 +1,91 @@
+/*****************************************************************************
+$Work file     : max30102_fifo.hpp $
+Description    : This file contains the MAX30102 FIFO drain, written against any
+				 I2C bus so that host tests can run it on a simulated sensor
+Project(s)     : Smart Health Gear
+Compiler       : Cross ARM GCC
+OS			   : RTOS
+Original Author: $ agent
+$Author        : $ agent
+$Date          : $ 17 Oct 2026
+$Revision      : 1.0 $
+*****************************************************************************/
+#ifndef L5_APPLICATION_MAX30102_FIFO_HPP_
+#define L5_APPLICATION_MAX30102_FIFO_HPP_
+
+/****************************************************************************/
+/*                       INCLUDE FILES                                      */
+/****************************************************************************/
+#include <stdint.h>
+
+/****************************************************************************/
+/*                        MACRO Definitions                                 */
+/****************************************************************************/
+// MAX30102 FIFO holds 32 samples of 3 bytes red + 3 bytes IR
+#define  MAX30102_FIFO_DEPTH        (32)
+#define  MAX30102_SAMPLE_BYTES      (6)
+// I2C address of the MAX30102 (write address, as I2C_Base takes it)
+#define  MAX30102_I2C_ADDR          (0xAE)
+#define  MAX30102_REG_INT_STATUS_1  (0x00)
+#define  MAX30102_REG_FIFO_WR_PTR   (0x04)
+#define  MAX30102_REG_FIFO_DATA     (0x07)
+// INT_STATUS_1 : FIFO almost full (A_FULL), cleared by reading INT_STATUS_1
+#define  MAX30102_INT_A_FULL        (0x80)
+
+/****************************************************************************/
+/*                       Function definitions                               */
+/****************************************************************************/
+/*----------------------------------------------------------------------------
+Function    :  maxim_max30102_drain_fifo ()
+Inputs      :  I2C &bus       - bus with readRegisters(address, reg, data, length),
+						        I2C1 on the board
+			   uint8_t *puch_fifo - MAX30102_FIFO_DEPTH * MAX30102_SAMPLE_BYTES bytes
+Processing  :  This function reads the interrupt status and the FIFO write / read
+			   pointers, and then every pending sample of the MAX30102 FIFO in a
+			   single burst
+Outputs     :  *puch_fifo     - raw samples, MAX30102_SAMPLE_BYTES each
+			   *pun_overflows - samples lost because the FIFO was full, added
+Returns     :  Number of samples read
+Notes       :  Two I2C transactions when samples are pending, one otherwise.
+			   The almost-full interrupt (A_FULL) is only cleared by reading
+			   INT_STATUS_1, reading FIFO_DATA only clears PPG_RDY.  Until it is
+			   cleared the INT pin stays low and no new falling edge comes.
+			   Equal pointers are an empty or a full FIFO : with OVF_COUNTER at 0
+			   the FIFO is exactly full when A_FULL says samples are waiting.
+----------------------------------------------------------------------------*/
+template <typename I2C>
+uint8_t maxim_max30102_drain_fifo(I2C &bus, uint8_t *puch_fifo, uint32_t *pun_overflows)
+{
+  // INT_STATUS_1 (0x00) to FIFO_RD_PTR (0x06) : status 1 and 2, enable 1 and 2,
+  // FIFO_WR_PTR, OVF_COUNTER and FIFO_RD_PTR
+  uint8_t ach_regs[7] = {0};
+  const uint8_t *ach_ptr = ach_regs + MAX30102_REG_FIFO_WR_PTR;
+  uint8_t uch_samples;
+
+  // reading INT_STATUS_1 releases the INT pin for the next almost-full interrupt
+  if(!bus.readRegisters(MAX30102_I2C_ADDR, MAX30102_REG_INT_STATUS_1, ach_regs, sizeof(ach_regs)))
+	  return 0;
+
+  uch_samples = (ach_ptr[0] - ach_ptr[2]) & (MAX30102_FIFO_DEPTH - 1);
+  if(ach_ptr[1] != 0)
+  {
+	  // FIFO is full (write pointer caught up with the read pointer)
+	  *pun_overflows += ach_ptr[1];
+	  uch_samples = MAX30102_FIFO_DEPTH;
+  }
+  else if(uch_samples == 0 && (ach_regs[0] & MAX30102_INT_A_FULL))
+  {
+	  // full with no sample lost yet
+	  uch_samples = MAX30102_FIFO_DEPTH;
+  }
+  if(uch_samples == 0)
+	  return 0;
+
+  // FIFO_DATA does not auto-increment, so the whole burst comes from 0x07
+  if(!bus.readRegisters(MAX30102_I2C_ADDR, MAX30102_REG_FIFO_DATA, puch_fifo, uch_samples * MAX30102_SAMPLE_BYTES))
+	  return 0;
+
+  return uch_samples;
+}
+
+#endif /* L5_APPLICATION_MAX30102_FIFO_HPP_ */
@@ -0,0 +1,187 @@
+/*****************************************************************************
+$Work file     : peak_detect.cpp $
+Description    : This file contains the peak detection and close-peak suppression
+Project(s)     : Smart Health Gear
+Compiler       : Cross ARM GCC
+OS			   : RTOS
+Original Author: $ MAXIM REFDES 117
+$Author        : $ agent
+$Date          : $ 17 Oct 2026
+$Revision      : 1.0 $
+*****************************************************************************/
+
+/****************************************************************************/
+/*                       INCLUDE FILES                                      */
+/****************************************************************************/
+#include "peak_detect.hpp"
+
+
+/*----------------------------------------------------------------------------
+Function    :  peak_before ()
+Inputs      :  pn_heights - candidate heights
+			   a, b       - candidate numbers
+Processing  :  This function tells whether candidate a is visited before b :
+			   larger first, and the earlier one first for equal heights
+Outputs     :  None
+Returns     :  true if a comes before b
+Notes       :  Same order as the stable insertion sort of maxim_sort_indices_descend()
+----------------------------------------------------------------------------*/
+static inline bool peak_before(const int32_t *pn_heights, int32_t a, int32_t b)
+{
+    return (pn_heights[a] > pn_heights[b]) || (pn_heights[a] == pn_heights[b] && a < b);
+}
+
+/*----------------------------------------------------------------------------
+Function    :  peak_sift_down ()
+Inputs      :  pn_heights - candidate heights
+			   pn_order   - heap of candidate numbers
+			   n_root     - heap entry to move down
+			   n_size     - number of heap entries
+Processing  :  This function restores the heap below n_root, with the
+			   candidate visited last at the top
+Outputs     :  None
+Returns     :  None
+Notes       :  None
+----------------------------------------------------------------------------*/
+static void peak_sift_down(const int32_t *pn_heights, int32_t *pn_order, int32_t n_root, int32_t n_size)
+{
+    const int32_t n_temp = pn_order[n_root];
+    int32_t n_child;
+
+    while ((n_child = 2 * n_root + 1) < n_size) {
+        if (n_child + 1 < n_size && peak_before(pn_heights, pn_order[n_child], pn_order[n_child + 1]))
+            n_child++;
+        if (!peak_before(pn_heights, n_temp, pn_order[n_child]))
+            break;
+        pn_order[n_root] = pn_order[n_child];
+        n_root = n_child;
+    }
+    pn_order[n_root] = n_temp;
+}
+
+/*----------------------------------------------------------------------------
+Function    :  peak_find_candidates ()
+Inputs      :  pn_x             - signal
+			   n_size           - number of samples in pn_x
+			   n_min_height     - peaks must be above this value
+			   n_max_candidates - size of pn_locs and pn_heights
+Processing  :  This function finds local maxima above n_min_height in one pass.
+			   For flat peaks the location is the left edge.
+Outputs     :  *pn_locs    - peak locations, ascending
+			   *pn_heights - value of pn_x at each location
+Returns     :  Number of candidates, at most n_max_candidates
+Notes       :  A plateau that runs to the end of the signal is not a peak
+----------------------------------------------------------------------------*/
+int32_t peak_find_candidates(const int32_t *pn_x, int32_t n_size, int32_t n_min_height,
+                             int32_t *pn_locs, int32_t *pn_heights, int32_t n_max_candidates)
+{
+    int32_t i = 1, n_width, n_npks = 0;
+
+    while (i < n_size-1 && n_npks < n_max_candidates){
+        if (pn_x[i] > n_min_height && pn_x[i] > pn_x[i-1]){            // find left edge of potential peaks
+            n_width = 1;
+            while (i+n_width < n_size && pn_x[i] == pn_x[i+n_width])    // find flat peaks
+                n_width++;
+            if (i+n_width < n_size && pn_x[i] > pn_x[i+n_width]){       // find right edge of peaks
+                pn_locs[n_npks] = i;
+                pn_heights[n_npks] = pn_x[i];
+                n_npks++;
+                i += n_width+1;
+            }
+            else
+                i += n_width;
+        }
+        else
+            i++;
+    }
+    return n_npks;
+}
+
+/*----------------------------------------------------------------------------
+Function    :  peak_order_by_height ()
+Inputs      :  pn_heights - candidate heights
+			   n_npks     - number of candidates
+Processing  :  This function heap sorts the candidate numbers from the largest
+			   to the smallest height, earlier candidates first for equal heights
+Outputs     :  *pn_order  - candidate numbers in visiting order
+Returns     :  None
+Notes       :  O(n log n), no recursion and no extra memory
+----------------------------------------------------------------------------*/
+void peak_order_by_height(const int32_t *pn_heights, int32_t *pn_order, int32_t n_npks)
+{
+    int32_t k, n_temp;
+
+    for (k = 0; k < n_npks; k++)
+        pn_order[k] = k;
+    for (k = n_npks/2 - 1; k >= 0; k--)
+        peak_sift_down(pn_heights, pn_order, k, n_npks);
+
+    // the top of the heap is the candidate visited last, move it to the end
+    for (k = n_npks - 1; k > 0; k--) {
+        n_temp = pn_order[0];
+        pn_order[0] = pn_order[k];
+        pn_order[k] = n_temp;
+        peak_sift_down(pn_heights, pn_order, 0, k);
+    }
+}
+
+/*----------------------------------------------------------------------------
+Function    :  peak_suppress_close ()
+Inputs      :  pn_locs        - candidate locations, ascending
+			   pn_heights     - candidate heights
+			   n_npks         - number of candidates
+			   n_min_distance - minimum distance between two kept peaks
+			   pn_order       - work buffer of n_npks entries
+			   puch_state     - work buffer of n_npks entries
+Processing  :  This function removes peaks separated by less than
+			   n_min_distance from a larger peak. Like maxim_remove_close_peaks(),
+			   a lag-zero peak is assumed at index -1.
+Outputs     :  *pn_locs    - kept locations, still ascending
+			   *pn_heights - kept heights
+Returns     :  Number of kept peaks
+Notes       :  None
+----------------------------------------------------------------------------*/
+int32_t peak_suppress_close(int32_t *pn_locs, int32_t *pn_heights, int32_t n_npks, int32_t n_min_distance,
+                            int32_t *pn_order, uint8_t *puch_state)
+{
+    int32_t k, j, n_kept = 0;
+
+    for (k = 0; k < n_npks; k++)
+        puch_state[k] = (pn_locs[k] + 1 > n_min_distance) ? PEAK_STATE_PENDING : PEAK_STATE_REMOVED;
+
+    peak_order_by_height(pn_heights, pn_order, n_npks);
+
+    // sweep from the largest peak, kept peaks remove the smaller ones next to them
+    for (k = 0; k < n_npks; k++) {
+        const int32_t n_cand = pn_order[k];
+        if (PEAK_STATE_REMOVED == puch_state[n_cand])
+            continue;
+
+        uint8_t uch_state = PEAK_STATE_KEPT;
+        for (j = n_cand - 1; j >= 0 && pn_locs[n_cand] - pn_locs[j] <= n_min_distance; j--) {
+            if (PEAK_STATE_KEPT == puch_state[j]) {
+                uch_state = PEAK_STATE_REMOVED;
+                break;
+            }
+        }
+        for (j = n_cand + 1; PEAK_STATE_KEPT == uch_state && j < n_npks && pn_locs[j] - pn_locs[n_cand] <= n_min_distance; j++) {
+            if (PEAK_STATE_KEPT == puch_state[j])
+                uch_state = PEAK_STATE_REMOVED;
+        }
+        puch_state[n_cand] = uch_state;
+    }
+
+    // compact in place, candidates are already in ascending location order
+    for (k = 0; k < n_npks; k++) {
+        if (PEAK_STATE_KEPT == puch_state[k]) {
+            pn_locs[n_kept] = pn_locs[k];
+            pn_heights[n_kept] = pn_heights[k];
+            n_kept++;
+        }
+    }
+    return n_kept;
+}
+/*===================================================================
+// $Log: $1.0 Linear scan and heap ordered close-peak suppression
+//
+//--------------------------------------------------------------------*/
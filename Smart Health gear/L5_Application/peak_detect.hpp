@@ -0,0 +1,68 @@
+/*****************************************************************************
+$Work file     : peak_detect.hpp $
+Description    : This file contains the peak detection and close-peak suppression
+Project(s)     : Smart Health Gear
+Compiler       : Cross ARM GCC
+OS			   : RTOS
+Original Author: $ MAXIM REFDES 117
+$Author        : $ agent
+$Date          : $ 17 Oct 2026
+$Revision      : 1.0 $
+*****************************************************************************/
+#ifndef L5_APPLICATION_PEAK_DETECT_HPP_
+#define L5_APPLICATION_PEAK_DETECT_HPP_
+
+/****************************************************************************/
+/*                       INCLUDE FILES                                      */
+/****************************************************************************/
+#include <stdint.h>
+
+/****************************************************************************/
+/*                        MACRO Definitions                                 */
+/****************************************************************************/
+// Peak candidates kept by the heart rate algorithm (at 100 sps, 15 peaks in
+// 5 seconds is 180 bpm). Can be overridden from the build flags.
+#ifndef PEAK_MAX_CANDIDATES
+#define PEAK_MAX_CANDIDATES        (15)
+#endif
+// Peaks closer than this (in samples) to a larger peak are removed
+#ifndef PEAK_MIN_DISTANCE
+#define PEAK_MIN_DISTANCE          (8)
+#endif
+// Number of peaks used for the heart rate
+#ifndef PEAK_MAX_HR_PEAKS
+#define PEAK_MAX_HR_PEAKS          (5)
+#endif
+
+// State of a candidate during peak_suppress_close()
+#define PEAK_STATE_PENDING         (0)
+#define PEAK_STATE_KEPT            (1)
+#define PEAK_STATE_REMOVED         (2)
+
+/****************************************************************************/
+/*                       Function declarations                              */
+/****************************************************************************/
+/*
+ * Peaks are found in two steps :
+ *  1. peak_find_candidates() scans the signal once for local maxima above a
+ *     minimum height, giving candidates in ascending location order.
+ *  2. peak_suppress_close() visits the candidates from largest to smallest
+ *     (heap sort) and keeps one only if no larger kept peak is within the
+ *     minimum distance.  Candidates are at least 2 samples apart, so only
+ *     n_min_distance/2 neighbours on each side need to be checked.
+ *
+ * The cost is O(n) for the scan and O(p log p) for p candidates, instead of
+ * the O(p^2) insertion sorts and rescans of the original Maxim code, with the
+ * same result.
+ */
+int32_t peak_find_candidates(const int32_t *pn_x, int32_t n_size, int32_t n_min_height,
+                             int32_t *pn_locs, int32_t *pn_heights, int32_t n_max_candidates);
+void    peak_order_by_height(const int32_t *pn_heights, int32_t *pn_order, int32_t n_npks);
+int32_t peak_suppress_close(int32_t *pn_locs, int32_t *pn_heights, int32_t n_npks, int32_t n_min_distance,
+                            int32_t *pn_order, uint8_t *puch_state);
+
+#endif /* L5_APPLICATION_PEAK_DETECT_HPP_ */
+/*===================================================================
+// $Log: $1.0 Linear scan and heap ordered close-peak suppression
+//
+//--------------------------------------------------------------------*/
@@ -0,0 +1,423 @@
+/*****************************************************************************
+$Work file     : ppg_stream.cpp $
+Description    : This file contains the streaming heart rate / SpO2 engine
+Project(s)     : Smart Health Gear
+Compiler       : Cross ARM GCC
+OS			   : RTOS
+Original Author: $ MAXIM REFDES 117
+$Author        : $ agent
+$Date          : $ 17 Oct 2026
+$Revision      : 1.0 $
+*****************************************************************************/
+
+/****************************************************************************/
+/*                       INCLUDE FILES                                      */
+/****************************************************************************/
+#include <stdlib.h>
+#include <string.h>
+#include "ppg_stream.hpp"
+
+
+/*----------------------------------------------------------------------------
+Function    :  PpgStreamEngineT (Constructor)
+Inputs      :  None
+Processing  :  This function clears the engine and selects one output per second
+Outputs     :  None
+Returns     :  None
+Notes       :  None
+----------------------------------------------------------------------------*/
+template <uint32_t SAMPLE_RATE, uint32_t WINDOW_SIZE>
+PpgStreamEngineT<SAMPLE_RATE, WINDOW_SIZE>::PpgStreamEngineT() : mOutputInterval(SAMPLE_RATE), mSpo2Enabled(true)
+{
+    reset();
+}
+
+/*----------------------------------------------------------------------------
+Function    :  reset ()
+Inputs      :  None
+Processing  :  This function discards all samples and filter state
+Outputs     :  None
+Returns     :  None
+Notes       :  The output interval is kept
+----------------------------------------------------------------------------*/
+template <uint32_t SAMPLE_RATE, uint32_t WINDOW_SIZE>
+void PpgStreamEngineT<SAMPLE_RATE, WINDOW_SIZE>::reset(void)
+{
+    mCount       = 0;
+    mSinceOutput = 0;
+    mAbsSum      = 0;
+    mPrevFilt    = 0;
+    mRising      = false;
+    mCandLoc     = 0;
+    mPeakHead    = 0;
+    mPeakCount   = 0;
+    mBeatCount   = 0;
+    mLastBeat    = 0;
+    mIrMa4.reset();
+    mRedMa4.reset();
+    mIrChain.reset();
+}
+
+/*----------------------------------------------------------------------------
+Function    :  setOutputInterval ()
+Inputs      :  samples - number of samples between two outputs
+Processing  :  This function sets how often addSample() reports an output
+Outputs     :  None
+Returns     :  None
+Notes       :  Zero is treated as one (an output for every sample)
+----------------------------------------------------------------------------*/
+template <uint32_t SAMPLE_RATE, uint32_t WINDOW_SIZE>
+void PpgStreamEngineT<SAMPLE_RATE, WINDOW_SIZE>::setOutputInterval(uint32_t samples)
+{
+    mOutputInterval = (0 == samples) ? 1 : samples;
+    mSinceOutput = 0;
+}
+
+/*----------------------------------------------------------------------------
+Function    :  addSample ()
+Inputs      :  un_red - raw red LED sample
+			   un_ir  - raw IR LED sample
+Processing  :  This function stores the sample, runs the MA4 stage for red and
+			   IR and feeds the IR average through the rest of the filter chain
+Outputs     :  None
+Returns     :  true when an output is due
+Notes       :  None
+----------------------------------------------------------------------------*/
+template <uint32_t SAMPLE_RATE, uint32_t WINDOW_SIZE>
+bool PpgStreamEngineT<SAMPLE_RATE, WINDOW_SIZE>::addSample(uint32_t un_red, uint32_t un_ir)
+{
+    const uint32_t n = mCount++;
+    int32_t n_ir_ma, n_red_ma;
+
+    mIrRaw[slot(n)] = un_ir;
+
+    // 4 pt Moving Average of raw red and IR, the batch algorithm uses the same
+    // averages for the SpO2 ratio so they are kept for the whole window.
+    // Both stages get every sample, so they produce their first output together.
+    const bool b_ir_ready = mIrMa4.push(un_ir, n_ir_ma);
+    const bool b_red_ready = mRedMa4.push(un_red, n_red_ma);
+    if (b_ir_ready && b_red_ready)
+    {
+        const uint32_t un_ma_index = n - (kMaSize - 1);
+        mIrMa [slot(un_ma_index)] = n_ir_ma;
+        mRedMa[slot(un_ma_index)] = n_red_ma;
+
+        filterStep(un_ma_index, n_ir_ma);
+    }
+
+    if (!windowReady()) {
+        return false;
+    }
+
+    // First output as soon as the window is full, then every mOutputInterval samples
+    if (kWindow == mCount || ++mSinceOutput >= mOutputInterval) {
+        mSinceOutput = 0;
+        return true;
+    }
+    return false;
+}
+
+/*----------------------------------------------------------------------------
+Function    :  filterStep ()
+Inputs      :  un_ma_index - absolute index of the MA4 output
+			   n_ir_ma     - MA4 output
+Processing  :  This function runs the difference, 2-pt MA and Hamming window
+			   stages for one sample and updates the peak threshold sum
+Outputs     :  None
+Returns     :  None
+Notes       :  The DC is not removed first; the difference stage rejects it,
+			   but the chain then rounds differently from the batch algorithm
+----------------------------------------------------------------------------*/
+template <uint32_t SAMPLE_RATE, uint32_t WINDOW_SIZE>
+void PpgStreamEngineT<SAMPLE_RATE, WINDOW_SIZE>::filterStep(uint32_t un_ma_index, int32_t n_ir_ma)
+{
+    int32_t n_filt;
+
+    // difference, 2-pt MA and hamming window, flipped so that valleys show up as peaks
+    if (!mIrChain.push(n_ir_ma, n_filt)) {
+        return;
+    }
+
+    const uint32_t un_index = un_ma_index - IrDerivativeChain::kDelay;
+    mFilt[slot(un_index)] = n_filt;
+    mAbsSum += abs(n_filt);
+    if (un_index >= kWindow - kLatency) {
+        mAbsSum -= abs(mFilt[slot(un_index - (kWindow - kLatency))]);
+    }
+
+    peakStep(un_index, n_filt);
+}
+
+/*----------------------------------------------------------------------------
+Function    :  peakStep ()
+Inputs      :  un_index - absolute index of the filtered sample
+			   n_value  - filtered sample
+Processing  :  This function records the left edge of a (flat) peak once the
+			   signal drops after a rising edge, like peak_find_candidates()
+Outputs     :  None
+Returns     :  None
+Notes       :  The height threshold is applied in compute()
+----------------------------------------------------------------------------*/
+template <uint32_t SAMPLE_RATE, uint32_t WINDOW_SIZE>
+void PpgStreamEngineT<SAMPLE_RATE, WINDOW_SIZE>::peakStep(uint32_t un_index, int32_t n_value)
+{
+    if (un_index > 0)
+    {
+        if (n_value > mPrevFilt) {
+            mRising  = true;
+            mCandLoc = un_index;
+        }
+        else if (n_value < mPrevFilt) {
+            if (mRising) {
+                pushPeak(mCandLoc, mPrevFilt);
+            }
+            mRising = false;
+        }
+    }
+    mPrevFilt = n_value;
+}
+
+/*----------------------------------------------------------------------------
+Function    :  pushPeak ()
+Inputs      :  un_loc    - absolute index of the peak
+			   n_height  - filtered value of the peak
+Processing  :  This function appends a peak candidate to the ring
+Outputs     :  None
+Returns     :  None
+Notes       :  None
+----------------------------------------------------------------------------*/
+template <uint32_t SAMPLE_RATE, uint32_t WINDOW_SIZE>
+void PpgStreamEngineT<SAMPLE_RATE, WINDOW_SIZE>::pushPeak(uint32_t un_loc, int32_t n_height)
+{
+    if (kMaxCandidates == mPeakCount) {
+        mPeakHead = (mPeakHead + 1) % kMaxCandidates;
+        --mPeakCount;
+    }
+    peak_t& peak = mPeaks[(mPeakHead + mPeakCount) % kMaxCandidates];
+    peak.un_loc = un_loc;
+    peak.n_height = n_height;
+    ++mPeakCount;
+}
+
+/*----------------------------------------------------------------------------
+Function    :  evictPeaks ()
+Inputs      :  un_min_loc - oldest absolute index to keep
+Processing  :  This function drops peak candidates that left the window
+Outputs     :  None
+Returns     :  None
+Notes       :  None
+----------------------------------------------------------------------------*/
+template <uint32_t SAMPLE_RATE, uint32_t WINDOW_SIZE>
+void PpgStreamEngineT<SAMPLE_RATE, WINDOW_SIZE>::evictPeaks(uint32_t un_min_loc)
+{
+    while (mPeakCount > 0 && mPeaks[mPeakHead].un_loc < un_min_loc) {
+        mPeakHead = (mPeakHead + 1) % kMaxCandidates;
+        --mPeakCount;
+    }
+}
+
+/*----------------------------------------------------------------------------
+Function    :  compute ()
+Inputs      :  None
+Processing  :  This function applies the threshold and close-peak suppression
+			   to the tracked peaks, then refines the valleys and computes the
+			   SpO2 ratio on the stored MA4 rings, following the steps of
+			   maxim_heart_rate_and_oxygen_saturation() on a full buffer
+Outputs     :  *pn_spo2                - Calculated SpO2 value
+ 	 	 	   *pch_spo2_valid         - 1 if the calculated SpO2 value is valid
+ 	 	 	   *pn_heart_rate          - Calculated heart rate value
+ 	 	 	   *pch_hr_valid           - 1 if the calculated heart rate value is valid
+Returns     :  None
+Notes       :  Locations below are relative to the oldest sample of the window.
+			   SpO2 is left invalid while setSpo2Enabled(false).
+			   Results can differ from the batch algorithm, see ppg_stream.hpp
+----------------------------------------------------------------------------*/
+template <uint32_t SAMPLE_RATE, uint32_t WINDOW_SIZE>
+void PpgStreamEngineT<SAMPLE_RATE, WINDOW_SIZE>::compute(int32_t *pn_spo2, int8_t *pch_spo2_valid, int32_t *pn_heart_rate, int8_t *pch_hr_valid)
+{
+    int32_t k, i;
+    int32_t an_locs[kMaxPeaks];
+    int32_t an_heights[kMaxPeaks];
+    int32_t an_order[kMaxPeaks];
+    uint8_t auch_state[kMaxPeaks];
+    int32_t an_exact_ir_valley_locs[kMaxPeaks];
+    int32_t n_npks = 0, n_exact_ir_valley_locs_count = 0;
+
+    *pn_heart_rate = -999;
+    *pch_hr_valid  = 0;
+    *pn_spo2       = -999;
+    *pch_spo2_valid = 0;
+    mBeatCount = 0;
+
+    if (!windowReady()) {
+        return;
+    }
+
+    const uint32_t un_start = mCount - kWindow;
+
+    // The batch peak finder never reports the first sample of the window
+    evictPeaks(un_start + 1);
+
+    // threshold is the mean absolute value of the filtered signal
+    const int32_t n_th1 = mAbsSum / (int32_t)(kWindow - kLatency);
+
+    // peaks above the threshold, at most kMaxPeaks in time order
+    for (uint32_t p = 0; p < mPeakCount && n_npks < kMaxPeaks; p++) {
+        const peak_t& peak = mPeaks[(mPeakHead + p) % kMaxCandidates];
+        if (peak.n_height > n_th1) {
+            an_locs[n_npks]    = (int32_t)(peak.un_loc - un_start);
+            an_heights[n_npks] = peak.n_height;
+            n_npks++;
+        }
+    }
+
+    // Keep a peak only if no larger kept peak is within kMinDistance
+    n_npks = peak_suppress_close(an_locs, an_heights, n_npks, kMinDistance, an_order, auch_state);
+
+    // Kept peaks more than kMinDistance before the newest filtered sample are beats
+    const uint32_t un_newest = mCount - 1 - kLatency;
+    for (k = 0; k < n_npks; k++) {
+        const uint32_t un_loc = un_start + (uint32_t)an_locs[k];
+        if (un_loc > mLastBeat && un_loc + kMinDistance <= un_newest) {
+            mBeats[mBeatCount++] = un_loc;
+            mLastBeat = un_loc;
+        }
+    }
+    n_npks = min(n_npks, kMaxHrPeaks);
+
+    if (n_npks >= 2) {
+        int32_t n_peak_interval_sum = 0;
+        for (k = 1; k < n_npks; k++) {
+            n_peak_interval_sum += (an_locs[k] - an_locs[k-1]);
+        }
+        n_peak_interval_sum = n_peak_interval_sum / (n_npks - 1);
+        *pn_heart_rate = (int32_t)((kSampleRate * 60) / n_peak_interval_sum); // beats per minutes
+        *pch_hr_valid  = 1;
+    }
+
+    // everything below is for SpO2 only
+    if (!mSpo2Enabled) {
+        return;
+    }
+
+    // find precise min of raw IR near each valley
+    for (k = 0; k < n_npks; k++) {
+        const int32_t m = an_locs[k] + HAMMING_SIZE/2;
+        if (m + kValleySpan < (int32_t)kWindow - HAMMING_SIZE && m - kValleySpan > 0) {
+            int32_t n_c_min = 16777216; // 2^24
+            for (i = m - kValleySpan; i < m + kValleySpan; i++) {
+                const int32_t n_ir = (int32_t)mIrRaw[slot(un_start + i)];
+                if (n_ir < n_c_min) {
+                    n_c_min = n_ir;
+                    an_exact_ir_valley_locs[n_exact_ir_valley_locs_count] = i;
+                }
+            }
+            n_exact_ir_valley_locs_count++;
+        }
+    }
+    if (n_exact_ir_valley_locs_count < 2) {
+        return; // do not use SPO2 since signal ratio is out of range
+    }
+
+    // find max between two valley locations
+    // and use ratio betwen AC compoent of Ir & Red and DC compoent of Ir & Red for SPO2
+    int32_t an_ratio[5] = { 0 };
+    int32_t n_i_ratio_count = 0;
+    for (k = 0; k < n_exact_ir_valley_locs_count - 1; k++) {
+        const int32_t n_v0 = an_exact_ir_valley_locs[k];
+        const int32_t n_v1 = an_exact_ir_valley_locs[k+1];
+        if (n_v1 - n_v0 <= kMinValleyGap) {
+            continue;
+        }
+
+        int32_t n_y_dc_max = -16777216;
+        int32_t n_x_dc_max = -16777216;
+        int32_t n_y_dc_max_idx = n_v0;
+        int32_t n_x_dc_max_idx = n_v0;
+        for (i = n_v0; i < n_v1; i++) {
+            const int32_t n_x = mIrMa[slot(un_start + i)];
+            const int32_t n_y = mRedMa[slot(un_start + i)];
+            if (n_x > n_x_dc_max) { n_x_dc_max = n_x; n_x_dc_max_idx = i; }
+            if (n_y > n_y_dc_max) { n_y_dc_max = n_y; n_y_dc_max_idx = i; }
+        }
+        const int32_t n_x0 = mIrMa [slot(un_start + n_v0)];
+        const int32_t n_x1 = mIrMa [slot(un_start + n_v1)];
+        const int32_t n_y0 = mRedMa[slot(un_start + n_v0)];
+        const int32_t n_y1 = mRedMa[slot(un_start + n_v1)];
+
+        int32_t n_y_ac = (n_y1 - n_y0) * (n_y_dc_max_idx - n_v0); //red
+        n_y_ac = n_y0 + n_y_ac / (n_v1 - n_v0);
+        n_y_ac = mRedMa[slot(un_start + n_y_dc_max_idx)] - n_y_ac; // subracting linear DC compoenents from raw
+        int32_t n_x_ac = (n_x1 - n_x0) * (n_x_dc_max_idx - n_v0); // ir
+        n_x_ac = n_x0 + n_x_ac / (n_v1 - n_v0);
+        n_x_ac = mIrMa[slot(un_start + n_y_dc_max_idx)] - n_x_ac;  // same index as the batch algorithm
+
+        const int32_t n_nume  = (n_y_ac * n_x_dc_max) >> 7; //prepare X100 to preserve floating value
+        const int32_t n_denom = (n_x_ac * n_y_dc_max) >> 7;
+        if (n_denom > 0 && n_i_ratio_count < 5 && n_nume != 0) {
+            an_ratio[n_i_ratio_count++] = (n_nume * 100) / n_denom;
+        }
+    }
+
+    maxim_sort_ascend(an_ratio, n_i_ratio_count);
+    const int32_t n_middle_idx = n_i_ratio_count / 2;
+    int32_t n_ratio_average;
+    if (n_middle_idx > 1)
+        n_ratio_average = (an_ratio[n_middle_idx-1] + an_ratio[n_middle_idx]) / 2; // use median
+    else
+        n_ratio_average = an_ratio[n_middle_idx];
+
+    if (n_ratio_average > 2 && n_ratio_average < 184) {
+        *pn_spo2 = uch_spo2_table[n_ratio_average];
+        *pch_spo2_valid = 1;
+    }
+}
+
+/*----------------------------------------------------------------------------
+Function    :  getBeats ()
+Inputs      :  un_max    - size of pun_locs
+Processing  :  This function copies the beats found by the last compute()
+Outputs     :  *pun_locs - absolute sample index of each beat, oldest first
+Returns     :  Number of beats copied
+Notes       :  The PPG rings are not touched, only the peak locations are copied
+----------------------------------------------------------------------------*/
+template <uint32_t SAMPLE_RATE, uint32_t WINDOW_SIZE>
+uint32_t PpgStreamEngineT<SAMPLE_RATE, WINDOW_SIZE>::getBeats(uint32_t *pun_locs, uint32_t un_max) const
+{
+    const uint32_t un_count = (mBeatCount < un_max) ? mBeatCount : un_max;
+    for (uint32_t k = 0; k < un_count; k++) {
+        pun_locs[k] = mBeats[k];
+    }
+    return un_count;
+}
+
+/*----------------------------------------------------------------------------
+Function    :  ppg_engine_create ()
+Inputs      :  un_sample_rate - 25, 50, 100 or 200 samples per second
+Processing  :  This function allocates the engine built for the sample rate,
+			   with a PPG_STREAM_WINDOW_SEC window
+Outputs     :  None
+Returns     :  The new engine, or NULL
+Notes       :  The 200 sps engine needs about 20 Kbytes
+----------------------------------------------------------------------------*/
+PpgEngine* ppg_engine_create(uint32_t un_sample_rate)
+{
+    switch (un_sample_rate)
+    {
+        case 25:  return new PpgStreamEngineT<25,  25  * PPG_STREAM_WINDOW_SEC>();
+        case 50:  return new PpgStreamEngineT<50,  50  * PPG_STREAM_WINDOW_SEC>();
+        case 100: return new PpgStreamEngineT<100, 100 * PPG_STREAM_WINDOW_SEC>();
+        case 200: return new PpgStreamEngineT<200, 200 * PPG_STREAM_WINDOW_SEC>();
+        default:  return NULL;
+    }
+}
+
+// Engines available to ppg_engine_create(), the batch rate is always built
+template class PpgStreamEngineT<FS, BUFFER_SIZE>;
+template class PpgStreamEngineT<25,  25  * PPG_STREAM_WINDOW_SEC>;
+template class PpgStreamEngineT<50,  50  * PPG_STREAM_WINDOW_SEC>;
+template class PpgStreamEngineT<200, 200 * PPG_STREAM_WINDOW_SEC>;
+/*===================================================================
+// $Log: $1.0 Streaming engine for heart rate and SpO2
+//
+//--------------------------------------------------------------------*/
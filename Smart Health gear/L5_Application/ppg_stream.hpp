@@ -0,0 +1,246 @@
+/*****************************************************************************
+$Work file     : ppg_stream.hpp $
+Description    : This file contains the streaming heart rate / SpO2 engine
+Project(s)     : Smart Health Gear
+Compiler       : Cross ARM GCC
+OS			   : RTOS
+Original Author: $ MAXIM REFDES 117
+$Author        : $ agent
+$Date          : $ 17 Oct 2026
+$Revision      : 1.0 $
+*****************************************************************************/
+#ifndef L5_APPLICATION_PPG_STREAM_HPP_
+#define L5_APPLICATION_PPG_STREAM_HPP_
+
+/****************************************************************************/
+/*                       INCLUDE FILES                                      */
+/****************************************************************************/
+#include <stdint.h>
+#include "algorithm.hpp"
+
+/****************************************************************************/
+/*                        MACRO Definitions                                 */
+/****************************************************************************/
+// Window of the streaming engines, same 5 seconds as the batch algorithm at every rate
+#define PPG_STREAM_WINDOW_SEC      (BUFFER_SIZE / FS)
+
+/*----------------------------------------------------------------------------
+Function    :  ppg_scale_samples ()
+Inputs      :  un_samples     - number of samples at FS (100 sps)
+			   un_sample_rate - samples per second to convert to
+Processing  :  This function converts a duration given in samples at FS to the
+			   same duration at another rate, at compile time
+Outputs     :  None
+Returns     :  Number of samples, at least 1
+Notes       :  None
+----------------------------------------------------------------------------*/
+constexpr uint32_t ppg_scale_samples(uint32_t un_samples, uint32_t un_sample_rate)
+{
+    return ((un_samples * un_sample_rate / FS) > 0) ? (un_samples * un_sample_rate / FS) : 1;
+}
+
+/****************************************************************************/
+/*                       Class declarations                                 */
+/****************************************************************************/
+/**
+ * Interface of the streaming heart rate / SpO2 engines, so that the heart rate
+ * task can switch between sample rates at runtime (see ppg_engine_create()).
+ */
+class PpgEngine
+{
+    public:
+        virtual ~PpgEngine() { }
+
+        /// Discards all samples and filter state
+        virtual void reset(void) = 0;
+
+        /**
+         * Sets the number of samples between two outputs once the window is full.
+         * @param samples  getSampleRate() gives one result per second, etc.
+         */
+        virtual void setOutputInterval(uint32_t samples) = 0;
+        virtual uint32_t getOutputInterval(void) const = 0;
+
+        /**
+         * Enables or skips the SpO2 stages (valley refinement, AC/DC ratios, median
+         * and table lookup) of compute().  Heart rate and beats are always computed.
+         * @param b_enabled  false reports SpO2 as not valid, ie: while the wearer moves
+         */
+        virtual void setSpo2Enabled(bool b_enabled) = 0;
+
+        /**
+         * Adds one red/IR sample pair to the engine.
+         * @returns true when a new output is due and compute() should be called
+         */
+        virtual bool addSample(uint32_t un_red, uint32_t un_ir) = 0;
+
+        /// @returns true once a full window of samples has been collected
+        virtual bool windowReady(void) const = 0;
+
+        /// @returns the total number of samples added since reset()
+        virtual uint32_t getSampleCount(void) const = 0;
+
+        /// @returns the samples per second and the window length this engine was built for
+        virtual uint32_t getSampleRate(void) const = 0;
+        virtual uint32_t getWindowSize(void) const = 0;
+
+        /**
+         * Computes heart rate and SpO2 over the last window of samples.
+         * Outputs follow the same convention as maxim_heart_rate_and_oxygen_saturation()
+         */
+        virtual void compute(int32_t *pn_spo2, int8_t *pch_spo2_valid, int32_t *pn_heart_rate, int8_t *pch_hr_valid) = 0;
+
+        /**
+         * Copies the beats confirmed by the last compute(), oldest first.  A beat is
+         * a kept heart rate peak that no newer peak can suppress any more; each one
+         * is reported once, as an absolute sample index (see getSampleCount()).
+         * @returns the number of beats copied
+         */
+        virtual uint32_t getBeats(uint32_t *pun_locs, uint32_t un_max) const = 0;
+};
+
+/**
+ * Streaming version of maxim_heart_rate_and_oxygen_saturation().
+ *
+ * Every filter stage (MA4, difference, 2-pt MA and the Hamming window, see
+ * fir_filter.hpp) keeps its own state and runs once per new sample, and peak
+ * candidates of the filtered signal are tracked as they appear.  When an output
+ * is due, only the short peak list and the spans between valleys are visited,
+ * so nothing is shifted or recomputed over the whole window.
+ *
+ * The sample rate and window length are template parameters.  The durations of
+ * the batch algorithm (given in samples at FS) are scaled to the sample rate at
+ * compile time.  The Hamming window keeps its 5 taps at every rate.
+ *
+ * PpgStreamEngineT<FS, BUFFER_SIZE> follows the stages of
+ * maxim_heart_rate_and_oxygen_saturation() but is not bit-exact with it :
+ *  - The IR DC is not removed before the MA4, so the truncating divisions of
+ *    the filter chain round differently.
+ *  - The threshold and the peaks cover the kWindow - kLatency filtered samples
+ *    (491 at FS).  The batch code uses 495 entries of an_dx[], the last 6 of
+ *    which are not Hamming filtered or flipped.
+ * A peak close to the threshold can then be kept by one and dropped by the
+ * other.  On host/ppg_replay --synth traces (300 sec each, 50 to 160 bpm, SpO2
+ * 92 to 98 %, 0 to 10 % noise, 28416 outputs) the heart rate differs in 2.9 %
+ * of the outputs (2.4 % by more than 1 bpm or in validity) and SpO2 in 1.0 %.
+ * Run host/ppg_replay on a recorded trace to compare the two on real data.
+ *
+ * @code
+ *      PpgStreamEngine engine;         // FS samples per second, BUFFER_SIZE window
+ *      engine.setOutputInterval(FS);   // one result per second
+ *
+ *      if (engine.addSample(red, ir)) {
+ *          engine.compute(&spo2, &spo2_valid, &hr, &hr_valid);
+ *      }
+ * @endcode
+ */
+template <uint32_t SAMPLE_RATE, uint32_t WINDOW_SIZE>
+class PpgStreamEngineT : public PpgEngine
+{
+    public:
+        /** @{ Compile time constants */
+        static const uint32_t kSampleRate = SAMPLE_RATE;
+        static const uint32_t kWindow = WINDOW_SIZE;
+        /// Length of the first moving average (4 samples at FS)
+        static const uint32_t kMaSize = ppg_scale_samples(MA4_SIZE, SAMPLE_RATE);
+        /// Samples between the newest raw sample and the newest filtered sample
+        static const uint32_t kLatency = (kMaSize - 1) + IrDerivativeChain::kDelay;
+        /// A local maximum needs a rising edge, so at most every other sample is a candidate
+        static const uint32_t kMaxCandidates = WINDOW_SIZE / 2;
+        /// Peaks above the threshold (15 in 5 seconds, as the batch peak finder)
+        static const int32_t kMaxPeaks = PEAK_MAX_CANDIDATES * WINDOW_SIZE * FS / (BUFFER_SIZE * SAMPLE_RATE);
+        static const int32_t kMinDistance = ppg_scale_samples(PEAK_MIN_DISTANCE, SAMPLE_RATE);
+        static const int32_t kMaxHrPeaks = PEAK_MAX_HR_PEAKS;
+        /// Half width of the search for the exact IR valley (5 samples at FS)
+        static const int32_t kValleySpan = ppg_scale_samples(5, SAMPLE_RATE);
+        /// Valleys closer than this are not used for SpO2 (10 samples at FS)
+        static const int32_t kMinValleyGap = ppg_scale_samples(10, SAMPLE_RATE);
+        /** @} */
+
+        PpgStreamEngineT();
+
+        void reset(void);
+        void setOutputInterval(uint32_t samples);
+        inline uint32_t getOutputInterval(void) const { return mOutputInterval; }
+        inline void setSpo2Enabled(bool b_enabled) { mSpo2Enabled = b_enabled; }
+        bool addSample(uint32_t un_red, uint32_t un_ir);
+        inline bool windowReady(void) const { return (mCount >= kWindow); }
+        inline uint32_t getSampleCount(void) const { return mCount; }
+        inline uint32_t getSampleRate(void) const { return kSampleRate; }
+        inline uint32_t getWindowSize(void) const { return kWindow; }
+        void compute(int32_t *pn_spo2, int8_t *pch_spo2_valid, int32_t *pn_heart_rate, int8_t *pch_hr_valid);
+        uint32_t getBeats(uint32_t *pun_locs, uint32_t un_max) const;
+
+    private:
+        /// Peak candidate of the filtered signal
+        typedef struct {
+            uint32_t un_loc;    ///< Absolute sample index
+            int32_t  n_height;  ///< Filtered value at un_loc
+        } peak_t;
+
+        /// @returns the ring slot of an absolute sample index
+        static inline uint32_t slot(uint32_t un_index) { return (un_index % kWindow); }
+
+        /// Runs the filter chain for the MA4 output at absolute index un_ma_index
+        void filterStep(uint32_t un_ma_index, int32_t n_ir_ma);
+
+        /// Tracks rising edges / plateaus of the filtered signal and records peaks
+        void peakStep(uint32_t un_index, int32_t n_value);
+
+        /// Appends a candidate, dropping the oldest one if the ring is full
+        void pushPeak(uint32_t un_loc, int32_t n_height);
+
+        /// Removes candidates located before un_min_loc
+        void evictPeaks(uint32_t un_min_loc);
+
+        uint32_t mCount;                ///< Number of samples added since reset()
+        uint32_t mOutputInterval;       ///< Samples between two outputs
+        uint32_t mSinceOutput;          ///< Samples since the last output
+        bool     mSpo2Enabled;          ///< SpO2 stages run in compute()
+
+        /** @{ Sample history */
+        uint32_t mIrRaw[kWindow];       ///< Raw IR ring, used to refine valleys
+        int32_t  mIrMa[kWindow];        ///< MA4 of raw IR ring
+        int32_t  mRedMa[kWindow];       ///< MA4 of raw red ring
+        int32_t  mFilt[kWindow];        ///< Hamming filtered (flipped) IR derivative ring
+        /** @} */
+
+        /** @{ Filter state */
+        MovingAverageStage<kMaSize> mIrMa4;     ///< 4 pt MA of raw IR
+        MovingAverageStage<kMaSize> mRedMa4;    ///< 4 pt MA of raw red
+        IrDerivativeChain mIrChain;     ///< Rest of the chain, runs on the IR average
+        int32_t  mAbsSum;               ///< Sum of |filtered| over the window (threshold)
+        /** @} */
+
+        /** @{ Peak tracking */
+        int32_t  mPrevFilt;             ///< Previous filtered value
+        bool     mRising;               ///< True while on a rising edge or plateau after one
+        uint32_t mCandLoc;              ///< Left edge of the current rising plateau
+        peak_t   mPeaks[kMaxCandidates];    ///< Ring of peak candidates
+        uint32_t mPeakHead;             ///< Oldest candidate in mPeaks
+        uint32_t mPeakCount;            ///< Number of candidates in mPeaks
+        /** @} */
+
+        /** @{ Beat output */
+        uint32_t mBeats[kMaxPeaks];     ///< Beats confirmed by the last compute()
+        uint32_t mBeatCount;            ///< Number of entries in mBeats
+        uint32_t mLastBeat;             ///< Last beat reported, 0 if none (never a peak)
+        /** @} */
+};
+
+/// Engine of the batch algorithm's rate and window
+typedef PpgStreamEngineT<FS, BUFFER_SIZE> PpgStreamEngine;
+
+/**
+ * Creates a streaming engine with a PPG_STREAM_WINDOW_SEC window.
+ * @param un_sample_rate  25, 50, 100 or 200 samples per second
+ * @returns the engine (delete it when done), or NULL if the rate is not supported
+ *          or there is not enough memory
+ */
+PpgEngine* ppg_engine_create(uint32_t un_sample_rate);
+
+#endif /* L5_APPLICATION_PPG_STREAM_HPP_ */
+/*===================================================================
+// $Log: $1.0 Streaming engine for heart rate and SpO2
+//
+//--------------------------------------------------------------------*/
@@ -0,0 +1,508 @@
+/*****************************************************************************
+$Work file     : ppg_trace.cpp $
+Description    : This file contains the PPG trace recorder, spool writer and trace file reader
+Project(s)     : Smart Health Gear
+Compiler       : Cross ARM GCC
+OS			   : RTOS
+Original Author: $ agent
+$Author        : $ agent
+$Date          : $ 17 Oct 2026
+$Revision      : 1.0 $
+*****************************************************************************/
+
+/****************************************************************************/
+/*                       INCLUDE FILES                                      */
+/****************************************************************************/
+#include <string.h>
+#include "ppg_trace.hpp"
+#include "algorithm.hpp"
+#include "lpc_sys.h"
+
+/****************************************************************************/
+/*                        VARIABLES AND MACROS                              */
+/****************************************************************************/
+PpgTraceRecorder ppg_trace_recorder;
+
+
+/*----------------------------------------------------------------------------
+Function    :  PpgTraceRecorder (Constructor)
+Inputs      :  None
+Processing  :  This function creates an idle recorder
+Outputs     :  None
+Returns     :  None
+Notes       :  None
+----------------------------------------------------------------------------*/
+PpgTraceRecorder::PpgTraceRecorder() :
+    mHead(0), mTail(0), mActive(false), mRemaining(0), mCaptured(0), mDropped(0)
+{
+}
+
+/*----------------------------------------------------------------------------
+Function    :  start ()
+Inputs      :  un_samples - number of samples to capture
+Processing  :  This function empties the ring and arms the capture
+Outputs     :  None
+Returns     :  None
+Notes       :  Called by the writer while no capture is in progress
+----------------------------------------------------------------------------*/
+void PpgTraceRecorder::start(uint32_t un_samples)
+{
+    mActive    = false;
+    mHead      = 0;
+    mTail      = 0;
+    mCaptured  = 0;
+    mDropped   = 0;
+    mRemaining = un_samples;
+    mActive    = (un_samples > 0);
+}
+
+/*----------------------------------------------------------------------------
+Function    :  stop ()
+Inputs      :  None
+Processing  :  This function ends the capture
+Outputs     :  None
+Returns     :  None
+Notes       :  None
+----------------------------------------------------------------------------*/
+void PpgTraceRecorder::stop(void)
+{
+    mActive = false;
+}
+
+/*----------------------------------------------------------------------------
+Function    :  feed ()
+Inputs      :  const uint8_t *puch_fifo - raw FIFO samples
+			   uch_samples              - number of samples in puch_fifo
+Processing  :  This function copies the samples to the ring while a capture is
+			   in progress
+Outputs     :  None
+Returns     :  None
+Notes       :  Samples that do not fit are counted as dropped
+----------------------------------------------------------------------------*/
+void PpgTraceRecorder::feed(const uint8_t *puch_fifo, uint8_t uch_samples)
+{
+    if (!mActive) {
+        return;
+    }
+
+    uint32_t un_head = mHead;
+    for (uint8_t i = 0; i < uch_samples && mRemaining > 0; i++, mRemaining--)
+    {
+        const uint32_t un_next = (un_head + 1) % PPG_TRACE_RING_SAMPLES;
+        if (un_next == mTail) {
+            mDropped++;
+            continue;
+        }
+        memcpy(&mRing[un_head * PPG_TRACE_SAMPLE_BYTES], puch_fifo + (i * PPG_TRACE_SAMPLE_BYTES),
+               PPG_TRACE_SAMPLE_BYTES);
+        un_head = un_next;
+        mCaptured++;
+    }
+
+    // Publish the samples before the capture may be seen as finished
+    mHead = un_head;
+    if (0 == mRemaining) {
+        mActive = false;
+    }
+}
+
+/*----------------------------------------------------------------------------
+Function    :  read ()
+Inputs      :  un_max_bytes - size of puch_dst
+Processing  :  This function copies whole samples out of the ring
+Outputs     :  *puch_dst    - raw FIFO samples
+Returns     :  Number of bytes copied
+Notes       :  None
+----------------------------------------------------------------------------*/
+uint32_t PpgTraceRecorder::read(uint8_t *puch_dst, uint32_t un_max_bytes)
+{
+    const uint32_t un_head = mHead;
+    uint32_t un_tail = mTail;
+    uint32_t un_bytes = 0;
+
+    while (un_tail != un_head && (un_bytes + PPG_TRACE_SAMPLE_BYTES) <= un_max_bytes)
+    {
+        memcpy(puch_dst + un_bytes, &mRing[un_tail * PPG_TRACE_SAMPLE_BYTES], PPG_TRACE_SAMPLE_BYTES);
+        un_bytes += PPG_TRACE_SAMPLE_BYTES;
+        un_tail = (un_tail + 1) % PPG_TRACE_RING_SAMPLES;
+    }
+
+    mTail = un_tail;
+    return un_bytes;
+}
+
+/*----------------------------------------------------------------------------
+Function    :  PpgSpoolWriter (Constructor)
+Inputs      :  None
+Processing  :  This function creates a writer without any file
+Outputs     :  None
+Returns     :  None
+Notes       :  None
+----------------------------------------------------------------------------*/
+PpgSpoolWriter::PpgSpoolWriter() :
+    mOpen(false), mOk(false), mBlockLen(0), mBytes(0), mSinceSync(0), mMaxWriteUs(0)
+{
+    memset(&mHeader, 0, sizeof(mHeader));
+    memset(mPending, 0, sizeof(mPending));
+}
+
+PpgSpoolWriter::~PpgSpoolWriter()
+{
+    close();
+}
+
+/*----------------------------------------------------------------------------
+Function    :  open ()
+Inputs      :  const char *pch_path - file to create, ie: "1:spool.bin"
+			   un_sample_rate       - samples per second of the sensor
+Processing  :  This function creates the file and writes a header without samples
+Outputs     :  None
+Returns     :  true if the file was created
+Notes       :  An existing file is overwritten
+----------------------------------------------------------------------------*/
+bool PpgSpoolWriter::open(const char *pch_path, uint32_t un_sample_rate)
+{
+    UINT un_written = 0;
+
+    close();
+    if (FR_OK != f_open(&mFile, pch_path, FA_WRITE | FA_CREATE_ALWAYS)) {
+        return false;
+    }
+    mOpen = true;
+
+    memset(&mHeader, 0, sizeof(mHeader));
+    mHeader.un_magic = PPG_TRACE_MAGIC;
+    mHeader.us_version = PPG_TRACE_VERSION_PACKED;
+    mHeader.us_sample_rate = un_sample_rate;
+    mHeader.us_sample_bytes = PPG_TRACE_PACKED_BYTES;
+    mHeader.s_hr_label = PPG_TRACE_NO_LABEL;
+    mHeader.s_spo2_label = PPG_TRACE_NO_LABEL;
+    mBlockLen = 0;
+    mBytes = 0;
+    mSinceSync = 0;
+    mMaxWriteUs = 0;
+
+    mOk = (FR_OK == f_write(&mFile, &mHeader, sizeof(mHeader), &un_written) && sizeof(mHeader) == un_written);
+    return mOk;
+}
+
+/*----------------------------------------------------------------------------
+Function    :  close ()
+Inputs      :  None
+Processing  :  This function packs a last odd sample with a zero sample, writes
+			   the buffered pairs and the final header and closes the file
+Outputs     :  None
+Returns     :  true if every write succeeded
+Notes       :  The header sample count does not include the padding
+----------------------------------------------------------------------------*/
+bool PpgSpoolWriter::close(void)
+{
+    if (!mOpen) {
+        return mOk;
+    }
+    if (mOk && (mHeader.un_samples & 1)) {
+        const uint32_t aun_red[2] = { mPending[0][0], 0 };
+        const uint32_t aun_ir[2]  = { mPending[0][1], 0 };
+        ppg_trace_pack_pair(aun_red, aun_ir, &mBlock[mBlockLen]);
+        mBlockLen += PPG_TRACE_PACKED_BYTES;
+    }
+    if (mOk) {
+        flush(true);
+    }
+    f_close(&mFile);
+    mOpen = false;
+    return mOk;
+}
+
+/*----------------------------------------------------------------------------
+Function    :  add ()
+Inputs      :  un_red - red LED reading
+			   un_ir  - IR LED reading
+Processing  :  This function packs every second sample with the previous one and
+			   writes a block once PPG_SPOOL_BLOCK_PAIRS pairs are buffered
+Outputs     :  None
+Returns     :  false after a write error
+Notes       :  Called by the spool writer task for every sample in spool mode
+----------------------------------------------------------------------------*/
+bool PpgSpoolWriter::add(uint32_t un_red, uint32_t un_ir)
+{
+    if (!mOpen || !mOk) {
+        return false;
+    }
+
+    const uint32_t un_odd = mHeader.un_samples & 1;
+    mPending[un_odd][0] = un_red;
+    mPending[un_odd][1] = un_ir;
+    mHeader.un_samples++;
+    mSinceSync++;
+    if (!un_odd) {
+        return true;
+    }
+
+    const uint32_t aun_red[2] = { mPending[0][0], mPending[1][0] };
+    const uint32_t aun_ir[2]  = { mPending[0][1], mPending[1][1] };
+    ppg_trace_pack_pair(aun_red, aun_ir, &mBlock[mBlockLen]);
+    mBlockLen += PPG_TRACE_PACKED_BYTES;
+
+    if (mBlockLen == sizeof(mBlock)) {
+        return flush(mSinceSync >= (uint32_t)mHeader.us_sample_rate * PPG_SPOOL_SYNC_SEC);
+    }
+    return true;
+}
+
+/*----------------------------------------------------------------------------
+Function    :  flush ()
+Inputs      :  b_sync - also update the header sample count and sync the file
+Processing  :  This function writes the buffered pairs
+Outputs     :  None
+Returns     :  false after a write error
+Notes       :  The header counts the samples of the pairs written so far
+----------------------------------------------------------------------------*/
+bool PpgSpoolWriter::flush(bool b_sync)
+{
+    UINT un_written = 0;
+    const uint64_t un_start_us = sys_get_uptime_us();
+
+    if (mBlockLen > 0) {
+        mOk = (FR_OK == f_write(&mFile, mBlock, mBlockLen, &un_written) && mBlockLen == un_written);
+        mBytes += mBlockLen;
+        mBlockLen = 0;
+    }
+    if (mOk && b_sync) {
+        // An odd sample is only counted by close(), once it has been written
+        ppg_trace_header_t header = mHeader;
+        header.un_samples = (mBytes / PPG_TRACE_PACKED_BYTES) * 2;
+        if (header.un_samples > mHeader.un_samples) {
+            header.un_samples = mHeader.un_samples;
+        }
+        const DWORD un_end = f_tell(&mFile);
+        mOk = (FR_OK == f_lseek(&mFile, 0) &&
+               FR_OK == f_write(&mFile, &header, sizeof(header), &un_written) && sizeof(header) == un_written &&
+               FR_OK == f_lseek(&mFile, un_end) &&
+               FR_OK == f_sync(&mFile));
+        mSinceSync = 0;
+    }
+
+    const uint32_t un_us = (uint32_t)(sys_get_uptime_us() - un_start_us);
+    if (un_us > mMaxWriteUs) {
+        mMaxWriteUs = un_us;
+    }
+    return mOk;
+}
+
+/*----------------------------------------------------------------------------
+Function    :  PpgTraceReader (Constructor)
+Inputs      :  None
+Processing  :  This function creates a reader without any file
+Outputs     :  None
+Returns     :  None
+Notes       :  None
+----------------------------------------------------------------------------*/
+PpgTraceReader::PpgTraceReader() :
+    mOpen(false), mBinary(false), mSamplesLeft(0), mPairRed(0), mPairIr(0), mPairPending(false),
+    mBufferLen(0), mBufferPos(0)
+{
+    memset(&mHeader, 0, sizeof(mHeader));
+    mHeader.us_sample_rate = FS;
+    mHeader.s_hr_label = PPG_TRACE_NO_LABEL;
+    mHeader.s_spo2_label = PPG_TRACE_NO_LABEL;
+}
+
+PpgTraceReader::~PpgTraceReader()
+{
+    close();
+}
+
+/*----------------------------------------------------------------------------
+Function    :  open ()
+Inputs      :  const char *pch_path - file to read, ie: "1:trace.bin"
+Processing  :  This function opens the file and checks for the binary header,
+			   raw FIFO samples or packed pairs. Files without the header are
+			   read as "red,ir" text.
+Outputs     :  None
+Returns     :  true if the file was opened
+Notes       :  None
+----------------------------------------------------------------------------*/
+bool PpgTraceReader::open(const char *pch_path)
+{
+    UINT un_read = 0;
+
+    close();
+    if (FR_OK != f_open(&mFile, pch_path, FA_OPEN_EXISTING | FA_READ)) {
+        return false;
+    }
+    mOpen = true;
+
+    if (FR_OK == f_read(&mFile, &mHeader, sizeof(mHeader), &un_read) &&
+        sizeof(mHeader) == un_read &&
+        PPG_TRACE_MAGIC == mHeader.un_magic &&
+        ((PPG_TRACE_VERSION == mHeader.us_version && PPG_TRACE_SAMPLE_BYTES == mHeader.us_sample_bytes) ||
+         (PPG_TRACE_VERSION_PACKED == mHeader.us_version && PPG_TRACE_PACKED_BYTES == mHeader.us_sample_bytes)))
+    {
+        mBinary = true;
+        mSamplesLeft = mHeader.un_samples;
+    }
+    else
+    {
+        memset(&mHeader, 0, sizeof(mHeader));
+        mHeader.us_sample_rate = FS;
+        mHeader.s_hr_label = PPG_TRACE_NO_LABEL;
+        mHeader.s_spo2_label = PPG_TRACE_NO_LABEL;
+        mBinary = false;
+        f_lseek(&mFile, 0);
+    }
+
+    mBufferLen = 0;
+    mBufferPos = 0;
+    mPairPending = false;
+    return true;
+}
+
+/*----------------------------------------------------------------------------
+Function    :  close ()
+Inputs      :  None
+Processing  :  This function closes the file if it is open
+Outputs     :  None
+Returns     :  None
+Notes       :  None
+----------------------------------------------------------------------------*/
+void PpgTraceReader::close(void)
+{
+    if (mOpen) {
+        f_close(&mFile);
+        mOpen = false;
+    }
+}
+
+/*----------------------------------------------------------------------------
+Function    :  getByte ()
+Inputs      :  None
+Processing  :  This function returns the next byte, refilling the buffer from
+			   the file when it is empty
+Outputs     :  None
+Returns     :  The byte, or -1 at the end of the file
+Notes       :  None
+----------------------------------------------------------------------------*/
+int32_t PpgTraceReader::getByte(void)
+{
+    if (mBufferPos >= mBufferLen)
+    {
+        UINT un_read = 0;
+        if (!mOpen || FR_OK != f_read(&mFile, mBuffer, sizeof(mBuffer), &un_read) || 0 == un_read) {
+            return -1;
+        }
+        mBufferLen = un_read;
+        mBufferPos = 0;
+    }
+    return mBuffer[mBufferPos++];
+}
+
+/*----------------------------------------------------------------------------
+Function    :  next ()
+Inputs      :  None
+Processing  :  This function reads one sample of a binary trace (unpacking two
+			   at a time from a spool file), or parses the next "red,ir" line of
+			   a text trace
+Outputs     :  *pun_red - red LED reading
+			   *pun_ir  - IR LED reading
+Returns     :  false at the end of the file
+Notes       :  Text lines that do not hold two numbers are skipped
+----------------------------------------------------------------------------*/
+bool PpgTraceReader::next(uint32_t *pun_red, uint32_t *pun_ir)
+{
+    if (mBinary && PPG_TRACE_VERSION_PACKED == mHeader.us_version)
+    {
+        uint8_t auch_pair[PPG_TRACE_PACKED_BYTES];
+        uint32_t aun_red[2], aun_ir[2];
+        if (0 == mSamplesLeft) {
+            return false;
+        }
+        mSamplesLeft--;
+        if (mPairPending) {
+            mPairPending = false;
+            *pun_red = mPairRed;
+            *pun_ir  = mPairIr;
+            return true;
+        }
+        for (int i = 0; i < PPG_TRACE_PACKED_BYTES; i++) {
+            const int32_t n_byte = getByte();
+            if (n_byte < 0) {
+                mSamplesLeft = 0;
+                return false;
+            }
+            auch_pair[i] = (uint8_t) n_byte;
+        }
+        ppg_trace_unpack_pair(auch_pair, aun_red, aun_ir);
+        *pun_red = aun_red[0];
+        *pun_ir  = aun_ir[0];
+        mPairRed = aun_red[1];
+        mPairIr  = aun_ir[1];
+        mPairPending = true;
+        return true;
+    }
+    if (mBinary)
+    {
+        uint8_t auch_sample[PPG_TRACE_SAMPLE_BYTES];
+        if (0 == mSamplesLeft) {
+            return false;
+        }
+        for (int i = 0; i < PPG_TRACE_SAMPLE_BYTES; i++) {
+            const int32_t n_byte = getByte();
+            if (n_byte < 0) {
+                return false;
+            }
+            auch_sample[i] = (uint8_t) n_byte;
+        }
+        mSamplesLeft--;
+        maxim_max30102_unpack(auch_sample, pun_red, pun_ir);
+        return true;
+    }
+
+    // Fields after the IR reading (ie: a time stamp) are ignored
+    uint32_t aun_val[2] = { 0, 0 };
+    bool ab_digits[2] = { false, false };
+    int32_t n_field = 0;
+    bool b_comment = false;
+    int32_t n_c;
+
+    while ((n_c = getByte()) >= 0)
+    {
+        if ('\n' == n_c || '\r' == n_c)
+        {
+            if (ab_digits[1]) {
+                *pun_red = aun_val[0];
+                *pun_ir  = aun_val[1];
+                return true;
+            }
+            aun_val[0] = aun_val[1] = 0;
+            ab_digits[0] = ab_digits[1] = false;
+            n_field = 0;
+            b_comment = false;
+        }
+        else if (b_comment || n_field > 1) {
+            continue;
+        }
+        else if ('#' == n_c && 0 == n_field && !ab_digits[0]) {
+            b_comment = true;
+        }
+        else if (n_c >= '0' && n_c <= '9') {
+            aun_val[n_field] = (aun_val[n_field] * 10) + (n_c - '0');
+            ab_digits[n_field] = true;
+        }
+        else if (',' == n_c && ab_digits[n_field]) {
+            n_field++;
+        }
+    }
+
+    // Last line without a line feed
+    if (ab_digits[1]) {
+        *pun_red = aun_val[0];
+        *pun_ir  = aun_val[1];
+        return true;
+    }
+    return false;
+}
+/*===================================================================
+// $Log: $1.0 PPG trace recorder, spool writer and reader
+//
+//--------------------------------------------------------------------*/
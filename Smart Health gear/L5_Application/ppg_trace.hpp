@@ -0,0 +1,197 @@
+/*****************************************************************************
+$Work file     : ppg_trace.hpp $
+Description    : This file contains the PPG trace recorder, spool writer and trace file reader
+Project(s)     : Smart Health Gear
+Compiler       : Cross ARM GCC
+OS			   : RTOS
+Original Author: $ agent
+$Author        : $ agent
+$Date          : $ 17 Oct 2026
+$Revision      : 1.0 $
+*****************************************************************************/
+#ifndef L5_APPLICATION_PPG_TRACE_HPP_
+#define L5_APPLICATION_PPG_TRACE_HPP_
+
+/****************************************************************************/
+/*                       INCLUDE FILES                                      */
+/****************************************************************************/
+#include <stdint.h>
+#include "ppg_trace_format.hpp"
+#include "ff.h"
+
+/****************************************************************************/
+/*                        MACRO Definitions                                 */
+/****************************************************************************/
+// Samples buffered between the heart rate task and the file writer (~6.8 sec at 100 sps)
+#define PPG_TRACE_RING_SAMPLES     (680)
+
+// Pairs buffered before a write (504 bytes, one flash / SD sector)
+#define PPG_SPOOL_BLOCK_PAIRS      (56)
+// The header sample count is updated and the file synced every 10 seconds of samples
+#define PPG_SPOOL_SYNC_SEC         (10)
+
+/****************************************************************************/
+/*                       Class declarations                                 */
+/****************************************************************************/
+/**
+ * Captures raw MAX30102 FIFO samples for the 'ppgrec' terminal command.  The
+ * heart rate task's spool mode ('hrspool') uses a second one to hand its samples
+ * to the spool writer task.
+ *
+ * The heart rate task calls feed() with every FIFO burst, which costs one check
+ * while nothing is being recorded.  Samples go to a ring that the file writer
+ * empties with read(), so the heart rate task never waits on the SPI flash or SD.
+ * There is one producer (heart rate task) and one consumer (writer), so the ring
+ * needs no lock.
+ */
+class PpgTraceRecorder
+{
+    public:
+        PpgTraceRecorder();
+
+        /**
+         * Starts a new recording, discarding anything left in the ring.
+         * @param un_samples  Number of samples to capture
+         */
+        void start(uint32_t un_samples);
+
+        /// Stops capturing, samples still in the ring can be read
+        void stop(void);
+
+        /// @returns true until the requested number of samples has been captured
+        inline bool isRecording(void) const { return mActive; }
+
+        /// Called by the heart rate task with every FIFO burst
+        void feed(const uint8_t *puch_fifo, uint8_t uch_samples);
+
+        /**
+         * Copies whole samples out of the ring.
+         * @returns the number of bytes copied, a multiple of PPG_TRACE_SAMPLE_BYTES
+         */
+        uint32_t read(uint8_t *puch_dst, uint32_t un_max_bytes);
+
+        /** @{ Statistics of the current recording */
+        inline uint32_t getCaptured(void) const { return mCaptured; }
+        inline uint32_t getDropped(void) const { return mDropped; }
+        /** @} */
+
+    private:
+        uint8_t mRing[PPG_TRACE_RING_SAMPLES * PPG_TRACE_SAMPLE_BYTES];
+        volatile uint32_t mHead;        ///< Next sample slot written by feed()
+        volatile uint32_t mTail;        ///< Next sample slot read by read()
+        volatile bool mActive;          ///< Capture in progress
+        uint32_t mRemaining;            ///< Samples left to capture
+        uint32_t mCaptured;             ///< Samples put in the ring
+        uint32_t mDropped;              ///< Samples lost because the ring was full
+};
+
+/**
+ * Writes the spool file of the heart rate task's spool mode ('hrspool').
+ *
+ * Samples are packed two by two (PPG_TRACE_VERSION_PACKED), so a night at
+ * 25 sps takes about 3.2 Mbytes instead of 4.3 for raw FIFO samples.  Packed
+ * pairs are collected into one sector and written together, and the header is
+ * updated every PPG_SPOOL_SYNC_SEC so that a file cut by a power loss can still
+ * be read up to the last sync.
+ */
+class PpgSpoolWriter
+{
+    public:
+        PpgSpoolWriter();
+        ~PpgSpoolWriter();
+
+        /// Creates the file and writes the header
+        bool open(const char *pch_path, uint32_t un_sample_rate);
+
+        /// Writes what is buffered and the final header, then closes the file
+        bool close(void);
+
+        /**
+         * Adds one sample.
+         * @returns false once a write has failed, the file is then left as it was
+         *          at the last sync
+         */
+        bool add(uint32_t un_red, uint32_t un_ir);
+
+        /** @{ Statistics */
+        inline uint32_t getSamples(void) const { return mHeader.un_samples; }
+        inline uint32_t getBytes(void) const { return sizeof(mHeader) + mBytes; }
+        inline uint32_t getMaxWriteUs(void) const { return mMaxWriteUs; }
+        /** @} */
+
+    private:
+        /// Writes the buffered pairs, and the header when a sync is due
+        bool flush(bool b_sync);
+
+        FIL mFile;
+        bool mOpen;
+        bool mOk;                       ///< No write error so far
+        ppg_trace_header_t mHeader;     ///< un_samples counts every sample added
+        uint32_t mPending[2][2];        ///< Red / IR of a sample waiting for its pair
+        uint8_t mBlock[PPG_SPOOL_BLOCK_PAIRS * PPG_TRACE_PACKED_BYTES];
+        uint32_t mBlockLen;             ///< Bytes in mBlock
+        uint32_t mBytes;                ///< Sample bytes written to the file
+        uint32_t mSinceSync;            ///< Samples since the last header update
+        uint32_t mMaxWriteUs;           ///< Longest block write
+};
+
+/**
+ * Reads red/IR samples back from a trace file.  Three formats are accepted :
+ *  - Binary file written by 'ppgrec' (ppg_trace_header_t followed by raw FIFO samples)
+ *  - Packed spool file written by 'hrspool' (ppg_trace_header_t followed by packed pairs)
+ *  - Text file with one "red,ir" pair per line, lines starting with '#' are skipped
+ */
+class PpgTraceReader
+{
+    public:
+        PpgTraceReader();
+        ~PpgTraceReader();
+
+        /// Opens the file and reads the header if it is a binary trace
+        bool open(const char *pch_path);
+        void close(void);
+
+        /**
+         * Reads the next sample.
+         * @returns false at the end of the file or upon a read error
+         */
+        bool next(uint32_t *pun_red, uint32_t *pun_ir);
+
+        /// @returns true if the file is a binary trace, false for text
+        inline bool isBinary(void) const { return mBinary; }
+        /// @returns true if the binary trace holds packed pairs (spool file)
+        inline bool isPacked(void) const { return mBinary && PPG_TRACE_VERSION_PACKED == mHeader.us_version; }
+
+        /// @returns the sample rate from the binary header, text traces are taken as FS
+        inline uint32_t getSampleRate(void) const { return mHeader.us_sample_rate; }
+
+        /** @{ Reference readings from the binary header, PPG_TRACE_NO_LABEL otherwise */
+        inline int32_t getHrLabel(void) const { return mHeader.s_hr_label; }
+        inline int32_t getSpo2Label(void) const { return mHeader.s_spo2_label; }
+        /** @} */
+
+    private:
+        /// @returns the next byte of the file, or -1 at the end
+        int32_t getByte(void);
+
+        FIL mFile;
+        bool mOpen;
+        bool mBinary;
+        ppg_trace_header_t mHeader;
+        uint32_t mSamplesLeft;          ///< Binary samples not read yet
+        uint32_t mPairRed;              ///< Second sample of a packed pair, not read yet
+        uint32_t mPairIr;
+        bool mPairPending;
+        uint8_t mBuffer[128];           ///< File read buffer
+        uint32_t mBufferLen;
+        uint32_t mBufferPos;
+};
+
+/// Recorder fed by the heart rate task
+extern PpgTraceRecorder ppg_trace_recorder;
+
+#endif /* L5_APPLICATION_PPG_TRACE_HPP_ */
+/*===================================================================
+// $Log: $1.0 PPG trace recorder, spool writer and reader
+//
+//--------------------------------------------------------------------*/
@@ -0,0 +1,119 @@
+/*****************************************************************************
+$Work file     : ppg_trace_format.hpp $
+Description    : This file contains the PPG trace file format and sample packing,
+				 with no RTOS or FatFs dependency so that host tools can use it
+Project(s)     : Smart Health Gear
+Compiler       : Cross ARM GCC
+OS			   : RTOS
+Original Author: $ agent
+$Author        : $ agent
+$Date          : $ 17 Oct 2026
+$Revision      : 1.0 $
+*****************************************************************************/
+#ifndef L5_APPLICATION_PPG_TRACE_FORMAT_HPP_
+#define L5_APPLICATION_PPG_TRACE_FORMAT_HPP_
+
+/****************************************************************************/
+/*                       INCLUDE FILES                                      */
+/****************************************************************************/
+#include <stdint.h>
+
+/****************************************************************************/
+/*                        MACRO Definitions                                 */
+/****************************************************************************/
+// "PPGT" at the start of a binary trace file
+#define PPG_TRACE_MAGIC            (0x54475050)
+#define PPG_TRACE_VERSION          (1)
+// Bytes of one MAX30102 FIFO sample (red then IR, 3 bytes each, MSB first)
+#define PPG_TRACE_SAMPLE_BYTES     (6)
+// Label value of a trace without a reference reading
+#define PPG_TRACE_NO_LABEL         (-1)
+
+// Spool files : samples packed by pairs, 18 bits red + 18 bits IR each (4.5 bytes/sample)
+#define PPG_TRACE_VERSION_PACKED   (2)
+#define PPG_TRACE_PACKED_BYTES     (9)
+
+/****************************************************************************/
+/*                        Type Definitions                                  */
+/****************************************************************************/
+/**
+ * Header of a binary trace file, followed by un_samples raw FIFO samples of
+ * PPG_TRACE_SAMPLE_BYTES each, exactly as read from the MAX30102 FIFO_DATA register.
+ * All fields are little endian.
+ */
+typedef struct {
+    uint32_t un_magic;          ///< PPG_TRACE_MAGIC
+    uint16_t us_version;        ///< PPG_TRACE_VERSION
+    uint16_t us_sample_rate;    ///< Samples per second
+    uint16_t us_sample_bytes;   ///< PPG_TRACE_SAMPLE_BYTES
+    int16_t  s_hr_label;        ///< Reference heart rate (bpm) or PPG_TRACE_NO_LABEL
+    int16_t  s_spo2_label;      ///< Reference SpO2 (%) or PPG_TRACE_NO_LABEL
+    uint16_t us_reserved;
+    uint32_t un_samples;        ///< Number of samples after the header
+} ppg_trace_header_t;
+
+/****************************************************************************/
+/*                       Function declarations                              */
+/****************************************************************************/
+/*----------------------------------------------------------------------------
+Function    :  maxim_max30102_unpack ()
+Inputs      :  const uint8_t *puch_sample - 6 bytes of one FIFO sample
+Processing  :  This function converts one FIFO sample to red and IR LED readings
+Outputs     :  *pun_red_led   - pointer that stores the red LED reading data
+ 	 	 	   *pun_ir_led    - pointer that stores the IR LED reading data
+Returns     :  None
+Notes       :  Algorithm by Maxim, edited by Jean Mary M
+----------------------------------------------------------------------------*/
+static inline void maxim_max30102_unpack(const uint8_t *puch_sample, uint32_t *pun_red_led, uint32_t *pun_ir_led)
+{
+  *pun_red_led = ((uint32_t)puch_sample[0] << 16) | ((uint32_t)puch_sample[1] << 8) | puch_sample[2];
+  *pun_ir_led  = ((uint32_t)puch_sample[3] << 16) | ((uint32_t)puch_sample[4] << 8) | puch_sample[5];
+  *pun_red_led&=0x03FFFF;  //Mask MSB [23:18]
+  *pun_ir_led&=0x03FFFF;  //Mask MSB [23:18]
+}
+
+/*----------------------------------------------------------------------------
+Function    :  ppg_trace_pack_pair ()
+Inputs      :  const uint32_t *pun_red - 2 red LED readings (18 bits)
+			   const uint32_t *pun_ir  - 2 IR LED readings (18 bits)
+Processing  :  This function packs two samples into PPG_TRACE_PACKED_BYTES bytes :
+			   red0, ir0, red1 and ir1 are 18 bit fields of a little endian bit
+			   stream, red0 in the low bits of the first byte
+Outputs     :  *puch_dst - PPG_TRACE_PACKED_BYTES bytes
+Returns     :  None
+Notes       :  None
+----------------------------------------------------------------------------*/
+static inline void ppg_trace_pack_pair(const uint32_t *pun_red, const uint32_t *pun_ir, uint8_t *puch_dst)
+{
+  const uint64_t un_bits = (uint64_t)(pun_red[0] & 0x03FFFF)        |
+                           ((uint64_t)(pun_ir[0]  & 0x03FFFF) << 18) |
+                           ((uint64_t)(pun_red[1] & 0x03FFFF) << 36) |
+                           ((uint64_t)(pun_ir[1]  & 0x03FFFF) << 54);
+  for (int i = 0; i < 8; i++) {
+    puch_dst[i] = (uint8_t)(un_bits >> (8 * i));
+  }
+  puch_dst[8] = (uint8_t)((pun_ir[1] & 0x03FFFF) >> 10);
+}
+
+/*----------------------------------------------------------------------------
+Function    :  ppg_trace_unpack_pair ()
+Inputs      :  const uint8_t *puch_src - PPG_TRACE_PACKED_BYTES bytes
+Processing  :  This function is the reverse of ppg_trace_pack_pair()
+Outputs     :  *pun_red - 2 red LED readings
+			   *pun_ir  - 2 IR LED readings
+Returns     :  None
+Notes       :  None
+----------------------------------------------------------------------------*/
+static inline void ppg_trace_unpack_pair(const uint8_t *puch_src, uint32_t *pun_red, uint32_t *pun_ir)
+{
+  uint64_t un_bits = 0;
+  for (int i = 0; i < 8; i++) {
+    un_bits |= (uint64_t)puch_src[i] << (8 * i);
+  }
+  pun_red[0] = (uint32_t)(un_bits & 0x03FFFF);
+  pun_ir[0]  = (uint32_t)((un_bits >> 18) & 0x03FFFF);
+  pun_red[1] = (uint32_t)((un_bits >> 36) & 0x03FFFF);
+  pun_ir[1]  = (uint32_t)(un_bits >> 54) | ((uint32_t)puch_src[8] << 10);
+}
+
+#endif /* L5_APPLICATION_PPG_TRACE_FORMAT_HPP_ */
@@ -18,6 +18,7 @@
 
 #include <disk/spi_flash.h>
 #include <stdio.h>              // printf()
+#include <stdlib.h>
 #include <string.h>
 #include <time.h>
 #include "printf_lib.h"
@@ -55,7 +56,11 @@
 #include "task.h"
 #include "lpc_sys.h"
 #include "soft_timer.hpp"
+#include "isr_event.hpp"
+#include "byte_ring.hpp"
 #include "algorithm.hpp"
+#include "ppg_stream.hpp"
+#include "ppg_trace.hpp"
 #include "Thermistor.hpp"
 
 #include "examples/examples.hpp"
@@ -498,6 +503,7 @@ CMD_HANDLER_FUNC(i2cIoHandler)
     bool read = cmdParams.beginsWithIgnoreCase("read");
     bool write = cmdParams.beginsWithIgnoreCase("write");
     bool discover = cmdParams.beginsWithIgnoreCase("discover");
+    bool stats = cmdParams.beginsWithIgnoreCase("stats");
 
     int addr = 0;
     int reg = 0;
@@ -544,8 +550,32 @@ CMD_HANDLER_FUNC(i2cIoHandler)
             }
         }
     }
+    else if (stats) {
+        I2C_Base *buses[] = { &I2C1::getInstance(), &I2C2::getInstance() };
+        for (unsigned int b = 0; b < sizeof(buses) / sizeof(buses[0]); b++) {
+            I2C_Base &bus = *buses[b];
+            if (cmdParams.containsIgnoreCase("reset")) {
+                bus.resetStats();
+                continue;
+            }
+
+            const uint64_t stats_us = bus.getStatsUs();
+            const uint32_t busy_pm = stats_us ? (uint32_t) (bus.getBusyUs() * 1000 / stats_us) : 0;
+            output.printf("I2C%u: %u.%u%% busy over %u sec, %u transactions submitted, queue up to %u\n",
+                          b + 1, busy_pm / 10, busy_pm % 10, (uint32_t) (stats_us / 1000000),
+                          bus.getTransferCount(), bus.getMaxQueueDepth());
+            for (uint32_t i = 0; i < bus.getStatsDeviceCount(); i++) {
+                const I2C_Base::DeviceStats &dev = bus.getDeviceStats(i);
+                output.printf("    %#4x @ %3u Khz : %7u transactions, %4u errors, %4u us each, %u.%u%% of the bus\n",
+                              dev.address, bus.getDeviceSpeed(dev.address), dev.transfers, dev.errors,
+                              dev.transfers ? dev.busyUs / dev.transfers : 0,
+                              stats_us ? (uint32_t) ((uint64_t) dev.busyUs * 100 / stats_us) : 0,
+                              stats_us ? (uint32_t) ((uint64_t) dev.busyUs * 1000 / stats_us) % 10 : 0);
+            }
+        }
+    }
 
-    return (read || write || discover);
+    return (read || write || discover || stats);
 }
 
 CMD_HANDLER_FUNC(mvHandler)
@@ -916,16 +946,11 @@ bool maxim_max30102_read_fifo(uint32_t *pun_red_led, uint32_t *pun_ir_led)
   return true;
 }
 volatile bool flag = false;
-extern bool flag1;
 // irq
-/// ISR callback function upon NRF IRQ rising edge interrupt
+/// ISR callback function upon MAX30102 interrupt falling edge (eint driver clears the pin)
  void heartrate_irq_callback(void)
 {
-
-	LPC_GPIOINT->IO2IntClr = 0xFFFFFFFF;
-	flag1 = true;
-	return;
-
+	max30102_fifo_event.signalFromIsr();
 }
 //
 CMD_HANDLER_FUNC(i2cTaskHandlerTrial)
@@ -933,41 +958,12 @@ CMD_HANDLER_FUNC(i2cTaskHandlerTrial)
 	while(1)
 	{
        // i2c.readReg(I2CAddr_TemperatureSensor, 0);
-		float resistance;
-		float temp = ((LS.getRawValue() * 3.3)/4096);
-		temp = 3.3/temp;
-		resistance = 10/(temp - 1);
-		float temperature, T1,T2,R1,R2;
-		for(int i =0; i<240; i++)
-		{
-			//cout<<resistance<<","<<resistance_array[i] <<endl;
-			if((resistance > resistance_array[i] )  )
-			{
-				if(resistance == resistance_array[i - 1])
-				{
-					temperature = i - 41;
-					break;
-				}
-				if(resistance < resistance_array[i - 1] )
-				{
-					R1 = resistance_array[i - 1];
-					R2 = resistance_array[i];
-					T1 = i - 41;
-					T2 = i - 40;
-
-					//cout<<R1<<","<<R2<<","<<T1<<","<<T2 <<endl;
-					temperature = ((resistance - R1) * (R2 - R1))/(T2-T1);
-					temperature = temperature + T1;
-					break;
-				}
-
-			}
+		const uint16_t code = LS.getRawValue();
+		const int32_t centi = thermistor_adc_to_centi_celsius(code);
 
-		}
-
-	    cout<<"temp:"<<temperature<<endl;
-		cout<<"resistance:"<<resistance<<endl;
-		LD.setNumber(temperature);
+	    cout<<"temp:"<<centi / 100<<"."<<abs(centi % 100)<<endl;
+		cout<<"adc:"<<code<<endl;
+		LD.setNumber(thermistor_centi_to_celsius(centi));
 
 	    delay_ms(1000);
 	}
@@ -1159,6 +1155,1409 @@ CMD_HANDLER_FUNC(smartHealthHandler)
 	return true;
 }
 
+/// Deterministic PPG-like trace (72 bpm, 100 sps) used by the heart rate benchmark
+static void hrbench_sample(uint32_t un_index, uint32_t *pun_red, uint32_t *pun_ir)
+{
+    const uint32_t period = 83;
+    const uint32_t rise = 4;
+    static uint32_t seed = 0;
+    static int32_t pulse = 0;
+    if (0 == un_index) {
+        seed = 12345;
+        pulse = 0;
+    }
+    seed = seed * 1103515245 + 12345;
+    const int32_t noise = (int32_t) ((seed >> 16) % 61) - 30;
+
+    /* Short systolic rise followed by an exponential (15/16 per sample) decay */
+    const uint32_t phase = un_index % period;
+    if (phase < rise) {
+        pulse = (int32_t) ((phase + 1) * 1024 / rise);
+    }
+    else {
+        pulse = pulse * 15 / 16;
+    }
+
+    *pun_ir  = 120000 - (1500 * pulse / 1024) + (2 * noise);
+    *pun_red = 100000 - ( 900 * pulse / 1024) + noise;
+}
+
+CMD_HANDLER_FUNC(hrBenchHandler)
+{
+    const int block = 100;
+    int seconds = 30;
+    int interval = FS;
+    cmdParams.scanf("%i %i", &seconds, &interval);
+    if (seconds < (BUFFER_SIZE / FS) || interval <= 0) {
+        output.putline("Usage: hrbench <seconds (min 5)> <output interval in samples>");
+        return true;
+    }
+
+    uint32_t *aun_ir_buffer = new uint32_t[BUFFER_SIZE];
+    uint32_t *aun_red_buffer = new uint32_t[BUFFER_SIZE];
+    PpgStreamEngine *engine = new PpgStreamEngine();
+    if (NULL == aun_ir_buffer || NULL == aun_red_buffer || NULL == engine) {
+        output.putline("Out of memory");
+        delete [] aun_ir_buffer;
+        delete [] aun_red_buffer;
+        delete engine;
+        return true;
+    }
+    engine->setOutputInterval(interval);
+
+    int32_t n_sp02 = 0, n_heart_rate = 0, n_stream_sp02 = 0, n_stream_hr = 0;
+    int8_t ch_spo2_valid = 0, ch_hr_valid = 0, ch_stream_spo2_valid = 0, ch_stream_hr_valid = 0;
+    uint32_t un_red[block], un_ir[block];
+    uint64_t legacy_us = 0, stream_us = 0, start_us = 0;
+    uint32_t legacy_outputs = 0, stream_outputs = 0, compared = 0, hr_agree = 0, spo2_agree = 0;
+    const uint32_t total = seconds * FS;
+
+    for (uint32_t n = 0; n < total; n += block)
+    {
+        bool stream_due = false;
+        for (int i = 0; i < block; i++) {
+            hrbench_sample(n + i, &un_red[i], &un_ir[i]);
+        }
+
+        /* Legacy path: shift the window by one block, then run the batch algorithm */
+        start_us = sys_get_uptime_us();
+        for (int i = block; i < BUFFER_SIZE; i++) {
+            aun_red_buffer[i - block] = aun_red_buffer[i];
+            aun_ir_buffer[i - block] = aun_ir_buffer[i];
+        }
+        for (int i = 0; i < block; i++) {
+            aun_red_buffer[BUFFER_SIZE - block + i] = un_red[i];
+            aun_ir_buffer[BUFFER_SIZE - block + i] = un_ir[i];
+        }
+        if (n + block >= BUFFER_SIZE) {
+            maxim_heart_rate_and_oxygen_saturation(aun_ir_buffer, BUFFER_SIZE, aun_red_buffer,
+                                                   &n_sp02, &ch_spo2_valid, &n_heart_rate, &ch_hr_valid);
+            legacy_outputs++;
+        }
+        legacy_us += sys_get_uptime_us() - start_us;
+
+        /* Streaming path: one sample at a time, compute whenever an output is due */
+        start_us = sys_get_uptime_us();
+        for (int i = 0; i < block; i++) {
+            stream_due = engine->addSample(un_red[i], un_ir[i]);
+            if (stream_due) {
+                engine->compute(&n_stream_sp02, &ch_stream_spo2_valid, &n_stream_hr, &ch_stream_hr_valid);
+                stream_outputs++;
+            }
+        }
+        stream_us += sys_get_uptime_us() - start_us;
+
+        /* Both paths look at the same window when the engine output lands on the block end */
+        if (stream_due && n + block >= BUFFER_SIZE) {
+            compared++;
+            hr_agree += (ch_hr_valid == ch_stream_hr_valid && n_heart_rate == n_stream_hr);
+            spo2_agree += (ch_spo2_valid == ch_stream_spo2_valid && n_sp02 == n_stream_sp02);
+        }
+    }
+
+    output.printf("Samples : %u (%i sec), stream output every %i samples\n", total, seconds, interval);
+    output.printf("Legacy  : %5u outputs %8u us total %6u us/output\n", legacy_outputs,
+                  (uint32_t) legacy_us, legacy_outputs ? (uint32_t) (legacy_us / legacy_outputs) : 0);
+    output.printf("Stream  : %5u outputs %8u us total %6u us/output\n", stream_outputs,
+                  (uint32_t) stream_us, stream_outputs ? (uint32_t) (stream_us / stream_outputs) : 0);
+    output.printf("Last    : legacy HR %i SpO2 %i, stream HR %i SpO2 %i\n",
+                  n_heart_rate, n_sp02, n_stream_hr, n_stream_sp02);
+    output.printf("Agree   : HR %u/%u, SpO2 %u/%u\n", hr_agree, compared, spo2_agree, compared);
+
+    delete [] aun_ir_buffer;
+    delete [] aun_red_buffer;
+    delete engine;
+    return true;
+}
+
+CMD_HANDLER_FUNC(hrFifoHandler)
+{
+    heartRate *hr = (heartRate*) scheduler_task::getTaskPtrByName("hrt-rt");
+    if (NULL == hr) {
+        output.putline("Heart rate task is not running");
+        return true;
+    }
+
+    int ms = 1000;
+    cmdParams.scanf("%i", &ms);
+    if (ms <= 0) {
+        ms = 1000;
+    }
+
+    const uint32_t wakeups = hr->getWakeups();
+    const uint32_t samples = hr->getSamples();
+    const uint32_t overflows = hr->getOverflows();
+    const uint32_t transfers = i2c.getTransferCount();
+    vTaskDelayMs(ms);
+
+    const uint32_t d_wakeups = hr->getWakeups() - wakeups;
+    const uint32_t d_samples = hr->getSamples() - samples;
+    const uint32_t d_transfers = i2c.getTransferCount() - transfers;
+
+    output.printf("Samples      : %u/sec\n", d_samples * 1000 / ms);
+    output.printf("Wakeups      : %u/sec\n", d_wakeups * 1000 / ms);
+    output.printf("I2C1 xfers   : %u/sec\n", d_transfers * 1000 / ms);
+    if (d_samples) {
+        output.printf("Per sample   : %u.%02u I2C transactions (3 before FIFO bursts)\n",
+                      d_transfers / d_samples, (d_transfers * 100 / d_samples) % 100);
+    }
+    output.printf("FIFO overflow: %u samples\n", hr->getOverflows() - overflows);
+    return true;
+}
+
+CMD_HANDLER_FUNC(accBenchHandler)
+{
+    int samples = 25;
+    cmdParams.scanf("%i", &samples);
+    if (samples <= 0) {
+        output.putline("Usage: accbench <samples>");
+        return true;
+    }
+
+    /* Other I2C2 devices may add a few transactions while this runs */
+    I2C2& bus = I2C2::getInstance();
+    int16_t xyz[3];
+
+    uint32_t transfers = bus.getTransferCount();
+    uint64_t start_us = sys_get_uptime_us();
+    for (int i = 0; i < samples; i++) {
+        xyz[0] = AS.getX();
+        xyz[1] = AS.getY();
+        xyz[2] = AS.getZ();
+    }
+    const uint32_t axis_us = sys_get_uptime_us() - start_us;
+    const uint32_t axis_transfers = bus.getTransferCount() - transfers;
+
+    uint32_t failed = 0;
+    transfers = bus.getTransferCount();
+    start_us = sys_get_uptime_us();
+    for (int i = 0; i < samples; i++) {
+        failed += AS.getXYZ(xyz) ? 0 : 1;
+    }
+    const uint32_t burst_us = sys_get_uptime_us() - start_us;
+    const uint32_t burst_transfers = bus.getTransferCount() - transfers;
+
+    output.printf("Per axis : %5u I2C2 transactions %7u us\n", axis_transfers, axis_us);
+    output.printf("XYZ burst: %5u I2C2 transactions %7u us, %u failed\n", burst_transfers, burst_us, failed);
+    output.printf("Last     : X %i Y %i Z %i\n", xyz[0], xyz[1], xyz[2]);
+    return true;
+}
+
+CMD_HANDLER_FUNC(accRecordHandler)
+{
+    char *file = NULL, *secs = NULL;
+    const int tokens = cmdParams.tokenize(" ", 2, &file, &secs);
+    const int seconds = (tokens >= 2) ? str::toInt(secs) : 0;
+    if (seconds <= 0) {
+        output.putline("Usage: accrec <file> <seconds>");
+        return true;
+    }
+
+    FIL file_obj;
+    if (FR_OK != f_open(&file_obj, file, FA_WRITE | FA_CREATE_ALWAYS)) {
+        output.printf("Unable to open '%s' to write the trace\n", file);
+        return true;
+    }
+
+    /* Raw X, Y, Z int16_t records at the step detector rate, written 64 at a time */
+    int16_t buffer[64][3];
+    uint32_t count = 0, samples = 0, errors = 0;
+    const uint32_t total = seconds * STEP_SAMPLE_RATE_HZ;
+    UINT bw = 0;
+    bool ok = true;
+    TickType_t last_wake = xTaskGetTickCount();
+    output.printf("Recording %i sec at %u sps to %s ...\n", seconds, STEP_SAMPLE_RATE_HZ, file);
+
+    while (ok && samples < total)
+    {
+        errors += AS.getXYZ(buffer[count]) ? 0 : 1;
+        samples++;
+        if (++count == sizeof(buffer) / sizeof(buffer[0]) || samples == total) {
+            ok = (FR_OK == f_write(&file_obj, buffer, count * sizeof(buffer[0]), &bw) && count * sizeof(buffer[0]) == bw);
+            count = 0;
+        }
+        vTaskDelayUntil(&last_wake, OS_MS(1000 / STEP_SAMPLE_RATE_HZ));
+    }
+    f_close(&file_obj);
+
+    output.printf("%s : %u samples, %u read errors (%u bytes)\n", ok ? "Done" : "Write error",
+                  samples, errors, samples * sizeof(buffer[0]));
+    return true;
+}
+
+/// Reference step detection : sort the last window of every axis at every tick, as sort_Function() did
+typedef struct {
+    int16_t an_ring[3][STEP_WINDOW_SAMPLES];
+    int16_t an_mid[3][3];
+    uint32_t un_count;
+    uint32_t un_ticks;
+} stepplay_reference_t;
+
+static bool stepplay_reference(stepplay_reference_t &ref, const int16_t *pn_xyz, forBack_Count &step)
+{
+    int16_t an_sorted[STEP_WINDOW_SAMPLES];
+
+    for (int a = 0; a < 3; a++) {
+        ref.an_ring[a][ref.un_count % STEP_WINDOW_SAMPLES] = pn_xyz[a];
+    }
+    ref.un_count++;
+    if (ref.un_count < STEP_WINDOW_SAMPLES || 0 != (ref.un_count - STEP_WINDOW_SAMPLES) % STEP_TICK_SAMPLES) {
+        return false;
+    }
+    ref.un_ticks++;
+
+    for (int a = 0; a < 3; a++) {
+        memcpy(an_sorted, ref.an_ring[a], sizeof(an_sorted));
+        sort(an_sorted, an_sorted + STEP_WINDOW_SAMPLES);
+        ref.an_mid[2][a] = ref.an_mid[1][a];
+        ref.an_mid[1][a] = ref.an_mid[0][a];
+        ref.an_mid[0][a] = (an_sorted[0] + an_sorted[STEP_WINDOW_SAMPLES - 1]) / 2;
+    }
+
+    const int16_t x_th = ref.an_mid[0][0], x_prev = ref.an_mid[1][0], x_old = ref.an_mid[2][0];
+    step = invalid;
+    if (ref.un_ticks >= 3 && x_old + STEP_FORWARD_LEVEL < x_prev && x_th + STEP_FORWARD_LEVEL < x_prev) {
+        step = forw;
+    }
+    else if (ref.un_ticks >= 3 && x_old > x_prev + STEP_BACK_LEVEL && x_th > x_prev + STEP_BACK_LEVEL) {
+        step = back;
+    }
+    return true;
+}
+
+CMD_HANDLER_FUNC(stepReplayHandler)
+{
+    FIL file_obj;
+    if (0 == cmdParams.getLen()) {
+        output.putline("Usage: stepplay <file recorded by accrec>");
+        return true;
+    }
+    if (FR_OK != f_open(&file_obj, cmdParams(), FA_READ)) {
+        output.printf("Failed to open: %s\n", cmdParams());
+        return true;
+    }
+
+    StepDetector *detector = new StepDetector();
+    stepplay_reference_t *ref = new stepplay_reference_t;
+    if (NULL == detector || NULL == ref) {
+        output.putline("Out of memory");
+        f_close(&file_obj);
+        delete detector;
+        delete ref;
+        return true;
+    }
+    memset(ref, 0, sizeof(*ref));
+
+    int16_t buffer[64][3];
+    UINT br = 0;
+    uint32_t samples = 0, ticks = 0, ref_steps = 0, mismatch = 0;
+    uint64_t stream_us = 0, ref_us = 0;
+    forBack_Count step = invalid, ref_step = invalid;
+
+    while (FR_OK == f_read(&file_obj, buffer, sizeof(buffer), &br) && br >= sizeof(buffer[0]))
+    {
+        const uint32_t count = br / sizeof(buffer[0]);
+
+        uint64_t start_us = sys_get_uptime_us();
+        for (uint32_t i = 0; i < count; i++) {
+            detector->addSample(buffer[i], step);
+        }
+        stream_us += sys_get_uptime_us() - start_us;
+
+        /* Separate pass so the timing is per detector, the steps are compared tick by tick below */
+        start_us = sys_get_uptime_us();
+        for (uint32_t i = 0; i < count; i++) {
+            if (stepplay_reference(*ref, buffer[i], ref_step)) {
+                ref_steps += (invalid != ref_step) ? 1 : 0;
+            }
+        }
+        ref_us += sys_get_uptime_us() - start_us;
+        samples += count;
+
+        mismatch += (ref->un_ticks != detector->getTicks() ||
+                     ref->an_mid[0][0] != detector->getMidRange(0) ||
+                     ref->an_mid[0][1] != detector->getMidRange(1) ||
+                     ref->an_mid[0][2] != detector->getMidRange(2)) ? 1 : 0;
+    }
+    f_close(&file_obj);
+    ticks = detector->getTicks();
+
+    output.printf("Trace   : %u samples (%u sec), %u ticks\n", samples, samples / STEP_SAMPLE_RATE_HZ, ticks);
+    output.printf("Steps   : sliding min/max %u, sorted window %u%s\n", detector->getSteps(), ref_steps,
+                  (detector->getSteps() == ref_steps && 0 == mismatch) ? " (same)" : "");
+    if (mismatch) {
+        output.printf("Mid-range differs after %u of the blocks read\n", mismatch);
+    }
+    if (samples) {
+        output.printf("Time    : sliding %u ns/sample, sorted %u ns/sample\n",
+                      (uint32_t) (stream_us * 1000 / samples), (uint32_t) (ref_us * 1000 / samples));
+    }
+    delete detector;
+    delete ref;
+    return true;
+}
+
+/// Reference IR derivative filter : separate passes with a buffer between them
+static void firbench_reference(const int32_t *pn_x, int32_t *pn_ma, int32_t *pn_dx, int32_t *pn_out)
+{
+    const int32_t n_size = BUFFER_SIZE;
+    int32_t k, n_s;
+
+    for (k = 0; k <= n_size - MA4_SIZE; k++) {
+        pn_ma[k] = (pn_x[k] + pn_x[k + 1] + pn_x[k + 2] + pn_x[k + 3]) / (int32_t) 4;
+    }
+    for (k = 0; k < n_size - MA4_SIZE; k++) {
+        pn_dx[k] = pn_ma[k + 1] - pn_ma[k];
+    }
+    for (k = 0; k < n_size - MA4_SIZE - 1; k++) {
+        pn_dx[k] = (pn_dx[k] + pn_dx[k + 1]) / 2;
+    }
+    for (k = 0; k < n_size - MA4_SIZE - HAMMING_SIZE; k++) {
+        n_s = 0;
+        for (int32_t i = 0; i < HAMMING_SIZE; i++) {
+            n_s -= pn_dx[k + i] * auw_hamm[i];
+        }
+        pn_out[k] = n_s / (int32_t) 1146;
+    }
+}
+
+/// Reference temperature conversion : float resistance and linear table scan, as tempMeasure did it
+static float tempbench_reference(uint16_t code)
+{
+    float temperature = 0;
+    const float resistance = 10 / ((3.3f / ((code * 3.3f) / 4096)) - 1);
+    for (int i = 1; i < THERMISTOR_POINTS; i++) {
+        if (resistance > resistance_array[i] && resistance <= resistance_array[i - 1]) {
+            const float r1 = resistance_array[i - 1], r2 = resistance_array[i];
+            temperature = (THERMISTOR_MIN_C + i - 1) + (resistance - r1) / (r2 - r1);
+            break;
+        }
+    }
+    return temperature;
+}
+
+CMD_HANDLER_FUNC(tempBenchHandler)
+{
+    int rounds = 10;
+    cmdParams.scanf("%i", &rounds);
+    if (rounds <= 0) {
+        output.putline("Usage: tempbench <rounds of 4096 ADC codes>");
+        return true;
+    }
+
+    /* Every ADC code, so that both sides do the same mix of short and long searches */
+    volatile float ref_sink = 0;
+    volatile int32_t table_sink = 0;
+    uint64_t start_us = sys_get_uptime_us();
+    for (int r = 0; r < rounds; r++) {
+        for (uint32_t code = 0; code < 4096; code++) {
+            ref_sink = tempbench_reference(code);
+        }
+    }
+    const uint64_t ref_us = sys_get_uptime_us() - start_us;
+
+    start_us = sys_get_uptime_us();
+    for (int r = 0; r < rounds; r++) {
+        for (uint32_t code = 0; code < 4096; code++) {
+            table_sink = thermistor_adc_to_centi_celsius(code);
+        }
+    }
+    const uint64_t table_us = sys_get_uptime_us() - start_us;
+    (void) ref_sink;
+    (void) table_sink;
+
+    /* Accuracy against the float reference, within the table */
+    int32_t max_error = 0;
+    for (uint32_t code = 1; code < 4095; code++) {
+        const float resistance = 10.0f * code / (4096.0f - code);
+        if (resistance > resistance_array[0] || resistance < resistance_array[THERMISTOR_POINTS - 1]) {
+            continue;
+        }
+        const int32_t error = abs((int32_t) (tempbench_reference(code) * 100) - thermistor_adc_to_centi_celsius(code));
+        if (error > max_error) {
+            max_error = error;
+        }
+    }
+
+    const uint32_t conversions = rounds * 4096;
+    const uint32_t mhz = sys_get_cpu_clock() / (1000 * 1000);
+    output.printf("Float scan : %u cycles/conversion\n", (uint32_t) (ref_us * mhz / conversions));
+    output.printf("Table      : %u cycles/conversion\n", (uint32_t) (table_us * mhz / conversions));
+    output.printf("Max error  : %u.%02u C vs float interpolation of the table\n", max_error / 100, max_error % 100);
+    return true;
+}
+
+CMD_HANDLER_FUNC(firBenchHandler)
+{
+    typedef FilterChain<MovingAverageStage<MA4_SIZE>, IrDerivativeChain> Chain;
+    const int32_t n_outputs = BUFFER_SIZE - Chain::kDelay;
+    int windows = 100;
+    cmdParams.scanf("%i", &windows);
+    if (windows <= 0) {
+        output.putline("Usage: firbench <windows>");
+        return true;
+    }
+
+    int32_t *x = new int32_t[BUFFER_SIZE];
+    int32_t *ma = new int32_t[BUFFER_SIZE];
+    int32_t *dx = new int32_t[BUFFER_SIZE];
+    int32_t *ref = new int32_t[BUFFER_SIZE];
+    int32_t *fused = new int32_t[BUFFER_SIZE];
+    Chain *chain = new Chain();
+    if (NULL == x || NULL == ma || NULL == dx || NULL == ref || NULL == fused || NULL == chain) {
+        output.putline("Out of memory");
+    }
+    else {
+        uint64_t ref_us = 0, fused_us = 0, start_us = 0;
+        uint32_t mismatch = 0;
+        uint32_t un_red, un_ir;
+
+        for (int w = 0; w < windows; w++)
+        {
+            /* Fresh window of the benchmark trace, with the DC removed */
+            int32_t n_mean = 0;
+            for (int i = 0; i < BUFFER_SIZE; i++) {
+                hrbench_sample(w * BUFFER_SIZE + i, &un_red, &un_ir);
+                x[i] = un_ir;
+                n_mean += un_ir;
+            }
+            n_mean /= BUFFER_SIZE;
+            for (int i = 0; i < BUFFER_SIZE; i++) {
+                x[i] -= n_mean;
+            }
+
+            start_us = sys_get_uptime_us();
+            firbench_reference(x, ma, dx, ref);
+            ref_us += sys_get_uptime_us() - start_us;
+
+            start_us = sys_get_uptime_us();
+            chain->reset();
+            for (int i = 0, k = 0; i < BUFFER_SIZE; i++) {
+                if (chain->push(x[i], fused[k])) {
+                    k++;
+                }
+            }
+            fused_us += sys_get_uptime_us() - start_us;
+
+            for (int32_t k = 0; k < n_outputs; k++) {
+                mismatch += (ref[k] != fused[k]);
+            }
+        }
+
+        output.printf("Windows   : %i of %i samples, %i outputs each\n", windows, BUFFER_SIZE, n_outputs);
+        output.printf("4 passes  : %6u us/window\n", (uint32_t) (ref_us / windows));
+        output.printf("Fused     : %6u us/window\n", (uint32_t) (fused_us / windows));
+        output.printf("Mismatch  : %u/%u\n", mismatch, (uint32_t) (n_outputs * windows));
+    }
+
+    delete [] x;
+    delete [] ma;
+    delete [] dx;
+    delete [] ref;
+    delete [] fused;
+    delete chain;
+    return true;
+}
+
+/// Reference close-peak suppression : insertion sort by height, then a rescan per kept peak
+static int32_t peakbench_reference(int32_t *pn_locs, int32_t n_npks, const int32_t *pn_x, int32_t n_min_distance)
+{
+    int32_t i, j, n_temp, n_old_npks, n_dist;
+
+    for (i = 1; i < n_npks; i++) {
+        n_temp = pn_locs[i];
+        for (j = i; j > 0 && pn_x[n_temp] > pn_x[pn_locs[j-1]]; j--)
+            pn_locs[j] = pn_locs[j-1];
+        pn_locs[j] = n_temp;
+    }
+    for (i = -1; i < n_npks; i++) {
+        n_old_npks = n_npks;
+        n_npks = i + 1;
+        for (j = i + 1; j < n_old_npks; j++) {
+            n_dist = pn_locs[j] - (i == -1 ? -1 : pn_locs[i]);
+            if (n_dist > n_min_distance || n_dist < -n_min_distance)
+                pn_locs[n_npks++] = pn_locs[j];
+        }
+    }
+    maxim_sort_ascend(pn_locs, n_npks);
+    return n_npks;
+}
+
+CMD_HANDLER_FUNC(peakBenchHandler)
+{
+    int max_size = 8000;
+    int min_distance = PEAK_MIN_DISTANCE;
+    cmdParams.scanf("%i %i", &max_size, &min_distance);
+
+    output.printf("%6s %6s %6s %10s %10s  %s\n", "Size", "Cands", "Kept", "Ref us", "Heap us", "Match");
+    for (int32_t n_size = BUFFER_SIZE; n_size <= max_size; n_size *= 2)
+    {
+        /* Candidates are at least 2 samples apart, so a cap of n_size/2 never drops any */
+        const int32_t n_cap = n_size / 2;
+        int32_t *x = new int32_t[n_size];
+        int32_t *locs = new int32_t[n_cap];
+        int32_t *heights = new int32_t[n_cap];
+        int32_t *order = new int32_t[n_cap];
+        int32_t *ref = new int32_t[n_cap];
+        uint8_t *state = new uint8_t[n_cap];
+
+        if (NULL == x || NULL == locs || NULL == heights || NULL == order || NULL == ref || NULL == state) {
+            output.printf("%6i skipped, out of memory\n", n_size);
+        }
+        else {
+            /* Flipped benchmark trace, noise gives many local maxima of random height */
+            uint32_t un_red, un_ir;
+            for (int32_t i = 0; i < n_size; i++) {
+                hrbench_sample(i, &un_red, &un_ir);
+                x[i] = 120000 - (int32_t) un_ir;
+            }
+
+            const int32_t n_cands = peak_find_candidates(x, n_size, 0, locs, heights, n_cap);
+            memcpy(ref, locs, n_cands * sizeof(int32_t));
+
+            uint64_t start_us = sys_get_uptime_us();
+            const int32_t n_ref = peakbench_reference(ref, n_cands, x, min_distance);
+            const uint32_t ref_us = sys_get_uptime_us() - start_us;
+
+            start_us = sys_get_uptime_us();
+            const int32_t n_kept = peak_suppress_close(locs, heights, n_cands, min_distance, order, state);
+            const uint32_t heap_us = sys_get_uptime_us() - start_us;
+
+            const bool match = (n_ref == n_kept && 0 == memcmp(ref, locs, n_kept * sizeof(int32_t)));
+            output.printf("%6i %6i %6i %10u %10u  %s\n", n_size, n_cands, n_kept, ref_us, heap_us, match ? "yes" : "NO");
+        }
+
+        delete [] x;
+        delete [] locs;
+        delete [] heights;
+        delete [] order;
+        delete [] ref;
+        delete [] state;
+    }
+    return true;
+}
+
+CMD_HANDLER_FUNC(ppgRecordHandler)
+{
+    char *file = NULL, *secs = NULL, *hr = NULL, *spo2 = NULL;
+    const int tokens = cmdParams.tokenize(" ", 4, &file, &secs, &hr, &spo2);
+    const int seconds = (tokens >= 2) ? str::toInt(secs) : 0;
+    if (seconds <= 0) {
+        output.putline("Usage: ppgrec <file> <seconds> [reference HR] [reference SpO2]");
+        return true;
+    }
+    heartRate *hr_task = (heartRate*) scheduler_task::getTaskPtrByName("hrt-rt");
+    if (NULL == hr_task) {
+        output.putline("Heart rate task is not running");
+        return true;
+    }
+    const uint32_t rate = hr_task->getSampleRate();
+
+    FIL file_obj;
+    if (FR_OK != f_open(&file_obj, file, FA_WRITE | FA_CREATE_ALWAYS)) {
+        output.printf("Unable to open '%s' to write the trace\n", file);
+        return true;
+    }
+
+    /* Sample count is filled in once the recording ends */
+    ppg_trace_header_t header;
+    memset(&header, 0, sizeof(header));
+    header.un_magic = PPG_TRACE_MAGIC;
+    header.us_version = PPG_TRACE_VERSION;
+    header.us_sample_rate = rate;
+    header.us_sample_bytes = PPG_TRACE_SAMPLE_BYTES;
+    header.s_hr_label = (tokens >= 3) ? str::toInt(hr) : PPG_TRACE_NO_LABEL;
+    header.s_spo2_label = (tokens >= 4) ? str::toInt(spo2) : PPG_TRACE_NO_LABEL;
+
+    UINT bw = 0;
+    bool ok = (FR_OK == f_write(&file_obj, &header, sizeof(header), &bw) && sizeof(header) == bw);
+
+    uint8_t buffer[PPG_TRACE_SAMPLE_BYTES * 64];
+    const uint32_t start_ms = sys_get_uptime_ms();
+    const uint32_t timeout_ms = (seconds + 5) * 1000;
+    ppg_trace_recorder.start(seconds * rate);
+    output.printf("Recording %i sec at %u sps to %s ...\n", seconds, rate, file);
+
+    while (ok)
+    {
+        /* Check before reading, so the samples of the last burst are not left behind */
+        const bool done = !ppg_trace_recorder.isRecording();
+        uint32_t bytes;
+        while (ok && (bytes = ppg_trace_recorder.read(buffer, sizeof(buffer))) > 0) {
+            ok = (FR_OK == f_write(&file_obj, buffer, bytes, &bw) && bytes == bw);
+            header.un_samples += bytes / PPG_TRACE_SAMPLE_BYTES;
+        }
+        if (done) {
+            break;
+        }
+        if (sys_get_uptime_ms() - start_ms > timeout_ms) {
+            output.putline("No samples from the sensor, recording stopped");
+            break;
+        }
+        vTaskDelayMs(100);
+    }
+    ppg_trace_recorder.stop();
+
+    if (ok) {
+        ok = (FR_OK == f_lseek(&file_obj, 0) &&
+              FR_OK == f_write(&file_obj, &header, sizeof(header), &bw) && sizeof(header) == bw);
+    }
+    f_close(&file_obj);
+
+    output.printf("%s : %u samples, %u dropped (%u bytes)\n", ok ? "Done" : "Write error",
+                  header.un_samples, ppg_trace_recorder.getDropped(),
+                  sizeof(header) + header.un_samples * PPG_TRACE_SAMPLE_BYTES);
+    return true;
+}
+
+CMD_HANDLER_FUNC(ppgReplayHandler)
+{
+    char *file = NULL, *hr = NULL, *spo2 = NULL;
+    const int tokens = cmdParams.tokenize(" ", 3, &file, &hr, &spo2);
+    if (tokens < 1) {
+        output.putline("Usage: ppgplay <file> [reference HR] [reference SpO2]");
+        return true;
+    }
+
+    PpgTraceReader *reader = new PpgTraceReader();
+    uint32_t *aun_ir_buffer = new uint32_t[BUFFER_SIZE];
+    uint32_t *aun_red_buffer = new uint32_t[BUFFER_SIZE];
+    uint32_t *aun_ir_ring = new uint32_t[BUFFER_SIZE];
+    uint32_t *aun_red_ring = new uint32_t[BUFFER_SIZE];
+    if (NULL == reader || NULL == aun_ir_buffer || NULL == aun_red_buffer ||
+        NULL == aun_ir_ring || NULL == aun_red_ring) {
+        output.putline("Out of memory");
+    }
+    else if (!reader->open(file)) {
+        output.printf("Failed to open: %s\n", file);
+    }
+    else if (FS != reader->getSampleRate()) {
+        output.printf("Trace is %u sps, the batch algorithm needs %u sps\n", reader->getSampleRate(), FS);
+    }
+    else {
+        /* Labels given on the command line win over the ones in the file */
+        const int32_t hr_label = (tokens >= 2) ? str::toInt(hr) : reader->getHrLabel();
+        const int32_t spo2_label = (tokens >= 3) ? str::toInt(spo2) : reader->getSpo2Label();
+
+        int32_t n_sp02, n_heart_rate;
+        int8_t ch_spo2_valid, ch_hr_valid;
+        uint32_t un_red, un_ir, samples = 0, calls = 0, hr_valid = 0, spo2_valid = 0;
+        uint32_t hr_error = 0, spo2_error = 0, max_us = 0;
+        int32_t heap_delta = 0;
+        uint64_t total_us = 0;
+        const uint32_t stack_free_before = uxTaskGetStackHighWaterMark(NULL) * sizeof(StackType_t);
+
+        while (reader->next(&un_red, &un_ir))
+        {
+            aun_red_ring[samples % BUFFER_SIZE] = un_red;
+            aun_ir_ring[samples % BUFFER_SIZE] = un_ir;
+            samples++;
+
+            /* Same schedule as the original task : first result after 5 sec, then every second */
+            if (samples < BUFFER_SIZE || 0 != (samples - BUFFER_SIZE) % FS) {
+                continue;
+            }
+            for (int i = 0; i < BUFFER_SIZE; i++) {
+                aun_red_buffer[i] = aun_red_ring[(samples + i) % BUFFER_SIZE];
+                aun_ir_buffer[i] = aun_ir_ring[(samples + i) % BUFFER_SIZE];
+            }
+
+            const uint32_t heap_before = sys_get_mem_info().used_heap;
+            const uint64_t start_us = sys_get_uptime_us();
+            maxim_heart_rate_and_oxygen_saturation(aun_ir_buffer, BUFFER_SIZE, aun_red_buffer,
+                                                   &n_sp02, &ch_spo2_valid, &n_heart_rate, &ch_hr_valid);
+            const uint32_t us = sys_get_uptime_us() - start_us;
+            heap_delta += (int32_t) (sys_get_mem_info().used_heap - heap_before);
+
+            calls++;
+            total_us += us;
+            if (us > max_us) {
+                max_us = us;
+            }
+            if (ch_hr_valid) {
+                hr_valid++;
+                hr_error += abs(n_heart_rate - hr_label);
+            }
+            if (ch_spo2_valid) {
+                spo2_valid++;
+                spo2_error += abs(n_sp02 - spo2_label);
+            }
+        }
+        const uint32_t stack_free_after = uxTaskGetStackHighWaterMark(NULL) * sizeof(StackType_t);
+
+        output.printf("Trace   : %u samples (%s), %u calls\n", samples, reader->isBinary() ? "binary" : "text", calls);
+        if (calls) {
+            output.printf("Time    : %u ns/call, max %u us\n", (uint32_t) (total_us * 1000 / calls), max_us);
+        }
+        output.printf("Heap    : %i bytes allocated by the algorithm\n", heap_delta);
+        output.printf("Stack   : %u bytes free before, %u after (peak grew by %u)\n",
+                      stack_free_before, stack_free_after, stack_free_before - stack_free_after);
+        output.printf("HR      : %u/%u valid", hr_valid, calls);
+        if (hr_valid && PPG_TRACE_NO_LABEL != hr_label) {
+            output.printf(", mean error %u.%02u bpm vs %i", hr_error / hr_valid, (hr_error * 100 / hr_valid) % 100, hr_label);
+        }
+        output.printf("\nSpO2    : %u/%u valid", spo2_valid, calls);
+        if (spo2_valid && PPG_TRACE_NO_LABEL != spo2_label) {
+            output.printf(", mean error %u.%02u %% vs %i", spo2_error / spo2_valid, (spo2_error * 100 / spo2_valid) % 100, spo2_label);
+        }
+        output.printf("\n");
+    }
+
+    delete reader;
+    delete [] aun_ir_buffer;
+    delete [] aun_red_buffer;
+    delete [] aun_ir_ring;
+    delete [] aun_red_ring;
+    return true;
+}
+
+CMD_HANDLER_FUNC(hrRateHandler)
+{
+    heartRate *hr = (heartRate*) scheduler_task::getTaskPtrByName("hrt-rt");
+    if (NULL == hr) {
+        output.putline("Heart rate task is not running");
+        return true;
+    }
+
+    int rate = 0;
+    if (1 == cmdParams.scanf("%i", &rate)) {
+        if (hr->isSpooling()) {
+            output.putline("Stop the spool file first ('hrspool stop')");
+            return true;
+        }
+        if (rate <= 0 || !hr->setSampleRate(rate)) {
+            output.putline("Sample rate must be 25, 50, 100 or 200");
+            return true;
+        }
+        /* Applied by the heart rate task before its next FIFO read */
+        for (int i = 0; i < 20 && hr->getSampleRate() != (uint32_t) rate; i++) {
+            vTaskDelayMs(100);
+        }
+    }
+
+    output.printf("Heart rate sampled at %u sps, first result %u sec after a change\n",
+                  hr->getSampleRate(), PPG_STREAM_WINDOW_SEC);
+    if (rate > 0 && hr->getSampleRate() != (uint32_t) rate) {
+        output.printf("%i sps not applied (out of memory or task busy)\n", rate);
+    }
+    return true;
+}
+
+CMD_HANDLER_FUNC(tempHandler)
+{
+    tempMeasure *temp = (tempMeasure*) scheduler_task::getTaskPtrByName("temp");
+    if (NULL == temp) {
+        output.putline("Temperature task is not running");
+        return true;
+    }
+
+    int value = 0;
+    if (cmdParams == "reset") {
+        temp->resetStats();
+    }
+    else if (1 == cmdParams.scanf("rate %i", &value)) {
+        if (value <= 0 || !temp->setRate(value)) {
+            output.printf("Rate must be 1 to %u readings per second\n", TEMP_MAX_RATE_HZ);
+            return true;
+        }
+    }
+    else if (1 == cmdParams.scanf("hyst %i", &value)) {
+        if (value < 0) {
+            output.putline("Hysteresis must be 0 or more (0.01 C)");
+            return true;
+        }
+        temp->setHysteresis(value);
+    }
+
+    const int32_t centi = temp->getCentiCelsius();
+    const int32_t sent = temp->getPublishedCenti();
+    output.printf("Temperature %s%i.%02i C, last sent %s%i.%02i C (%u sent)\n",
+                  (centi < 0) ? "-" : "", abs(centi) / 100, abs(centi) % 100,
+                  (sent < 0) ? "-" : "", abs(sent) / 100, abs(sent) % 100, temp->getPublished());
+    output.printf("%u readings/sec of %u conversions, hysteresis %u.%02u C\n",
+                  temp->getRate(), TEMP_OVERSAMPLE, temp->getHysteresis() / 100, temp->getHysteresis() % 100);
+    output.printf("%u conversions/sec, CPU %u %%\n", temp->getConversionsPerSec(), temp->getTaskCpuPercent());
+    return true;
+}
+
+CMD_HANDLER_FUNC(hrSpoolHandler)
+{
+    heartRate *hr = (heartRate*) scheduler_task::getTaskPtrByName("hrt-rt");
+    if (NULL == hr) {
+        output.putline("Heart rate task is not running");
+        return true;
+    }
+
+    const bool stop = (cmdParams == "stop");
+    if (stop || cmdParams.getLen() > 0) {
+        const bool was_spooling = hr->isSpooling();
+        if (stop ? !hr->stopSpool() : !hr->startSpool(cmdParams())) {
+            output.putline(stop ? "Not spooling" : "Already spooling, or the file name is too long");
+            return true;
+        }
+        /* Applied by the spool writer task within HR_SPOOL_DRAIN_MS */
+        for (int i = 0; i < 20 && hr->isSpooling() == was_spooling && !hr->getSpoolError(); i++) {
+            vTaskDelayMs(100);
+        }
+    }
+
+    if (hr->getSpoolError()) {
+        output.printf("Unable to write '%s'\n", hr->getSpoolPath());
+    }
+    const uint32_t rate = hr->getSampleRate();
+    const uint32_t samples = hr->getSpoolSamples();
+    output.printf("%s %s : %u samples (%u sec at %u sps), %u bytes, longest write %u us, %u dropped\n",
+                  hr->isSpooling() ? "Spooling to" : "Last spool file", hr->getSpoolPath(),
+                  samples, samples / rate, rate, hr->getSpoolBytes(), hr->getSpoolMaxWriteUs(),
+                  hr->getSpoolDropped());
+    return true;
+}
+
+CMD_HANDLER_FUNC(spoolRunHandler)
+{
+    char *file = NULL, *csv = NULL;
+    const int tokens = cmdParams.tokenize(" ", 2, &file, &csv);
+    if (tokens < 1) {
+        output.putline("Usage: spoolrun <spool or trace file> [output csv file]");
+        return true;
+    }
+
+    PpgTraceReader *reader = new PpgTraceReader();
+    PpgEngine *engine = NULL;
+    FIL *csv_file = (tokens >= 2) ? new FIL : NULL;
+    if (NULL == reader || (tokens >= 2 && NULL == csv_file)) {
+        output.putline("Out of memory");
+    }
+    else if (!reader->open(file)) {
+        output.printf("Failed to open: %s\n", file);
+    }
+    else if (NULL == (engine = ppg_engine_create(reader->getSampleRate()))) {
+        output.printf("No engine for %u sps (or out of memory)\n", reader->getSampleRate());
+    }
+    else if (NULL != csv_file && FR_OK != f_open(csv_file, csv, FA_WRITE | FA_CREATE_ALWAYS)) {
+        output.printf("Unable to open '%s' to write the results\n", csv);
+        delete csv_file;
+        csv_file = NULL;
+    }
+    else {
+        /* Same engine and schedule as the live heart rate task, so the series is identical */
+        const uint32_t rate = reader->getSampleRate();
+        engine->setOutputInterval(rate);
+
+        char line[512];
+        uint32_t line_len = 0;
+        UINT bw = 0;
+        bool ok = true;
+        if (NULL != csv_file) {
+            line_len = sprintf(line, "sample,hr,hr_valid,spo2,spo2_valid\n");
+        }
+
+        int32_t n_sp02, n_heart_rate;
+        int8_t ch_spo2_valid, ch_hr_valid;
+        uint32_t un_red, un_ir, samples = 0, windows = 0, hr_valid = 0, spo2_valid = 0;
+        uint64_t compute_us = 0;
+        const uint64_t start_us = sys_get_uptime_us();
+
+        while (ok && reader->next(&un_red, &un_ir))
+        {
+            samples++;
+            if (!engine->addSample(un_red, un_ir)) {
+                continue;
+            }
+            const uint64_t compute_start_us = sys_get_uptime_us();
+            engine->compute(&n_sp02, &ch_spo2_valid, &n_heart_rate, &ch_hr_valid);
+            compute_us += sys_get_uptime_us() - compute_start_us;
+            windows++;
+            hr_valid += ch_hr_valid ? 1 : 0;
+            spo2_valid += ch_spo2_valid ? 1 : 0;
+
+            if (NULL != csv_file) {
+                line_len += sprintf(line + line_len, "%u,%i,%i,%i,%i\n", samples, n_heart_rate, ch_hr_valid,
+                                    n_sp02, ch_spo2_valid);
+                /* Written a sector at a time */
+                if (line_len > sizeof(line) - 64) {
+                    ok = (FR_OK == f_write(csv_file, line, line_len, &bw) && line_len == bw);
+                    line_len = 0;
+                }
+            }
+        }
+        if (NULL != csv_file) {
+            ok = ok && (FR_OK == f_write(csv_file, line, line_len, &bw) && line_len == bw);
+            f_close(csv_file);
+        }
+        const uint32_t total_ms = (uint32_t) ((sys_get_uptime_us() - start_us) / 1000);
+
+        output.printf("Trace    : %u samples at %u sps (%s), %u windows\n", samples, rate,
+                      reader->isPacked() ? "spool" : reader->isBinary() ? "binary" : "text", windows);
+        output.printf("HR       : %u/%u valid, SpO2 %u/%u valid\n", hr_valid, windows, spo2_valid, windows);
+        if (total_ms > 0) {
+            output.printf("Speed    : %u windows/sec, %u samples/sec (%ux real time) in %u ms\n",
+                          (uint32_t) ((uint64_t) windows * 1000 / total_ms), (uint32_t) ((uint64_t) samples * 1000 / total_ms),
+                          (uint32_t) ((uint64_t) samples * 1000 / total_ms / rate), total_ms);
+        }
+        if (windows > 0) {
+            output.printf("compute(): %u us/window, the rest is reading and filtering\n", (uint32_t) (compute_us / windows));
+        }
+        if (!ok) {
+            output.printf("Write error on %s\n", csv);
+        }
+    }
+
+    delete reader;
+    delete engine;
+    delete csv_file;
+    return true;
+}
+
+CMD_HANDLER_FUNC(hrvHandler)
+{
+    heartRate *hr = (heartRate*) scheduler_task::getTaskPtrByName("hrt-rt");
+    if (NULL == hr) {
+        output.putline("Heart rate task is not running");
+        return true;
+    }
+
+    int minutes = 0;
+    if (1 == cmdParams.scanf("%i", &minutes)) {
+        if (minutes <= 0 || !hr->setHrvWindow(minutes)) {
+            output.printf("Window must be %u to %u minutes\n", HrvStats::kMinWindowMin, HrvStats::kMaxWindowMin);
+            return true;
+        }
+        /* Applied by the heart rate task, shown with the next beat */
+        output.printf("HRV window set to %i min\n", minutes);
+    }
+
+    const hrv_t hrv = hr->getHrv();
+    if (0 == hrv.us_intervals) {
+        output.putline("No RR interval yet");
+    }
+    else {
+        output.printf("Window    : %u min, %u RR intervals, last beat %u ms ago\n", hrv.uch_window_min,
+                      hrv.us_intervals, (unsigned) (sys_get_uptime_ms() - hrv.un_time_ms));
+        output.printf("RR        : last %u ms, mean %u ms\n", hrv.us_rr_ms, hrv.us_mean_rr_ms);
+        output.printf("SDNN      : %u.%u ms\n", hrv.us_sdnn_x10 / 10, hrv.us_sdnn_x10 % 10);
+        output.printf("RMSSD     : %u.%u ms\n", hrv.us_rmssd_x10 / 10, hrv.us_rmssd_x10 % 10);
+        output.printf("pNN50     : %u.%u %%\n", hrv.us_pnn50_x10 / 10, hrv.us_pnn50_x10 % 10);
+    }
+    output.printf("Intervals : %u taken, %u rejected as artifacts\n", hr->getHrvAccepted(), hr->getHrvRejected());
+    return true;
+}
+
+CMD_HANDLER_FUNC(spo2GateHandler)
+{
+    heartRate *hr = (heartRate*) scheduler_task::getTaskPtrByName("hrt-rt");
+    if (NULL == hr) {
+        output.putline("Heart rate task is not running");
+        return true;
+    }
+
+    int skip = 0, slow = 0;
+    if (cmdParams == "reset") {
+        hr->resetSpo2Stats();
+    }
+    else if (2 == cmdParams.scanf("%i %i", &skip, &slow)) {
+        if (skip < 0 || slow < 0 || !hr->setMotionLevels(skip, slow)) {
+            output.putline("Levels must be positive, with <slow> not above <skip>");
+            return true;
+        }
+    }
+
+    const uint32_t computed = hr->getSpo2Computed();
+    const uint32_t skipped = hr->getSpo2Skipped();
+    const uint32_t slowed = hr->getSpo2Slowed();
+    const uint32_t outputs = computed + skipped + slowed;
+    const uint32_t full_us = computed ? (uint32_t) (hr->getFullComputeUs() / computed) : 0;
+    const uint32_t hr_us = (skipped + slowed) ? (uint32_t) (hr->getHrOnlyComputeUs() / (skipped + slowed)) : 0;
+
+    output.printf("Motion    : %u now, SpO2 skipped above %u, every %u outputs above %u\n",
+                  (unsigned) motion_intensity, hr->getSkipLevel(), HR_SPO2_SLOW_DIVIDER, hr->getSlowLevel());
+    output.printf("Outputs   : %u, SpO2 computed %u, skipped %u, down-rated %u\n",
+                  outputs, computed, skipped, slowed);
+    output.printf("compute() : %u us with SpO2, %u us without\n", full_us, hr_us);
+
+    /* The heart rate task asks for one output per second, so outputs are seconds of wear */
+    if (computed > 0 && (skipped + slowed) > 0 && full_us > hr_us) {
+        const uint64_t saved_us = (uint64_t) (skipped + slowed) * (full_us - hr_us);
+        output.printf("Saved     : %u ms of CPU per hour of wear\n",
+                      (unsigned) ((saved_us * 3600) / outputs / 1000));
+    }
+    return true;
+}
+
+CMD_HANDLER_FUNC(isrEventHandler)
+{
+    const bool reset = (cmdParams == "reset");
+
+    output.printf("%-10s %8s %6s %6s %7s  Latency (us) <", "Event", "Signals", "Missed", "T/O", "Max us");
+    for (uint8_t b = 0; b < IsrEvent::kLatencyBuckets - 1; b++) {
+        output.printf("%6u", IsrEvent::getBucketLimitUs(b));
+    }
+    output.printf("  more\n");
+
+    for (IsrEvent *e = IsrEvent::getFirst(); NULL != e; e = e->getNext())
+    {
+        output.printf("%-10s %8u %6u %6u %7u                ", e->getName(), e->getSignalCount(),
+                      e->getMissedCount(), e->getTimeoutCount(), e->getMaxLatencyUs());
+        for (uint8_t b = 0; b < IsrEvent::kLatencyBuckets; b++) {
+            output.printf("%6u", e->getLatencyCount(b));
+        }
+        output.printf("\n");
+
+        if (reset) {
+            e->resetStats();
+        }
+    }
+    return true;
+}
+
+CMD_HANDLER_FUNC(sampleJobHandler)
+{
+    const bool reset = (cmdParams == "reset");
+
+    output.printf("%-8s %6s %5s %8s %8s %7s %5s  Latency (us) %5s %5s %5s %6s\n", "Job", "Period", "Phase",
+                  "Slots", "Runs", "Overrun", "T/O", "min", "avg", "max", "jitter");
+    for (SampleJob *j = SampleJob::getFirst(); NULL != j; j = j->getNext())
+    {
+        output.printf("%-8s %6u %5u %8u %8u %7u %5u               %5u %5u %5u %6u\n", j->getName(),
+                      j->getPeriodMs(), j->getPhaseMs(), j->getSlotCount(), j->getRunCount(),
+                      j->getOverrunCount(), j->getTimeoutCount(), j->getMinLatencyUs(),
+                      j->getAvgLatencyUs(), j->getMaxLatencyUs(), j->getJitterUs());
+        if (reset) {
+            j->resetStats();
+        }
+    }
+    const uint64_t slot = SampleScheduler::getSlot();
+    output.printf("Slots for %u sec, longest timer interrupt %u us\n", (uint32_t) (slot / 1000),
+                  SampleScheduler::getMaxIsrUs());
+    if (reset) {
+        SampleScheduler::resetStats();
+    }
+    return true;
+}
+
+CMD_HANDLER_FUNC(lcdBenchHandler)
+{
+    display_Task *lcd = (display_Task*) scheduler_task::getTaskPtrByName("display");
+    if (NULL == lcd || NULL == screen_change) {
+        output.putline("Display task is not running");
+        return true;
+    }
+
+    /* Hold the screen so that the display and button tasks do not draw meanwhile */
+    if (!xSemaphoreTake(screen_change, OS_MS(1000))) {
+        output.putline("Display is busy, try again");
+        return true;
+    }
+
+    /* 'text' draws the digits below the sensor grid at the size of the readings */
+    const bool text = (cmdParams == "text");
+    const char *digits = "0123456789";
+    const int text_rounds = 20;
+
+    /* The DMA run returns before the last fill is sent, the task is free meanwhile */
+    const char *mode[] = { "Per pixel", "Bulk", "Bulk DMA" };
+    for (int i = 0; i < 3; i++) {
+        lcd->setPerPixel(0 == i);
+        lcd->setDma(2 == i);
+        lcd->resetSpiStats();
+        lcd->getTextRaster().resetStats();
+        const uint64_t start_us = sys_get_uptime_us();
+        if (text) {
+            for (int r = 0; r < text_rounds; r++) {
+                lcd->drawString(digits, 12, 270, 2, (r & 1) ? ILI9340_YELLOW : ILI9340_CYAN);
+            }
+        }
+        else {
+            lcd->clearScrn1();
+        }
+        const uint32_t call_us = sys_get_uptime_us() - start_us;
+        lcd->waitPixels();
+        const uint32_t us = sys_get_uptime_us() - start_us;
+        output.printf("%-9s: %7u SPI transactions %8u bytes %8u us, returned after %8u us\n", mode[i],
+                      lcd->getSpiTransactions(), lcd->getSpiBytes(), us, call_us);
+        if (text) {
+            output.printf("           %7u chars/sec, %u glyph rows cached, %u expanded\n",
+                          (uint32_t) (1000000ULL * text_rounds * strlen(digits) / (us ? us : 1)),
+                          lcd->getTextRaster().getCacheHits(), lcd->getTextRaster().getCacheMisses());
+        }
+    }
+    if (text) {
+        lcd->fillRect(12, 270, TextRaster::getWidth(digits, 2), 16, ILI9340_BLACK);
+    }
+    lcd->redrawScreen();
+    lcd->setPerPixel(false);
+    lcd->setDma(true);
+
+    xSemaphoreGive(screen_change);
+    return true;
+}
+
+CMD_HANDLER_FUNC(lcdRateHandler)
+{
+    display_Task *lcd = (display_Task*) scheduler_task::getTaskPtrByName("display");
+    if (NULL == lcd || NULL == screen_change) {
+        output.putline("Display task is not running");
+        return true;
+    }
+
+    char *ms_str = NULL, *mode = NULL;
+    const int tokens = cmdParams.tokenize(" ", 2, &ms_str, &mode);
+    int ms = (tokens >= 1) ? str::toInt(ms_str) : 0;
+    ms = (ms > 0) ? ms : 5000;
+    const bool immediate = (tokens >= 2 && 0 == strcmp(mode, "immediate"));
+
+    /* The widgets are repainted by the display task, switch between two frames */
+    if (xSemaphoreTake(screen_change, OS_MS(1000))) {
+        lcd->setRetained(!immediate);
+        xSemaphoreGive(screen_change);
+    }
+
+    const uint32_t bytes = lcd->getSpiBytes();
+    const uint32_t transactions = lcd->getSpiTransactions();
+    const uint64_t start_us = sys_get_uptime_us();
+    vTaskDelayMs(ms);
+    const uint32_t us = sys_get_uptime_us() - start_us;
+    const uint32_t sent = lcd->getSpiBytes() - bytes;
+    const uint32_t cycles = lcd->getSpiTransactions() - transactions;
+
+    if (xSemaphoreTake(screen_change, OS_MS(1000))) {
+        lcd->setRetained(true);
+        xSemaphoreGive(screen_change);
+    }
+
+    output.printf("%s : %u bytes/sec, %u SPI transactions/sec over %u ms\n", immediate ? "Full redraw" : "Widgets",
+                  (uint32_t) (1000000ULL * sent / us), (uint32_t) (1000000ULL * cycles / us), us / 1000);
+    return true;
+}
+
+CMD_HANDLER_FUNC(lcdLatencyHandler)
+{
+    display_Task *lcd = (display_Task*) scheduler_task::getTaskPtrByName("display");
+    if (NULL == lcd) {
+        output.putline("Display task is not running");
+        return true;
+    }
+
+    if (cmdParams == "reset") {
+        lcd->resetLatency();
+        output.putline("Display latency statistics cleared");
+        return true;
+    }
+
+    /* From the sample to the end of the pixels, for the readings shown on the sensor screen */
+    output.printf("Sensor to pixel: %u readings, min %u us, avg %u us, max %u us\n", lcd->getLatencyCount(),
+                  lcd->getMinLatencyUs(), lcd->getAvgLatencyUs(), lcd->getMaxLatencyUs());
+    output.printf("Event loop     : %u wake-ups, %u events, %u at most in one burst, %u readings coalesced\n",
+                  lcd->getWakeups(), lcd->getEvents(), lcd->getMaxBurst(), lcd->getCoalesced());
+    return true;
+}
+
+CMD_HANDLER_FUNC(btLinkHandler)
+{
+    display_Task *lcd = (display_Task*) scheduler_task::getTaskPtrByName("display");
+    int ms = 0;
+
+    if (cmdParams == "ascii" || cmdParams == "binary") {
+        if (NULL != lcd) {
+            lcd->setBtBinary(cmdParams == "binary");
+        }
+    }
+    else if (cmdParams == "history") {
+        if (NULL != lcd) {
+            lcd->requestHistory();
+        }
+    }
+    else if (cmdParams == "reset") {
+        if (NULL != lcd) {
+            lcd->getBtEncoder().resetStats();
+            lcd->resetBtBytes();
+        }
+    }
+    else if (cmdParams.beginsWith("batch ") && 1 == cmdParams.scanf("%*s %i", &ms) && ms >= 0) {
+        if (NULL != lcd) {
+            lcd->getBtEncoder().setBatchMs(ms);
+        }
+    }
+    else if (cmdParams.beginsWith("key ") && 1 == cmdParams.scanf("%*s %i", &ms) && ms > 0) {
+        if (NULL != lcd) {
+            lcd->getBtEncoder().setKeyframeMs(ms);
+        }
+    }
+    else if (cmdParams.beginsWith("bench")) {
+        /* Simulated vitals : heart rate and HRV every second, SpO2 every 5 sec, temperature
+         * every 30 sec, steps at 2 Hz.  The old loop sent the ASCII frame every 100 msec.
+         */
+        int secs = 60;
+        cmdParams.scanf("%*s %i", &secs);
+        secs = (secs > 0) ? secs : 60;
+        const uint32_t batch_ms[] = { 0, 1000 };
+        char ascii[48];
+        uint8_t frame[VLINK_MAX_FRAME];
+        uint32_t ascii_bytes = 0;
+        uint64_t start_us = 0;
+        uint32_t ascii_us = 0;
+
+        for (int pass = 0; pass < 3; pass++) {
+            VitalsEncoder enc;
+            VitalsDecoder dec;
+            vitals_t v = { { 72, 97, 36, 0, 420, 510, 90 } };
+            vlink_record_t rec;
+            bool same = false;
+            uint32_t code_us = 0;
+            enc.setBatchMs((pass > 0) ? batch_ms[pass - 1] : 0);
+
+            for (uint32_t t = 0; t < (uint32_t) secs * 10; t++) {
+                const uint32_t ms_now = t * 100;
+                v.an_value[VLINK_STEPS] += (t % 5) ? 0 : 1;
+                if (0 == t % 10) {
+                    v.an_value[VLINK_HEART_RATE] = 70 + (t / 10) % 7;
+                    v.an_value[VLINK_RMSSD_X10] = 400 + (t / 10) % 31;
+                    v.an_value[VLINK_SDNN_X10] = 500 + (t / 10) % 17;
+                }
+                v.an_value[VLINK_OXYGEN] = 96 + (t / 50) % 3;
+                v.an_value[VLINK_BODY_TEMP] = 36 + (t / 300) % 2;
+
+                start_us = sys_get_uptime_us();
+                if (0 == pass) {
+                    ascii_bytes += snprintf(ascii, sizeof(ascii), "#%3d+%3d+%3d+%4d+~", (int) v.an_value[0],
+                                            (int) v.an_value[1], (int) v.an_value[2], (int) v.an_value[3]);
+                    if (0 == t % 10) {
+                        ascii_bytes += snprintf(ascii, sizeof(ascii), "%%%5u+%5u+%4u+%u+~", (unsigned) v.an_value[5],
+                                                (unsigned) v.an_value[4], (unsigned) v.an_value[6], 1u);
+                    }
+                    ascii_us += sys_get_uptime_us() - start_us;
+                    continue;
+                }
+                uint32_t len = enc.addVitals(v, ms_now, frame);
+                if (enc.flushDue(ms_now)) {
+                    len += enc.flush(ms_now, frame + len);
+                }
+                code_us += sys_get_uptime_us() - start_us;
+
+                /* The phone side, the last record decoded has the values sent */
+                for (uint32_t i = 0; i < len; i++) {
+                    if (dec.feed(frame[i])) {
+                        while (dec.nextRecord(rec)) {
+                            same = (0 == memcmp(&rec.vitals, &v, sizeof(v)));
+                        }
+                    }
+                }
+            }
+            /* The rest of the batch */
+            const uint32_t len = enc.flush(secs * 1000, frame);
+            for (uint32_t i = 0; i < len; i++) {
+                if (dec.feed(frame[i])) {
+                    while (dec.nextRecord(rec)) {
+                        same = (0 == memcmp(&rec.vitals, &v, sizeof(v)));
+                    }
+                }
+            }
+            if (0 == pass) {
+                output.printf("ASCII every 100 ms : %6u bytes/sec, %3u%% of 9600 baud, %u us per tick\n",
+                              ascii_bytes / secs, ascii_bytes / secs * 10 / 96, ascii_us / (secs * 10));
+                continue;
+            }
+            /* Latency : waiting in the batch, then the frame on the air at 960 bytes/sec */
+            const uint32_t frame_ms = enc.getFrames() ? (enc.getBytes() * 1000 / 960 / enc.getFrames()) : 0;
+            output.printf("Binary, batch %4u : %6u bytes/sec, %3u%% of 9600 baud, %u us per tick, "
+                          "%u records in %u frames, latency %u ms, decoded %s\n",
+                          enc.getBatchMs(), enc.getBytes() / secs, enc.getBytes() / secs * 10 / 96,
+                          code_us / (secs * 10), enc.getRecords(), enc.getFrames(),
+                          enc.getAvgBatchWaitMs() + frame_ms, same ? "OK" : "FAILED");
+        }
+        return true;
+    }
+
+    if (NULL == lcd) {
+        output.putline("Display task is not running");
+        return true;
+    }
+    const VitalsEncoder &enc = lcd->getBtEncoder();
+    const VitalsDecoder &dec = lcd->getBtDecoder();
+    output.printf("Mode     : %s, %u bytes sent\n", lcd->getBtBinary() ? "binary" : "ASCII", lcd->getBtBytes());
+    output.printf("Encoder  : %u records, %u keyframes, %u frames, %u bytes, keyframe every %u ms, batch %u ms (%u ms wait)\n",
+                  enc.getRecords(), enc.getKeyframes(), enc.getFrames(), enc.getBytes(),
+                  enc.getKeyframeMs(), enc.getBatchMs(), enc.getAvgBatchWaitMs());
+    output.printf("Requests : %u frames, %u CRC errors, %u lost\n",
+                  dec.getFrames(), dec.getCrcErrors(), dec.getLostFrames());
+    output.printf("History  : %u entries\n", lcd->getBtHistory().getCount());
+    return true;
+}
+
+CMD_HANDLER_FUNC(uartBenchHandler)
+{
+    /* Moves the same bytes through a FreeRTOS queue one char at a time like the old
+     * UART driver did, and through a ByteRing one char and one FIFO (16 chars) at a
+     * time.  The cost per byte is then scaled to the byte rate of 115200 and 921600 bps.
+     */
+    const uint32_t total = 8192;
+    const uint32_t span = 16;
+    const char *names[] = { "queue", "ring", "ring x16" };
+    uint32_t us[3] = { 0 };
+    uint8_t buff[span] = { 0 };
+    uint8_t c = 0;
+    long woken = 0;
+
+    Uart0 &u0 = Uart0::getInstance();
+    output.printf("Uart0: %u/%u (rx/tx) watermarks, %u rx bytes lost, %u interrupts, "
+                  "DMA %s/%s (rx/tx) with %u tx runs\n",
+                  u0.getRxQueueWatermark(), u0.getTxQueueWatermark(), u0.getRxOverflowCount(),
+                  u0.getInterruptCount(), u0.isRxDma() ? "on" : "off", u0.isTxDma() ? "on" : "off",
+                  u0.getTxDmaCount());
+
+    QueueHandle_t q = xQueueCreate(span, sizeof(char));
+    ByteRing ring;
+    if (0 == q || !ring.init(span)) {
+        output.putline("Out of memory");
+        if (q) {
+            vQueueDelete(q);
+        }
+        return true;
+    }
+
+    vTaskSuspendAll();
+    uint64_t start_us = sys_get_uptime_us();
+    for (uint32_t i = 0; i < total; i += span) {
+        for (uint32_t k = 0; k < span; k++) {
+            xQueueSendFromISR(q, &buff[k], &woken);
+        }
+        for (uint32_t k = 0; k < span; k++) {
+            xQueueReceive(q, &c, 0);
+        }
+    }
+    us[0] = sys_get_uptime_us() - start_us;
+
+    start_us = sys_get_uptime_us();
+    for (uint32_t i = 0; i < total; i += span) {
+        for (uint32_t k = 0; k < span; k++) {
+            ring.put(buff[k]);
+        }
+        for (uint32_t k = 0; k < span; k++) {
+            ring.get(&c);
+        }
+    }
+    us[1] = sys_get_uptime_us() - start_us;
+
+    start_us = sys_get_uptime_us();
+    for (uint32_t i = 0; i < total; i += span) {
+        ring.write(buff, span);
+        ring.read(buff, span);
+    }
+    us[2] = sys_get_uptime_us() - start_us;
+    xTaskResumeAll();
+    vQueueDelete(q);
+
+    /* 10 bits per char on the line, so bps / 10 bytes every second */
+    output.printf("%u bytes in and out, CPU time at the line rate:\n", total);
+    for (int i = 0; i < 3; i++) {
+        const uint32_t pm115 = (uint64_t) us[i] * (115200 / 10) * 1000 / ((uint64_t) total * 1000000);
+        const uint32_t pm921 = (uint64_t) us[i] * (921600 / 10) * 1000 / ((uint64_t) total * 1000000);
+        output.printf("%-8s : %5u us, %2u.%u%% @ 115200, %2u.%u%% @ 921600\n", names[i], us[i],
+                      pm115 / 10, pm115 % 10, pm921 / 10, pm921 % 10);
+    }
+    return true;
+}
+
 #if TERMINAL_USE_CAN_BUS_HANDLER
 #include "can.h"
 #include "printf_lib.h"
@@ -101,6 +101,9 @@ void high_level_init(void)
     if (!I2C1::getInstance().init(SYS_CFG_I2C2_CLK_KHZ)) {					// for i2c1 j
         puts("ERROR: Possible short on SDA or SCL wire (I2C1)!");
     }
+    /* Fast-mode devices are not held back by the slower devices of their bus */
+    I2C1::getInstance().setDeviceSpeed(I2CAddr_HeartRateSensor, SYS_CFG_I2C_FAST_CLK_KHZ);
+    I2C2::getInstance().setDeviceSpeed(I2CAddr_AccelerationSensor, SYS_CFG_I2C_FAST_CLK_KHZ);
 
     /**
      * This timer does several things:
@@ -14,96 +14,464 @@ $Revision      : 1.0 $
 /****************************************************************************/
 /*                       INCLUDE FILES                                      */
 /****************************************************************************/
+#include <string.h>
 #include "tasks.hpp"
 #include "algorithm.hpp"
+#include "ppg_stream.hpp"
+#include "ppg_trace.hpp"
 #include "eint.h"
 #include "handlers.hpp"
 #include "queue.h"
 #include "lpc_timers.h"
+#include "adc0.h"
 /****************************************************************************/
 /*                        VARIABLES AND MACROS                              */
 /****************************************************************************/
 
+// Queues to share SpO2 and heart rate values
+QueueHandle_t oxygen_data = NULL;
+QueueHandle_t heart_data  = NULL;
 // Queue to share Temperature values
 QueueHandle_t temp_data = NULL;
 // Queue to share Steps values
 QueueHandle_t step_data =  NULL;
+// Queue to share every RR interval
+QueueHandle_t rr_data =  NULL;
+// Queue to share the latest heart rate variability
+QueueHandle_t hrv_data =  NULL;
+// Motion intensity from the accelerometer, read by the heart rate task
+volatile uint32_t motion_intensity = 0;
 // Get instance of I2C1 to communicate with Hear Rate - Oxygen Sensor
 I2C1& i2c1 = I2C1::getInstance();
-volatile bool flag1 = false;
+// Signaled by the MAX30102 FIFO almost-full interrupt
+IsrEvent max30102_fifo_event("max30102");
+// Scheduler slots of the accelerometer samples and the temperature readings
+static SampleJob accel_job("accel", 1000 / STEP_SAMPLE_RATE_HZ, ACCEL_JOB_PHASE_MS);
+static SampleJob temp_job("temp", 1000 / TEMP_DEFAULT_RATE_HZ, TEMP_JOB_PHASE_MS);
 extern volatile bool start;
-#define MAX_BRIGHTNESS 255
+// Almost-full interrupt comes every 17 samples (85 msec at 200 sps, 680 msec at 25 sps),
+// drain the FIFO anyway if it is missed
+#define HR_FIFO_TIMEOUT_MS (1000)
 GPIO_CUSTOM gpioObj;
 
 /*----------------------------------------------------------------------------
 Function    :  maxim_max30102_read_fifo ()
-Inputs      :  uint32_t *pun_red_led, uint32_t *pun_ir_led
-Processing  :  This function reads a set of samples from the MAX30102 FIFO register
-Outputs     :  *pun_red_led   - pointer that stores the red LED reading data
- 	 	 	   *pun_ir_led    - pointer that stores the IR LED reading data
-Returns     :  true on success
-Notes       :  Algorithm by Maxim, edited by Jean Mary M
+Inputs      :  uint8_t *puch_fifo - MAX30102_FIFO_DEPTH * MAX30102_SAMPLE_BYTES bytes
+Processing  :  This function drains the MAX30102 FIFO on I2C1 and counts the
+			   samples and the overflows
+Outputs     :  *puch_fifo     - raw samples, MAX30102_SAMPLE_BYTES each
+Returns     :  Number of samples read
+Notes       :  See maxim_max30102_drain_fifo(), host/max30102_fifo_test.cpp runs
+			   it against a simulated sensor
 ----------------------------------------------------------------------------*/
+uint8_t heartRate :: maxim_max30102_read_fifo(uint8_t *puch_fifo)
+{
+  const uint8_t uch_samples = maxim_max30102_drain_fifo(i2c1, puch_fifo, &mOverflows);
 
-bool heartRate :: maxim_max30102_read_fifo(uint32_t *pun_red_led, uint32_t *pun_ir_led)
+  mSamples += uch_samples;
+  return uch_samples;
+}
+/*----------------------------------------------------------------------------
+Function    :  maxim_max30102_set_rate ()
+Inputs      :  un_sample_rate - 25, 50, 100 or 200 samples per second
+Processing  :  This function sets the SpO2 sample rate and the FIFO sample
+			   averaging, then empties the FIFO
+Outputs     :  None
+Returns     :  None
+Notes       :  The sensor has no 25 sps setting, it samples at 50 sps and
+			   averages 2 samples per FIFO entry.  The writes go as one I2C batch,
+			   which ends by clearing a pending A_FULL : with both pointers at 0 a
+			   drain would otherwise take the empty FIFO for a full one.
+----------------------------------------------------------------------------*/
+void heartRate :: maxim_max30102_set_rate(uint32_t un_sample_rate)
 {
-  uint32_t un_temp;
- // unsigned char uch_temp;
-  uint8_t uch_temp;
+  Board_I2C_Device_AddressesI2C1 deviceAdd = I2CAddr_HeartRateSensor;
+  // SPO2_SR [4:2] : 0 = 50, 1 = 100, 2 = 200 sps
+  uint8_t uch_sr = (un_sample_rate >= 200) ? 2 : (un_sample_rate >= 100) ? 1 : 0;
+  // SMP_AVE [7:5] : 1 = average of 2 samples
+  uint8_t uch_ave = (un_sample_rate < 50) ? 1 : 0;
+
+  // so2 config: 4096 nA range, sample rate, 411 us pulse (18 bits)
+  uint8_t uch_spo2 = 0x23 | (uch_sr << 2);
+  // fifo config: averaging, no rollover, almost full with 15 free slots (17 samples)
+  uint8_t uch_fifo = 0x0F | (uch_ave << 5);
+  // drop the samples taken at the previous rate : write, overflow and read pointers
+  uint8_t ach_ptr[3] = {0x00, 0x00, 0x00};
+  uint8_t uch_status;
+
+  const I2C_Base::Segment rate[] = {
+	  { 0x0A, false, &uch_spo2, 1 },
+	  { 0x08, false, &uch_fifo, 1 },
+	  { 0x04, false, ach_ptr, sizeof(ach_ptr) },
+	  { MAX30102_REG_INT_STATUS_1, true, &uch_status, 1 },
+  };
+  i2c1.transferBatch(deviceAdd, rate, sizeof(rate) / sizeof(rate[0]));
+}
+/*----------------------------------------------------------------------------
+Function    :  heartRate ::setSampleRate ()
+Inputs      :  un_sample_rate - 25, 50, 100 or 200 samples per second
+Processing  :  This function records the rate for the task to apply
+Outputs     :  None
+Returns     :  false if the rate is not supported, or while spooling (the spool
+			   file has a single rate)
+Notes       :  Called from the terminal task
+----------------------------------------------------------------------------*/
+bool heartRate :: setSampleRate(uint32_t un_sample_rate)
+{
+	if(un_sample_rate != 25 && un_sample_rate != 50 && un_sample_rate != 100 && un_sample_rate != 200)
+		return false;
+	if(isSpooling() || mSpoolRequest != spool_none)
+		return false;
+	mRequestedRate = un_sample_rate;
+	return true;
+}
+/*----------------------------------------------------------------------------
+Function    :  heartRate ::changeSampleRate ()
+Inputs      :  un_sample_rate - 25, 50, 100 or 200 samples per second
+Processing  :  This function replaces the engine by the one built for the new
+			   rate and reconfigures the sensor
+Outputs     :  None
+Returns     :  false if the engine could not be allocated, the task then goes
+			   back to the previous rate (mpEngine is NULL if that fails too)
+Notes       :  The old engine is freed first so that both are never allocated
+----------------------------------------------------------------------------*/
+bool heartRate :: changeSampleRate(uint32_t un_sample_rate)
+{
+	const uint32_t un_old_rate = mSampleRate;
+	bool b_changed = true;
 
-  *pun_red_led=0;
-  *pun_ir_led=0;
-  uint8_t ach_i2c_data[6] = {0};
-  //uint8_t*
-  i2c1.readRegisters(0xAE ,0x00, &uch_temp, 1);
-  i2c1.readRegisters(0xAE ,0x01, &uch_temp, 1);
+	delete mpEngine;
+	mpEngine = ppg_engine_create(un_sample_rate);
+	if(mpEngine == NULL)
+	{
+		un_sample_rate = un_old_rate;
+		mpEngine = ppg_engine_create(un_sample_rate);
+		b_changed = false;
+	}
+	if(mpEngine != NULL)
+	{
+		// first result after a full window (5 seconds), then one every second
+		mpEngine->setOutputInterval(un_sample_rate);
+		maxim_max30102_set_rate(un_sample_rate);
+	}
+	mSampleRate = un_sample_rate;
+	// the new engine counts samples from 0, no interval to the last beat
+	mLastBeat = 0;
+	mHrv.breakSequence();
+	return b_changed;
+}
+/*----------------------------------------------------------------------------
+Function    :  heartRate ::setHrvWindow ()
+Inputs      :  minutes - HRV window, 1 to 5 minutes
+Processing  :  This function records the window for the task to apply
+Outputs     :  None
+Returns     :  false if the window is not supported
+Notes       :  Called from the terminal task
+----------------------------------------------------------------------------*/
+bool heartRate :: setHrvWindow(uint32_t minutes)
+{
+	if(minutes < HrvStats::kMinWindowMin || minutes > HrvStats::kMaxWindowMin)
+		return false;
+	mRequestedHrvWindow = minutes;
+	return true;
+}
+/*----------------------------------------------------------------------------
+Function    :  heartRate ::getHrv ()
+Inputs      :  None
+Processing  :  This function copies the HRV published with the last beat
+Outputs     :  None
+Returns     :  The HRV, all 0 before the first interval
+Notes       :  Called from the terminal task
+----------------------------------------------------------------------------*/
+hrv_t heartRate :: getHrv(void)
+{
+	hrv_t hrv;
+	taskENTER_CRITICAL();
+	hrv = mLatestHrv;
+	taskEXIT_CRITICAL();
+	return hrv;
+}
+/*----------------------------------------------------------------------------
+Function    :  heartRate ::setMotionLevels ()
+Inputs      :  un_skip_level - motion intensity above which SpO2 is skipped
+			   un_slow_level - motion intensity above which SpO2 is down-rated
+Processing  :  This function sets the levels of the SpO2 motion gate
+Outputs     :  None
+Returns     :  false if the slow level is above the skip level
+Notes       :  Called from the terminal task
+----------------------------------------------------------------------------*/
+bool heartRate :: setMotionLevels(uint32_t un_skip_level, uint32_t un_slow_level)
+{
+	if(un_slow_level > un_skip_level)
+		return false;
+	mSkipLevel = un_skip_level;
+	mSlowLevel = un_slow_level;
+	return true;
+}
+/*----------------------------------------------------------------------------
+Function    :  heartRate ::resetSpo2Stats ()
+Inputs      :  None
+Processing  :  This function clears the SpO2 gate statistics
+Outputs     :  None
+Returns     :  None
+Notes       :  None
+----------------------------------------------------------------------------*/
+void heartRate :: resetSpo2Stats(void)
+{
+	mSpo2Computed = 0;
+	mSpo2Skipped  = 0;
+	mSpo2Slowed   = 0;
+	mFullUs       = 0;
+	mHrOnlyUs     = 0;
+}
+/*----------------------------------------------------------------------------
+Function    :  heartRate ::spo2Due ()
+Inputs      :  None
+Processing  :  This function gates the SpO2 stages on the motion intensity :
+			   above the skip level SpO2 is not computed at all, above the slow
+			   level it is computed on every HR_SPO2_SLOW_DIVIDER output only
+Outputs     :  None
+Returns     :  true if SpO2 should be computed
+Notes       :  The PPG ratios are not usable while the wrist moves, the heart
+			   rate (peak intervals) still is
+----------------------------------------------------------------------------*/
+bool heartRate :: spo2Due(void)
+{
+	const uint32_t un_motion = motion_intensity;
 
-  i2c1.readRegisters(0xAE ,0x07, ach_i2c_data, 6);
+	if(un_motion > mSkipLevel)
+	{
+		mSpo2Skipped++;
+		return false;
+	}
+	if(un_motion > mSlowLevel && ++mSlowCount < HR_SPO2_SLOW_DIVIDER)
+	{
+		mSpo2Slowed++;
+		return false;
+	}
+	mSlowCount = 0;
+	mSpo2Computed++;
+	return true;
+}
+/*----------------------------------------------------------------------------
+Function    :  heartRate ::startSpool ()
+Inputs      :  const char *pch_path - spool file, ie: "1:spool.bin"
+Processing  :  This function records the file for the task to open
+Outputs     :  None
+Returns     :  false if already spooling, a request is pending or the path is too long
+Notes       :  Called from the terminal task
+----------------------------------------------------------------------------*/
+bool heartRate :: startSpool(const char *pch_path)
+{
+	if(isSpooling() || mSpoolRequest != spool_none || strlen(pch_path) >= sizeof(mSpoolPath))
+		return false;
+	strcpy(mSpoolPath, pch_path);
+	mSpoolRequest = spool_start;
+	return true;
+}
+/*----------------------------------------------------------------------------
+Function    :  heartRate ::stopSpool ()
+Inputs      :  None
+Processing  :  This function asks the task to close the spool file
+Outputs     :  None
+Returns     :  false if not spooling or a request is pending
+Notes       :  Called from the terminal task
+----------------------------------------------------------------------------*/
+bool heartRate :: stopSpool(void)
+{
+	if(!isSpooling() || mSpoolRequest != spool_none)
+		return false;
+	mSpoolRequest = spool_stop;
+	return true;
+}
+/*----------------------------------------------------------------------------
+Function    :  heartRate ::serviceSpool ()
+Inputs      :  None
+Processing  :  This function applies a start / stop request, packs the samples
+			   waiting in the ring to the spool file and closes the file after
+			   a write error
+Outputs     :  None
+Returns     :  None
+Notes       :  Called by the spool writer task only, so the heart rate task
+			   never waits on f_write() / f_sync()
+----------------------------------------------------------------------------*/
+void heartRate :: serviceSpool(void)
+{
+	if(mSpoolRequest != spool_none)
+	{
+		changeSpool();
+	}
+	if(mpSpool != NULL)
+	{
+		drainSpool();
+		if(mSpoolError)
+		{
+			changeSpool();
+		}
+	}
+}
+/*----------------------------------------------------------------------------
+Function    :  heartRate ::changeSpool ()
+Inputs      :  None
+Processing  :  This function opens the spool file and starts the ring on a start
+			   request, or stops the ring and closes the file on a stop request
+			   (or after a write error)
+Outputs     :  None
+Returns     :  None
+Notes       :  Runs in the spool writer task, which is the only writer of the
+			   file.  The heart rate task restarts the engine from an empty
+			   window once mSpooling is cleared.
+----------------------------------------------------------------------------*/
+void heartRate :: changeSpool(void)
+{
+	const spool_request_t request = mSpoolRequest;
 
-  un_temp=(unsigned char) ach_i2c_data[0];
-  un_temp<<=16;
-  *pun_red_led+=un_temp;
-  un_temp=(unsigned char) ach_i2c_data[1];
-  un_temp<<=8;
-  *pun_red_led+=un_temp;
-  un_temp=(unsigned char) ach_i2c_data[2];
-  *pun_red_led+=un_temp;
+	if(request == spool_start && mpSpool == NULL)
+	{
+		// The header takes the sensor rate, so wait for an 'hrrate' being applied
+		if(mRequestedRate != mSampleRate)
+			return;
+		mSpoolSamples = 0;
+		mSpoolBytes = 0;
+		mSpoolMaxWriteUs = 0;
+		mSpoolDropped = 0;
+		// The ring is kept once allocated, the heart rate task may still be in feed()
+		if(mpSpoolRing == NULL)
+			mpSpoolRing = new PpgTraceRecorder();
+		mpSpool = new PpgSpoolWriter();
+		mSpoolError = (mpSpoolRing == NULL || mpSpool == NULL || !mpSpool->open(mSpoolPath, mSampleRate));
+		if(mSpoolError)
+		{
+			delete mpSpool;
+			mpSpool = NULL;
+		}
+		else
+		{
+			// No sample count limit (248 days at 200 sps)
+			mpSpoolRing->start(0xFFFFFFFF);
+			mSpooling = true;
+		}
+	}
+	else if(mpSpool != NULL && (request == spool_stop || mSpoolError))
+	{
+		mpSpoolRing->stop();
+		drainSpool();
+		mSpoolError = !mpSpool->close() || mSpoolError;
+		mSpoolSamples = mpSpool->getSamples();
+		mSpoolBytes = mpSpool->getBytes();
+		mSpoolMaxWriteUs = mpSpool->getMaxWriteUs();
+		delete mpSpool;
+		mpSpool = NULL;
+		// Cleared last, so 'hrspool stop' reports the closed file
+		mSpooling = false;
+	}
+	mSpoolRequest = spool_none;
+}
+/*----------------------------------------------------------------------------
+Function    :  heartRate ::drainSpool ()
+Inputs      :  None
+Processing  :  This function unpacks the raw FIFO samples waiting in the ring
+			   and adds them to the spool file
+Outputs     :  None
+Returns     :  None
+Notes       :  Stops at the first write error
+----------------------------------------------------------------------------*/
+void heartRate :: drainSpool(void)
+{
+	uint8_t auch_samples[MAX30102_FIFO_DEPTH * MAX30102_SAMPLE_BYTES];
+	uint32_t un_bytes, un_red, un_ir;
 
-  un_temp=(unsigned char) ach_i2c_data[3];
-  un_temp<<=16;
-  *pun_ir_led+=un_temp;
-  un_temp=(unsigned char) ach_i2c_data[4];
-  un_temp<<=8;
-  *pun_ir_led+=un_temp;
-  un_temp=(unsigned char) ach_i2c_data[5];
-  *pun_ir_led+=un_temp;
-  *pun_red_led&=0x03FFFF;  //Mask MSB [23:18]
-  *pun_ir_led&=0x03FFFF;  //Mask MSB [23:18]
+	while(!mSpoolError && (un_bytes = mpSpoolRing->read(auch_samples, sizeof(auch_samples))) > 0)
+	{
+		for(uint32_t i = 0; i < un_bytes && !mSpoolError; i += PPG_TRACE_SAMPLE_BYTES)
+		{
+			maxim_max30102_unpack(auch_samples + i, &un_red, &un_ir);
+			mSpoolError = !mpSpool->add(un_red, un_ir);
+		}
+	}
+	mSpoolSamples = mpSpool->getSamples();
+	mSpoolBytes = mpSpool->getBytes();
+	mSpoolMaxWriteUs = mpSpool->getMaxWriteUs();
+	mSpoolDropped = mpSpoolRing->getDropped();
+}
+/*----------------------------------------------------------------------------
+Function    :  heartRate ::publishBeat ()
+Inputs      :  un_loc - absolute sample index of the beat (PpgEngine::getBeats())
+Processing  :  This function sends the RR interval from the previous beat on
+			   rr_data, adds it to the rolling HRV statistics and sends the
+			   updated HRV on hrv_data
+Outputs     :  None
+Returns     :  None
+Notes       :  Only the beat locations are used, the PPG window is not copied.
+			   The beat time is back-dated from the newest sample.
+----------------------------------------------------------------------------*/
+void heartRate :: publishBeat(uint32_t un_loc)
+{
+	const uint32_t un_rate = mpEngine->getSampleRate();
+	const uint32_t un_age_ms = ((mpEngine->getSampleCount() - 1 - un_loc) * 1000) / un_rate;
+	const uint32_t un_time_ms = (uint32_t)sys_get_uptime_ms() - un_age_ms;
+	const uint32_t un_last = mLastBeat;
+
+	mLastBeat = un_loc;
+	mBeats++;
+	if(un_last == 0)
+	{
+		// first beat after a start or a rate change
+		return;
+	}
 
-  return true;
+	rr_event_t rr_event;
+	const uint32_t un_rr_ms = ((un_loc - un_last) * 1000) / un_rate;
+	rr_event.un_time_ms   = un_time_ms;
+	rr_event.un_beat      = mBeats;
+	rr_event.us_rr_ms     = (un_rr_ms > 0xFFFF) ? 0xFFFF : (uint16_t)un_rr_ms;
+	rr_event.uch_valid    = mHrv.addInterval(un_time_ms, un_rr_ms) ? 1 : 0;
+	rr_event.uch_reserved = 0;
+	// never wait, an event is dropped if nobody is reading them
+	xQueueSend(rr_data, &rr_event, 0);
+
+	HrvStats::Result result;
+	hrv_t hrv;
+	mHrv.compute(result);
+	hrv.un_time_ms     = un_time_ms;
+	hrv.us_rr_ms       = rr_event.us_rr_ms;
+	hrv.us_mean_rr_ms  = (uint16_t)result.meanRr;
+	hrv.us_sdnn_x10    = (uint16_t)min(result.sdnnX10, (uint32_t)0xFFFF);
+	hrv.us_rmssd_x10   = (uint16_t)min(result.rmssdX10, (uint32_t)0xFFFF);
+	hrv.us_pnn50_x10   = (uint16_t)result.pnn50X10;
+	hrv.us_intervals   = (uint16_t)result.intervals;
+	hrv.uch_window_min = (uint8_t)mHrv.getWindow();
+	hrv.uch_reserved   = 0;
+	// never wait either, hrv_data is in the display queue set and is not overwritten
+	xQueueSend(hrv_data, &hrv, 0);
+
+	taskENTER_CRITICAL();
+	mLatestHrv = hrv;
+	taskEXIT_CRITICAL();
 }
 /*----------------------------------------------------------------------------
 Function    :  heartRate ::run ()
 Inputs      :  None
-Processing  :  This function manintains a window of 500 samples, 100 samples/sec.
-			   It finds the peaks, calculates minimum distance between peaks to
-			   calculate heart rate and oxygen level.
+Processing  :  This function drains the MAX30102 FIFO on every almost-full interrupt
+			   (about 6 times/sec at 100 samples/sec) and feeds each sample to the streaming
+			   engine, which keeps a 5 second window and filters / tracks peaks
+			   as samples arrive. Heart rate and oxygen level are computed every
+			   second once the window is full. The engine is built for the sample
+			   rate selected with setSampleRate().
 Outputs     :  None
 Returns     :  None
 Notes       :  None
 ----------------------------------------------------------------------------*/
 bool heartRate :: run(void *p)
 {
-
-
 			// GPIO 2 as INPUT to read Interrupt value
 			gpioObj.setInputDir(2, 0);
-			//IR LED sensor data
-			uint32_t aun_ir_buffer[500];
-			 //data length
-			int32_t n_ir_buffer_length;
-			//Red LED sensor data
-			uint32_t aun_red_buffer[500];
+			//Raw FIFO samples, drained in one burst
+			uint8_t auch_fifo[MAX30102_FIFO_DEPTH * MAX30102_SAMPLE_BYTES];
+			uint8_t uch_samples;
+			int i;
+			//Red and IR LED sensor data
+			uint32_t un_red, un_ir;
 			//SPO2 value
 			int32_t n_sp02;
 			//indicator to show if the SP02 calculation is valid
@@ -112,315 +480,313 @@ bool heartRate :: run(void *p)
 			int32_t n_heart_rate;
 			//indicator to show if the heart rate calculation is valid
 			int8_t  ch_hr_valid;
+			//beats confirmed by the engine (absolute sample indexes)
+			uint32_t aun_beats[HR_MAX_BEATS];
+			uint32_t un_beats;
+			//SpO2 computed on this output, and time of the compute
+			bool b_spo2;
+			//samples went to the spool file since the last live result
+			bool b_spooled = false;
+			uint64_t un_start_us;
+			//reading sent to the display, stamped when the FIFO was read
+			reading_t reading;
 			uint8_t uch_dummy;
-			//variables to calculate the on-board LED brightness that reflects the heartbeats
-			uint32_t un_min, un_max, un_prev_data;
-			int i;
-			int32_t n_brightness;
-			float f_temp;
-			i2c1.readRegisters(0xAE ,0x00, &uch_dummy, 1);
-			n_brightness=0;
-			un_min = 0x3FFFF;
-			un_max=0;
 			Board_I2C_Device_AddressesI2C1 deviceAdd;
 			deviceAdd = I2CAddr_HeartRateSensor;
 
-			// Initialize the Hear rate sensor
+			// Initialize the Hear rate sensor, in one I2C batch with repeated starts
 
 			// HR mode
-			i2c1.writeReg(deviceAdd, 0x09, 0x03);
-			// intr 1 enable
-			i2c1.writeReg(deviceAdd, 0x02, 0xC0);
-			// intr 2 enable
-			i2c1.writeReg(deviceAdd, 0x03, 0x00);
-			// fifo write ptr
-			i2c1.writeReg(deviceAdd, 0x04, 0x00);
-			// fifo ovf ptr
-			i2c1.writeReg(deviceAdd, 0x05, 0x00);
-			// fifo read ptr
-			i2c1.writeReg(deviceAdd, 0x06, 0x00);
-			// fifo config
-			i2c1.writeReg(deviceAdd, 0x08, 0x0F);
-			// led 1
-			i2c1.writeReg(deviceAdd, 0x0C, 0x24);
-			// led 2
-			i2c1.writeReg(deviceAdd, 0x0D, 0x24);
+			uint8_t uch_mode = 0x03;
+			// intr 1 enable: FIFO almost full only (no interrupt per sample), intr 2 enable,
+			// fifo write ptr, fifo ovf ptr, fifo read ptr
+			uint8_t ach_intr_fifo[5] = {0x80, 0x00, 0x00, 0x00, 0x00};
+			// led 1, led 2
+			uint8_t ach_led[2] = {0x24, 0x24};
 			// pilot led
-			i2c1.writeReg(deviceAdd, 0x10, 0x7F);
-			// so2 config
-			i2c1.writeReg(deviceAdd, 0x0A, 0x27);
-
-
-			//buffer length of 100 stores 5 seconds of samples running at 100sps
-			n_ir_buffer_length=500;
+			uint8_t uch_pilot = 0x7F;
+
+			const I2C_Base::Segment init[] = {
+				{ 0x00, true,  &uch_dummy,    1 },	// clears the interrupt status
+				{ 0x09, false, &uch_mode,     1 },
+				{ 0x02, false, ach_intr_fifo, sizeof(ach_intr_fifo) },
+				{ 0x0C, false, ach_led,       sizeof(ach_led) },
+				{ 0x10, false, &uch_pilot,    1 },
+			};
+			i2c1.transferBatch(deviceAdd, init, sizeof(init) / sizeof(init[0]));
+			// so2 config and fifo config, engine for the sample rate
+			changeSampleRate(mRequestedRate);
 
 			// enable port 2 interrupt to initiate the sampling only upon detection of finger
 			eint3_enable_port2(0, eint_falling_edge, heartrate_irq_callback);
 
-			//read the first 500 samples, and determine the signal range
-			for(i=0;i<n_ir_buffer_length;i++)
+			//Continuously taking samples from MAX30102
+			while(1)
 			{
-				//while(((LPC_GPIOINT->IO2IntStatF & 0x01))!=1);   //wait until the interrupt pin asserts
-				while(!flag1);
-				flag1 = false;
-
-				maxim_max30102_read_fifo((aun_red_buffer+i), (aun_ir_buffer+i));  //read from MAX30102 FIFO
-
-				if(un_min>aun_red_buffer[i])
-					//update signal min
-					un_min=aun_red_buffer[i];
-				if(un_max<aun_red_buffer[i])
-					//update signal max
-					un_max=aun_red_buffer[i];
-			}
-
-
-			//calculate heart rate and SpO2 after first 500 samples (first 5 seconds of samples)
-			maxim_heart_rate_and_oxygen_saturation(aun_ir_buffer, n_ir_buffer_length, aun_red_buffer, &n_sp02, &ch_spo2_valid, &n_heart_rate, &ch_hr_valid);
+				// Sample rate requested from the terminal ('hrrate')
+				if(mRequestedRate != mSampleRate && !changeSampleRate(mRequestedRate))
+				{
+					mRequestedRate = mSampleRate;
+				}
+				if(mpEngine == NULL)
+				{
+					// out of memory
+					return false;
+				}
+				// HRV window requested from the terminal ('hrv')
+				if(mRequestedHrvWindow != mHrv.getWindow())
+				{
+					mHrv.setWindow(mRequestedHrvWindow);
+				}
 
-				//Continuously taking samples from MAX30102.  Heart rate and SpO2 are calculated every 1 second
-				while(1)
+				// Drain first, so an interrupt pending before eint was enabled is cleared as well
+				uch_samples = maxim_max30102_read_fifo(auch_fifo);
+				reading.un_time_us = (uint32_t)sys_get_uptime_us();
+				// Raw samples go to the 'ppgrec' trace recorder when it is running
+				ppg_trace_recorder.feed(auch_fifo, uch_samples);
+				// Spool mode ('hrspool') : the raw samples go to the spool writer task
+				// instead of the engine, processed later with 'spoolrun'
+				if(mSpooling)
+				{
+					mpSpoolRing->feed(auch_fifo, uch_samples);
+					b_spooled = true;
+					uch_samples = 0;
+				}
+				else if(b_spooled)
 				{
-					i=0;
-					un_min=0x3FFFF;
-					un_max=0;
-					//dumping the first 100 sets of samples in the memory and shift the last 400 sets of samples to the top
-					for(i=100;i<500;i++)
+					// live results again, from a new window
+					b_spooled = false;
+					mpEngine->reset();
+					mLastBeat = 0;
+					mHrv.breakSequence();
+				}
+				for(i=0;i<uch_samples;i++)
+				{
+					maxim_max30102_unpack(auch_fifo + (i * MAX30102_SAMPLE_BYTES), &un_red, &un_ir);
+					if(!mpEngine->addSample(un_red, un_ir))
 					{
-						aun_red_buffer[i-100]=aun_red_buffer[i];
-						aun_ir_buffer[i-100]=aun_ir_buffer[i];
-
-						//update the signal min and max
-						if(un_min>aun_red_buffer[i])
-						un_min=aun_red_buffer[i];
-						if(un_max<aun_red_buffer[i])
-						un_max=aun_red_buffer[i];
+						continue;
 					}
-
-					//take 100 sets of samples before calculating the heart rate.
-					for(i=400;i<500;i++)
+					// SpO2 stages only when the wrist is still enough (spo2gate)
+					b_spo2 = spo2Due();
+					mpEngine->setSpo2Enabled(b_spo2);
+					un_start_us = sys_get_uptime_us();
+					mpEngine->compute(&n_sp02, &ch_spo2_valid, &n_heart_rate, &ch_hr_valid);
+					if(b_spo2)
+						mFullUs += sys_get_uptime_us() - un_start_us;
+					else
+						mHrOnlyUs += sys_get_uptime_us() - un_start_us;
+
+					// RR intervals and HRV, published with heart_data
+					un_beats = mpEngine->getBeats(aun_beats, HR_MAX_BEATS);
+					for(uint32_t b = 0; b < un_beats; b++)
 					{
-						un_prev_data=aun_red_buffer[i-1];
-						while(!flag1);
-						flag1 = false;
-						maxim_max30102_read_fifo((aun_red_buffer+i), (aun_ir_buffer+i));
-
-						if(aun_red_buffer[i]>un_prev_data)
-						{
-							f_temp=aun_red_buffer[i]-un_prev_data;
-							f_temp/=(un_max-un_min);
-							f_temp*=MAX_BRIGHTNESS;
-							n_brightness-=(int)f_temp;
-							if(n_brightness<0)
-								n_brightness=0;
-						}
-						else
-						{
-							f_temp=un_prev_data-aun_red_buffer[i];
-							f_temp/=(un_max-un_min);
-							f_temp*=MAX_BRIGHTNESS;
-							n_brightness+=(int)f_temp;
-							if(n_brightness>MAX_BRIGHTNESS)
-								n_brightness=MAX_BRIGHTNESS;
-						}
+						publishBeat(aun_beats[b]);
 					}
-					maxim_heart_rate_and_oxygen_saturation(aun_ir_buffer, n_ir_buffer_length, aun_red_buffer, &n_sp02, &ch_spo2_valid, &n_heart_rate, &ch_hr_valid);
 
-					// temp measurement
+			    	// Never wait for the display, it shows the latest reading of a burst
 			    	if(ch_hr_valid == 1 && n_heart_rate <170 && n_heart_rate>50)
 			    	{
-			    			if(xQueueSend(heart_data,&n_heart_rate,100))
+			    			reading.n_value = n_heart_rate;
+			    			if(xQueueSend(heart_data,&reading,0))
 			    			{
 			    				//debug
 			    			}
 			    	}
 			    	if( ch_spo2_valid == 1 && n_sp02 >70)
 			    	{
-			        	if(xQueueSend(oxygen_data,&n_sp02,100))
+			        	reading.n_value = n_sp02;
+			        	if(xQueueSend(oxygen_data,&reading,0))
 			        	{
 			        		//debug
 			        	}
 			    	}
 				}
+
+				// Sleep until the FIFO almost-full interrupt, drain anyway if it never comes
+				if(max30102_fifo_event.wait(OS_MS(HR_FIFO_TIMEOUT_MS)))
+				{
+					mWakeups++;
+				}
+			}
 	    return true;
 }
 /*----------------------------------------------------------------------------
+Function    :  spoolWriter::run ()
+Inputs      :  None
+Processing  :  This function runs every HR_SPOOL_DRAIN_MS and does the file
+			   side of the heart rate task's spool mode : open, write, sync
+			   and close (heartRate::serviceSpool())
+Returns     :  false if there is no heart rate task
+Notes       :  None
+----------------------------------------------------------------------------*/
+bool spoolWriter:: run(void *p)
+{
+	if(mpHeartRate == NULL)
+	{
+		mpHeartRate = (heartRate*) scheduler_task::getTaskPtrByName("hrt-rt");
+		if(mpHeartRate == NULL)
+		{
+			return false;
+		}
+	}
+	mpHeartRate->serviceSpool();
+	return true;
+}
+/*----------------------------------------------------------------------------
 Function    :  tempMeasure::run ()
 Inputs      :  None
-Processing  :  This function reads the analog channel and maps the voltage on pin to find
- 	 	 	   out the resistance of thermistor which is then used to map to a corresponding
- 	 	 	   temperature value using resistance-temperature table.
+Processing  :  This function wakes in the temperature slot of the sampling
+ 	 	 	   scheduler mRateHz times per second, averages a burst of
+ 	 	 	   TEMP_OVERSAMPLE conversions of the thermistor channel and maps the
+ 	 	 	   averaged ADC code to a temperature with the resistance-temperature table,
+ 	 	 	   converted to ADC codes at compile time (Thermistor.hpp).
+ 	 	 	   The temperature is sent to the display only when it moves more than
+ 	 	 	   mHysteresis from the last value sent.
 Returns     :  None
-Notes       :  None
+Notes       :  The average keeps 4 more bits than one reading, no floating point
 ----------------------------------------------------------------------------*/
 bool tempMeasure:: run(void *p)
 {
+		bool b_first = true;
+
+		resetStats();
 		while(1)
 		{
-				float resistance;
-				float temp = ((LS.getRawValue() * 3.3)/4096);
-				temp = 3.3/temp;
-				resistance = 10/(temp - 1);
-				float temperature, T1,T2,R1,R2;
-				for(int i =0; i<240; i++)
+				if(!temp_job.wait())
 				{
-					if((resistance > resistance_array[i] )  )
-					{
-						if(resistance == resistance_array[i - 1])
-						{
-							temperature = i - 41;
-							break;
-						}
-						if(resistance < resistance_array[i - 1] )
-						{
-							R1 = resistance_array[i - 1];
-							R2 = resistance_array[i];
-							T1 = i - 41;
-							T2 = i - 40;
-							temperature = ((resistance - R1) * (R2 - R1))/(T2-T1);
-							temperature = temperature + T1;
-							break;
-						}
-
-					}
+					continue;
+				}
+				const uint32_t un_sum = adc0_get_burst_sum(TEMP_ADC_CHANNEL, TEMP_OVERSAMPLE);
+				mConversions += TEMP_OVERSAMPLE;
+				mCentiCelsius = thermistor_code_to_centi_celsius((un_sum << THERMISTOR_CODE_SHIFT) / TEMP_OVERSAMPLE);
 
+				const int32_t n_moved = mCentiCelsius - mPublishedCenti;
+				if(b_first || n_moved > (int32_t)mHysteresis || -n_moved > (int32_t)mHysteresis)
+				{
+					b_first = false;
+					mPublishedCenti = mCentiCelsius;
+					mPublished++;
+					// Push the data in the Queue with the time of the slot it was sampled in,
+					// not overwritten since the display blocks on it in a queue set
+					reading_t body_temp;
+					body_temp.n_value = thermistor_centi_to_celsius(mCentiCelsius);
+					body_temp.un_time_us = temp_job.getSlotTimeUs();
+					xQueueSend(temp_data,&body_temp,0);
 				}
-				int32_t body_temp = temperature;
-				// Push the data in the Queue
-				xQueueSend(temp_data,&body_temp,portMAX_DELAY);
 			}
 }
 /*----------------------------------------------------------------------------
-Function    :  orient_compute(constructor)
-Inputs      :  None
-Processing  :  This function creates a Queue between orient compute and orient process
-			   Task and calibrate initial position
-Returns     :  None
+Function    :  tempMeasure::setRate ()
+Inputs      :  un_rate_hz - readings per second
+Processing  :  This function sets the rate used from the next reading on
+Returns     :  false if the rate is out of range
 Notes       :  None
 ----------------------------------------------------------------------------*/
-orient_compute::orient_compute(uint8_t priority) :scheduler_task("compute", 4096, priority)
- {
-		     	Timer2_init();
-				 // Create a binary semaphore 100 msec delay
-				 vSemaphoreCreateBinary( triggerHundredMilliSec );
-				 // Collect samples to get the reference position of wrist
-				 calibrate();
- }
+bool tempMeasure::setRate(uint32_t un_rate_hz)
+{
+	if(un_rate_hz < 1 || un_rate_hz > TEMP_MAX_RATE_HZ)
+	{
+		return false;
+	}
+	mRateHz = un_rate_hz;
+	temp_job.setPeriod(1000 / un_rate_hz);
+	resetStats();
+	return true;
+}
 /*----------------------------------------------------------------------------
-Function    :  calibrate()
+Function    :  tempMeasure::getConversionsPerSec ()
 Inputs      :  None
-Processing  :  This function acquires 25 samples of orientation to take sorted average
-Returns     :  None
+Processing  :  This function divides the conversions by the time since resetStats()
+Returns     :  ADC conversions per second
 Notes       :  None
 ----------------------------------------------------------------------------*/
-void orient_compute::calibrate(void)
- {
-	if(first == 0)
-	{
-		for(int i=0; i<50; i++)
-		{
-
-			X[i] = AS.getX();
-			Y[i] = AS.getY();
-			Z[i] = AS.getZ();
-
-		}
-	}
-	else
-	{
-
-			for(int i=0; i<25; i++)
-			{
-
-				X[i] = AS.getX();
-				Y[i] = AS.getY();
-				Z[i] = AS.getZ();
-
-			}
-
-	}
-	first++;
-	sort_Function();
- }
+uint32_t tempMeasure::getConversionsPerSec(void) const
+{
+	const uint32_t un_elapsed_ms = (uint32_t)sys_get_uptime_ms() - mStatsStartMs;
+	return (un_elapsed_ms > 0) ? (uint32_t)(((uint64_t)mConversions * 1000) / un_elapsed_ms) : 0;
+}
 /*----------------------------------------------------------------------------
-Function    :  sort_Function()
+Function    :  tempMeasure::resetStats ()
 Inputs      :  None
-Processing  :  This function sorts accelerometer values in ascending values
+Processing  :  This function restarts the conversion and publish counters
 Returns     :  None
 Notes       :  None
 ----------------------------------------------------------------------------*/
-void orient_compute::sort_Function(void)
+void tempMeasure::resetStats(void)
 {
-				sort(X, X + 25);
-	        	sort(Y, Y + 25);
-	        	sort(Z, Z + 25);
-	        	x_old = x_prev;
-	        	y_old = y_prev;
-	        	z_old = z_prev;
-	        	x_prev = x_th;
-	        	y_prev = y_th;
-	        	z_prev = z_th;
-	        	x_th = (X[0] + X[24])/2;
-	        	y_th = (Y[0] + Y[24])/2;
-	        	z_th = (Z[0] + Z[24])/2;
+	mConversions = 0;
+	mPublished = 0;
+	mStatsStartMs = (uint32_t)sys_get_uptime_ms();
 }
 /*----------------------------------------------------------------------------
-Function    :  calculate_count()
+Function    :  orient_compute(constructor)
 Inputs      :  None
-Processing  :  This function increments step count
+Processing  :  None, the samples are paced by the accelerometer job of the
+			   sampling scheduler
 Returns     :  None
-Notes       :  None
+Notes       :  The reference position of the wrist is the first full window
+----------------------------------------------------------------------------*/
+orient_compute::orient_compute(uint8_t priority) :scheduler_task("compute", 4096, priority)
+ {
+ }
+/*----------------------------------------------------------------------------
+Function    :  update_motion()
+Inputs      :  None
+Processing  :  This function publishes the motion intensity : the change of the
+			   mid-range of X, Y and Z since the previous 100 msec, smoothed over
+			   about 4 ticks
+Returns     :  None
+Notes       :  1 g is 1024 counts, so the intensity is about mg per 100 msec
 ----------------------------------------------------------------------------*/
-forBack_Count orient_compute::calculate_count(void)
+void orient_compute::update_motion(void)
 {
-
-	forBack_Count count = invalid;
-
-          for(int i=0; i<24; i++)
-          {
-			X[i] = AS.getX();
-			Y[i] = AS.getY();
-			Z[i] = AS.getZ();
-          }
-
-		 if(((x_old + 15 < x_prev )  && (x_th + 15 < x_prev )) )
-		{
-			count = forw;
-			step_Count++;
-			step++;
-		}
-		else if(((x_old > x_prev + 10)  && (x_th > x_prev + 10)) )
-		{
-			count = back;
-			step_Count++;
-			step++;
-		}
-		return count;
+	// the first mid-ranges are not set yet
+	if(mDetector.getTicks() < 3)
+	{
+		return;
+	}
+	const uint32_t delta = mDetector.getMidRangeChange();
+	motion_intensity = (3 * motion_intensity + delta) / 4;
 }
 /*----------------------------------------------------------------------------
 Function    :  orient_compute::run
 Inputs      :  None
-Processing  :  This function is a producer task and puts then newly calculated
-			   orientation in the queue.
+Processing  :  This function is a producer task : it reads one accelerometer
+			   sample every accelerometer slot into the step detector, and every 100 msec
+			   updates the motion intensity and puts the new step count in the queue.
 Returns     :  None
-Notes       :  None
+Notes       :  One I2C transaction per sample, no sorting
 ----------------------------------------------------------------------------*/
 bool  orient_compute::run(void *p)
  {
 	forBack_Count orientation = invalid;
+	int16_t xyz[3];
 	while(1)
 	{
-			if( xSemaphoreTake(triggerHundredMilliSec,portMAX_DELAY))
+			if(accel_job.wait())
 			{
-					 calibrate();
-						orientation = calculate_count();
+					if(!AS.getXYZ(xyz))
+					{
+						mReadErrors++;
+						continue;
+					}
+					if(mDetector.addSample(xyz, orientation))
+					{
+						update_motion();
 						if(orientation == forw || orientation == back )
 						{
-							if(xQueueSend(step_data,&step_Count,0))
+							step_Count++;
+							step++;
+							reading_t steps;
+							steps.n_value = step_Count;
+							steps.un_time_us = accel_job.getSlotTimeUs();
+							if(xQueueSend(step_data,&steps,0))
 							{
 								//debug
 							}
 						}
+					}
 			}
 	}
 
@@ -430,8 +796,8 @@ bool  orient_compute::run(void *p)
 /*----------------------------------------------------------------------------
 Function    :  TIMER2_IRQHandler
 Inputs      :  None
-Processing  :  This function is a producer task and puts then newly calculated
-			   orientation in the queue.
+Processing  :  This function is the one msec slot of the sampling scheduler, it
+			   wakes up the sampling jobs due in this slot.
 Returns     :  None
 Notes       :  None
 ----------------------------------------------------------------------------*/
@@ -440,41 +806,8 @@ extern "C"
 
 void TIMER2_IRQHandler()
 {
-	// clear the interrupt
-	one_ms_timer_ptr->IR =0b1;
-	// Trigger 100ms task
-	xSemaphoreGive(triggerHundredMilliSec);
-}
-
+	SampleScheduler::handleInterrupt();
 }
-/*----------------------------------------------------------------------------
-Function    :  Timer2_init
-Inputs      :  None
-Processing  :  This function is a producer task and puts then newly calculated
-			   orientation in the queue.
-Returns     :  None
-Notes       :  None
-----------------------------------------------------------------------------*/
- void Timer2_init(void)
-{
-
-	 const lpc_timer_t one_ms_timer_source = (lpc_timer_t) one_ms_timer;
-	 // set timer resolution for 1 micro-second
-	 const uint32_t one_micro_second = 1;
-	 // Initialize the timer structure pointer
-	 one_ms_timer_ptr = lpc_timer_get_struct(one_ms_timer_source);
-	 // enable the timer for a precision of one milli second to increment TC count
-	 lpc_timer_enable(one_ms_timer_source, one_micro_second);
-	 // Stop on Interrupt , No auto re-start
-	 one_ms_timer_ptr->MCR = 0b11;
-	 //  timeout is 100 msec
-	 one_ms_timer_ptr->MR0 = 100000;
-	 // enable LPC timer
-	 lpc_timer_enable(one_ms_timer_source, one_micro_second);
-	 // Get the IRQ number for timer interrupt
-	 const IRQn_Type timer_irq = lpc_timer_get_irq_num(one_ms_timer_source);
-	 // Enable timer interrupt
-	 NVIC_EnableIRQ(timer_irq);
 
 }
  /*===================================================================
@@ -73,6 +73,8 @@ bool terminalTask::taskEntry()
     // System information handlers
     cp.addHandler(taskListHandler, "info",    "Task/CPU Info.  Use 'info 200' to get CPU during 200ms");
     cp.addHandler(memInfoHandler,  "meminfo", "See memory info");
+    cp.addHandler(isrEventHandler, "events",  "ISR to task event counts and wake-up latency.  'events reset' clears them");
+    cp.addHandler(sampleJobHandler, "jobs",   "Sampling job slots, overruns, latency and jitter.  'jobs reset' clears them");
     cp.addHandler(healthHandler,   "health",  "Output system health");
     cp.addHandler(timeHandler,     "time",    "'time' to view time.  'time set MM DD YYYY HH MM SS Wday' to set time");
     cp.addHandler(conProHandler,  "con", "Consumer producer board orientation task communication");
@@ -95,11 +97,33 @@ bool terminalTask::taskEntry()
   //  cp.addHandler(i2cTaskHandler,     "mas",    "I2C master task");
     cp.addHandler(i2cTaskHandlerTrial,     "mas",    "I2C master task");
     cp.addHandler(smartHealthHandler,     "start",    "Display my health details");
+    cp.addHandler(hrBenchHandler,     "hrbench",    "'hrbench <seconds> <interval>' : Compare batch and streaming heart rate / SpO2 engines");
+    cp.addHandler(hrFifoHandler,     "hrfifo",    "'hrfifo <ms>' : MAX30102 FIFO wakeups and I2C transactions per second");
+    cp.addHandler(accBenchHandler,   "accbench",  "'accbench <samples>' : I2C2 transactions and time of per-axis vs XYZ burst accelerometer reads");
+    cp.addHandler(accRecordHandler,  "accrec",    "'accrec <file> <seconds>' : Record raw X, Y, Z accelerometer samples at the step detector rate");
+    cp.addHandler(stepReplayHandler, "stepplay",  "'stepplay <file>' : Replay an accelerometer trace through the sliding and the sorted step detectors");
+    cp.addHandler(hrRateHandler,     "hrrate",    "'hrrate <25|50|100|200>' : Show or set the heart rate sample rate");
+    cp.addHandler(hrvHandler,        "hrv",       "'hrv [1-5]' : Show RR / HRV (SDNN, RMSSD, pNN50) or set the window in minutes");
+    cp.addHandler(hrSpoolHandler,    "hrspool",   "'hrspool <file> | stop' : Spool raw PPG samples to a file instead of computing HR / SpO2");
+    cp.addHandler(spoolRunHandler,   "spoolrun",  "'spoolrun <file> [csv]' : Batch HR / SpO2 of a spool or trace file, with windows/sec");
+    cp.addHandler(tempHandler,       "temp",      "'temp [rate <hz>] [hyst <0.01 C>] | reset' : Temperature acquisition rate, hysteresis, conversions/sec and CPU");
+    cp.addHandler(tempBenchHandler,  "tempbench", "'tempbench <rounds>' : Cycles per thermistor conversion, float scan vs ADC code table");
+    cp.addHandler(lcdRateHandler,    "lcdrate",   "'lcdrate [ms] [immediate]' : LCD SPI bytes/sec of the screen refresh, widgets or the full redraw");
+    cp.addHandler(btLinkHandler,     "btlink",    "'btlink [ascii | binary | batch <ms> | key <ms> | history | reset | bench [sec]]' : HC-05 vitals frames, or the ASCII vs binary benchmark");
+    cp.addHandler(lcdLatencyHandler, "lcdlat",    "'lcdlat [reset]' : Sensor to pixel latency of the readings, and the display wake-ups and bursts");
+    cp.addHandler(uartBenchHandler,  "uartbench", "UART0 ring statistics, and the cost of a FreeRTOS queue vs the byte ring per char");
+    cp.addHandler(lcdBenchHandler,   "lcdbench",  "'lcdbench [text]' : SPI transactions, bytes and time of clearScrn1() or of text (chars/sec), per pixel vs bulk windows vs DMA");
+    cp.addHandler(spo2GateHandler,   "spo2gate",  "'spo2gate [<skip> <slow>] | reset' : SpO2 motion gate levels and skip/compute counters");
+    cp.addHandler(firBenchHandler,     "firbench",    "'firbench <windows>' : Compare separate and fused PPG filter passes");
+    cp.addHandler(peakBenchHandler,     "peakbench",    "'peakbench <max size> <min distance>' : Compare close-peak suppression from 500 samples up to <max size>");
+    cp.addHandler(ppgRecordHandler,     "ppgrec",    "'ppgrec <file> <seconds> [hr] [spo2]' : Record raw MAX30102 samples, ie: 'ppgrec 1:trace.bin 60 72 98'");
+    cp.addHandler(ppgReplayHandler,     "ppgplay",    "'ppgplay <file> [hr] [spo2]' : Replay a binary or 'red,ir' text trace through the heart rate algorithm");
 
     // Misc. handlers
     cp.addHandler(i2cIoHandler,   "i2c",   "'i2c read 0x01 0x02 <count>' : Reads <count> registers of device 0x01 starting from 0x02\n"
                                            "'i2c write 0x01 0x02 0x03'   : Writes 0x03 to device 0x01, reg 0x02\n"
-                                           "'i2c discover' : Discovers all I2C devices on the BUS");
+                                           "'i2c discover' : Discovers all I2C devices on the BUS\n"
+                                           "'i2c stats [reset]' : Transactions and bus time per device, and bus utilization");
 #if TERMINAL_USE_CAN_BUS_HANDLER
     CMD_HANDLER_FUNC(canBusHandler);
     cp.addHandler(canBusHandler,  "canbus", "'canbus init' : initialize CAN-1\n"
@@ -140,7 +164,7 @@ bool terminalTask::taskEntry()
 
     // Initialize Interrupt driven version of getchar & putchar
     Uart0& uart0 = Uart0::getInstance();
-    bool success = uart0.init(SYS_CFG_UART0_BPS, 32, SYS_CFG_UART0_TXQ_SIZE);
+    bool success = uart0.init(SYS_CFG_UART0_BPS, 32, SYS_CFG_UART0_TXQ_SIZE, SYS_CFG_UART0_DMA);
     uart0.setReady(true);
     sys_set_inchar_func(uart0.getcharIntrDriven);
     sys_set_outchar_func(uart0.putcharIntrDriven);
@@ -0,0 +1,110 @@
+/*****************************************************************************
+$Work file     : step_detect.cpp $
+Description    : This file contains the streaming step detector
+Project(s)     : Smart Health Gear
+Compiler       : Cross ARM GCC
+OS			   : RTOS
+Original Author: $ agent
+$Author        : $ agent
+$Date          : $ 17 Oct 2026
+$Revision      : 1.0 $
+*****************************************************************************/
+
+/****************************************************************************/
+/*                       INCLUDE FILES                                      */
+/****************************************************************************/
+#include <stdlib.h>
+#include "step_detect.hpp"
+
+
+/*----------------------------------------------------------------------------
+Function    :  StepDetector::reset ()
+Inputs      :  None
+Processing  :  This function empties the windows and clears the mid-ranges and counters
+Outputs     :  None
+Returns     :  None
+Notes       :  None
+----------------------------------------------------------------------------*/
+void StepDetector::reset(void)
+{
+	for(uint32_t a = 0; a < 3; a++)
+	{
+		mAxis[a].reset();
+		mMid[0][a] = mMid[1][a] = mMid[2][a] = 0;
+	}
+	mTickSamples = 0;
+	mTicks = 0;
+	mSteps = 0;
+}
+
+/*----------------------------------------------------------------------------
+Function    :  StepDetector::addSample ()
+Inputs      :  pn_xyz - X, Y and Z acceleration
+Processing  :  This function adds the sample to the sliding windows. Every
+			   STEP_TICK_SAMPLES it shifts the mid-range history, takes the new
+			   mid-ranges and checks X for a peak or a valley.
+Outputs     :  step - step found at the end of a tick
+Returns     :  true at the end of a tick
+Notes       :  Ticks start once the window is full
+----------------------------------------------------------------------------*/
+bool StepDetector::addSample(const int16_t *pn_xyz, forBack_Count &step)
+{
+	for(uint32_t a = 0; a < 3; a++)
+	{
+		mAxis[a].push(pn_xyz[a]);
+	}
+	// the first tick is on the sample that fills the window
+	if(!mAxis[0].isFull() ||
+	   (mAxis[0].getCount() > STEP_WINDOW_SAMPLES && ++mTickSamples < STEP_TICK_SAMPLES))
+	{
+		return false;
+	}
+	mTickSamples = 0;
+	mTicks++;
+
+	for(uint32_t a = 0; a < 3; a++)
+	{
+		mMid[2][a] = mMid[1][a];
+		mMid[1][a] = mMid[0][a];
+		mMid[0][a] = (mAxis[a].getMin() + mAxis[a].getMax()) / 2;
+	}
+
+	const int16_t n_th = mMid[0][0], n_prev = mMid[1][0], n_old = mMid[2][0];
+	step = invalid;
+	if(mTicks < 3)
+	{
+		// no history to compare against yet
+	}
+	else if(n_old + STEP_FORWARD_LEVEL < n_prev && n_th + STEP_FORWARD_LEVEL < n_prev)
+	{
+		step = forw;
+	}
+	else if(n_old > n_prev + STEP_BACK_LEVEL && n_th > n_prev + STEP_BACK_LEVEL)
+	{
+		step = back;
+	}
+	mSteps += (invalid != step) ? 1 : 0;
+	return true;
+}
+
+/*----------------------------------------------------------------------------
+Function    :  StepDetector::getMidRangeChange ()
+Inputs      :  None
+Processing  :  This function adds up the change of the three mid-ranges since
+			   the tick before
+Outputs     :  None
+Returns     :  Change in counts (1 g is 1024), 0 until two ticks are done
+Notes       :  Used as the motion intensity of the SpO2 gate
+----------------------------------------------------------------------------*/
+uint32_t StepDetector::getMidRangeChange(void) const
+{
+	if(mTicks < 2)
+	{
+		return 0;
+	}
+	return abs(mMid[0][0] - mMid[1][0]) + abs(mMid[0][1] - mMid[1][1]) + abs(mMid[0][2] - mMid[1][2]);
+}
+/*===================================================================
+// $Log: $1.0 Streaming step detector with sliding min/max
+//
+//--------------------------------------------------------------------*/
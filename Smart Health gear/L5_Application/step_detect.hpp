@@ -0,0 +1,151 @@
+/*****************************************************************************
+$Work file     : step_detect.hpp $
+Description    : This file contains the streaming step detector
+Project(s)     : Smart Health Gear
+Compiler       : Cross ARM GCC
+OS			   : RTOS
+Original Author: $ agent
+$Author        : $ agent
+$Date          : $ 17 Oct 2026
+$Revision      : 1.0 $
+*****************************************************************************/
+#ifndef L5_APPLICATION_STEP_DETECT_HPP_
+#define L5_APPLICATION_STEP_DETECT_HPP_
+
+/****************************************************************************/
+/*                       INCLUDE FILES                                      */
+/****************************************************************************/
+#include <stdint.h>
+#include "sliding_minmax.hpp"
+
+/****************************************************************************/
+/*                        MACRO Definitions                                 */
+/****************************************************************************/
+// Accelerometer samples per second fed to the detector (sensor output data rate)
+#define STEP_SAMPLE_RATE_HZ        (100)
+// The wrist position is the mid-range of X, Y and Z over the last 25 samples,
+// taken every 10 samples (100 msec)
+#define STEP_WINDOW_SAMPLES        (25)
+#define STEP_TICK_SAMPLES          (10)
+// A rise then fall of X by more than this is a forward step
+#define STEP_FORWARD_LEVEL         (15)
+// A fall then rise of X by more than this is a backward step
+#define STEP_BACK_LEVEL            (10)
+
+typedef enum {
+	invalid,
+	forw,
+	back
+} forBack_Count;
+
+/****************************************************************************/
+/*                       Class declarations                                 */
+/****************************************************************************/
+/**
+ * Step detector fed one accelerometer sample at a time.
+ *
+ * Every STEP_TICK_SAMPLES the mid-range (min + max) / 2 of each axis over the
+ * last STEP_WINDOW_SAMPLES is taken from sliding min/max queues, which cost
+ * O(1) per sample instead of sorting the window.  A step is counted when the
+ * mid-range of X of the previous tick is a peak (forward) or a valley (back)
+ * against the tick before it and the current one.
+ */
+class StepDetector
+{
+    public:
+        StepDetector() { reset(); }
+
+        /// Discards all samples, mid-ranges and steps
+        void reset(void);
+
+        /**
+         * Adds one sample.
+         * @param pn_xyz  X, Y and Z acceleration (1 g is 1024)
+         * @param step    set at the end of a tick to the step found, invalid if none
+         * @returns true at the end of a tick (every STEP_TICK_SAMPLES)
+         */
+        bool addSample(const int16_t *pn_xyz, forBack_Count &step);
+
+        /// @returns the mid-range of an axis (0 = X, 1 = Y, 2 = Z) at the last tick
+        int16_t getMidRange(uint32_t un_axis) const { return mMid[0][un_axis]; }
+
+        /// @returns the change of the X, Y and Z mid-ranges at the last tick, 0 for the first ticks
+        uint32_t getMidRangeChange(void) const;
+
+        /** @{ Counters since reset() */
+        uint32_t getTicks(void) const { return mTicks; }
+        uint32_t getSteps(void) const { return mSteps; }
+        /** @} */
+
+    private:
+        SlidingMinMax<int16_t, STEP_WINDOW_SAMPLES> mAxis[3];   ///< Window of X, Y and Z
+        int16_t  mMid[3][3];       ///< Mid-ranges of this tick [0], the one before [1] and before that [2]
+        uint32_t mTickSamples;     ///< Samples since the last tick
+        uint32_t mTicks;           ///< Ticks with a full window
+        uint32_t mSteps;           ///< Steps found
+};
+
+#ifdef TESTING
+#include <assert.h>
+#include <algorithm>
+static inline void test_StepDetector(void)
+{
+	const int n = 3000;
+	static int16_t an_trace[n];
+	int16_t an_x[STEP_WINDOW_SAMPLES];
+	int16_t an_xyz[3];
+	int16_t n_th = 0, n_prev = 0, n_old = 0;
+	uint32_t seed = 3, un_ticks = 0, un_steps = 0;
+	forBack_Count step;
+
+	StepDetector detector;
+	for(int i = 0; i < n; i++)
+	{
+		// about one step per second on X with noise, Y and Z mostly still
+		seed = seed * 1103515245 + 12345;
+		const int n_phase = i % STEP_SAMPLE_RATE_HZ;
+		an_trace[i] = ((n_phase < 50) ? n_phase : (100 - n_phase)) * 8 + (int16_t)((seed >> 16) % 9);
+		an_xyz[0] = an_trace[i];
+		an_xyz[1] = 200 + (int16_t)((seed >> 20) % 5);
+		an_xyz[2] = 1024;
+
+		const bool b_tick = detector.addSample(an_xyz, step);
+		if(i + 1 < STEP_WINDOW_SAMPLES || 0 != (i + 1 - STEP_WINDOW_SAMPLES) % STEP_TICK_SAMPLES)
+		{
+			assert(!b_tick);
+			continue;
+		}
+		assert(b_tick);
+
+		// reference : sort the last window at every tick, like the per-tick sort did
+		for(int k = 0; k < STEP_WINDOW_SAMPLES; k++)
+		{
+			an_x[k] = an_trace[i + 1 - STEP_WINDOW_SAMPLES + k];
+		}
+		std::sort(an_x, an_x + STEP_WINDOW_SAMPLES);
+		n_old = n_prev;
+		n_prev = n_th;
+		n_th = (an_x[0] + an_x[STEP_WINDOW_SAMPLES - 1]) / 2;
+		un_ticks++;
+
+		forBack_Count expected = invalid;
+		if(un_ticks >= 3 && n_old + STEP_FORWARD_LEVEL < n_prev && n_th + STEP_FORWARD_LEVEL < n_prev)
+			expected = forw;
+		else if(un_ticks >= 3 && n_old > n_prev + STEP_BACK_LEVEL && n_th > n_prev + STEP_BACK_LEVEL)
+			expected = back;
+		un_steps += (invalid != expected) ? 1 : 0;
+
+		assert(n_th == detector.getMidRange(0));
+		assert(expected == step);
+	}
+	assert(un_ticks == detector.getTicks() && un_steps == detector.getSteps());
+	// 30 seconds of walking, a forward and a back step for every swing
+	assert(un_steps >= 50);
+}
+#endif /* #ifdef TESTING */
+
+#endif /* L5_APPLICATION_STEP_DETECT_HPP_ */
+/*===================================================================
+// $Log: $1.0 Streaming step detector with sliding min/max
+//
+//--------------------------------------------------------------------*/
@@ -42,6 +42,11 @@ $Revision      : 1.0 $
 #include "fat/ff.h"
 #include "Thermistor.hpp"
 #include "i2c1.hpp"
+#include "isr_event.hpp"
+#include "sample_scheduler.hpp"
+#include "hrv_stats.hpp"
+#include "step_detect.hpp"
+#include "max30102_fifo.hpp"
 #include <algorithm>
 #define	SS(fs)	((fs)->ssize)
 using namespace std;
@@ -49,26 +54,55 @@ using namespace std;
 /****************************************************************************/
 /*                        VARIABLES AND MACROS                              */
 /****************************************************************************/
-static LPC_TIM_TypeDef * one_ms_timer_ptr = NULL;
-static SemaphoreHandle_t triggerHundredMilliSec	   = NULL;
 void caliberate(void);
+// Timer of the sampling scheduler, one slot every msec
 #define  one_ms_timer    (2)
+// Slots of the sampling jobs within their period, staggered so that no two jobs
+// wake up in the same msec (the display uses slot 7, see display.hpp)
+#define  ACCEL_JOB_PHASE_MS     (0)
+#define  TEMP_JOB_PHASE_MS      (3)
 #define  SET			 (1)
 #define  HUNDRED_MILLI	 (100)
 #define  TENMILLI	     (1)
-typedef enum {
-	invalid,
-	forw,
-	back
-} forBack_Count;
+// Heart rate sample rate after power up, 'hrrate' selects 25, 50, 100 or 200 sps
+#define  HR_DEFAULT_SAMPLE_RATE (100)
+// HRV window after power up, 'hrv' selects 1 to 5 minutes
+#define  HR_DEFAULT_HRV_WINDOW_MIN (5)
+// Most beats the engine can confirm in one output (15 peaks in 5 seconds)
+#define  HR_MAX_BEATS           (32)
+// Motion intensity (change in mg per 100 msec, smoothed) above which SpO2 is skipped,
+// 'spo2gate' changes the levels
+#define  HR_MOTION_SKIP_LEVEL   (150)
+// Above this level SpO2 is only computed on every HR_SPO2_SLOW_DIVIDER output
+#define  HR_MOTION_SLOW_LEVEL   (60)
+#define  HR_SPO2_SLOW_DIVIDER   (4)
 static uint32_t step_Count =0;
 extern  uint32_t check;
+// Signaled by the MAX30102 FIFO almost-full interrupt
+extern IsrEvent max30102_fifo_event;
+// Motion intensity published by the step counter every 100 msec (orient_compute)
+extern volatile uint32_t motion_intensity;
+// Streaming heart rate / SpO2 engine (ppg_stream.hpp)
+class PpgEngine;
+// Spool file writer and the ring of samples waiting for it (ppg_trace.hpp)
+class PpgSpoolWriter;
+class PpgTraceRecorder;
+// Longest spool file path, ie: "1:spool.bin"
+#define  HR_SPOOL_PATH_SIZE     (32)
+// The spool writer task empties the ring every 250 msec (the ring holds 3.4 sec at 200 sps)
+#define  HR_SPOOL_DRAIN_MS      (250)
+// Thermistor ADC channel (light sensor input), readings per second after power up
+// and readings averaged per value, 'temp' changes the rate and the hysteresis
+#define  TEMP_ADC_CHANNEL       (3)
+#define  TEMP_DEFAULT_RATE_HZ   (4)
+#define  TEMP_MAX_RATE_HZ       (100)
+#define  TEMP_OVERSAMPLE        (16)
+// A new temperature is published when it moves this far (0.01 C) from the last one
+#define  TEMP_DEFAULT_HYSTERESIS_CENTI (20)
 
 /****************************************************************************/
 /*                       FUNCTION DECLARATAIONS                             */
 /****************************************************************************/
-// Timer to re- calibrate the accelerometer
-void Timer2_init(void);
 
 
 /****************************************************************************/
@@ -465,28 +499,58 @@ class UART2_task : public scheduler_task
  class orient_compute : public scheduler_task
  {
      public:
-        int first =0;
- 		int16_t x_value, y_value, z_value, x_th, y_th, z_th, x_prev, y_prev,z_prev, x_old, y_old, z_old;
- 		int16_t X[50],Y[50],Z[50];
- 		int16_t X_run[25],Y_run[25],Z_run[25];
  		int step =0;
  		uint32_t time 		        = 0;
         orient_compute(uint8_t priority);
-        void calibrate(void);
-        void sort_Function(void);
-        void sort_Window(void);
-        forBack_Count calculate_count(void);
+        void update_motion(void);
         bool run(void *p);
+        /// Detector state shown by the 'steps' terminal command
+        const StepDetector& get_detector(void) const { return mDetector; }
+        uint32_t get_read_errors(void) const { return mReadErrors; }
+     private:
+        StepDetector mDetector;     ///< Fed one sample every accelerometer slot
+        uint32_t mReadErrors = 0;   ///< Samples the accelerometer did not return
  };
 class tempMeasure : public scheduler_task
 {
     public:
-	tempMeasure (uint8_t priority) : scheduler_task("temp", 2048, priority)
+	tempMeasure (uint8_t priority) : scheduler_task("temp", 2048, priority),
+		mRateHz(TEMP_DEFAULT_RATE_HZ), mHysteresis(TEMP_DEFAULT_HYSTERESIS_CENTI),
+		mCentiCelsius(0), mPublishedCenti(0), mConversions(0), mPublished(0),
+		mStatsStartMs(0)
     {
         /* Nothing to init */
     }
 	bool run(void *p);
 
+	/**
+	 * Sets the readings per second, each one averaged over TEMP_OVERSAMPLE conversions
+	 * @returns false if un_rate_hz is not 1 to TEMP_MAX_RATE_HZ
+	 */
+	bool setRate(uint32_t un_rate_hz);
+	uint32_t getRate(void) const { return mRateHz; }
+
+	/// Sets how far (0.01 C) the temperature moves before it is published
+	void setHysteresis(uint32_t un_centi) { mHysteresis = un_centi; }
+	uint32_t getHysteresis(void) const { return mHysteresis; }
+
+	/// Statistics shown by the 'temp' terminal command
+	int32_t getCentiCelsius(void) const { return mCentiCelsius; }
+	int32_t getPublishedCenti(void) const { return mPublishedCenti; }
+	uint32_t getConversions(void) const { return mConversions; }
+	uint32_t getPublished(void) const { return mPublished; }
+	/// @returns ADC conversions per second since the last resetStats()
+	uint32_t getConversionsPerSec(void) const;
+	void resetStats(void);
+
+    private:
+	volatile uint32_t mRateHz;           ///< Readings per second
+	volatile uint32_t mHysteresis;       ///< Publish threshold in 0.01 C
+	int32_t  mCentiCelsius;              ///< Latest averaged temperature
+	int32_t  mPublishedCenti;            ///< Temperature last sent on temp_data
+	uint32_t mConversions;               ///< ADC conversions since resetStats()
+	uint32_t mPublished;                 ///< Values sent on temp_data since resetStats()
+	uint32_t mStatsStartMs;              ///< Uptime of resetStats()
 };
 // Body Temperature Task
 class bodyTemperature : public scheduler_task
@@ -503,14 +567,149 @@ class bodyTemperature : public scheduler_task
 class heartRate : public scheduler_task
 {
     public:
-	heartRate (uint8_t priority) : scheduler_task("hrt-rt", 5120, priority)
+	heartRate (uint8_t priority) : scheduler_task("hrt-rt", 5120, priority),
+		mWakeups(0), mSamples(0), mOverflows(0),
+		mpEngine(NULL), mSampleRate(0), mRequestedRate(HR_DEFAULT_SAMPLE_RATE),
+		mLatestHrv(), mLastBeat(0), mBeats(0), mRequestedHrvWindow(HR_DEFAULT_HRV_WINDOW_MIN),
+		mSkipLevel(HR_MOTION_SKIP_LEVEL), mSlowLevel(HR_MOTION_SLOW_LEVEL), mSlowCount(0),
+		mpSpool(NULL), mpSpoolRing(NULL), mSpooling(false), mSpoolRequest(spool_none),
+		mSpoolSamples(0), mSpoolBytes(0), mSpoolMaxWriteUs(0), mSpoolDropped(0), mSpoolError(false)
     {
-        /* Nothing to init */
+        mSpoolPath[0] = '\0';
+        resetSpo2Stats();
+        mHrv.setWindow(HR_DEFAULT_HRV_WINDOW_MIN);
     }
   //  void static heartrate_irq(void);
-	bool maxim_max30102_read_fifo(uint32_t *pun_red_led, uint32_t *pun_ir_led);
+	uint8_t maxim_max30102_read_fifo(uint8_t *puch_fifo);
+	void maxim_max30102_set_rate(uint32_t un_sample_rate);
+	bool run(void * p);
+
+	/**
+	 * Requests a new sample rate, applied by the task before its next FIFO read.
+	 * @returns false if the rate is not 25, 50, 100 or 200, or while spooling
+	 */
+	bool setSampleRate(uint32_t un_sample_rate);
+	/// @returns the sample rate the sensor and the engine are running at
+	uint32_t getSampleRate(void) const { return mSampleRate; }
+
+	/// FIFO statistics shown by the 'hrfifo' terminal command
+	uint32_t getWakeups(void) const { return mWakeups; }
+	uint32_t getSamples(void) const { return mSamples; }
+	uint32_t getOverflows(void) const { return mOverflows; }
+
+	/**
+	 * Requests a new HRV window, applied by the task before its next FIFO read.
+	 * @returns false if minutes is not 1 to 5
+	 */
+	bool setHrvWindow(uint32_t minutes);
+	/// @returns the HRV published with the last beat, for the 'hrv' terminal command
+	hrv_t getHrv(void);
+	/// @returns RR intervals taken / rejected by the HRV statistics
+	uint32_t getHrvAccepted(void) const { return mHrv.getAccepted(); }
+	uint32_t getHrvRejected(void) const { return mHrv.getRejected(); }
+
+	/**
+	 * Sets the motion levels of the SpO2 gate.
+	 * @returns false if un_slow_level is above un_skip_level
+	 */
+	bool setMotionLevels(uint32_t un_skip_level, uint32_t un_slow_level);
+	uint32_t getSkipLevel(void) const { return mSkipLevel; }
+	uint32_t getSlowLevel(void) const { return mSlowLevel; }
+
+	/// SpO2 gate statistics shown by the 'spo2gate' terminal command
+	void resetSpo2Stats(void);
+	uint32_t getSpo2Computed(void) const { return mSpo2Computed; }
+	uint32_t getSpo2Skipped(void) const { return mSpo2Skipped; }
+	uint32_t getSpo2Slowed(void) const { return mSpo2Slowed; }
+	uint64_t getFullComputeUs(void) const { return mFullUs; }
+	uint64_t getHrOnlyComputeUs(void) const { return mHrOnlyUs; }
+
+	/**
+	 * Spool mode : raw samples are packed to a file instead of being processed,
+	 * the engine does not run so nothing is sent to the display.  The task only
+	 * copies the FIFO samples to a ring, the spool writer task does the file
+	 * writes.  Applied by the spool writer task within HR_SPOOL_DRAIN_MS.
+	 * @returns false if a start or stop is already pending
+	 */
+	bool startSpool(const char *pch_path);
+	bool stopSpool(void);
+	/// @returns true while samples are being spooled
+	bool isSpooling(void) const { return mSpooling; }
+	/// Spool statistics shown by the 'hrspool' terminal command, kept after a stop
+	uint32_t getSpoolSamples(void) const { return mSpoolSamples; }
+	uint32_t getSpoolBytes(void) const { return mSpoolBytes; }
+	uint32_t getSpoolMaxWriteUs(void) const { return mSpoolMaxWriteUs; }
+	uint32_t getSpoolDropped(void) const { return mSpoolDropped; }
+	bool getSpoolError(void) const { return mSpoolError; }
+	const char* getSpoolPath(void) const { return mSpoolPath; }
+	/// Opens, writes and closes the spool file, called by the spool writer task only
+	void serviceSpool(void);
+
+    private:
+	uint32_t mWakeups;   ///< Almost-full interrupts serviced
+	uint32_t mSamples;   ///< Samples drained from the FIFO
+	uint32_t mOverflows; ///< Samples lost because the FIFO was full
+
+	/// Switches the sensor and the engine to un_sample_rate
+	bool changeSampleRate(uint32_t un_sample_rate);
+
+	/// Sends the RR interval ending at the beat un_loc and the HRV over the window
+	void publishBeat(uint32_t un_loc);
+
+	/// @returns true if the next compute() should run the SpO2 stages
+	bool spo2Due(void);
+
+	/// Opens or closes the spool file as requested by startSpool() / stopSpool()
+	void changeSpool(void);
+	/// Packs the samples waiting in the ring to the spool file
+	void drainSpool(void);
+
+	PpgEngine *mpEngine;                 ///< Engine built for mSampleRate
+	uint32_t mSampleRate;                ///< Current samples per second
+	volatile uint32_t mRequestedRate;    ///< Rate set by setSampleRate()
+
+	HrvStats mHrv;                       ///< Rolling HRV statistics
+	hrv_t    mLatestHrv;                 ///< Last value sent on hrv_data
+	uint32_t mLastBeat;                  ///< Sample index of the last beat, 0 if none
+	uint32_t mBeats;                     ///< Beats since the task started
+	volatile uint32_t mRequestedHrvWindow;   ///< Window set by setHrvWindow()
+
+	volatile uint32_t mSkipLevel;        ///< Motion above this skips SpO2
+	volatile uint32_t mSlowLevel;        ///< Motion above this down-rates SpO2
+	uint32_t mSlowCount;                 ///< Outputs since SpO2 was last computed while down-rated
+	uint32_t mSpo2Computed;              ///< Outputs with SpO2
+	uint32_t mSpo2Skipped;               ///< Outputs without SpO2, motion above mSkipLevel
+	uint32_t mSpo2Slowed;                ///< Outputs without SpO2, motion above mSlowLevel
+	uint64_t mFullUs;                    ///< Time spent in compute() with SpO2
+	uint64_t mHrOnlyUs;                  ///< Time spent in compute() without SpO2
+
+	typedef enum { spool_none, spool_start, spool_stop } spool_request_t;
+	PpgSpoolWriter *mpSpool;             ///< Open spool file, NULL when not spooling
+	PpgTraceRecorder *mpSpoolRing;       ///< FIFO samples for the spool writer, kept once allocated
+	volatile bool mSpooling;             ///< Set by the spool writer once the file is open
+	volatile spool_request_t mSpoolRequest;  ///< Set by startSpool() / stopSpool()
+	char mSpoolPath[HR_SPOOL_PATH_SIZE];
+	uint32_t mSpoolSamples;              ///< Samples spooled to the current / last file
+	uint32_t mSpoolBytes;                ///< Size of the current / last file
+	uint32_t mSpoolMaxWriteUs;           ///< Longest block write
+	uint32_t mSpoolDropped;              ///< Samples lost because the ring was full
+	bool mSpoolError;                    ///< The file could not be created or written
+};
+
+// Spool Writer Task : the file side of the heart rate task's spool mode.  It runs
+// at the lowest task priority, like the heart rate task, so the heart rate task
+// waits at most one tick for it.
+class spoolWriter : public scheduler_task
+{
+    public:
+	spoolWriter (uint8_t priority) : scheduler_task("spool", 2048, priority), mpHeartRate(NULL)
+    {
+        setRunDuration(HR_SPOOL_DRAIN_MS);
+    }
 	bool run(void * p);
 
+    private:
+	heartRate *mpHeartRate;              ///< Task whose samples are spooled
 };
 
 
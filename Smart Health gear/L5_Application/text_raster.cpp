@@ -0,0 +1,160 @@
+/*****************************************************************************
+$Work file     : text_raster.cpp $
+Description    : This file contains the text rasteriser of the display
+Project(s)     : Smart Health Gear
+Compiler       : Cross ARM GCC
+OS			   : RTOS
+Original Author: $ agent
+$Author        : $ agent
+$Date          : $ 17 Oct 2026
+$Revision      : 1.0 $
+*****************************************************************************/
+
+/****************************************************************************/
+/*                       INCLUDE FILES                                      */
+/****************************************************************************/
+#include "text_raster.hpp"
+
+
+/*----------------------------------------------------------------------------
+Function    :  TextRaster (Constructor)
+Inputs      :  pFont - 5x7 font, 5 bytes per character
+Processing  :  This function expands the digits at the cached scales
+Outputs     :  None
+Returns     :  None
+Notes       :  None
+----------------------------------------------------------------------------*/
+TextRaster::TextRaster(const unsigned char *pFont) :
+		mpFont(pFont),
+		mCacheHits(0),
+		mCacheMisses(0)
+{
+	for(uint32_t s = 0; s < TEXT_CACHE_SCALES; s++)
+	{
+		for(uint32_t d = 0; d < 10; d++)
+		{
+			for(uint8_t r = 0; r < 8; r++)
+			{
+				mDigits[s][d][r] = expandRow('0' + d, r, text_cache_scale[s]);
+			}
+		}
+	}
+}
+
+/*----------------------------------------------------------------------------
+Function    :  TextRaster::getWidth ()
+Inputs      :  pStr - string, size - scale
+Processing  :  This function adds the advance of all characters but the last
+			   one and the cell of the last one
+Outputs     :  None
+Returns     :  Width of the string box in pixels
+Notes       :  None
+----------------------------------------------------------------------------*/
+int16_t TextRaster::getWidth(const char *pStr, uint8_t size)
+{
+	int16_t n_width = 0;
+	if(*pStr)
+	{
+		while(*++pStr)
+		{
+			n_width += getAdvance(size);
+		}
+		n_width += 6 * size;
+	}
+	return n_width;
+}
+
+/*----------------------------------------------------------------------------
+Function    :  TextRaster::getRowMask ()
+Inputs      :  c - character, row - glyph row 0 to 7, size - scale
+Processing  :  This function takes the mask of a digit from the cache, or
+			   expands it for other characters and scales
+Outputs     :  None
+Returns     :  Bit i set if pixel column i of the scaled cell is the text color
+Notes       :  None
+----------------------------------------------------------------------------*/
+uint64_t TextRaster::getRowMask(unsigned char c, uint8_t row, uint8_t size)
+{
+	if(c >= '0' && c <= '9')
+	{
+		for(uint32_t s = 0; s < TEXT_CACHE_SCALES; s++)
+		{
+			if(text_cache_scale[s] == size)
+			{
+				mCacheHits++;
+				return mDigits[s][c - '0'][row];
+			}
+		}
+	}
+	mCacheMisses++;
+	return expandRow(c, row, size);
+}
+
+/*----------------------------------------------------------------------------
+Function    :  TextRaster::expandRow ()
+Inputs      :  c - character, row - glyph row 0 to 7, size - scale
+Processing  :  This function repeats every column bit of the glyph row size
+			   times, the 6th column is background
+Outputs     :  None
+Returns     :  Mask of the scaled cell row
+Notes       :  Characters from 176 are shifted by one like drawChar()
+----------------------------------------------------------------------------*/
+uint64_t TextRaster::expandRow(unsigned char c, uint8_t row, uint8_t size) const
+{
+	const uint64_t ul_run = ((uint64_t) 1 << size) - 1;
+	uint64_t ul_mask = 0;
+
+	if(c >= 176) c++;
+	for(uint32_t i = 0; i < 5; i++)
+	{
+		if((mpFont[c * 5 + i] >> row) & 1)
+		{
+			ul_mask |= ul_run << (i * size);
+		}
+	}
+	return ul_mask;
+}
+
+/*----------------------------------------------------------------------------
+Function    :  TextRaster::renderRows ()
+Inputs      :  pStr - string, size - scale, color / bg - text and background
+			   colors, x0 / y0 / width / rows - part of the string box,
+			   stride - pixels per row of pBuf
+Processing  :  This function writes the cells of the characters one after the
+			   other in every row, a cell overwrites the end of the one before
+Outputs     :  pBuf - pixels of the part of the box
+Returns     :  None
+Notes       :  None
+----------------------------------------------------------------------------*/
+void TextRaster::renderRows(const char *pStr, uint8_t size, uint16_t color, uint16_t bg,
+                            int16_t x0, int16_t y0, int16_t width, int16_t rows,
+                            int16_t stride, uint16_t *pBuf)
+{
+	const int16_t n_advance = getAdvance(size);
+	const int16_t n_cell = 6 * size;
+	const int16_t n_x1 = x0 + width;
+
+	for(int16_t r = 0; r < rows; r++, pBuf += stride)
+	{
+		const uint8_t uch_row = (y0 + r) / size;
+		int16_t x = 0;
+		for(const char *pch = pStr; *pch && x < n_x1; pch++, x += n_advance)
+		{
+			if(x + n_cell <= x0)
+			{
+				continue;
+			}
+			const int16_t n_start = (x > x0) ? x : x0;
+			const int16_t n_end = (x + n_cell < n_x1) ? (x + n_cell) : n_x1;
+			uint64_t ul_mask = getRowMask(*pch, uch_row, size) >> (n_start - x);
+			for(int16_t i = n_start; i < n_end; i++, ul_mask >>= 1)
+			{
+				pBuf[i - x0] = (ul_mask & 1) ? color : bg;
+			}
+		}
+	}
+}
+/*===================================================================
+// $Log: $1.0 Text rasteriser with a digit cache
+//
+//--------------------------------------------------------------------*/
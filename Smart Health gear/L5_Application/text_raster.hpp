@@ -0,0 +1,146 @@
+/*****************************************************************************
+$Work file     : text_raster.hpp $
+Description    : This file contains the text rasteriser of the display
+Project(s)     : Smart Health Gear
+Compiler       : Cross ARM GCC
+OS			   : RTOS
+Original Author: $ agent
+$Author        : $ agent
+$Date          : $ 17 Oct 2026
+$Revision      : 1.0 $
+*****************************************************************************/
+#ifndef L5_APPLICATION_TEXT_RASTER_HPP_
+#define L5_APPLICATION_TEXT_RASTER_HPP_
+
+/****************************************************************************/
+/*                       INCLUDE FILES                                      */
+/****************************************************************************/
+#include <stdint.h>
+
+/****************************************************************************/
+/*                        MACRO Definitions                                 */
+/****************************************************************************/
+// A scaled character cell row (6 columns) must fit in 64 bits
+#define TEXT_MAX_SCALE             (10)
+// Pixels of one strip buffer, at least 4 rows of a full screen width
+#define TEXT_STRIP_PIXELS          (1024)
+// Digits are kept expanded for the scales of the readings (2), date (3) and clock (6)
+#define TEXT_CACHE_SCALES          (3)
+static const uint8_t text_cache_scale[TEXT_CACHE_SCALES] = {2, 3, 6};
+
+/****************************************************************************/
+/*                       Class declarations                                 */
+/****************************************************************************/
+/**
+ * Renders strings of the classic 5x7 font into RGB565 pixel rows.
+ *
+ * The string box is laid out like drawChar() does one character at a time :
+ * a 6 x 8 cell scaled by size (the 6th column is background), one cell every
+ * (5.0 + 0.4) * size pixels, a cell overwriting the end of the one before.  The
+ * rows are rendered into a strip buffer that is sent to the LCD through one
+ * address window.
+ *
+ * A glyph row is expanded to a mask with one bit per pixel of the scaled cell.
+ * The masks of the digits at the scales of the screens are cached.
+ */
+class TextRaster
+{
+    public:
+        /// @param pFont  5 bytes per character, one bit per row of each column
+        TextRaster(const unsigned char *pFont);
+
+        /// @returns the distance from a character to the next one
+        static int16_t getAdvance(uint8_t size) { return (27 * size) / 5; }
+        /// @returns the width of the string box, 0 for an empty string
+        static int16_t getWidth(const char *pStr, uint8_t size);
+
+        /// @returns row (0 to 7) of the scaled cell of c, bit i is pixel column i
+        uint64_t getRowMask(unsigned char c, uint8_t row, uint8_t size);
+
+        /**
+         * Renders a part of the string box, the pixels outside the cells are not written.
+         * @param x0, y0  first pixel column and row (0, 0 is the top left of the box)
+         * @param width   pixel columns, the box is clipped to them
+         * @param rows    pixel rows
+         * @param stride  pixels from one row of pBuf to the next
+         * @param pBuf    column x0 of row y0
+         */
+        void renderRows(const char *pStr, uint8_t size, uint16_t color, uint16_t bg,
+                        int16_t x0, int16_t y0, int16_t width, int16_t rows,
+                        int16_t stride, uint16_t *pBuf);
+
+        /** @{ Glyph rows taken from the cache or expanded */
+        uint32_t getCacheHits(void) const   { return mCacheHits; }
+        uint32_t getCacheMisses(void) const { return mCacheMisses; }
+        void resetStats(void)               { mCacheHits = 0; mCacheMisses = 0; }
+        /** @} */
+
+    private:
+        uint64_t expandRow(unsigned char c, uint8_t row, uint8_t size) const;
+
+        const unsigned char *mpFont;
+        uint64_t mDigits[TEXT_CACHE_SCALES][10][8];   ///< Masks of '0' to '9'
+        uint32_t mCacheHits;
+        uint32_t mCacheMisses;
+};
+
+#ifdef TESTING
+#include <assert.h>
+static inline void test_TextRaster(void)
+{
+	// random columns instead of the font, so that every bit pattern is seen
+	static unsigned char auch_font[256 * 5];
+	static uint16_t aus_screen[40][240], aus_strip[TEXT_STRIP_PIXELS];
+	uint32_t seed = 5;
+	for(int i = 0; i < 256 * 5; i++)
+	{
+		seed = seed * 1103515245 + 12345;
+		auch_font[i] = (uint8_t)(seed >> 16);
+	}
+
+	TextRaster raster(auch_font);
+	const char *apch_text[] = { "72", "98.6", "12:34", "Heart Rate", "\xb0\xff!" };
+	for(uint8_t size = 1; size <= 4; size++)
+	{
+		for(unsigned t = 0; t < sizeof(apch_text) / sizeof(apch_text[0]); t++)
+		{
+			// reference : the cells one after the other like drawChar()
+			const char *pch = apch_text[t];
+			const int16_t n_width = TextRaster::getWidth(pch, size);
+			for(int16_t x = 0; *pch; pch++, x += TextRaster::getAdvance(size))
+			{
+				unsigned char c = *pch;
+				c += (c >= 176) ? 1 : 0;
+				for(int i = 0; i < 6 * size; i++)
+					for(int j = 0; j < 8 * size; j++)
+						aus_screen[j][x + i] = (i < 5 * size && ((auch_font[c * 5 + i / size] >> (j / size)) & 1)) ? 0xFFE0 : 0;
+			}
+
+			// strips of 3 rows, the last one shorter
+			for(int16_t y = 0; y < 8 * size; y += 3)
+			{
+				const int16_t rows = (8 * size - y < 3) ? 8 * size - y : 3;
+				raster.renderRows(apch_text[t], size, 0xFFE0, 0, 0, y, n_width, rows, n_width, aus_strip);
+				for(int16_t r = 0; r < rows; r++)
+					for(int16_t i = 0; i < n_width; i++)
+						assert(aus_strip[r * n_width + i] == aus_screen[y + r][i]);
+			}
+
+			// a window inside the box, with a wider stride
+			const int16_t n_x0 = size + 1, n_cols = n_width - 2 * size - 1;
+			raster.renderRows(apch_text[t], size, 0xFFE0, 0, n_x0, size, n_cols, 4, 240, aus_strip);
+			for(int16_t r = 0; r < 4; r++)
+				for(int16_t i = 0; i < n_cols; i++)
+					assert(aus_strip[r * 240 + i] == aus_screen[size + r][n_x0 + i]);
+		}
+	}
+	assert(raster.getCacheHits() > 0 && raster.getCacheMisses() > 0);
+	assert(0 == TextRaster::getWidth("", 2) && 6 * 3 + 16 == TextRaster::getWidth("ab", 3));
+}
+#endif /* #ifdef TESTING */
+
+#endif /* L5_APPLICATION_TEXT_RASTER_HPP_ */
+/*===================================================================
+// $Log: $1.0 Text rasteriser with a digit cache
+//
+//--------------------------------------------------------------------*/
@@ -0,0 +1,574 @@
+/*****************************************************************************
+$Work file     : vitals_link.cpp $
+Description    : This file contains the binary framing of the vitals sent over
+				 the HC-05 Bluetooth link
+Project(s)     : Smart Health Gear
+Compiler       : Cross ARM GCC
+OS			   : RTOS
+Original Author: $ agent
+$Author        : $ agent
+$Date          : $ 17 Oct 2026
+$Revision      : 1.0 $
+*****************************************************************************/
+
+/****************************************************************************/
+/*                       INCLUDE FILES                                      */
+/****************************************************************************/
+#include <string.h>
+#include "vitals_link.hpp"
+
+
+/*----------------------------------------------------------------------------
+Function    :  put_varint ()
+Inputs      :  un_value - value
+Processing  :  This function writes the value 7 bits at a time, low bits first,
+			   with bit 7 set on every byte but the last
+Outputs     :  puch_dst - 1 to 5 bytes
+Returns     :  Number of bytes written
+Notes       :  None
+----------------------------------------------------------------------------*/
+static uint32_t put_varint(uint32_t un_value, uint8_t *puch_dst)
+{
+	uint32_t un_len = 0;
+	while(un_value >= 0x80)
+	{
+		puch_dst[un_len++] = (uint8_t)(un_value | 0x80);
+		un_value >>= 7;
+	}
+	puch_dst[un_len++] = (uint8_t)un_value;
+	return un_len;
+}
+
+/*----------------------------------------------------------------------------
+Function    :  get_varint ()
+Inputs      :  puch_src - bytes
+			   un_len   - bytes available
+Processing  :  This function reads a value written by put_varint()
+Outputs     :  un_pos   - moved past the value
+			   un_value - value
+Returns     :  false if the value does not end within the bytes or 5 bytes
+Notes       :  None
+----------------------------------------------------------------------------*/
+static bool get_varint(const uint8_t *puch_src, uint32_t un_len, uint32_t &un_pos, uint32_t &un_value)
+{
+	un_value = 0;
+	for(uint32_t un_shift = 0; un_shift < 35 && un_pos < un_len; un_shift += 7)
+	{
+		const uint8_t uch_byte = puch_src[un_pos++];
+		un_value |= (uint32_t)(uch_byte & 0x7F) << un_shift;
+		if(0 == (uch_byte & 0x80))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+// Signed values as varints : 0, -1, 1, -2 ... are 0, 1, 2, 3 ...
+static inline uint32_t zigzag(int32_t n_value)   { return ((uint32_t)n_value << 1) ^ (uint32_t)(n_value >> 31); }
+static inline int32_t unzigzag(uint32_t un_value) { return (int32_t)(un_value >> 1) ^ -(int32_t)(un_value & 1); }
+
+/*----------------------------------------------------------------------------
+Function    :  vlink_crc16 ()
+Inputs      :  puch_data - bytes
+			   un_len    - number of bytes
+			   us_crc    - CRC of the bytes before
+Processing  :  This function updates the CRC one bit at a time, MSB first
+Outputs     :  None
+Returns     :  CRC
+Notes       :  About 20 bytes are sent per record at 9600 baud, a table is not needed
+----------------------------------------------------------------------------*/
+uint16_t vlink_crc16(const uint8_t *puch_data, uint32_t un_len, uint16_t us_crc)
+{
+	for(uint32_t i = 0; i < un_len; i++)
+	{
+		us_crc ^= (uint16_t)puch_data[i] << 8;
+		for(uint8_t b = 0; b < 8; b++)
+		{
+			us_crc = (us_crc & 0x8000) ? (uint16_t)((us_crc << 1) ^ 0x1021) : (uint16_t)(us_crc << 1);
+		}
+	}
+	return us_crc;
+}
+
+/*----------------------------------------------------------------------------
+Function    :  VitalsHistory::add ()
+Inputs      :  vitals     - current values
+			   un_time_ms - uptime
+Processing  :  This function keeps the values once per VLINK_HISTORY_PERIOD_MS,
+			   the oldest entry is dropped when all are in use
+Outputs     :  None
+Returns     :  true if the values were kept
+Notes       :  None
+----------------------------------------------------------------------------*/
+bool VitalsHistory::add(const vitals_t &vitals, uint32_t un_time_ms)
+{
+	if(mCount && un_time_ms - mLastMs < VLINK_HISTORY_PERIOD_MS)
+	{
+		return false;
+	}
+	uint32_t un_slot = mHead + mCount;
+	if(mCount < VLINK_HISTORY_DEPTH)
+	{
+		mCount++;
+	}
+	else
+	{
+		mHead = (mHead + 1) % VLINK_HISTORY_DEPTH;
+	}
+	un_slot %= VLINK_HISTORY_DEPTH;
+	mVitals[un_slot] = vitals;
+	mTimeMs[un_slot] = un_time_ms;
+	mLastMs = un_time_ms;
+	return true;
+}
+
+void VitalsHistory::get(uint32_t un_index, vitals_t &vitals, uint32_t &un_time_ms) const
+{
+	const uint32_t un_slot = (mHead + un_index) % VLINK_HISTORY_DEPTH;
+	vitals = mVitals[un_slot];
+	un_time_ms = mTimeMs[un_slot];
+}
+
+/*----------------------------------------------------------------------------
+Function    :  VitalsEncoder::reset ()
+Inputs      :  None
+Processing  :  This function drops the batch, the next record is a keyframe
+Outputs     :  None
+Returns     :  None
+Notes       :  The sequence number goes on, the phone counts the dropped frames
+----------------------------------------------------------------------------*/
+void VitalsEncoder::reset(void)
+{
+	memset(&mLast, 0, sizeof(mLast));
+	mLastMs = 0;
+	mKeyMs = 0;
+	mKeyDue = true;
+	mBatchLen = 0;
+	mBatchFirstMs = 0;
+	mBatchRecords = 0;
+	mBatchSumMs = 0;
+	resetStats();
+}
+
+void VitalsEncoder::resetStats(void)
+{
+	mRecords = 0;
+	mKeyframes = 0;
+	mFrames = 0;
+	mBytes = 0;
+	mBatched = 0;
+	mBatchWaitMs = 0;
+}
+
+/*----------------------------------------------------------------------------
+Function    :  VitalsEncoder::encodeRecord ()
+Inputs      :  vitals     - values of the record
+			   prev       - values of the record before (not used for a keyframe)
+			   un_time_ms - time of the record
+			   un_prev_ms - time of the record before
+			   b_key      - keyframe
+Processing  :  This function writes the header (field mask), the time, and every
+			   field in the mask : the value for a keyframe, else the change
+Outputs     :  puch_rec - VLINK_MAX_RECORD bytes
+Returns     :  Length of the record
+Notes       :  A keyframe has all the fields and the absolute time
+----------------------------------------------------------------------------*/
+uint32_t VitalsEncoder::encodeRecord(const vitals_t &vitals, const vitals_t &prev, uint32_t un_time_ms,
+                                     uint32_t un_prev_ms, bool b_key, uint8_t *puch_rec)
+{
+	uint8_t uch_mask = 0;
+	for(uint32_t f = 0; f < VLINK_FIELDS; f++)
+	{
+		if(b_key || vitals.an_value[f] != prev.an_value[f])
+		{
+			uch_mask |= (1 << f);
+		}
+	}
+
+	uint32_t un_len = 0;
+	puch_rec[un_len++] = uch_mask | (b_key ? VLINK_KEYFRAME_BIT : 0);
+	un_len += put_varint(b_key ? un_time_ms : (un_time_ms - un_prev_ms), puch_rec + un_len);
+	for(uint32_t f = 0; f < VLINK_FIELDS; f++)
+	{
+		if(uch_mask & (1 << f))
+		{
+			const int32_t n_value = b_key ? vitals.an_value[f] : (vitals.an_value[f] - prev.an_value[f]);
+			un_len += put_varint(zigzag(n_value), puch_rec + un_len);
+		}
+	}
+	return un_len;
+}
+
+/*----------------------------------------------------------------------------
+Function    :  VitalsEncoder::frame ()
+Inputs      :  uch_type     - frame type
+			   puch_payload - payload
+			   un_len       - payload length, VLINK_MAX_PAYLOAD at most
+Processing  :  This function writes the SOF, type, sequence number and length,
+			   the payload and the CRC of type to the end of the payload
+Outputs     :  puch_frame - frame
+Returns     :  Length of the frame
+Notes       :  puch_payload may already be in place in puch_frame
+----------------------------------------------------------------------------*/
+uint32_t VitalsEncoder::frame(uint8_t uch_type, const uint8_t *puch_payload, uint32_t un_len, uint8_t *puch_frame)
+{
+	puch_frame[0] = VLINK_SOF;
+	puch_frame[1] = uch_type;
+	puch_frame[2] = mSeq++;
+	puch_frame[3] = (uint8_t)un_len;
+	if(puch_payload != puch_frame + VLINK_HEADER_BYTES)
+	{
+		memcpy(puch_frame + VLINK_HEADER_BYTES, puch_payload, un_len);
+	}
+	const uint16_t us_crc = vlink_crc16(puch_frame + 1, un_len + VLINK_HEADER_BYTES - 1);
+	puch_frame[VLINK_HEADER_BYTES + un_len] = (uint8_t)us_crc;
+	puch_frame[VLINK_HEADER_BYTES + un_len + 1] = (uint8_t)(us_crc >> 8);
+
+	mFrames++;
+	mBytes += un_len + VLINK_HEADER_BYTES + VLINK_CRC_BYTES;
+	return un_len + VLINK_HEADER_BYTES + VLINK_CRC_BYTES;
+}
+
+/*----------------------------------------------------------------------------
+Function    :  VitalsEncoder::addVitals ()
+Inputs      :  vitals     - current values
+			   un_time_ms - uptime
+Processing  :  This function adds a record if a value changed or the keyframe
+			   interval has elapsed.  The batch is sent first if the record does
+			   not fit, and the record is sent right away without a batch window.
+Outputs     :  puch_frame - frame to send
+Returns     :  Length of the frame to send, 0 if none
+Notes       :  None
+----------------------------------------------------------------------------*/
+uint32_t VitalsEncoder::addVitals(const vitals_t &vitals, uint32_t un_time_ms, uint8_t *puch_frame)
+{
+	const bool b_key = mKeyDue || (un_time_ms - mKeyMs >= mKeyframeMs);
+	if(!b_key && 0 == memcmp(&vitals, &mLast, sizeof(vitals_t)))
+	{
+		return 0;
+	}
+
+	uint8_t auch_rec[VLINK_MAX_RECORD];
+	const uint32_t un_rec = encodeRecord(vitals, mLast, un_time_ms, mLastMs, b_key, auch_rec);
+	uint32_t un_len = 0;
+	if(mBatchLen + un_rec > VLINK_MAX_PAYLOAD)
+	{
+		un_len = flush(un_time_ms, puch_frame);
+	}
+	if(0 == mBatchLen)
+	{
+		mBatchFirstMs = un_time_ms;
+	}
+	memcpy(mBatch + mBatchLen, auch_rec, un_rec);
+	mBatchLen += un_rec;
+	mBatchRecords++;
+	mBatchSumMs += un_time_ms;
+
+	mRecords++;
+	mLast = vitals;
+	mLastMs = un_time_ms;
+	if(b_key)
+	{
+		mKeyframes++;
+		mKeyMs = un_time_ms;
+		mKeyDue = false;
+	}
+
+	if(0 == mBatchMs && 0 == un_len)
+	{
+		un_len = flush(un_time_ms, puch_frame);
+	}
+	return un_len;
+}
+
+bool VitalsEncoder::flushDue(uint32_t un_time_ms) const
+{
+	return mBatchLen && (un_time_ms - mBatchFirstMs >= mBatchMs);
+}
+
+/*----------------------------------------------------------------------------
+Function    :  VitalsEncoder::flush ()
+Inputs      :  un_time_ms - uptime
+Processing  :  This function puts the batch in a VLINK_LIVE frame and adds the
+			   time its records waited to the statistics
+Outputs     :  puch_frame - frame to send
+Returns     :  Length of the frame, 0 if the batch is empty
+Notes       :  None
+----------------------------------------------------------------------------*/
+uint32_t VitalsEncoder::flush(uint32_t un_time_ms, uint8_t *puch_frame)
+{
+	if(0 == mBatchLen)
+	{
+		return 0;
+	}
+	const uint32_t un_len = frame(VLINK_LIVE, mBatch, mBatchLen, puch_frame);
+	mBatched += mBatchRecords;
+	mBatchWaitMs += (uint64_t)un_time_ms * mBatchRecords - mBatchSumMs;
+	mBatchLen = 0;
+	mBatchRecords = 0;
+	mBatchSumMs = 0;
+	return un_len;
+}
+
+uint32_t VitalsEncoder::encodeRr(uint32_t un_time_ms, uint16_t us_rr_ms, uint8_t uch_valid, uint8_t *puch_frame)
+{
+	uint8_t *puch = puch_frame + VLINK_HEADER_BYTES;
+	puch[0] = (uint8_t)un_time_ms;
+	puch[1] = (uint8_t)(un_time_ms >> 8);
+	puch[2] = (uint8_t)(un_time_ms >> 16);
+	puch[3] = (uint8_t)(un_time_ms >> 24);
+	puch[4] = (uint8_t)us_rr_ms;
+	puch[5] = (uint8_t)(us_rr_ms >> 8);
+	puch[6] = uch_valid;
+	return frame(VLINK_RR, puch, 7, puch_frame);
+}
+
+/*----------------------------------------------------------------------------
+Function    :  VitalsEncoder::encodeHistory ()
+Inputs      :  history - entries to send
+			   un_next - first entry of this frame
+Processing  :  This function puts as many entries as fit in a VLINK_HISTORY
+			   frame, the first one as a keyframe so every frame can be decoded
+			   on its own.  Once all entries are sent, the VLINK_HISTORY_END frame
+			   gives their number.
+Outputs     :  un_next    - entry after the last one encoded
+			   puch_frame - frame to send
+Returns     :  Length of the frame, 0 once the end frame was encoded
+Notes       :  The live records and their keyframes are not affected
+----------------------------------------------------------------------------*/
+uint32_t VitalsEncoder::encodeHistory(const VitalsHistory &history, uint32_t &un_next, uint8_t *puch_frame)
+{
+	uint8_t *puch_payload = puch_frame + VLINK_HEADER_BYTES;
+	uint32_t un_len = 0;
+
+	if(un_next > history.getCount())
+	{
+		return 0;
+	}
+	if(un_next == history.getCount())
+	{
+		un_len = put_varint(history.getCount(), puch_payload);
+		un_next = 0xFFFFFFFF;
+		return frame(VLINK_HISTORY_END, puch_payload, un_len, puch_frame);
+	}
+
+	vitals_t prev, vitals;
+	memset(&prev, 0, sizeof(prev));
+	uint32_t un_prev_ms = 0, un_time_ms;
+	uint8_t auch_rec[VLINK_MAX_RECORD];
+	for(bool b_key = true; un_next < history.getCount(); b_key = false)
+	{
+		history.get(un_next, vitals, un_time_ms);
+		const uint32_t un_rec = encodeRecord(vitals, prev, un_time_ms, un_prev_ms, b_key, auch_rec);
+		if(un_len + un_rec > VLINK_MAX_PAYLOAD)
+		{
+			break;
+		}
+		memcpy(puch_payload + un_len, auch_rec, un_rec);
+		un_len += un_rec;
+		prev = vitals;
+		un_prev_ms = un_time_ms;
+		un_next++;
+	}
+	return frame(VLINK_HISTORY, puch_payload, un_len, puch_frame);
+}
+
+/*----------------------------------------------------------------------------
+Function    :  VitalsDecoder::reset ()
+Inputs      :  None
+Processing  :  This function forgets the frame in progress, the values of both
+			   streams and the statistics
+Outputs     :  None
+Returns     :  None
+Notes       :  None
+----------------------------------------------------------------------------*/
+void VitalsDecoder::reset(void)
+{
+	memset(mFrame, 0, sizeof(mFrame));
+	memset(&mLive, 0, sizeof(mLive));
+	memset(&mHistory, 0, sizeof(mHistory));
+	mHistory.b_history = true;
+	mLen = 0;
+	mRead = 0;
+	mValid = false;
+	mSeqKnown = false;
+	mSeq = 0;
+	mLiveKnown = false;
+	mHistoryKnown = false;
+	mFrames = 0;
+	mCrcErrors = 0;
+	mLostFrames = 0;
+	mSkipped = 0;
+	mRecords = 0;
+}
+
+/*----------------------------------------------------------------------------
+Function    :  VitalsDecoder::feed ()
+Inputs      :  uch_byte - received byte
+Processing  :  This function collects a frame from the SOF up to the length it
+			   gives and checks the CRC.  A bad frame is dropped and the bytes
+			   after its SOF are searched again for the next SOF.  The sequence
+			   number of a valid frame is checked against the expected one.
+Outputs     :  None
+Returns     :  true if the byte ended a valid frame
+Notes       :  A lost frame makes both streams unknown until their next keyframe
+----------------------------------------------------------------------------*/
+bool VitalsDecoder::feed(uint8_t uch_byte)
+{
+	// Decode what is left of the last frame before it is overwritten
+	if(mValid)
+	{
+		vlink_record_t record;
+		while(nextRecord(record))
+		{
+		}
+		mValid = false;
+		mLen = 0;
+	}
+
+	if(0 == mLen && VLINK_SOF != uch_byte)
+	{
+		return false;
+	}
+	mFrame[mLen++] = uch_byte;
+
+	while(mLen > VLINK_HEADER_BYTES - 1)
+	{
+		const uint32_t un_payload = mFrame[3];
+		const uint32_t un_total = VLINK_HEADER_BYTES + un_payload + VLINK_CRC_BYTES;
+		if(un_payload <= VLINK_MAX_PAYLOAD && mLen < un_total)
+		{
+			return false;
+		}
+		if(un_payload <= VLINK_MAX_PAYLOAD)
+		{
+			const uint16_t us_crc = mFrame[un_total - 2] | ((uint16_t)mFrame[un_total - 1] << 8);
+			if(us_crc == vlink_crc16(mFrame + 1, un_total - 3))
+			{
+				break;
+			}
+		}
+		// Not a frame : start again at the next SOF after this one
+		mCrcErrors++;
+		uint32_t un_sof = 1;
+		while(un_sof < mLen && VLINK_SOF != mFrame[un_sof])
+		{
+			un_sof++;
+		}
+		memmove(mFrame, mFrame + un_sof, mLen - un_sof);
+		mLen -= un_sof;
+	}
+	if(mLen < VLINK_HEADER_BYTES)
+	{
+		return false;
+	}
+
+	if(mSeqKnown && mFrame[2] != mSeq)
+	{
+		mLostFrames += (uint8_t)(mFrame[2] - mSeq);
+		mLiveKnown = false;
+		mHistoryKnown = false;
+	}
+	mSeq = mFrame[2] + 1;
+	mSeqKnown = true;
+	mFrames++;
+	mRead = 0;
+	mValid = true;
+	return true;
+}
+
+/*----------------------------------------------------------------------------
+Function    :  VitalsDecoder::nextRecord ()
+Inputs      :  None
+Processing  :  This function decodes the next record of the frame on the values
+			   of its stream.  Changes to unknown values are skipped until a
+			   keyframe, and every history frame starts with one.
+Outputs     :  record - values after the record
+Returns     :  false at the end of the frame, or for other frames
+Notes       :  A record cut short ends the frame
+----------------------------------------------------------------------------*/
+bool VitalsDecoder::nextRecord(vlink_record_t &record)
+{
+	const uint8_t uch_type = mFrame[1];
+	if(!mValid || (VLINK_LIVE != uch_type && VLINK_HISTORY != uch_type))
+	{
+		return false;
+	}
+	const bool b_history = (VLINK_HISTORY == uch_type);
+	vlink_record_t &state = b_history ? mHistory : mLive;
+	bool &b_known = b_history ? mHistoryKnown : mLiveKnown;
+	if(b_history && 0 == mRead)
+	{
+		b_known = false;
+	}
+
+	const uint8_t *puch_payload = mFrame + VLINK_HEADER_BYTES;
+	const uint32_t un_len = mFrame[3];
+	while(mRead < un_len)
+	{
+		const uint8_t uch_header = puch_payload[mRead++];
+		const bool b_key = (0 != (uch_header & VLINK_KEYFRAME_BIT));
+		uint32_t un_value;
+		vlink_record_t next = state;
+
+		if(!get_varint(puch_payload, un_len, mRead, un_value))
+		{
+			mRead = un_len;
+			return false;
+		}
+		next.un_time_ms = b_key ? un_value : (state.un_time_ms + un_value);
+		for(uint32_t f = 0; f < VLINK_FIELDS; f++)
+		{
+			if(0 == (uch_header & (1 << f)))
+			{
+				continue;
+			}
+			if(!get_varint(puch_payload, un_len, mRead, un_value))
+			{
+				mRead = un_len;
+				return false;
+			}
+			next.vitals.an_value[f] = b_key ? unzigzag(un_value) : (next.vitals.an_value[f] + unzigzag(un_value));
+		}
+
+		if(!b_key && !b_known)
+		{
+			mSkipped++;
+			continue;
+		}
+		next.uch_mask = uch_header & ~VLINK_KEYFRAME_BIT;
+		next.b_key = b_key;
+		next.b_history = b_history;
+		state = next;
+		b_known = true;
+		mRecords++;
+		record = state;
+		return true;
+	}
+	return false;
+}
+
+bool VitalsDecoder::getRr(vlink_rr_t &rr) const
+{
+	const uint8_t *puch = mFrame + VLINK_HEADER_BYTES;
+	if(!mValid || VLINK_RR != mFrame[1] || mFrame[3] < 7)
+	{
+		return false;
+	}
+	rr.un_time_ms = puch[0] | ((uint32_t)puch[1] << 8) | ((uint32_t)puch[2] << 16) | ((uint32_t)puch[3] << 24);
+	rr.us_rr_ms = puch[4] | ((uint16_t)puch[5] << 8);
+	rr.uch_valid = puch[6];
+	return true;
+}
+
+bool VitalsDecoder::getHistoryCount(uint32_t &un_count) const
+{
+	uint32_t un_pos = 0;
+	return mValid && VLINK_HISTORY_END == mFrame[1] &&
+	       get_varint(mFrame + VLINK_HEADER_BYTES, mFrame[3], un_pos, un_count);
+}
+/*===================================================================
+// $Log: $1.0 Binary framing of the vitals for the Bluetooth link
+//
+//--------------------------------------------------------------------*/
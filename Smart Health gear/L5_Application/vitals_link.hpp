@@ -0,0 +1,427 @@
+/*****************************************************************************
+$Work file     : vitals_link.hpp $
+Description    : This file contains the binary framing of the vitals sent over
+				 the HC-05 Bluetooth link
+Project(s)     : Smart Health Gear
+Compiler       : Cross ARM GCC
+OS			   : RTOS
+Original Author: $ agent
+$Author        : $ agent
+$Date          : $ 17 Oct 2026
+$Revision      : 1.0 $
+*****************************************************************************/
+#ifndef L5_APPLICATION_VITALS_LINK_HPP_
+#define L5_APPLICATION_VITALS_LINK_HPP_
+
+/****************************************************************************/
+/*                       INCLUDE FILES                                      */
+/****************************************************************************/
+#include <stdint.h>
+
+/****************************************************************************/
+/*                        MACRO Definitions                                 */
+/****************************************************************************/
+// Frame : SOF, type, sequence, payload length, payload, CRC-16 (LSB first) of
+// type to the end of the payload
+#define VLINK_SOF              (0xA5)
+#define VLINK_HEADER_BYTES     (4)
+#define VLINK_CRC_BYTES        (2)
+#define VLINK_MAX_PAYLOAD      (64)
+#define VLINK_MAX_FRAME        (VLINK_HEADER_BYTES + VLINK_MAX_PAYLOAD + VLINK_CRC_BYTES)
+
+// Frame types, watch to phone
+#define VLINK_LIVE             (0x01)    // vitals records
+#define VLINK_RR               (0x02)    // one RR interval : time (4), RR msec (2), valid (1)
+#define VLINK_HISTORY          (0x03)    // vitals records of the history
+#define VLINK_HISTORY_END      (0x04)    // number of history records sent (varint)
+// Frame types, phone to watch
+#define VLINK_HISTORY_REQUEST  (0x10)    // no payload
+
+// Fields of a vitals record, bit N of the record header is field N
+#define VLINK_HEART_RATE       (0)
+#define VLINK_OXYGEN           (1)
+#define VLINK_BODY_TEMP        (2)
+#define VLINK_STEPS            (3)
+#define VLINK_RMSSD_X10        (4)
+#define VLINK_SDNN_X10         (5)
+#define VLINK_PNN50_X10        (6)
+#define VLINK_FIELDS           (7)
+// Record header : field mask, and this bit for a keyframe (all fields, absolute time)
+#define VLINK_KEYFRAME_BIT     (0x80)
+// Largest record : header, time and fields of 5 bytes (32 bit varints)
+#define VLINK_MAX_RECORD       (1 + 5 * (1 + VLINK_FIELDS))
+
+// Defaults : a keyframe every 5 sec, no batching
+#define VLINK_KEYFRAME_MS      (5000)
+#define VLINK_BATCH_MS         (0)
+// One history entry per minute, for the last hour
+#define VLINK_HISTORY_PERIOD_MS (60000)
+#define VLINK_HISTORY_DEPTH    (60)
+
+/****************************************************************************/
+/*                        Type Definitions                                  */
+/****************************************************************************/
+// Values of the fields, in the units shown on the watch
+typedef struct {
+	int32_t an_value[VLINK_FIELDS];
+} vitals_t;
+
+// A decoded vitals record
+typedef struct {
+	uint32_t un_time_ms;      // uptime of the record
+	vitals_t vitals;          // all the fields, the ones not in uch_mask did not change
+	uint8_t  uch_mask;        // fields sent in this record
+	bool     b_key;           // keyframe
+	bool     b_history;       // from a history transfer
+} vlink_record_t;
+
+// A decoded RR interval
+typedef struct {
+	uint32_t un_time_ms;
+	uint16_t us_rr_ms;
+	uint8_t  uch_valid;
+} vlink_rr_t;
+
+/*----------------------------------------------------------------------------
+Function    :  vlink_crc16 ()
+Inputs      :  puch_data - bytes
+			   un_len    - number of bytes
+			   us_crc    - CRC of the bytes before, 0xFFFF to start
+Processing  :  This function computes the CRC-16/CCITT (polynomial 0x1021) of the bytes
+Outputs     :  None
+Returns     :  CRC
+Notes       :  None
+----------------------------------------------------------------------------*/
+uint16_t vlink_crc16(const uint8_t *puch_data, uint32_t un_len, uint16_t us_crc = 0xFFFF);
+
+/****************************************************************************/
+/*                       Class declarations                                 */
+/****************************************************************************/
+/**
+ * Vitals sampled once per VLINK_HISTORY_PERIOD_MS, the last VLINK_HISTORY_DEPTH
+ * of them, sent to the phone when it asks for them.
+ */
+class VitalsHistory
+{
+    public:
+        VitalsHistory() { reset(); }
+
+        /// Discards all the entries
+        void reset(void) { mHead = 0; mCount = 0; mLastMs = 0; }
+
+        /**
+         * Keeps the vitals if the period has elapsed since the last entry
+         * @returns true if they were kept
+         */
+        bool add(const vitals_t &vitals, uint32_t un_time_ms);
+
+        /// @returns the number of entries
+        uint32_t getCount(void) const { return mCount; }
+
+        /// Entry un_index, 0 is the oldest one
+        void get(uint32_t un_index, vitals_t &vitals, uint32_t &un_time_ms) const;
+
+    private:
+        vitals_t mVitals[VLINK_HISTORY_DEPTH];
+        uint32_t mTimeMs[VLINK_HISTORY_DEPTH];
+        uint32_t mHead;            ///< Oldest entry
+        uint32_t mCount;           ///< Entries in use
+        uint32_t mLastMs;          ///< Time of the newest entry
+};
+
+/**
+ * Encoder of the frames sent to the phone.
+ *
+ * A record is added only when a value changed, with the changed fields as zigzag
+ * varints of the change and the time since the record before.  Every keyframe
+ * interval a keyframe record carries all the fields and the absolute time, so the
+ * phone recovers from a lost frame.  Records are batched in one frame until the
+ * batch window has elapsed or the frame is full; a zero window sends every record
+ * right away.
+ *
+ * @code
+ *      uint8_t frame[VLINK_MAX_FRAME];
+ *      send(frame, encoder.addVitals(vitals, now_ms, frame));
+ *      if (encoder.flushDue(now_ms)) {
+ *          send(frame, encoder.flush(now_ms, frame));
+ *      }
+ * @endcode
+ */
+class VitalsEncoder
+{
+    public:
+        VitalsEncoder() : mKeyframeMs(VLINK_KEYFRAME_MS), mBatchMs(VLINK_BATCH_MS), mSeq(0) { reset(); }
+
+        /// Starts over with a keyframe, the intervals are kept
+        void reset(void);
+
+        /** @{ Intervals in msec, a zero batch window sends every record on its own */
+        void setKeyframeMs(uint32_t un_ms) { mKeyframeMs = un_ms ? un_ms : 1; }
+        void setBatchMs(uint32_t un_ms)    { mBatchMs = un_ms; }
+        uint32_t getKeyframeMs(void) const { return mKeyframeMs; }
+        uint32_t getBatchMs(void) const    { return mBatchMs; }
+        /** @} */
+
+        /**
+         * Adds a record of the vitals if a value changed or a keyframe is due.
+         * @param puch_frame  VLINK_MAX_FRAME bytes for a frame to send
+         * @returns the length of the frame to send, 0 if there is none
+         */
+        uint32_t addVitals(const vitals_t &vitals, uint32_t un_time_ms, uint8_t *puch_frame);
+
+        /// @returns true if records are batched and the batch window has elapsed
+        bool flushDue(uint32_t un_time_ms) const;
+
+        /// Ends the batch, @returns the length of the frame to send, 0 if it is empty
+        uint32_t flush(uint32_t un_time_ms, uint8_t *puch_frame);
+
+        /// Encodes an RR interval frame, @returns its length
+        uint32_t encodeRr(uint32_t un_time_ms, uint16_t us_rr_ms, uint8_t uch_valid, uint8_t *puch_frame);
+
+        /**
+         * Encodes the next frame of a history transfer, starting at entry un_next.
+         * The first record of every frame is a keyframe.  The last frame is the
+         * VLINK_HISTORY_END frame.
+         * @param un_next  0 to start, moved past the entries encoded, and past any
+         *                 entry once the end frame is encoded
+         * @returns the length of the frame, 0 once the transfer is over
+         */
+        uint32_t encodeHistory(const VitalsHistory &history, uint32_t &un_next, uint8_t *puch_frame);
+
+        /** @{ Statistics since resetStats() */
+        uint32_t getRecords(void) const     { return mRecords; }
+        uint32_t getKeyframes(void) const   { return mKeyframes; }
+        uint32_t getFrames(void) const      { return mFrames; }
+        uint32_t getBytes(void) const       { return mBytes; }
+        uint32_t getAvgBatchWaitMs(void) const { return mBatched ? (uint32_t) (mBatchWaitMs / mBatched) : 0; }
+        void resetStats(void);
+        /** @} */
+
+    private:
+        /// Writes the record to puch_rec, @returns its length
+        uint32_t encodeRecord(const vitals_t &vitals, const vitals_t &prev, uint32_t un_time_ms,
+                              uint32_t un_prev_ms, bool b_key, uint8_t *puch_rec);
+        /// Adds the header and CRC around the payload, @returns the frame length
+        uint32_t frame(uint8_t uch_type, const uint8_t *puch_payload, uint32_t un_len, uint8_t *puch_frame);
+
+        uint32_t mKeyframeMs;      ///< Time between keyframes
+        uint32_t mBatchMs;         ///< Batch window
+        vitals_t mLast;            ///< Vitals of the last record
+        uint32_t mLastMs;          ///< Time of the last record
+        uint32_t mKeyMs;           ///< Time of the last keyframe
+        bool     mKeyDue;          ///< Next record is a keyframe
+        uint8_t  mSeq;             ///< Sequence number of the next frame
+
+        uint8_t  mBatch[VLINK_MAX_PAYLOAD];    ///< Records not sent yet
+        uint32_t mBatchLen;        ///< Bytes in mBatch
+        uint32_t mBatchFirstMs;    ///< Time of the first record of the batch
+        uint32_t mBatchRecords;    ///< Records in mBatch
+        uint64_t mBatchSumMs;      ///< Sum of their times
+
+        uint32_t mRecords;
+        uint32_t mKeyframes;
+        uint32_t mFrames;
+        uint32_t mBytes;
+        uint32_t mBatched;         ///< Records that went out of a batch
+        uint64_t mBatchWaitMs;     ///< Time they waited in the batch
+};
+
+/**
+ * Decoder of the frames, for the phone side and for the requests of the phone.
+ *
+ * Bytes are fed one at a time; the decoder looks for the SOF and checks the
+ * length and CRC, so it finds the next frame after noise or a lost byte.  A gap
+ * in the sequence numbers means a lost frame : the records that follow are
+ * changes to values that are not known, they are skipped up to the next keyframe.
+ *
+ * @code
+ *      if (decoder.feed(byte) && VLINK_LIVE == decoder.getType()) {
+ *          vlink_record_t r;
+ *          while (decoder.nextRecord(r)) {
+ *              show(r.vitals);
+ *          }
+ *      }
+ * @endcode
+ */
+class VitalsDecoder
+{
+    public:
+        VitalsDecoder() { reset(); }
+
+        /// Forgets the frame in progress, the values and the statistics
+        void reset(void);
+
+        /**
+         * Adds one received byte.  The records of the frame before that were not
+         * read are decoded first, so the values stay right.
+         * @returns true if the byte ended a valid frame
+         */
+        bool feed(uint8_t uch_byte);
+
+        /// @returns the type of the last valid frame
+        uint8_t getType(void) const { return mFrame[1]; }
+
+        /// Next record of a VLINK_LIVE or VLINK_HISTORY frame, @returns false at the end
+        bool nextRecord(vlink_record_t &record);
+
+        /// RR interval of a VLINK_RR frame, @returns false for other frames
+        bool getRr(vlink_rr_t &rr) const;
+
+        /// Records of a VLINK_HISTORY_END frame, @returns false for other frames
+        bool getHistoryCount(uint32_t &un_count) const;
+
+        /** @{ Statistics */
+        uint32_t getFrames(void) const       { return mFrames; }
+        uint32_t getCrcErrors(void) const    { return mCrcErrors; }
+        uint32_t getLostFrames(void) const   { return mLostFrames; }
+        uint32_t getSkippedRecords(void) const { return mSkipped; }
+        uint32_t getRecords(void) const      { return mRecords; }
+        /** @} */
+
+    private:
+        uint8_t  mFrame[VLINK_MAX_FRAME];  ///< Frame being received, or the last valid one
+        uint32_t mLen;             ///< Bytes of the frame received
+        uint32_t mRead;            ///< Payload bytes of the last frame decoded by nextRecord()
+        bool     mValid;           ///< mFrame holds a valid frame
+        bool     mSeqKnown;        ///< A frame was received, mSeq is its successor
+        uint8_t  mSeq;             ///< Expected sequence number
+
+        /** @{ Values of the live and history streams, not known until a keyframe */
+        vlink_record_t mLive;
+        vlink_record_t mHistory;
+        bool     mLiveKnown;
+        bool     mHistoryKnown;
+        /** @} */
+
+        uint32_t mFrames;
+        uint32_t mCrcErrors;
+        uint32_t mLostFrames;
+        uint32_t mSkipped;
+        uint32_t mRecords;
+};
+
+#ifdef TESTING
+#include <assert.h>
+#include <string.h>
+static inline void test_VitalsLink(void)
+{
+	static uint8_t auch_stream[16384];
+	uint8_t auch_frame[VLINK_MAX_FRAME];
+	vitals_t sent[200];
+	uint32_t aun_time[200];
+	uint32_t un_len = 0, un_frames = 0;
+	vlink_record_t rec;
+
+	// A CRC-16/CCITT-FALSE check value
+	assert(0x29B1 == vlink_crc16((const uint8_t *) "123456789", 9));
+
+	// Vitals every 100 msec for 20 sec, batched over 1 sec
+	VitalsEncoder enc;
+	enc.setBatchMs(1000);
+	vitals_t v = {{72, 97, 36, 0, 412, 530, 81}};
+	for(uint32_t t = 0; t < 200; t++)
+	{
+		v.an_value[VLINK_STEPS] += (t % 5 == 0) ? 1 : 0;
+		v.an_value[VLINK_HEART_RATE] += (t % 10 == 0) ? ((t % 20) ? 1 : -1) : 0;
+		v.an_value[VLINK_RMSSD_X10] -= (t % 30 == 0) ? 7000 : 0;
+		sent[t] = v;
+		aun_time[t] = 1000 + t * 100;
+		un_len += enc.addVitals(v, aun_time[t], auch_stream + un_len);
+		if(enc.flushDue(aun_time[t]))
+		{
+			un_len += enc.flush(aun_time[t], auch_stream + un_len);
+		}
+	}
+	un_len += enc.flush(aun_time[199], auch_stream + un_len);
+	assert(un_len < sizeof(auch_stream) / 2);
+	// Unchanged ticks are not sent, every second goes in about one frame
+	assert(enc.getRecords() < 200 && enc.getFrames() <= 25);
+	assert(enc.getKeyframes() == 4);
+
+	// Decoded records give the values sent at their time
+	VitalsDecoder dec;
+	uint32_t un_records = 0;
+	for(uint32_t i = 0; i < un_len; i++)
+	{
+		if(!dec.feed(auch_stream[i]))
+			continue;
+		un_frames++;
+		assert(VLINK_LIVE == dec.getType());
+		while(dec.nextRecord(rec))
+		{
+			const uint32_t t = (rec.un_time_ms - 1000) / 100;
+			assert(t < 200 && aun_time[t] == rec.un_time_ms && !rec.b_history);
+			assert(0 == memcmp(&rec.vitals, &sent[t], sizeof(vitals_t)));
+			un_records++;
+		}
+	}
+	assert(un_frames == enc.getFrames() && un_records == enc.getRecords());
+	assert(0 == dec.getCrcErrors() && 0 == dec.getLostFrames());
+
+	// A lost frame and a bad byte : the records are skipped until the next keyframe
+	const uint32_t un_second = 4 + auch_stream[3] + 2;
+	const uint32_t un_third = un_second + 4 + auch_stream[un_second + 3] + 2;
+	auch_stream[un_third + 6] ^= 0x10;
+	VitalsDecoder lossy;
+	for(uint32_t i = 0; i < un_len; i++)
+	{
+		if(i >= un_second && i < un_third)
+			continue;
+		if(lossy.feed(auch_stream[i]))
+		{
+			while(lossy.nextRecord(rec))
+			{
+				// the first frame, then nothing before the keyframe at 6 sec
+				const uint32_t t = (rec.un_time_ms - 1000) / 100;
+				assert(rec.un_time_ms <= 2000 || rec.un_time_ms >= 6000);
+				assert(0 == memcmp(&rec.vitals, &sent[t], sizeof(vitals_t)));
+			}
+		}
+	}
+	assert(lossy.getCrcErrors() >= 1 && lossy.getLostFrames() >= 1 && lossy.getSkippedRecords() > 0);
+
+	// RR interval
+	VitalsDecoder rr_dec;
+	vlink_rr_t rr;
+	un_len = enc.encodeRr(123456, 812, 1, auch_frame);
+	for(uint32_t i = 0; i < un_len; i++)
+	{
+		assert(rr_dec.feed(auch_frame[i]) == (i + 1 == un_len));
+	}
+	assert(rr_dec.getRr(rr) && 123456 == rr.un_time_ms && 812 == rr.us_rr_ms && 1 == rr.uch_valid);
+
+	// History : one entry per period, the oldest ones are dropped
+	VitalsHistory hist;
+	for(uint32_t m = 0; m < VLINK_HISTORY_DEPTH + 10; m++)
+	{
+		assert(hist.add(sent[m], m * VLINK_HISTORY_PERIOD_MS));
+		assert(!hist.add(sent[m], m * VLINK_HISTORY_PERIOD_MS + 1000));
+	}
+	assert(VLINK_HISTORY_DEPTH == hist.getCount());
+	uint32_t un_next = 0, un_count = 0, un_end = 0;
+	un_records = 0;
+	VitalsDecoder hist_dec;
+	while(0 != (un_len = enc.encodeHistory(hist, un_next, auch_frame)))
+	{
+		for(uint32_t i = 0; i < un_len; i++)
+		{
+			if(hist_dec.feed(auch_frame[i]) && hist_dec.getHistoryCount(un_count))
+				un_end++;
+		}
+		while(hist_dec.nextRecord(rec))
+		{
+			assert(rec.b_history && rec.un_time_ms == (un_records + 10) * VLINK_HISTORY_PERIOD_MS);
+			assert(0 == memcmp(&rec.vitals, &sent[un_records + 10], sizeof(vitals_t)));
+			un_records++;
+		}
+	}
+	assert(1 == un_end && VLINK_HISTORY_DEPTH == un_count && VLINK_HISTORY_DEPTH == un_records);
+	assert(0 == hist_dec.getLostFrames());
+}
+#endif /* #ifdef TESTING */
+
+#endif /* L5_APPLICATION_VITALS_LINK_HPP_ */
+/*===================================================================
+// $Log: $1.0 Binary framing of the vitals for the Bluetooth link
+//
+//--------------------------------------------------------------------*/
@@ -0,0 +1,341 @@
+/*****************************************************************************
+$Work file     : widgets.cpp $
+Description    : This file contains the retained mode widgets of the display
+Project(s)     : Smart Health Gear
+Compiler       : Cross ARM GCC
+OS			   : RTOS
+Original Author: $ Aniket Dali
+$Author        : $ agent
+$Date          : $ 17 Oct 2026
+$Revision      : 1.0 $
+*****************************************************************************/
+
+/****************************************************************************/
+/*                       INCLUDE FILES                                      */
+/****************************************************************************/
+#include <stdio.h>
+#include "widgets.hpp"
+
+
+/*----------------------------------------------------------------------------
+Function    :  DamageList::add ()
+Inputs      :  x, y, w, h - rectangle of the screen
+Processing  :  This function clips the rectangle to the screen and merges it
+			   with every rectangle of the list it overlaps or touches. If the
+			   list is full, all rectangles become their bounding box.
+Outputs     :  None
+Returns     :  None
+Notes       :  None
+----------------------------------------------------------------------------*/
+void DamageList::add(int16_t x, int16_t y, int16_t w, int16_t h)
+{
+	if(x < 0) { w += x; x = 0; }
+	if(y < 0) { h += y; y = 0; }
+	if(x + w > WIDGET_SCREEN_WIDTH)  w = WIDGET_SCREEN_WIDTH - x;
+	if(y + h > WIDGET_SCREEN_HEIGHT) h = WIDGET_SCREEN_HEIGHT - y;
+	if((w <= 0) || (h <= 0)) return;
+
+	int16_t x1 = x + w, y1 = y + h;
+	uint32_t i = 0;
+	while(i < mCount)
+	{
+		const widget_rect_t &r = mRects[i];
+		const bool b_full = (WIDGET_MAX_DAMAGE == mCount);
+		if(b_full || (x <= r.x + r.w && r.x <= x1 && y <= r.y + r.h && r.y <= y1))
+		{
+			// the union may touch a rectangle seen before, start again
+			x1 = (r.x + r.w > x1) ? (r.x + r.w) : x1;
+			y1 = (r.y + r.h > y1) ? (r.y + r.h) : y1;
+			x  = (r.x < x) ? r.x : x;
+			y  = (r.y < y) ? r.y : y;
+			mRects[i] = mRects[--mCount];
+			i = b_full ? i : 0;
+		}
+		else
+		{
+			i++;
+		}
+	}
+	widget_rect_t &added = mRects[mCount++];
+	added.x = x;
+	added.y = y;
+	added.w = x1 - x;
+	added.h = y1 - y;
+}
+
+/*----------------------------------------------------------------------------
+Function    :  DamageList::pop ()
+Inputs      :  None
+Processing  :  This function takes the last rectangle out of the list
+Outputs     :  rect - the rectangle
+Returns     :  false if the list is empty
+Notes       :  None
+----------------------------------------------------------------------------*/
+bool DamageList::pop(widget_rect_t &rect)
+{
+	if(0 == mCount)
+	{
+		return false;
+	}
+	rect = mRects[--mCount];
+	return true;
+}
+
+/*----------------------------------------------------------------------------
+Function    :  Widget (Constructor)
+Inputs      :  x, y, w, h - bounds on the screen
+Processing  :  None
+Outputs     :  None
+Returns     :  None
+Notes       :  The widget damages nothing until a screen sets its damage list
+----------------------------------------------------------------------------*/
+Widget::Widget(int16_t x, int16_t y, int16_t w, int16_t h) :
+		mpDamage(0)
+{
+	mBounds.x = x;
+	mBounds.y = y;
+	mBounds.w = w;
+	mBounds.h = h;
+}
+
+void Widget::damage(int16_t x, int16_t y, int16_t w, int16_t h)
+{
+	if(mpDamage)
+	{
+		mpDamage->add(x, y, w, h);
+	}
+}
+
+bool Widget::clip(const widget_rect_t &area, widget_rect_t &part) const
+{
+	const int16_t x1 = (mBounds.x + mBounds.w < area.x + area.w) ? (mBounds.x + mBounds.w) : (area.x + area.w);
+	const int16_t y1 = (mBounds.y + mBounds.h < area.y + area.h) ? (mBounds.y + mBounds.h) : (area.y + area.h);
+	part.x = (mBounds.x > area.x) ? mBounds.x : area.x;
+	part.y = (mBounds.y > area.y) ? mBounds.y : area.y;
+	part.w = x1 - part.x;
+	part.h = y1 - part.y;
+	return (part.w > 0) && (part.h > 0);
+}
+
+/*----------------------------------------------------------------------------
+Function    :  BoxWidget::render ()
+Inputs      :  area - rectangle of the screen in pBuf, text - not used
+Processing  :  This function fills the part of the box inside the area
+Outputs     :  pBuf - pixels of the area
+Returns     :  None
+Notes       :  None
+----------------------------------------------------------------------------*/
+void BoxWidget::render(const widget_rect_t &area, uint16_t *pBuf, TextRaster &text)
+{
+	widget_rect_t part;
+	if(!clip(area, part))
+	{
+		return;
+	}
+	pBuf += (part.y - area.y) * area.w + (part.x - area.x);
+	for(int16_t j = 0; j < part.h; j++, pBuf += area.w)
+	{
+		for(int16_t i = 0; i < part.w; i++)
+		{
+			pBuf[i] = mColor;
+		}
+	}
+}
+
+/*----------------------------------------------------------------------------
+Function    :  TextField (Constructor)
+Inputs      :  x, y - top left, size - scale, color - text color,
+			   maxChars - characters of the bounds, pText - first text,
+			   bg - background of the cells
+Processing  :  This function sizes the bounds for maxChars characters
+Outputs     :  None
+Returns     :  None
+Notes       :  None
+----------------------------------------------------------------------------*/
+TextField::TextField(int16_t x, int16_t y, uint8_t size, uint16_t color, uint8_t maxChars,
+                     const char *pText, uint16_t bg) :
+		Widget(x, y, (maxChars - 1) * TextRaster::getAdvance(size) + 6 * size, 8 * size),
+		mSize(size),
+		mMaxChars((maxChars > WIDGET_MAX_CHARS) ? WIDGET_MAX_CHARS : maxChars),
+		mColor(color),
+		mBg(bg)
+{
+	for(uint32_t i = 0; i <= WIDGET_MAX_CHARS; i++)
+	{
+		mText[i] = 0;
+	}
+	setText(pText);
+}
+
+/*----------------------------------------------------------------------------
+Function    :  TextField::setText ()
+Inputs      :  pText - new text
+Processing  :  This function compares the new text with the last one and
+			   damages the cell of every character that changed
+Outputs     :  None
+Returns     :  None
+Notes       :  A shorter text damages the cells it no longer covers
+----------------------------------------------------------------------------*/
+void TextField::setText(const char *pText)
+{
+	const int16_t n_advance = TextRaster::getAdvance(mSize);
+	bool b_end = false;
+
+	for(uint32_t i = 0; i < mMaxChars; i++)
+	{
+		const char c = b_end ? 0 : pText[i];
+		b_end = (0 == c);
+		if(mText[i] != c)
+		{
+			mText[i] = c;
+			damage(mBounds.x + i * n_advance, mBounds.y, 6 * mSize, mBounds.h);
+		}
+	}
+}
+
+/*----------------------------------------------------------------------------
+Function    :  TextField::render ()
+Inputs      :  area - rectangle of the screen in pBuf, text - rasteriser
+Processing  :  This function renders the part of the text inside the area
+Outputs     :  pBuf - pixels of the area
+Returns     :  None
+Notes       :  The cells cover the widgets before, like drawString() did
+----------------------------------------------------------------------------*/
+void TextField::render(const widget_rect_t &area, uint16_t *pBuf, TextRaster &text)
+{
+	widget_rect_t part;
+	if(!clip(area, part))
+	{
+		return;
+	}
+	const int16_t n_offset = (part.y - area.y) * area.w + (part.x - area.x);
+	text.renderRows(mText, mSize, mColor, mBg, part.x - mBounds.x, part.y - mBounds.y,
+	                part.w, part.h, area.w, pBuf + n_offset);
+}
+
+/*----------------------------------------------------------------------------
+Function    :  NumberField::setValue ()
+Inputs      :  value - number to show
+Processing  :  This function writes the number in decimal into the field
+Outputs     :  None
+Returns     :  None
+Notes       :  None
+----------------------------------------------------------------------------*/
+void NumberField::setValue(int32_t value)
+{
+	char ach_text[12];
+	mValue = value;
+	snprintf(ach_text, sizeof(ach_text), "%ld", (long) value);
+	setText(ach_text);
+}
+
+/*----------------------------------------------------------------------------
+Function    :  IconWidget (Constructor)
+Inputs      :  x, y - top left, size - scale, color - color of the set bits,
+			   pRows - one 16 bit word per row, cols / rows - bitmap size
+Processing  :  None
+Outputs     :  None
+Returns     :  None
+Notes       :  The icon starts hidden
+----------------------------------------------------------------------------*/
+IconWidget::IconWidget(int16_t x, int16_t y, uint8_t size, uint16_t color,
+                       const uint16_t *pRows, uint8_t cols, uint8_t rows) :
+		Widget(x, y, cols * size, rows * size),
+		mpRows(pRows),
+		mSize(size),
+		mVisible(false),
+		mColor(color)
+{
+}
+
+void IconWidget::setVisible(bool visible)
+{
+	if(mVisible != visible)
+	{
+		mVisible = visible;
+		invalidate();
+	}
+}
+
+/*----------------------------------------------------------------------------
+Function    :  IconWidget::render ()
+Inputs      :  area - rectangle of the screen in pBuf, text - not used
+Processing  :  This function draws the set bits of the bitmap inside the area
+Outputs     :  pBuf - pixels of the area
+Returns     :  None
+Notes       :  Nothing is drawn while hidden
+----------------------------------------------------------------------------*/
+void IconWidget::render(const widget_rect_t &area, uint16_t *pBuf, TextRaster &text)
+{
+	widget_rect_t part;
+	if(!mVisible || !clip(area, part))
+	{
+		return;
+	}
+	pBuf += (part.y - area.y) * area.w + (part.x - area.x);
+	for(int16_t j = 0; j < part.h; j++, pBuf += area.w)
+	{
+		const uint16_t us_row = mpRows[(part.y - mBounds.y + j) / mSize];
+		for(int16_t i = 0; i < part.w; i++)
+		{
+			if((us_row >> ((part.x - mBounds.x + i) / mSize)) & 1)
+			{
+				pBuf[i] = mColor;
+			}
+		}
+	}
+}
+
+/*----------------------------------------------------------------------------
+Function    :  WidgetScreen (Constructor)
+Inputs      :  ppWidgets - widgets in drawing order, count - number of
+			   widgets, bg - background color
+Processing  :  This function gives the damage list of the screen to the widgets
+Outputs     :  None
+Returns     :  None
+Notes       :  None
+----------------------------------------------------------------------------*/
+WidgetScreen::WidgetScreen(Widget **ppWidgets, uint32_t count, uint16_t bg) :
+		mppWidgets(ppWidgets),
+		mCount(count),
+		mBg(bg)
+{
+	for(uint32_t i = 0; i < mCount; i++)
+	{
+		mppWidgets[i]->setDamageList(&mDamage);
+	}
+}
+
+void WidgetScreen::invalidate(void)
+{
+	for(uint32_t i = 0; i < mCount; i++)
+	{
+		mppWidgets[i]->invalidate();
+	}
+}
+
+/*----------------------------------------------------------------------------
+Function    :  WidgetScreen::render ()
+Inputs      :  area - rectangle of the screen, text - rasteriser
+Processing  :  This function fills the background and draws the widgets that
+			   are inside the area, in order
+Outputs     :  pBuf - area.w * area.h pixels
+Returns     :  None
+Notes       :  None
+----------------------------------------------------------------------------*/
+void WidgetScreen::render(const widget_rect_t &area, uint16_t *pBuf, TextRaster &text)
+{
+	const uint32_t un_pixels = (uint32_t) area.w * area.h;
+	for(uint32_t i = 0; i < un_pixels; i++)
+	{
+		pBuf[i] = mBg;
+	}
+	for(uint32_t i = 0; i < mCount; i++)
+	{
+		mppWidgets[i]->render(area, pBuf, text);
+	}
+}
+/*===================================================================
+// $Log: $1.0 Retained mode widgets with damage tracking
+//
+//--------------------------------------------------------------------*/
@@ -0,0 +1,271 @@
+/*****************************************************************************
+$Work file     : widgets.hpp $
+Description    : This file contains the retained mode widgets of the display
+Project(s)     : Smart Health Gear
+Compiler       : Cross ARM GCC
+OS			   : RTOS
+Original Author: $ Aniket Dali
+$Author        : $ agent
+$Date          : $ 17 Oct 2026
+$Revision      : 1.0 $
+*****************************************************************************/
+#ifndef L5_APPLICATION_WIDGETS_HPP_
+#define L5_APPLICATION_WIDGETS_HPP_
+
+/****************************************************************************/
+/*                       INCLUDE FILES                                      */
+/****************************************************************************/
+#include <stdint.h>
+#include "text_raster.hpp"
+
+/****************************************************************************/
+/*                        MACRO Definitions                                 */
+/****************************************************************************/
+#define WIDGET_SCREEN_WIDTH        (240)
+#define WIDGET_SCREEN_HEIGHT       (320)
+// Damaged rectangles kept apart, more are merged into one
+#define WIDGET_MAX_DAMAGE          (16)
+// Characters of a text or number field
+#define WIDGET_MAX_CHARS           (15)
+
+/****************************************************************************/
+/*                        Type Definitions                                  */
+/****************************************************************************/
+typedef struct {
+	int16_t x;
+	int16_t y;
+	int16_t w;
+	int16_t h;
+} widget_rect_t;
+
+/****************************************************************************/
+/*                       Class declarations                                 */
+/****************************************************************************/
+/**
+ * Rectangles of the screen to repaint.  A rectangle that overlaps or touches
+ * one in the list is merged with it, so the cells of a number that changed
+ * become one rectangle.
+ */
+class DamageList
+{
+    public:
+        DamageList() : mCount(0) { }
+
+        /// Adds a rectangle, clipped to the screen
+        void add(int16_t x, int16_t y, int16_t w, int16_t h);
+        /// Takes a rectangle out of the list, false if there is none
+        bool pop(widget_rect_t &rect);
+
+        uint32_t getCount(void) const { return mCount; }
+        void clear(void)              { mCount = 0; }
+
+    private:
+        widget_rect_t mRects[WIDGET_MAX_DAMAGE];
+        uint32_t mCount;
+};
+
+/**
+ * A widget keeps what it shows and damages the part of the screen that has to
+ * change.  The screen repaints the damage at the end of the frame by asking
+ * every widget to draw itself over the background of the damaged rectangle.
+ */
+class Widget
+{
+    public:
+        Widget(int16_t x, int16_t y, int16_t w, int16_t h);
+        virtual ~Widget() { }
+
+        const widget_rect_t& getBounds(void) const  { return mBounds; }
+        void setDamageList(DamageList *pDamage)     { mpDamage = pDamage; }
+        /// Damages the whole widget
+        void invalidate(void) { damage(mBounds.x, mBounds.y, mBounds.w, mBounds.h); }
+
+        /**
+         * Draws the part of the widget that is inside the area
+         * @param area  the rectangle of the screen that is in pBuf
+         * @param pBuf  area.w * area.h pixels with the background already in
+         * @param text  the text rasteriser of the display
+         */
+        virtual void render(const widget_rect_t &area, uint16_t *pBuf, TextRaster &text) = 0;
+
+    protected:
+        void damage(int16_t x, int16_t y, int16_t w, int16_t h);
+        /// Intersection of the bounds and the area, false if empty
+        bool clip(const widget_rect_t &area, widget_rect_t &part) const;
+
+        widget_rect_t mBounds;
+
+    private:
+        DamageList *mpDamage;
+};
+
+/// Rectangle of one color, the lines of the sensor screen
+class BoxWidget : public Widget
+{
+    public:
+        BoxWidget(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) :
+            Widget(x, y, w, h), mColor(color) { }
+        void render(const widget_rect_t &area, uint16_t *pBuf, TextRaster &text);
+
+    private:
+        uint16_t mColor;
+};
+
+/// Opaque text of the 5x7 font, only the cells of the characters that change are damaged
+class TextField : public Widget
+{
+    public:
+        TextField(int16_t x, int16_t y, uint8_t size, uint16_t color, uint8_t maxChars,
+                  const char *pText = "", uint16_t bg = 0);
+
+        /// Sets the text, longer text is cut to the maximum characters
+        void setText(const char *pText);
+        const char* getText(void) const { return mText; }
+        void render(const widget_rect_t &area, uint16_t *pBuf, TextRaster &text);
+
+    private:
+        char mText[WIDGET_MAX_CHARS + 1];   ///< Last text, zeros up to the end
+        uint8_t mSize;
+        uint8_t mMaxChars;
+        uint16_t mColor;
+        uint16_t mBg;
+};
+
+/// Decimal number in a text field
+class NumberField : public TextField
+{
+    public:
+        NumberField(int16_t x, int16_t y, uint8_t size, uint16_t color, uint8_t maxChars) :
+            TextField(x, y, size, color, maxChars, "0"), mValue(0) { }
+
+        void setValue(int32_t value);
+        int32_t getValue(void) const { return mValue; }
+
+    private:
+        int32_t mValue;
+};
+
+/// Bitmap of up to 16 x 16 bits shown or hidden, bit 0 of a row is the left pixel
+class IconWidget : public Widget
+{
+    public:
+        IconWidget(int16_t x, int16_t y, uint8_t size, uint16_t color,
+                   const uint16_t *pRows, uint8_t cols, uint8_t rows);
+
+        void setVisible(bool visible);
+        bool isVisible(void) const { return mVisible; }
+        void render(const widget_rect_t &area, uint16_t *pBuf, TextRaster &text);
+
+    private:
+        const uint16_t *mpRows;
+        uint8_t mSize;
+        bool mVisible;
+        uint16_t mColor;
+};
+
+/**
+ * The widgets of one screen and its damage.  Widgets drawn later cover the
+ * ones before them.
+ */
+class WidgetScreen
+{
+    public:
+        WidgetScreen(Widget **ppWidgets, uint32_t count, uint16_t bg);
+
+        /// Damages all widgets, when the screen is shown again
+        void invalidate(void);
+        /// Takes the next rectangle to repaint, false if there is none
+        bool popDamage(widget_rect_t &rect) { return mDamage.pop(rect); }
+        /// Renders the background and the widgets of an area of the screen
+        void render(const widget_rect_t &area, uint16_t *pBuf, TextRaster &text);
+
+    private:
+        Widget **mppWidgets;
+        uint32_t mCount;
+        uint16_t mBg;
+        DamageList mDamage;
+};
+
+#ifdef TESTING
+#include <assert.h>
+#include <string.h>
+static inline void test_Widgets(void)
+{
+	static unsigned char auch_font[256 * 5];
+	static uint16_t aus_screen[WIDGET_SCREEN_HEIGHT][WIDGET_SCREEN_WIDTH];
+	static uint16_t aus_full[WIDGET_SCREEN_HEIGHT * WIDGET_SCREEN_WIDTH];
+	static uint16_t aus_strip[WIDGET_SCREEN_HEIGHT * WIDGET_SCREEN_WIDTH];
+	static const uint16_t aus_icon[3] = { 0x5, 0x2, 0x5 };
+	uint32_t seed = 9;
+	for(int i = 0; i < 256 * 5; i++)
+	{
+		seed = seed * 1103515245 + 12345;
+		auch_font[i] = (uint8_t)(seed >> 16);
+	}
+	TextRaster raster(auch_font);
+
+	// merging : cells that touch become one, apart ones stay apart
+	DamageList damage;
+	widget_rect_t rect;
+	damage.add(10, 10, 12, 16);
+	damage.add(20, 10, 12, 16);
+	damage.add(100, 100, 5, 5);
+	damage.add(-5, 315, 10, 10);
+	assert(3 == damage.getCount());
+	for(int i = 0; i < 40; i++)
+		damage.add(i * 6, 200, 2, 2);
+	assert(damage.getCount() <= WIDGET_MAX_DAMAGE);
+	damage.clear();
+
+	BoxWidget line(5, 0, 1, 250, 0xFFFF);
+	TextField label(12, 20, 2, 0xFFE0, 10, "Heart Rate");
+	NumberField number(148, 20, 2, 0xFFE0, 8);
+	IconWidget icon(120, 20, 2, 0xF800, aus_icon, 3, 3);
+	TextField comma(120, 130, 3, 0x07E0, 1, ",");
+	TextField date(10, 130, 3, 0x07E0, 8, " Oct 17 ");
+	Widget *ap_widgets[] = { &line, &label, &number, &icon, &date, &comma };
+	WidgetScreen screen(ap_widgets, 6, 0);
+
+	const int32_t an_values[] = { 72, 73, 73, 108, 9, -12, 1234567 };
+	const int n_values = sizeof(an_values) / sizeof(an_values[0]);
+	// the screen is cleared to the background when it is shown
+	memset(aus_screen, 0, sizeof(aus_screen));
+	screen.invalidate();
+	for(int v = -1; v < n_values; v++)
+	{
+		if(v >= 0)
+		{
+			number.setValue(an_values[v]);
+			icon.setVisible(an_values[v] > 100);
+			date.setText((an_values[v] < 0) ? " Nov 18 " : " Oct 17 ");
+		}
+
+		uint32_t un_pixels = 0;
+		while(screen.popDamage(rect))
+		{
+			screen.render(rect, aus_strip, raster);
+			for(int16_t j = 0; j < rect.h; j++)
+				memcpy(&aus_screen[rect.y + j][rect.x], &aus_strip[j * rect.w], 2 * rect.w);
+			un_pixels += rect.w * rect.h;
+		}
+
+		// the repainted screen is the same as a full render
+		const widget_rect_t full = { 0, 0, WIDGET_SCREEN_WIDTH, WIDGET_SCREEN_HEIGHT };
+		screen.render(full, aus_full, raster);
+		assert(0 == memcmp(aus_full, aus_screen, sizeof(aus_full)));
+
+		// 72 to 73 repaints one cell, 73 again repaints nothing
+		if(1 == v)
+			assert(6 * 2 * 8 * 2 == un_pixels);
+		if(2 == v)
+			assert(0 == un_pixels);
+	}
+	assert(0 == strcmp("1234567", number.getText()));
+}
+#endif /* #ifdef TESTING */
+
+#endif /* L5_APPLICATION_WIDGETS_HPP_ */
+/*===================================================================
+// $Log: $1.0 Retained mode widgets with damage tracking
+//
+//--------------------------------------------------------------------*/
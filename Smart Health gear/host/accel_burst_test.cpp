@@ -0,0 +1,124 @@
+/*****************************************************************************
+$Work file     : accel_burst_test.cpp $
+Description    : Host test of the accelerometer reads : per-axis reads against
+				 the XYZ burst on a simulated MMA8452Q, counting I2C transactions
+Project(s)     : Smart Health Gear
+Compiler       : GCC (PC)
+OS			   : Linux (host)
+Original Author: $ agent
+$Author        : $ agent
+$Date          : $ 17 Oct 2026
+$Revision      : 1.0 $
+
+Acceleration_Sensor (L4_IO/src/acceleration_sensor.cpp) is built unchanged
+against the fake I2C2 bus of fake/i2c_base.hpp.
+*****************************************************************************/
+
+/****************************************************************************/
+/*                       INCLUDE FILES                                      */
+/****************************************************************************/
+#include <stdio.h>
+#include <assert.h>
+#include "acceleration_sensor.hpp"
+
+/****************************************************************************/
+/*                       Class declarations                                 */
+/****************************************************************************/
+/**
+ * MMA8452Q registers : the axes are 12 bit values, left justified in an MSB and
+ * an LSB register, and reads auto-increment from 0x06 back to 0x00.
+ */
+class FakeMma8452 : public I2C_Base::Device
+{
+    public:
+        FakeMma8452() : mCtrlReg1(0)
+        {
+            setSample(0, 0, 0);
+        }
+
+        /// A new conversion, each axis from -2048 to 2047
+        void setSample(int16_t x, int16_t y, int16_t z)
+        {
+            const int16_t axes[3] = { x, y, z };
+            for (int i = 0; i < 3; i++) {
+                const uint16_t left = (uint16_t) (axes[i] * 16);
+                mData[1 + 2 * i] = (uint8_t) (left >> 8);
+                mData[2 + 2 * i] = (uint8_t) left;
+            }
+            mData[0] = 0x0F;    // STATUS : new X, Y, Z
+        }
+
+        uint8_t readByte(uint8_t reg)
+        {
+            if (reg <= 6) {
+                return mData[reg];
+            }
+            return (0x0D == reg) ? 0x2A : (0x2A == reg) ? mCtrlReg1 : 0;
+        }
+
+        void writeByte(uint8_t reg, uint8_t value)
+        {
+            if (0x2A == reg) {
+                mCtrlReg1 = value;
+            }
+        }
+
+        uint8_t nextReg(uint8_t reg) { return (6 == reg) ? 0 : reg + 1; }
+
+        uint8_t mCtrlReg1;
+
+    private:
+        uint8_t mData[7];
+};
+
+int main(void)
+{
+    I2C2 &bus = I2C2::getInstance();
+    Acceleration_Sensor &sensor = Acceleration_Sensor::getInstance();
+    FakeMma8452 mma;
+    const uint32_t un_samples = 1000;
+    uint32_t un_seed = 11, un_start;
+    int16_t xyz[3];
+
+    bus.attach(I2CAddr_AccelerationSensor, &mma);
+
+    // Active mode at 100 Hz, then WHO_AM_I
+    un_start = bus.getTransferCount();
+    assert(sensor.init() && 0x19 == mma.mCtrlReg1);
+    assert(2 == bus.getTransferCount() - un_start);
+
+    uint32_t un_per_axis = 0, un_burst = 0;
+    for (uint32_t n = 0; n < un_samples; n++)
+    {
+        un_seed = un_seed * 1103515245 + 12345;
+        const int16_t x = (int16_t) ((un_seed >> 4) % 4096) - 2048;
+        const int16_t y = (int16_t) ((un_seed >> 12) % 4096) - 2048;
+        const int16_t z = (int16_t) ((un_seed >> 20) % 4096) - 2048;
+        mma.setSample(x, y, z);
+
+        // Before : one transaction per axis, as the step counter read them
+        un_start = bus.getTransferCount();
+        assert(x == sensor.getX() && y == sensor.getY() && z == sensor.getZ());
+        un_per_axis += bus.getTransferCount() - un_start;
+
+        // After : X_MSB to Z_LSB in one burst
+        un_start = bus.getTransferCount();
+        assert(sensor.getXYZ(xyz));
+        un_burst += bus.getTransferCount() - un_start;
+        assert(x == xyz[0] && y == xyz[1] && z == xyz[2]);
+    }
+    assert(3 * un_samples == un_per_axis && un_samples == un_burst);
+
+    // No ACK : the burst fails and gives zeros
+    bus.attach(I2CAddr_AccelerationSensor, NULL);
+    un_start = bus.getTransferCount();
+    assert(!sensor.getXYZ(xyz) && 0 == xyz[0] && 0 == xyz[1] && 0 == xyz[2]);
+    assert(1 == bus.getTransferCount() - un_start);
+
+    // The step counter used to read 49 to 50 samples per 100 msec, one sample
+    // per 10 msec tick is read now
+    printf("%u samples : %u I2C transactions per axis, %u by burst; step counter %u -> %u transactions per 100 msec\n",
+           un_samples, un_per_axis, un_burst, 3 * 50, 10 * un_burst / un_samples);
+    printf("accel_burst_test passed\n");
+    return 0;
+}
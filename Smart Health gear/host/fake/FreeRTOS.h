@@ -0,0 +1,29 @@
+/*****************************************************************************
+$Work file     : FreeRTOS.h $
+Description    : Host stand-in for the FreeRTOS types used by the board
+				 drivers built on the host
+Project(s)     : Smart Health Gear
+Compiler       : GCC (PC)
+OS			   : Linux (host)
+Original Author: $ agent
+$Author        : $ agent
+$Date          : $ 17 Oct 2026
+$Revision      : 1.0 $
+*****************************************************************************/
+#ifndef INC_FREERTOS_H
+#define INC_FREERTOS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef long          BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint32_t      TickType_t;
+
+#define pdFALSE        ((BaseType_t) 0)
+#define pdTRUE         ((BaseType_t) 1)
+#define portMAX_DELAY  ((TickType_t) 0xffffffffUL)
+
+#define portEND_SWITCHING_ISR(xSwitchRequired)  ((void) (xSwitchRequired))
+
+#endif /* INC_FREERTOS_H */
@@ -0,0 +1,62 @@
+/*****************************************************************************
+$Work file     : LPC17xx.h $
+Description    : Host stand-in for the CMSIS device header : the SSP0 and
+				 system control registers used by the LCD driver
+Project(s)     : Smart Health Gear
+Compiler       : GCC (PC)
+OS			   : Linux (host)
+Original Author: $ agent
+$Author        : $ agent
+$Date          : $ 17 Oct 2026
+$Revision      : 1.0 $
+
+Writes to SSP0 DR go to the LCD of fake/lcd_bus.hpp.  The status register
+always reads as transmit FIFO not full, not busy and receive FIFO empty.
+*****************************************************************************/
+#ifndef LPC17XX_H_
+#define LPC17XX_H_
+
+/****************************************************************************/
+/*                       INCLUDE FILES                                      */
+/****************************************************************************/
+#include <stdint.h>
+
+/****************************************************************************/
+/*                       Type Definitions                                   */
+/****************************************************************************/
+/// SSP data register : a write sends a frame, a read returns the (empty) RX FIFO
+class FakeSspData
+{
+    public:
+        FakeSspData& operator=(uint32_t frame);
+        operator uint32_t() const { return 0; }
+};
+
+typedef struct
+{
+    volatile uint32_t CR0;
+    volatile uint32_t CR1;
+    FakeSspData       DR;
+    volatile uint32_t SR;
+    volatile uint32_t CPSR;
+    volatile uint32_t IMSC;
+    volatile uint32_t RIS;
+    volatile uint32_t MIS;
+    volatile uint32_t ICR;
+    volatile uint32_t DMACR;
+} LPC_SSP_TypeDef;
+
+typedef struct
+{
+    volatile uint32_t PCONP;
+    volatile uint32_t PCLKSEL0;
+    volatile uint32_t PCLKSEL1;
+} LPC_SC_TypeDef;
+
+extern LPC_SSP_TypeDef fake_ssp0;
+extern LPC_SC_TypeDef  fake_sc;
+
+#define LPC_SSP0  (&fake_ssp0)
+#define LPC_SC    (&fake_sc)
+
+#endif /* LPC17XX_H_ */
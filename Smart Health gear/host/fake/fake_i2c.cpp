@@ -0,0 +1,30 @@
+/*****************************************************************************
+$Work file     : fake_i2c.cpp $
+Description    : Host stand-ins for the I2C1 and I2C2 drivers, on the fake bus
+				 of fake/i2c_base.hpp
+Project(s)     : Smart Health Gear
+Compiler       : GCC (PC)
+OS			   : Linux (host)
+Original Author: $ agent
+$Author        : $ agent
+$Date          : $ 17 Oct 2026
+$Revision      : 1.0 $
+*****************************************************************************/
+
+/****************************************************************************/
+/*                       INCLUDE FILES                                      */
+/****************************************************************************/
+#include "i2c2.hpp"
+
+/****************************************************************************/
+/*                       Function definitions                               */
+/****************************************************************************/
+I2C2::I2C2() : I2C_Base()
+{
+}
+
+bool I2C2::init(unsigned int speedInKhz)
+{
+    (void) speedInKhz;
+    return true;
+}
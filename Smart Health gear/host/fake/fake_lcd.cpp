@@ -0,0 +1,251 @@
+/*****************************************************************************
+$Work file     : fake_lcd.cpp $
+Description    : Host stand-ins for SSP0, its DMA, GPIO and the semaphores used
+				 by the LCD driver, and the LCD of fake/lcd_bus.hpp
+Project(s)     : Smart Health Gear
+Compiler       : GCC (PC)
+OS			   : Linux (host)
+Original Author: $ agent
+$Author        : $ agent
+$Date          : $ 17 Oct 2026
+$Revision      : 1.0 $
+*****************************************************************************/
+
+/****************************************************************************/
+/*                       INCLUDE FILES                                      */
+/****************************************************************************/
+#include "LPC17xx.h"
+#include "ssp0.h"
+#include "task.h"
+#include "semphr.h"
+#include "lcd_bus.hpp"
+extern "C"
+{
+	#include "gpio.h"
+}
+
+/****************************************************************************/
+/*                        MACRO Definitions                                 */
+/****************************************************************************/
+// ILI9340 commands decoded by the bus
+#define LCD_CASET   (0x2A)
+#define LCD_PASET   (0x2B)
+#define LCD_RAMWR   (0x2C)
+
+/****************************************************************************/
+/*                        VARIABLES                                         */
+/****************************************************************************/
+// SR : transmit FIFO empty and not full
+LPC_SSP_TypeDef fake_ssp0 = { 0, 0, FakeSspData(), 0x03, 0, 0, 0, 0, 0, 0 };
+LPC_SC_TypeDef  fake_sc;
+BaseType_t      fake_scheduler_state = taskSCHEDULER_RUNNING;
+LcdBus          lcd_bus;
+
+struct FakeSemaphore
+{
+    bool given;
+};
+
+static uint32_t dma_transfers = 0;
+
+/****************************************************************************/
+/*                       Function definitions                               */
+/****************************************************************************/
+void LcdBus::reset(uint16_t fill)
+{
+    for (int16_t y = 0; y < kHeight; y++) {
+        for (int16_t x = 0; x < kWidth; x++) {
+            mFrame[y][x] = fill;
+        }
+    }
+    mCsLow = false;
+    mDcHigh = false;
+    mCommand = 0;
+    mParamCount = 0;
+    mX0 = mY0 = 0;
+    mX1 = kWidth - 1;
+    mY1 = kHeight - 1;
+    mX = mY = 0;
+    mHaveHighByte = false;
+    mHighByte = 0;
+    resetCounters();
+}
+
+void LcdBus::setPin(uint8_t port, uint32_t pin, uint32_t value)
+{
+    if (0 == port && 29 == pin) {
+        if (!value && !mCsLow) {
+            mTransactions++;
+        }
+        mCsLow = !value;
+    }
+    else if (1 == port && 19 == pin) {
+        mDcHigh = value;
+    }
+}
+
+void LcdBus::write(uint16_t frame, bool sixteenBits)
+{
+    if (!mCsLow) {
+        mStrayBytes += sixteenBits ? 2 : 1;
+        return;
+    }
+    if (sixteenBits) {
+        mBytes += 2;
+        if (mDcHigh) {
+            data(frame >> 8);
+            data(frame & 0xFF);
+        }
+        else {
+            command(frame & 0xFF);
+        }
+        return;
+    }
+    mBytes++;
+    if (mDcHigh) {
+        data(frame & 0xFF);
+    }
+    else {
+        command(frame & 0xFF);
+    }
+}
+
+void LcdBus::command(uint8_t cmd)
+{
+    mCommand = cmd;
+    mParamCount = 0;
+    if (LCD_RAMWR == cmd) {
+        mX = mX0;
+        mY = mY0;
+        mHaveHighByte = false;
+    }
+}
+
+void LcdBus::data(uint8_t byte)
+{
+    if (LCD_CASET == mCommand || LCD_PASET == mCommand) {
+        if (mParamCount < 4) {
+            mParams[mParamCount++] = byte;
+        }
+        if (4 == mParamCount) {
+            const int16_t start = (mParams[0] << 8) | mParams[1];
+            const int16_t end   = (mParams[2] << 8) | mParams[3];
+            if (LCD_CASET == mCommand) { mX0 = start; mX1 = end; }
+            else                       { mY0 = start; mY1 = end; }
+        }
+        return;
+    }
+    if (LCD_RAMWR != mCommand) {
+        return;
+    }
+
+    // The high byte of a pixel comes first
+    if (!mHaveHighByte) {
+        mHighByte = byte;
+        mHaveHighByte = true;
+        return;
+    }
+    mHaveHighByte = false;
+    if (mY > mY1) {
+        return;
+    }
+    if (mX < kWidth && mY < kHeight) {
+        mFrame[mY][mX] = (mHighByte << 8) | byte;
+    }
+    mPixels++;
+    if (++mX > mX1) {
+        mX = mX0;
+        mY++;
+    }
+}
+
+FakeSspData& FakeSspData::operator=(uint32_t frame)
+{
+    // DSS : 0b0111 is 8 bits, 0b1111 is 16 bits
+    lcd_bus.write((uint16_t) frame, 0b1111 == (fake_ssp0.CR0 & 0xF));
+    return *this;
+}
+
+void GPIOSetDir(uint8_t portNum, uint32_t pinNum, uint32_t pinDir)
+{
+    (void) portNum; (void) pinNum; (void) pinDir;
+}
+
+void GPIOSetValue(uint8_t portNum, uint32_t pinNum, uint32_t pinVal)
+{
+    lcd_bus.setPin(portNum, pinNum, pinVal);
+}
+
+uint32_t GPIOGetValue(uint8_t portNum, uint32_t pinNum)
+{
+    (void) portNum; (void) pinNum;
+    return 0;
+}
+
+void GPIOSetMode(uint8_t portNum, uint32_t pinNum, uint32_t pinMode)
+{
+    (void) portNum; (void) pinNum; (void) pinMode;
+}
+
+void ssp0_dma_init(void)
+{
+}
+
+unsigned ssp0_dma_write_start(const uint16_t* pWords, uint32_t num_words, char repeat, ssp0_dma_done_t done)
+{
+    if (0 == num_words) {
+        return 1;
+    }
+    dma_transfers++;
+    for (uint32_t i = 0; i < num_words; i++) {
+        LPC_SSP0->DR = repeat ? pWords[0] : pWords[i];
+    }
+    if (done) {
+        done(0);
+    }
+    return 0;
+}
+
+char ssp0_dma_is_busy(void)
+{
+    return 0;
+}
+
+uint32_t ssp0_dma_get_transfers(void)
+{
+    return dma_transfers;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void)
+{
+    SemaphoreHandle_t s = new FakeSemaphore;
+    s->given = false;
+    return s;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t xSemaphore, TickType_t xBlockTime)
+{
+    (void) xBlockTime;
+    if (NULL == xSemaphore || !xSemaphore->given) {
+        return pdFALSE;
+    }
+    xSemaphore->given = false;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t xSemaphore)
+{
+    if (NULL == xSemaphore || xSemaphore->given) {
+        return pdFALSE;
+    }
+    xSemaphore->given = true;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t xSemaphore, long *pxHigherPriorityTaskWoken)
+{
+    if (pxHigherPriorityTaskWoken) {
+        *pxHigherPriorityTaskWoken = 0;
+    }
+    return xSemaphoreGive(xSemaphore);
+}
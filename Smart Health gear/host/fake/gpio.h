@@ -0,0 +1,34 @@
+/*****************************************************************************
+$Work file     : gpio.h $
+Description    : Host stand-in for L2_Drivers/gpio.h, the LCD pins are sent to
+				 fake/lcd_bus.hpp
+Project(s)     : Smart Health Gear
+Compiler       : GCC (PC)
+OS			   : Linux (host)
+Original Author: $ agent
+$Author        : $ agent
+$Date          : $ 17 Oct 2026
+$Revision      : 1.0 $
+*****************************************************************************/
+#ifndef L2_DRIVERS_GPIO_H_
+#define L2_DRIVERS_GPIO_H_
+
+#include <stdint.h>
+
+#define  FUNC1  	0
+#define  FUNC2  	1
+#define  FUNC3  	2
+#define  FUNC4      3
+
+#define  INPUT 		0
+#define  OUTPUT 	1
+
+#define  LOW		0
+#define  HIGH		1
+
+void GPIOSetDir( uint8_t portNum, uint32_t pinNum, uint32_t pinDir );
+void GPIOSetValue( uint8_t portNum, uint32_t pinNum, uint32_t pinVal );
+uint32_t GPIOGetValue (uint8_t portNum, uint32_t pinNum);
+void GPIOSetMode(uint8_t portNum, uint32_t pinNum, uint32_t pinMode);
+
+#endif /* L2_DRIVERS_GPIO_H_ */
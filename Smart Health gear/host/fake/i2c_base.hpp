@@ -0,0 +1,130 @@
+/*****************************************************************************
+$Work file     : i2c_base.hpp $
+Description    : Host stand-in for L2_Drivers/base/i2c_base.hpp : an I2C bus
+				 that runs register reads and writes on simulated devices
+Project(s)     : Smart Health Gear
+Compiler       : GCC (PC)
+OS			   : Linux (host)
+Original Author: $ agent
+$Author        : $ agent
+$Date          : $ 17 Oct 2026
+$Revision      : 1.0 $
+
+Host tests put this folder first on the include path, so i2c1.hpp, i2c2.hpp
+and the i2c*_device.hpp classes of the board build against it unchanged.
+Every call is one transaction and counts in getTransferCount(), as on the
+board.
+*****************************************************************************/
+#ifndef I2C_BASE_HPP_
+#define I2C_BASE_HPP_
+
+/****************************************************************************/
+/*                       INCLUDE FILES                                      */
+/****************************************************************************/
+#include <stdint.h>
+#include <stddef.h>
+
+/****************************************************************************/
+/*                       Class declarations                                 */
+/****************************************************************************/
+/**
+ * Fake I2C bus.  A simulated device is attached to an address; a transaction
+ * to an address with no device fails, like a missing ACK.
+ */
+class I2C_Base
+{
+    public:
+        /// Registers of a simulated device, one call per byte on the bus
+        class Device
+        {
+            public:
+                virtual ~Device() { }
+                virtual uint8_t readByte(uint8_t reg) = 0;
+                virtual void writeByte(uint8_t reg, uint8_t value) = 0;
+                /// @returns the register after reg within one transaction (auto-increment)
+                virtual uint8_t nextReg(uint8_t reg) { return reg + 1; }
+        };
+
+        /// Attaches a device to an address (read or write address), NULL detaches it
+        void attach(uint8_t deviceAddress, Device *pDevice)
+        {
+            for (uint32_t i = 0; i < kMaxDevices; i++) {
+                if (NULL == mDevices[i].pDevice || mDevices[i].address == (deviceAddress & 0xFE)) {
+                    mDevices[i].address = deviceAddress & 0xFE;
+                    mDevices[i].pDevice = pDevice;
+                    return;
+                }
+            }
+        }
+
+        uint8_t readReg(uint8_t deviceAddress, uint8_t registerAddress)
+        {
+            uint8_t value = 0;
+            readRegisters(deviceAddress, registerAddress, &value, 1);
+            return value;
+        }
+
+        bool writeReg(uint8_t deviceAddress, uint8_t registerAddress, uint8_t value)
+        {
+            return writeRegisters(deviceAddress, registerAddress, &value, 1);
+        }
+
+        bool readRegisters(uint8_t deviceAddress, uint8_t firstReg, uint8_t* pData, uint32_t transferSize)
+        {
+            Device *pDevice = start(deviceAddress);
+            for (uint32_t i = 0; NULL != pDevice && i < transferSize; i++) {
+                pData[i] = pDevice->readByte(firstReg);
+                firstReg = pDevice->nextReg(firstReg);
+            }
+            return NULL != pDevice;
+        }
+
+        bool writeRegisters(uint8_t deviceAddress, uint8_t firstReg, uint8_t* pData, uint32_t transferSize)
+        {
+            Device *pDevice = start(deviceAddress);
+            for (uint32_t i = 0; NULL != pDevice && i < transferSize; i++) {
+                pDevice->writeByte(firstReg, pData[i]);
+                firstReg = pDevice->nextReg(firstReg);
+            }
+            return NULL != pDevice;
+        }
+
+        bool checkDeviceResponse(uint8_t deviceAddress)
+        {
+            return NULL != start(deviceAddress);
+        }
+
+        /// @returns the number of transactions started on this bus
+        inline uint32_t getTransferCount(void) const { return mTransferCount; }
+
+    protected:
+        I2C_Base() : mTransferCount(0)
+        {
+            for (uint32_t i = 0; i < kMaxDevices; i++) {
+                mDevices[i].address = 0;
+                mDevices[i].pDevice = NULL;
+            }
+        }
+
+    private:
+        /// Counts a transaction, @returns the device at the address or NULL
+        Device* start(uint8_t deviceAddress)
+        {
+            mTransferCount++;
+            for (uint32_t i = 0; i < kMaxDevices; i++) {
+                if (NULL != mDevices[i].pDevice && mDevices[i].address == (deviceAddress & 0xFE)) {
+                    return mDevices[i].pDevice;
+                }
+            }
+            return NULL;
+        }
+
+        static const uint32_t kMaxDevices = 4;
+        struct {
+            uint8_t address;
+            Device *pDevice;
+        } mDevices[kMaxDevices];
+        uint32_t mTransferCount;
+};
+
+#endif /* I2C_BASE_HPP_ */
@@ -0,0 +1,96 @@
+/*****************************************************************************
+$Work file     : lcd_bus.hpp $
+Description    : Host stand-in for the ILI9340 on SSP0 : decodes the frames
+				 written to the fake SSP0 into a frame buffer
+Project(s)     : Smart Health Gear
+Compiler       : GCC (PC)
+OS			   : Linux (host)
+Original Author: $ agent
+$Author        : $ agent
+$Date          : $ 17 Oct 2026
+$Revision      : 1.0 $
+
+The fake LPC17xx.h, gpio.h and ssp0.h of this folder send the SSP0 data
+register writes, the CS (P0.29) and D/C (P1.19) pins and the DMA transfers
+here, so L5_Application/lcd_screen.cpp builds against it unchanged.  The
+counters are kept by the bus, apart from the ones of LcdScreen.
+*****************************************************************************/
+#ifndef LCD_BUS_HPP_
+#define LCD_BUS_HPP_
+
+/****************************************************************************/
+/*                       INCLUDE FILES                                      */
+/****************************************************************************/
+#include <stdint.h>
+
+/****************************************************************************/
+/*                       Class declarations                                 */
+/****************************************************************************/
+/**
+ * The LCD controller as seen from the SPI bus.  Column and page address
+ * (CASET, PASET) set the window, RAM write (RAMWR) sends the pixels that
+ * follow to it row by row.  A command stays selected across CS cycles.
+ */
+class LcdBus
+{
+    public:
+        static const int16_t kWidth  = 240;
+        static const int16_t kHeight = 320;
+
+        LcdBus() { reset(0); }
+
+        /// Fills the frame and clears the counters
+        void reset(uint16_t fill);
+        void resetCounters(void) { mTransactions = mBytes = mPixels = mStrayBytes = 0; }
+
+        /// A pin driven by GPIOSetValue()
+        void setPin(uint8_t port, uint32_t pin, uint32_t value);
+        /// A frame of 8 or 16 bits written to the SSP0 data register
+        void write(uint16_t frame, bool sixteenBits);
+
+        uint16_t getPixel(int16_t x, int16_t y) const { return mFrame[y][x]; }
+
+        /** @{ Traffic since reset() : CS low cycles, bytes on MOSI, pixels written
+         *     to the RAM, bytes outside a CS low cycle (must be 0) */
+        uint32_t getTransactions(void) const { return mTransactions; }
+        uint32_t getBytes(void) const        { return mBytes; }
+        uint32_t getPixels(void) const       { return mPixels; }
+        uint32_t getStrayBytes(void) const   { return mStrayBytes; }
+        /** @} */
+
+        /**
+         * @returns the seconds the traffic since reset() takes on the board
+         * @param sckHz  SSP0 clock, every byte is 8 clocks
+         * @param csNs   cost of one CS low cycle : the pin writes and the wait
+         *               for the last frame to shift out
+         */
+        double getBusSeconds(uint32_t sckHz, uint32_t csNs) const
+        {
+            return (8.0 * mBytes) / sckHz + 1e-9 * csNs * mTransactions;
+        }
+
+    private:
+        void command(uint8_t cmd);
+        void data(uint8_t byte);
+
+        uint16_t mFrame[kHeight][kWidth];
+        bool mCsLow;
+        bool mDcHigh;
+        uint8_t mCommand;
+        uint8_t mParams[4];
+        uint32_t mParamCount;
+        int16_t mX0, mX1, mY0, mY1;   // window
+        int16_t mX, mY;               // next pixel of the RAM write
+        uint16_t mHighByte;
+        bool mHaveHighByte;
+
+        uint32_t mTransactions;
+        uint32_t mBytes;
+        uint32_t mPixels;
+        uint32_t mStrayBytes;
+};
+
+/// The LCD on the fake SSP0
+extern LcdBus lcd_bus;
+
+#endif /* LCD_BUS_HPP_ */
@@ -0,0 +1,28 @@
+/*****************************************************************************
+$Work file     : ssp0.h $
+Description    : Host stand-in for the SSP0 DMA of L2_Drivers/ssp0.h : the
+				 words are sent to fake/lcd_bus.hpp before it returns
+Project(s)     : Smart Health Gear
+Compiler       : GCC (PC)
+OS			   : Linux (host)
+Original Author: $ agent
+$Author        : $ agent
+$Date          : $ 17 Oct 2026
+$Revision      : 1.0 $
+*****************************************************************************/
+#ifndef SPI0_H__
+#define SPI0_H__
+
+#include <stdint.h>
+
+typedef void (*ssp0_dma_done_t)(char failed);
+
+void ssp0_dma_init(void);
+/// Sends the words as 16-bit frames and calls done before it returns
+unsigned ssp0_dma_write_start(const uint16_t* pWords, uint32_t num_words, char repeat, ssp0_dma_done_t done);
+char ssp0_dma_is_busy(void);
+
+/// @returns the transfers started since the program started
+uint32_t ssp0_dma_get_transfers(void);
+
+#endif /* SPI0_H__ */
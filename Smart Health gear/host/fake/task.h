@@ -0,0 +1,29 @@
+/*****************************************************************************
+$Work file     : task.h $
+Description    : Host stand-in for the scheduler state of FreeRTOS task.h
+Project(s)     : Smart Health Gear
+Compiler       : GCC (PC)
+OS			   : Linux (host)
+Original Author: $ agent
+$Author        : $ agent
+$Date          : $ 17 Oct 2026
+$Revision      : 1.0 $
+*****************************************************************************/
+#ifndef INC_TASK_H
+#define INC_TASK_H
+
+#include "FreeRTOS.h"
+
+#define taskSCHEDULER_SUSPENDED    ((BaseType_t) 0)
+#define taskSCHEDULER_NOT_STARTED  ((BaseType_t) 1)
+#define taskSCHEDULER_RUNNING      ((BaseType_t) 2)
+
+/// The state returned by xTaskGetSchedulerState(), running unless a test changes it
+extern BaseType_t fake_scheduler_state;
+
+static inline BaseType_t xTaskGetSchedulerState(void)
+{
+    return fake_scheduler_state;
+}
+
+#endif /* INC_TASK_H */
@@ -0,0 +1,127 @@
+/*****************************************************************************
+$Work file     : lcd_spi_test.cpp $
+Description    : Host test of the LCD fills : clearScrn1() per pixel against
+				 one address window per rectangle, counting SPI transactions
+Project(s)     : Smart Health Gear
+Compiler       : GCC (PC)
+OS			   : Linux (host)
+Original Author: $ agent
+$Author        : $ agent
+$Date          : $ 17 Oct 2026
+$Revision      : 1.0 $
+
+LcdScreen (L5_Application/lcd_screen.cpp) is built unchanged against the
+fake SSP0 of fake/LPC17xx.h, which decodes the commands and pixels sent to
+the ILI9340 into the frame of fake/lcd_bus.hpp.
+*****************************************************************************/
+
+/****************************************************************************/
+/*                       INCLUDE FILES                                      */
+/****************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include "lcd_screen.hpp"
+#include "lcd_bus.hpp"
+#include "ssp0.h"
+
+/****************************************************************************/
+/*                        MACRO Definitions                                 */
+/****************************************************************************/
+// clearScrn1() : 3 vertical and 6 horizontal lines, 5 labels and the readings
+#define CLEAR_SCRN1_FILLS       (15)
+// A fill : CASET, PASET and RAMWR, 4 + 4 parameter bytes one CS cycle each, then the pixels
+#define FILL_TRANSACTIONS       (12)
+
+/*----------------------------------------------------------------------------
+Function    :  count_lit()
+Inputs      :  None
+Processing  :  Counts the pixels of the LCD that are not black
+Outputs     :  None
+Returns     :  The number of pixels
+Notes       :  None
+----------------------------------------------------------------------------*/
+static uint32_t count_lit(void)
+{
+	uint32_t un_lit = 0;
+	for (int16_t y = 0; y < LcdBus::kHeight; y++) {
+		for (int16_t x = 0; x < LcdBus::kWidth; x++) {
+			un_lit += (ILI9340_BLACK != lcd_bus.getPixel(x, y));
+		}
+	}
+	return un_lit;
+}
+
+/*----------------------------------------------------------------------------
+Function    :  draw_sensor_screen()
+Inputs      :  lcd - the screen
+Processing  :  Draws the lines, labels and readings of the sensor screen, as
+			   displayScrn1() does without the widgets
+Outputs     :  None
+Returns     :  None
+Notes       :  None
+----------------------------------------------------------------------------*/
+static void draw_sensor_screen(LcdScreen &lcd)
+{
+	const char *apch_label[] = { "Heart Rate", "Blood Oxygen", "Body Temp", "step count", "HRV (ms)" };
+	const char *apch_value[] = { "72", "97", "36", "1234", "42" };
+
+	lcd.drawFastVLine(5,0,250,ILI9340_WHITE);
+	lcd.drawFastVLine(142,0,250,ILI9340_WHITE);
+	lcd.drawFastVLine(235,0,250,ILI9340_WHITE);
+	for (int i = 0; i < 6; i++) {
+		lcd.drawFastHLine(5,50*i,231,ILI9340_WHITE);
+	}
+	for (int i = 0; i < 5; i++) {
+		lcd.drawString(apch_label[i],12,20+50*i,2,ILI9340_YELLOW);
+		lcd.drawString(apch_value[i],148,20+50*i,2,ILI9340_YELLOW);
+	}
+	lcd.waitPixels();
+}
+
+int main(void)
+{
+    LcdScreen lcd;
+    const char *apch_mode[] = { "Per pixel", "Bulk", "Bulk DMA" };
+    uint32_t aun_transactions[3], aun_bytes[3];
+
+    lcd.initSpi();
+    for (int i = 0; i < 3; i++)
+    {
+        lcd_bus.reset(ILI9340_BLACK);
+        lcd.setPerPixel(0 == i);
+        lcd.setDma(2 == i);
+        draw_sensor_screen(lcd);
+        assert(count_lit() > 0);
+        lcd_bus.resetCounters();
+        lcd.resetSpiStats();
+        const uint32_t un_dma_start = ssp0_dma_get_transfers();
+
+        lcd.clearScrn1();
+        assert(lcd.waitPixels(0));
+
+        // The driver counts what the bus saw, every byte within a CS low cycle
+        aun_transactions[i] = lcd_bus.getTransactions();
+        aun_bytes[i] = lcd_bus.getBytes();
+        assert(lcd.getSpiTransactions() == aun_transactions[i]);
+        assert(lcd.getSpiBytes() == aun_bytes[i]);
+        assert(0 == lcd_bus.getStrayBytes());
+        assert((2 == i) == (CLEAR_SCRN1_FILLS == ssp0_dma_get_transfers() - un_dma_start));
+
+        // The lines, labels and readings are gone
+        assert(0 == count_lit());
+
+        printf("%-9s: %7u SPI transactions %8u bytes %6u pixels\n", apch_mode[i],
+               aun_transactions[i], aun_bytes[i], lcd_bus.getPixels());
+    }
+
+    // One address window and one pixel stream per rectangle
+    assert(CLEAR_SCRN1_FILLS * FILL_TRANSACTIONS == aun_transactions[1]);
+    assert(aun_transactions[1] == aun_transactions[2] && aun_bytes[1] == aun_bytes[2]);
+    // A pixel costs 12 transactions and 12 bytes on its own
+    assert(aun_transactions[0] > 100 * aun_transactions[1]);
+    assert(aun_bytes[0] > 4 * aun_bytes[1]);
+
+    printf("lcd_spi_test passed\n");
+    return 0;
+}
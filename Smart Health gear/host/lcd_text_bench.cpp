@@ -0,0 +1,165 @@
+/*****************************************************************************
+$Work file     : lcd_text_bench.cpp $
+Description    : Host benchmark of the LCD text : drawString() through the strip
+				 buffers against drawChar() one pixel at a time, in chars/sec
+				 on a simulated SPI bus
+Project(s)     : Smart Health Gear
+Compiler       : GCC (PC)
+OS			   : Linux (host)
+Original Author: $ agent
+$Author        : $ agent
+$Date          : $ 17 Oct 2026
+$Revision      : 1.0 $
+
+Usage :
+	lcd_text_bench [rounds] [SCK MHz] [ns per CS cycle]
+
+LcdScreen (L5_Application/lcd_screen.cpp) draws on the fake SSP0 of
+fake/LPC17xx.h.  Every path must leave the same pixels on the LCD of
+fake/lcd_bus.hpp.  The chars/sec are those of the bus : 8 SCK clocks per
+byte (24 MHz on the board) and a fixed cost per CS low cycle for the pin
+writes and the wait for the last frame (2 usec by default).  The rendering
+time on the board is not modelled, the host ns/char only compare the paths.
+'lcdbench text' measures the same strings on the board.  The exit status is
+1 when a path draws other pixels or the strips are not faster.
+*****************************************************************************/
+
+/****************************************************************************/
+/*                       INCLUDE FILES                                      */
+/****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "lcd_screen.hpp"
+#include "lcd_bus.hpp"
+
+/****************************************************************************/
+/*                        MACRO Definitions                                 */
+/****************************************************************************/
+#define MODES                   (3)
+
+/****************************************************************************/
+/*                        Type Definitions                                  */
+/****************************************************************************/
+// A string drawn rounds times, in two colors in turn
+typedef struct {
+	const char *pch_name;
+	const char *pch_text;
+	int16_t     n_x;
+	int16_t     n_y;
+	uint8_t     uch_size;
+} text_case_t;
+
+/****************************************************************************/
+/*                        VARIABLES                                         */
+/****************************************************************************/
+// The readings of the sensor screen ('lcdbench text') and the clock
+static const text_case_t text_cases[] = {
+	{ "Readings", "0123456789", 12, 270, 2 },
+	{ "Clock",    "12:34",      40,  70, 6 },
+};
+static uint16_t aus_frame[LcdBus::kHeight][LcdBus::kWidth];
+
+/****************************************************************************/
+/*                       Function definitions                               */
+/****************************************************************************/
+/*----------------------------------------------------------------------------
+Function    :  now_ns ()
+Inputs      :  None
+Processing  :  This function reads the monotonic clock
+Outputs     :  None
+Returns     :  Time in nanoseconds
+Notes       :  None
+----------------------------------------------------------------------------*/
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/*----------------------------------------------------------------------------
+Function    :  same_frame ()
+Inputs      :  b_keep - true to keep the LCD frame as the reference
+Processing  :  This function compares the LCD frame with the reference
+Outputs     :  None
+Returns     :  The number of pixels that differ
+Notes       :  None
+----------------------------------------------------------------------------*/
+static uint32_t same_frame(bool b_keep)
+{
+    uint32_t un_diff = 0;
+    for (int16_t y = 0; y < LcdBus::kHeight; y++) {
+        for (int16_t x = 0; x < LcdBus::kWidth; x++) {
+            if (b_keep) {
+                aus_frame[y][x] = lcd_bus.getPixel(x, y);
+            }
+            un_diff += (aus_frame[y][x] != lcd_bus.getPixel(x, y));
+        }
+    }
+    return un_diff;
+}
+
+int main(int argc, char *argv[])
+{
+    const int n_rounds = (argc > 1) ? atoi(argv[1]) : 20;
+    const double f_sck_mhz = (argc > 2) ? atof(argv[2]) : 24.0;
+    const uint32_t un_cs_ns = (argc > 3) ? (uint32_t) atoi(argv[3]) : 2000;
+    const char *apch_mode[MODES] = { "Per pixel", "Strips", "Strips DMA" };
+    int n_status = 0;
+    LcdScreen lcd;
+
+    if (n_rounds < 1 || f_sck_mhz <= 0) {
+        fprintf(stderr, "usage: lcd_text_bench [rounds] [SCK MHz] [ns per CS cycle]\n");
+        return 2;
+    }
+    lcd.initSpi();
+    printf("Bus     : SCK %.1f MHz, %u ns per CS cycle, %d rounds\n", f_sck_mhz, un_cs_ns, n_rounds);
+
+    for (uint32_t c = 0; c < sizeof(text_cases) / sizeof(text_cases[0]); c++)
+    {
+        const text_case_t &t = text_cases[c];
+        const uint32_t un_chars = n_rounds * strlen(t.pch_text);
+        double af_chars_sec[MODES];
+
+        for (int m = 0; m < MODES; m++)
+        {
+            lcd_bus.reset(ILI9340_BLACK);
+            lcd.setPerPixel(0 == m);
+            lcd.setDma(2 == m);
+            lcd.resetSpiStats();
+            lcd.getTextRaster().resetStats();
+
+            const uint64_t ul_start = now_ns();
+            for (int r = 0; r < n_rounds; r++) {
+                lcd.drawString(t.pch_text, t.n_x, t.n_y, t.uch_size, (r & 1) ? ILI9340_YELLOW : ILI9340_CYAN);
+            }
+            lcd.waitPixels();
+            const uint64_t ul_ns = now_ns() - ul_start;
+
+            const double f_bus_sec = lcd_bus.getBusSeconds((uint32_t) (f_sck_mhz * 1e6), un_cs_ns);
+            af_chars_sec[m] = un_chars / f_bus_sec;
+            const uint32_t un_diff = same_frame(0 == m);
+            printf("%-8s: %-10s %8u SPI transactions %8u bytes, %8.0f chars/sec on the bus, %6.0f ns/char on the host",
+                   t.pch_name, apch_mode[m], lcd_bus.getTransactions(), lcd_bus.getBytes(), af_chars_sec[m],
+                   (double) ul_ns / un_chars);
+            if (0 != m) {
+                printf(", %u glyph rows cached, %u expanded", lcd.getTextRaster().getCacheHits(),
+                       lcd.getTextRaster().getCacheMisses());
+            }
+            printf("\n");
+
+            if (0 != un_diff || 0 != lcd_bus.getStrayBytes() || lcd.getSpiTransactions() != lcd_bus.getTransactions()) {
+                printf("%s : %s differs from per pixel in %u pixels, %u bytes outside CS\n", t.pch_name,
+                       apch_mode[m], un_diff, lcd_bus.getStrayBytes());
+                n_status = 1;
+            }
+        }
+        printf("%-8s: strips %.1fx the chars/sec of per pixel\n", t.pch_name, af_chars_sec[1] / af_chars_sec[0]);
+        if (af_chars_sec[1] <= af_chars_sec[0] || af_chars_sec[2] != af_chars_sec[1]) {
+            n_status = 1;
+        }
+    }
+    return n_status;
+}
@@ -0,0 +1,238 @@
+/*****************************************************************************
+$Work file     : max30102_fifo_test.cpp $
+Description    : Host test of the MAX30102 FIFO drain against a simulated
+				 sensor on a fake I2C bus
+Project(s)     : Smart Health Gear
+Compiler       : GCC (PC)
+OS			   : Linux (host)
+Original Author: $ agent
+$Author        : $ agent
+$Date          : $ 17 Oct 2026
+$Revision      : 1.0 $
+
+The fake sensor keeps the FIFO, its pointers, OVF_COUNTER and the A_FULL flag
+the way the datasheet describes them : INT_STATUS_1 clears on read, register
+reads auto-increment except on FIFO_DATA, where every 6 bytes pop a sample.
+The bus counts transactions, so each drain is checked for its transaction
+count, the samples it returns and the A_FULL flag it leaves behind.
+*****************************************************************************/
+
+/****************************************************************************/
+/*                       INCLUDE FILES                                      */
+/****************************************************************************/
+#include <stdio.h>
+#include <assert.h>
+#include "max30102_fifo.hpp"
+#include "ppg_trace_format.hpp"
+
+/****************************************************************************/
+/*                        MACRO Definitions                                 */
+/****************************************************************************/
+// A_FULL comes when only 15 slots are free (FIFO_A_FULL of the heart rate task)
+#define FAKE_A_FULL_SAMPLES        (MAX30102_FIFO_DEPTH - 15)
+
+/****************************************************************************/
+/*                       Class declarations                                 */
+/****************************************************************************/
+/**
+ * MAX30102 on a fake I2C bus, with FIFO rollover off as the heart rate task
+ * configures it.  Sample n holds red = n and IR = n + 0x20000.
+ */
+class FakeMax30102
+{
+    public:
+        FakeMax30102() : mTransactions(0), mEmptyReads(0), mCount(0), mWr(0), mRd(0), mOvf(0),
+                         mStatus(0), mByte(0), mNext(0) { }
+
+        /// Sensor side : one conversion, dropped (OVF_COUNTER + 1) when the FIFO is full
+        void convert(void)
+        {
+            const uint32_t un_id = mNext++;
+            if (MAX30102_FIFO_DEPTH == mCount) {
+                mOvf = (mOvf < 0x1F) ? mOvf + 1 : mOvf;
+                return;
+            }
+            mFifo[mWr] = un_id;
+            mWr = (mWr + 1) & (MAX30102_FIFO_DEPTH - 1);
+            if (FAKE_A_FULL_SAMPLES == ++mCount) {
+                mStatus |= MAX30102_INT_A_FULL;
+            }
+        }
+
+        /// The INT pin is low (asserted) while A_FULL is set
+        bool isIntAsserted(void) const { return 0 != (mStatus & MAX30102_INT_A_FULL); }
+
+        /// I2C side, one transaction : same arguments as I2C_Base::readRegisters()
+        bool readRegisters(uint8_t deviceAddress, uint8_t firstReg, uint8_t *pData, uint32_t transferSize)
+        {
+            assert(MAX30102_I2C_ADDR == deviceAddress && transferSize > 0);
+            mTransactions++;
+            for (uint32_t i = 0; i < transferSize; i++) {
+                pData[i] = readByte(firstReg);
+                if (MAX30102_REG_FIFO_DATA != firstReg) {
+                    firstReg++;
+                }
+            }
+            return true;
+        }
+
+        uint32_t mTransactions;     ///< I2C transactions since the start
+        uint32_t mEmptyReads;       ///< Samples read from an empty FIFO
+        uint32_t mCount;            ///< Samples in the FIFO
+
+    private:
+        uint8_t readByte(uint8_t reg)
+        {
+            uint8_t uch_value = 0;
+            switch (reg)
+            {
+                case MAX30102_REG_INT_STATUS_1:
+                    uch_value = mStatus;
+                    mStatus = 0;
+                    break;
+                case 0x02:
+                    uch_value = MAX30102_INT_A_FULL;
+                    break;
+                case MAX30102_REG_FIFO_WR_PTR:
+                    uch_value = mWr;
+                    break;
+                case 0x05:
+                    uch_value = mOvf;
+                    break;
+                case 0x06:
+                    uch_value = mRd;
+                    break;
+                case MAX30102_REG_FIFO_DATA:
+                    uch_value = readFifoByte();
+                    break;
+                default:
+                    break;
+            }
+            return uch_value;
+        }
+
+        /// Red then IR, 3 bytes each MSB first; the read pointer moves after the 6th byte
+        uint8_t readFifoByte(void)
+        {
+            if (0 == mByte && 0 == mCount) {
+                mEmptyReads++;
+            }
+            const uint32_t un_id = mFifo[mRd];
+            const uint32_t un_value = (mByte < 3) ? (un_id & 0x03FFFF) : ((un_id + 0x20000) & 0x03FFFF);
+            const uint8_t uch_byte = (uint8_t) (un_value >> (8 * (2 - (mByte % 3))));
+            if (MAX30102_SAMPLE_BYTES == ++mByte) {
+                mByte = 0;
+                if (mCount > 0) {
+                    mRd = (mRd + 1) & (MAX30102_FIFO_DEPTH - 1);
+                    mCount--;
+                    mOvf = 0;
+                }
+            }
+            return uch_byte;
+        }
+
+        uint32_t mFifo[MAX30102_FIFO_DEPTH];
+        uint8_t  mWr, mRd, mOvf, mStatus, mByte;
+        uint32_t mNext;             ///< Id of the next conversion
+};
+
+/****************************************************************************/
+/*                       Function definitions                               */
+/****************************************************************************/
+/*----------------------------------------------------------------------------
+Function    :  drain ()
+Inputs      :  sensor        - fake sensor
+			   un_expected   - samples that must come out
+			   pun_next      - id of the next sample expected
+			   un_lost       - samples the sensor dropped since the last drain
+Processing  :  This function drains the FIFO once and checks the transaction
+			   count, the sample order, the overflow count and that A_FULL is
+			   cleared
+Outputs     :  *pun_next - id after the last sample read
+Returns     :  None
+Notes       :  None
+----------------------------------------------------------------------------*/
+static void drain(FakeMax30102 &sensor, uint32_t un_expected, uint32_t *pun_next, uint32_t un_lost)
+{
+    uint8_t auch_fifo[MAX30102_FIFO_DEPTH * MAX30102_SAMPLE_BYTES];
+    uint32_t un_overflows = 0, un_red, un_ir;
+    const uint32_t un_before = sensor.mTransactions;
+
+    const uint8_t uch_samples = maxim_max30102_drain_fifo(sensor, auch_fifo, &un_overflows);
+
+    assert(un_expected == uch_samples);
+    assert(un_lost == un_overflows);
+    assert(sensor.mTransactions - un_before == (uch_samples ? 2u : 1u));
+    assert(!sensor.isIntAsserted() && 0 == sensor.mCount && 0 == sensor.mEmptyReads);
+    for (uint32_t i = 0; i < uch_samples; i++) {
+        maxim_max30102_unpack(auch_fifo + i * MAX30102_SAMPLE_BYTES, &un_red, &un_ir);
+        assert(un_red == (*pun_next & 0x03FFFF) && un_ir == ((*pun_next + 0x20000) & 0x03FFFF));
+        (*pun_next)++;
+    }
+    *pun_next += un_lost;
+}
+
+int main(void)
+{
+    uint32_t un_next = 0, un_seed = 7;
+
+    // Empty : only the status and pointers are read
+    {
+        FakeMax30102 sensor;
+        drain(sensor, 0, &un_next, 0);
+    }
+
+    // Below, at, and above the almost-full level, then exactly full (pointers
+    // equal, no overflow yet) and full with samples lost
+    const uint32_t aun_counts[] = {5, FAKE_A_FULL_SAMPLES, 31, MAX30102_FIFO_DEPTH, MAX30102_FIFO_DEPTH + 8};
+    {
+        FakeMax30102 sensor;
+        un_next = 0;
+        for (uint32_t c = 0; c < sizeof(aun_counts) / sizeof(aun_counts[0]); c++) {
+            for (uint32_t n = 0; n < aun_counts[c]; n++) {
+                sensor.convert();
+            }
+            assert(sensor.isIntAsserted() == (aun_counts[c] >= FAKE_A_FULL_SAMPLES));
+            const uint32_t un_lost = (aun_counts[c] > MAX30102_FIFO_DEPTH) ? aun_counts[c] - MAX30102_FIFO_DEPTH : 0;
+            drain(sensor, aun_counts[c] - un_lost, &un_next, un_lost);
+        }
+    }
+
+    // Random fill levels, so that both pointers wrap at every position
+    {
+        FakeMax30102 sensor;
+        un_next = 0;
+        for (uint32_t i = 0; i < 20000; i++) {
+            un_seed = un_seed * 1103515245 + 12345;
+            const uint32_t un_count = (un_seed >> 16) % (MAX30102_FIFO_DEPTH + 4);
+            for (uint32_t n = 0; n < un_count; n++) {
+                sensor.convert();
+            }
+            const uint32_t un_lost = (un_count > MAX30102_FIFO_DEPTH) ? un_count - MAX30102_FIFO_DEPTH : 0;
+            drain(sensor, un_count - un_lost, &un_next, un_lost);
+        }
+    }
+
+    // One minute at 100 sps, drained on every falling edge of INT as the heart
+    // rate task does.  The per-sample reader made 3 transactions per sample.
+    {
+        const uint32_t un_rate = 100, un_seconds = 60;
+        FakeMax30102 sensor;
+        uint32_t un_wakeups = 0;
+        un_next = 0;
+        for (uint32_t n = 0; n < un_rate * un_seconds; n++) {
+            sensor.convert();
+            if (sensor.isIntAsserted()) {
+                un_wakeups++;
+                drain(sensor, FAKE_A_FULL_SAMPLES, &un_next, 0);
+            }
+        }
+        const uint32_t un_per_sec = sensor.mTransactions / un_seconds;
+        printf("100 sps : %u wakeups/sec, %u I2C transactions/sec (per-sample reader : %u, %u)\n",
+               un_wakeups / un_seconds, un_per_sec, un_rate, 3 * un_rate);
+        assert(un_per_sec * 10 <= 3 * un_rate && un_wakeups * 10 <= un_rate * un_seconds);
+    }
+
+    printf("max30102_fifo_test passed\n");
+    return 0;
+}
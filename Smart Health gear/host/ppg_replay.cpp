@@ -0,0 +1,728 @@
+/*****************************************************************************
+$Work file     : ppg_replay.cpp $
+Description    : Host tool that replays a PPG trace through the batch algorithm
+				 and the streaming engine and compares their outputs
+Project(s)     : Smart Health Gear
+Compiler       : GCC (PC)
+OS			   : Linux (host)
+Original Author: $ agent
+$Author        : $ agent
+$Date          : $ 17 Oct 2026
+$Revision      : 1.2 $
+
+Build with 'make' in this folder (see the Makefile), nothing else of the board
+is needed.
+
+Usage :
+	ppg_replay [options] <trace> [reference HR] [reference SpO2]
+	ppg_replay [options] --synth <seconds> <HR> <SpO2> [noise %] [seed] [sps]
+Options :
+	--series        print the HR / SpO2 of every window as CSV on stdout
+	--spool <file>  also write the trace as a spool file
+
+The trace is a file written by 'ppgrec' or 'hrspool' (binary or packed) or
+"red,ir" text lines, as read by the 'ppgplay' terminal command.  --synth makes
+a pulse waveform instead, with 3% beat to beat jitter and baseline wander.
+
+The stream path runs the engine built for the rate of the trace, as the heart
+rate task and 'spoolrun' do, so its series is the one the board gives.  The
+batch algorithm only works at FS : other rates are averaged down (200 sps) or
+linearly interpolated up (25 and 50 sps) to FS for it, and each batch window
+ends at the time of the stream output it is compared with.  With --series the
+first five columns have the layout of the 'spoolrun' CSV file.
+
+Each path runs on its own thread whose stack is painted first, so the peak
+stack use is the depth of the deepest overwritten word.  operator new is
+replaced to count the allocations made while a path runs.
+*****************************************************************************/
+
+/****************************************************************************/
+/*                       INCLUDE FILES                                      */
+/****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+#include <new>
+#include <vector>
+#include "algorithm.hpp"
+#include "ppg_stream.hpp"
+#include "ppg_trace_format.hpp"
+
+/****************************************************************************/
+/*                        MACRO Definitions                                 */
+/****************************************************************************/
+// Stack of the thread that runs a path, painted with REPLAY_STACK_PAINT
+#define REPLAY_STACK_BYTES         (1024 * 1024)
+#define REPLAY_STACK_PAINT         (0xA5A5A5A5)
+
+/****************************************************************************/
+/*                        Type Definitions                                  */
+/****************************************************************************/
+/// Samples of a trace and its reference readings
+typedef struct {
+    std::vector<uint32_t> red;
+    std::vector<uint32_t> ir;
+    uint32_t    un_sample_rate;
+    int32_t     n_hr_label;
+    int32_t     n_spo2_label;
+    const char *pch_kind;
+} trace_t;
+
+/// One output of a path
+typedef struct {
+    uint32_t un_sample;     ///< Index of the last sample of the window
+    int32_t  n_hr;
+    int32_t  n_spo2;
+    int8_t   ch_hr_valid;
+    int8_t   ch_spo2_valid;
+} window_t;
+
+/// Results of one path over the whole trace
+typedef struct {
+    uint32_t un_hr_valid;
+    uint32_t un_spo2_valid;
+    uint64_t ul_hr_error;
+    uint64_t ul_spo2_error;
+    uint64_t ul_ns;
+    uint32_t un_allocs;
+    uint32_t un_stack_bytes;
+} path_stats_t;
+
+/// What a path reads and writes on its thread
+typedef struct {
+    const trace_t         *p_trace;
+    const trace_t         *p_trace_fs; ///< The trace at FS, for the batch algorithm
+    PpgEngine             *p_engine;
+    std::vector<window_t> *p_stream;   ///< Outputs of the engine, in order
+    std::vector<window_t> *p_batch;    ///< Batch outputs over the same windows
+    uint64_t               ul_ns;      ///< Time spent in the algorithm calls
+} replay_t;
+
+/****************************************************************************/
+/*                        VARIABLES                                         */
+/****************************************************************************/
+// Allocations made through operator new since the start
+static volatile uint32_t un_alloc_count = 0;
+// Windows handed to the batch algorithm, out of the path stacks
+static uint32_t aun_ir_buffer[BUFFER_SIZE], aun_red_buffer[BUFFER_SIZE];
+
+/****************************************************************************/
+/*                       Function definitions                               */
+/****************************************************************************/
+/*----------------------------------------------------------------------------
+Function    :  operator new () / operator delete ()
+Inputs      :  size - bytes to allocate / p - block to free
+Processing  :  These replace the library ones to count every allocation
+Outputs     :  None
+Returns     :  The new block
+Notes       :  new[] and delete[] go through these as well
+----------------------------------------------------------------------------*/
+void* operator new(size_t size)
+{
+    void *p = malloc(size ? size : 1);
+    if (NULL == p) {
+        throw std::bad_alloc();
+    }
+    __sync_fetch_and_add(&un_alloc_count, 1);
+    return p;
+}
+
+void operator delete(void *p) noexcept
+{
+    free(p);
+}
+
+/*----------------------------------------------------------------------------
+Function    :  now_ns ()
+Inputs      :  None
+Processing  :  This function reads the monotonic clock
+Outputs     :  None
+Returns     :  Time in nanoseconds
+Notes       :  None
+----------------------------------------------------------------------------*/
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/*----------------------------------------------------------------------------
+Function    :  load_trace ()
+Inputs      :  const char *pch_path - trace file
+Processing  :  This function reads a binary trace (raw FIFO samples or packed
+			   pairs) or "red,ir" text lines, the same formats as PpgTraceReader
+Outputs     :  *p_trace - samples and labels
+Returns     :  true if the file was read
+Notes       :  Text lines that do not hold two numbers are skipped
+----------------------------------------------------------------------------*/
+static bool load_trace(const char *pch_path, trace_t *p_trace)
+{
+    FILE *p_file = fopen(pch_path, "rb");
+    ppg_trace_header_t header;
+
+    if (NULL == p_file) {
+        return false;
+    }
+    p_trace->un_sample_rate = FS;
+    p_trace->n_hr_label = PPG_TRACE_NO_LABEL;
+    p_trace->n_spo2_label = PPG_TRACE_NO_LABEL;
+
+    if (1 == fread(&header, sizeof(header), 1, p_file) &&
+        PPG_TRACE_MAGIC == header.un_magic &&
+        ((PPG_TRACE_VERSION == header.us_version && PPG_TRACE_SAMPLE_BYTES == header.us_sample_bytes) ||
+         (PPG_TRACE_VERSION_PACKED == header.us_version && PPG_TRACE_PACKED_BYTES == header.us_sample_bytes)))
+    {
+        const bool b_packed = (PPG_TRACE_VERSION_PACKED == header.us_version);
+        uint8_t auch_bytes[PPG_TRACE_PACKED_BYTES];
+        uint32_t aun_red[2], aun_ir[2];
+
+        p_trace->un_sample_rate = header.us_sample_rate;
+        p_trace->n_hr_label = header.s_hr_label;
+        p_trace->n_spo2_label = header.s_spo2_label;
+        p_trace->pch_kind = b_packed ? "packed" : "binary";
+
+        while (p_trace->ir.size() < header.un_samples)
+        {
+            if (b_packed) {
+                if (1 != fread(auch_bytes, PPG_TRACE_PACKED_BYTES, 1, p_file)) {
+                    break;
+                }
+                ppg_trace_unpack_pair(auch_bytes, aun_red, aun_ir);
+                for (int i = 0; i < 2 && p_trace->ir.size() < header.un_samples; i++) {
+                    p_trace->red.push_back(aun_red[i]);
+                    p_trace->ir.push_back(aun_ir[i]);
+                }
+            }
+            else {
+                if (1 != fread(auch_bytes, PPG_TRACE_SAMPLE_BYTES, 1, p_file)) {
+                    break;
+                }
+                maxim_max30102_unpack(auch_bytes, &aun_red[0], &aun_ir[0]);
+                p_trace->red.push_back(aun_red[0]);
+                p_trace->ir.push_back(aun_ir[0]);
+            }
+        }
+    }
+    else
+    {
+        char ach_line[80];
+        unsigned long ul_red, ul_ir;
+
+        p_trace->pch_kind = "text";
+        rewind(p_file);
+        while (NULL != fgets(ach_line, sizeof(ach_line), p_file))
+        {
+            if ('#' != ach_line[0] && 2 == sscanf(ach_line, "%lu , %lu", &ul_red, &ul_ir)) {
+                p_trace->red.push_back((uint32_t) ul_red);
+                p_trace->ir.push_back((uint32_t) ul_ir);
+            }
+        }
+    }
+    fclose(p_file);
+    return true;
+}
+
+/*----------------------------------------------------------------------------
+Function    :  save_spool ()
+Inputs      :  const char *pch_path - file to write
+			   p_trace              - samples, rate and labels
+Processing  :  This function writes the trace in the packed format of the
+			   'hrspool' files, two samples in PPG_TRACE_PACKED_BYTES bytes
+Outputs     :  None
+Returns     :  true if the file was written
+Notes       :  An odd last sample is paired with a copy of itself, the header
+			   count tells the reader to stop before it
+----------------------------------------------------------------------------*/
+static bool save_spool(const char *pch_path, const trace_t *p_trace)
+{
+    FILE *p_file = fopen(pch_path, "wb");
+    ppg_trace_header_t header;
+    uint8_t auch_bytes[PPG_TRACE_PACKED_BYTES];
+    uint32_t aun_red[2], aun_ir[2];
+    bool b_ok;
+
+    if (NULL == p_file) {
+        return false;
+    }
+    memset(&header, 0, sizeof(header));
+    header.un_magic = PPG_TRACE_MAGIC;
+    header.us_version = PPG_TRACE_VERSION_PACKED;
+    header.us_sample_rate = p_trace->un_sample_rate;
+    header.us_sample_bytes = PPG_TRACE_PACKED_BYTES;
+    header.s_hr_label = p_trace->n_hr_label;
+    header.s_spo2_label = p_trace->n_spo2_label;
+    header.un_samples = p_trace->ir.size();
+    b_ok = (1 == fwrite(&header, sizeof(header), 1, p_file));
+
+    for (uint32_t n = 0; b_ok && n < header.un_samples; n += 2)
+    {
+        const uint32_t un_next = (n + 1 < header.un_samples) ? n + 1 : n;
+        aun_red[0] = p_trace->red[n];
+        aun_ir[0] = p_trace->ir[n];
+        aun_red[1] = p_trace->red[un_next];
+        aun_ir[1] = p_trace->ir[un_next];
+        ppg_trace_pack_pair(aun_red, aun_ir, auch_bytes);
+        b_ok = (1 == fwrite(auch_bytes, sizeof(auch_bytes), 1, p_file));
+    }
+    return (0 == fclose(p_file)) && b_ok;
+}
+
+/*----------------------------------------------------------------------------
+Function    :  resample_to_fs ()
+Inputs      :  p_in - trace at any rate
+Processing  :  This function converts the trace to FS.  Faster traces are
+			   averaged over the rate / FS samples of each output sample, as
+			   the sensor's FIFO averaging does; slower ones are linearly
+			   interpolated between the two samples around each output time.
+Outputs     :  *p_out - the same trace at FS
+Returns     :  None
+Notes       :  Output sample j covers the time j / FS, so sample n at FS ends
+			   at the same time as sample (n + 1) * rate / FS - 1 of the input
+----------------------------------------------------------------------------*/
+static void resample_to_fs(const trace_t *p_in, trace_t *p_out)
+{
+    const uint32_t un_rate = p_in->un_sample_rate;
+    const uint32_t un_in = p_in->ir.size();
+    const uint32_t un_out = (uint32_t) ((uint64_t) un_in * FS / un_rate);
+
+    p_out->un_sample_rate = FS;
+    p_out->n_hr_label = p_in->n_hr_label;
+    p_out->n_spo2_label = p_in->n_spo2_label;
+    p_out->pch_kind = p_in->pch_kind;
+    p_out->red.clear();
+    p_out->ir.clear();
+    p_out->red.reserve(un_out);
+    p_out->ir.reserve(un_out);
+
+    for (uint32_t j = 0; j < un_out; j++)
+    {
+        uint64_t ul_red = 0, ul_ir = 0;
+        if (un_rate >= FS) {
+            const uint32_t un_first = (uint32_t) ((uint64_t) j * un_rate / FS);
+            const uint32_t un_last = (uint32_t) ((uint64_t) (j + 1) * un_rate / FS);
+            for (uint32_t k = un_first; k < un_last; k++) {
+                ul_red += p_in->red[k];
+                ul_ir += p_in->ir[k];
+            }
+            ul_red /= (un_last - un_first);
+            ul_ir /= (un_last - un_first);
+        }
+        else {
+            const uint64_t ul_pos = (uint64_t) j * un_rate;
+            const uint32_t k = (uint32_t) (ul_pos / FS), un_frac = (uint32_t) (ul_pos % FS);
+            const uint32_t un_next = (k + 1 < un_in) ? k + 1 : k;
+            ul_red = ((uint64_t) p_in->red[k] * (FS - un_frac) + (uint64_t) p_in->red[un_next] * un_frac) / FS;
+            ul_ir = ((uint64_t) p_in->ir[k] * (FS - un_frac) + (uint64_t) p_in->ir[un_next] * un_frac) / FS;
+        }
+        p_out->red.push_back((uint32_t) ul_red);
+        p_out->ir.push_back((uint32_t) ul_ir);
+    }
+}
+
+/*----------------------------------------------------------------------------
+Function    :  synth_gauss ()
+Inputs      :  *pun_state - random generator state
+Processing  :  This function draws a normal random number (Box-Muller on a
+			   xorshift generator, so every host gives the same trace)
+Outputs     :  *pun_state - next state
+Returns     :  Random number, mean 0 and standard deviation 1
+Notes       :  None
+----------------------------------------------------------------------------*/
+static double synth_gauss(uint32_t *pun_state)
+{
+    double af_u[2];
+    for (int i = 0; i < 2; i++) {
+        *pun_state ^= *pun_state << 13;
+        *pun_state ^= *pun_state >> 17;
+        *pun_state ^= *pun_state << 5;
+        af_u[i] = (*pun_state + 1.0) / 4294967297.0;
+    }
+    return sqrt(-2.0 * log(af_u[0])) * cos(2.0 * M_PI * af_u[1]);
+}
+
+/*----------------------------------------------------------------------------
+Function    :  synth_trace ()
+Inputs      :  un_seconds  - trace length
+			   n_hr        - mean heart rate (bpm)
+			   n_spo2      - SpO2 (%) that sets the red / IR ratio
+			   f_noise     - white noise, in % of the pulse amplitude
+			   un_seed     - random seed
+			   un_rate     - samples per second
+Processing  :  This function makes a PPG waveform : a fast systolic rise,
+			   a slower fall and a small dicrotic wave every beat, on a drifting
+			   baseline.  The red
+			   amplitude follows the SpO2 = -45.06*R^2 + 30.354*R + 94.845 fit
+			   used by the Maxim lookup table.
+Outputs     :  *p_trace - samples and labels
+Returns     :  None
+Notes       :  None
+----------------------------------------------------------------------------*/
+static void synth_trace(uint32_t un_seconds, int32_t n_hr, int32_t n_spo2, double f_noise, uint32_t un_seed,
+                        uint32_t un_rate, trace_t *p_trace)
+{
+    const double f_ir_dc = 100000.0, f_red_dc = 80000.0, f_ir_ac = 1200.0;
+    const double f_disc = 30.354 * 30.354 - 4.0 * 45.06 * (n_spo2 - 94.845);
+    const double f_ratio = (f_disc > 0.0) ? (30.354 + sqrt(f_disc)) / (2.0 * 45.06) : 30.354 / (2.0 * 45.06);
+    const double f_red_ac = f_ratio * f_ir_ac * f_red_dc / f_ir_dc;
+    uint32_t un_state = un_seed ? un_seed : 1;
+    double f_period = 60.0 / n_hr, f_phase = 0.0;
+
+    p_trace->un_sample_rate = un_rate;
+    p_trace->n_hr_label = n_hr;
+    p_trace->n_spo2_label = n_spo2;
+    p_trace->pch_kind = "synthetic";
+
+    for (uint32_t n = 0; n < un_seconds * un_rate; n++)
+    {
+        const double f_t = (double) n / un_rate;
+        const double f_a = (f_phase - 0.15) / ((f_phase < 0.15) ? 0.06 : 0.2), f_b = (f_phase - 0.5) / 0.1;
+        const double f_pulse = exp(-f_a * f_a) + 0.1 * exp(-f_b * f_b);
+        const double f_wander = 1.0 + 0.005 * sin(2.0 * M_PI * 0.25 * f_t);
+
+        // More blood absorbs more light, so the readings dip with every beat
+        const double f_ir = f_ir_dc * f_wander - f_ir_ac * (f_pulse + f_noise / 100.0 * synth_gauss(&un_state));
+        const double f_red = f_red_dc * f_wander - f_red_ac * (f_pulse + f_noise / 100.0 * synth_gauss(&un_state));
+        p_trace->ir.push_back((uint32_t) f_ir & 0x03FFFF);
+        p_trace->red.push_back((uint32_t) f_red & 0x03FFFF);
+
+        f_phase += 1.0 / (f_period * un_rate);
+        if (f_phase >= 1.0) {
+            f_phase -= 1.0;
+            f_period = (60.0 / n_hr) * (1.0 + 0.03 * synth_gauss(&un_state));
+        }
+    }
+}
+
+/*----------------------------------------------------------------------------
+Function    :  run_path ()
+Inputs      :  pf_path - function to run
+			   p_arg   - its argument
+Processing  :  This function runs pf_path on a new thread whose stack is first
+			   painted with REPLAY_STACK_PAINT, and counts the allocations
+			   made meanwhile
+Outputs     :  *p_stats - un_allocs and un_stack_bytes
+Returns     :  true if the thread ran
+Notes       :  The stack grows down, so the deepest write is the first word
+			   from the bottom that lost the paint.  The thread start code and
+			   its data at the top of the stack are counted too.
+----------------------------------------------------------------------------*/
+static bool run_path(void *(*pf_path)(void *), void *p_arg, path_stats_t *p_stats)
+{
+    const uint32_t un_words = REPLAY_STACK_BYTES / sizeof(uint32_t);
+    void *p_stack = NULL;
+    pthread_attr_t attr;
+    pthread_t thread;
+    uint32_t i;
+
+    if (0 != posix_memalign(&p_stack, 4096, REPLAY_STACK_BYTES)) {
+        return false;
+    }
+    uint32_t *pun_stack = (uint32_t *) p_stack;
+    for (i = 0; i < un_words; i++) {
+        pun_stack[i] = REPLAY_STACK_PAINT;
+    }
+
+    const uint32_t un_allocs = un_alloc_count;
+    bool b_ok = (0 == pthread_attr_init(&attr) &&
+                 0 == pthread_attr_setstack(&attr, p_stack, REPLAY_STACK_BYTES) &&
+                 0 == pthread_create(&thread, &attr, pf_path, p_arg) &&
+                 0 == pthread_join(thread, NULL));
+    pthread_attr_destroy(&attr);
+    p_stats->un_allocs = un_alloc_count - un_allocs;
+
+    for (i = 0; i < un_words && REPLAY_STACK_PAINT == pun_stack[i]; i++) {
+    }
+    p_stats->un_stack_bytes = (un_words - i) * sizeof(uint32_t);
+    free(p_stack);
+    return b_ok;
+}
+
+/*----------------------------------------------------------------------------
+Function    :  idle_path ()
+Inputs      :  void *p_arg - not used
+Processing  :  This function does nothing, run_path() of it gives the stack
+			   used by the thread itself
+Outputs     :  None
+Returns     :  NULL
+Notes       :  None
+----------------------------------------------------------------------------*/
+static void* idle_path(void *p_arg)
+{
+    (void) p_arg;
+    return NULL;
+}
+
+/*----------------------------------------------------------------------------
+Function    :  stream_path ()
+Inputs      :  void *p_arg - replay_t
+Processing  :  This function adds every sample of the trace to the engine and
+			   computes an output whenever one is due, the schedule of the
+			   heart rate task and of 'spoolrun'
+Outputs     :  p_stream - outputs, ul_ns - time in addSample() and compute()
+Returns     :  NULL
+Notes       :  p_stream must have room for every output, so that it does not
+			   allocate while the path runs
+----------------------------------------------------------------------------*/
+static void* stream_path(void *p_arg)
+{
+    replay_t *p_replay = (replay_t *) p_arg;
+    const trace_t *p_trace = p_replay->p_trace;
+    window_t window;
+
+    for (uint32_t n = 0; n < p_trace->ir.size(); n++)
+    {
+        const uint64_t ul_start = now_ns();
+        const bool b_due = p_replay->p_engine->addSample(p_trace->red[n], p_trace->ir[n]);
+        if (b_due) {
+            p_replay->p_engine->compute(&window.n_spo2, &window.ch_spo2_valid, &window.n_hr, &window.ch_hr_valid);
+        }
+        p_replay->ul_ns += now_ns() - ul_start;
+        if (b_due) {
+            window.un_sample = n;
+            p_replay->p_stream->push_back(window);
+        }
+    }
+    return NULL;
+}
+
+/*----------------------------------------------------------------------------
+Function    :  batch_path ()
+Inputs      :  void *p_arg - replay_t
+Processing  :  This function runs maxim_heart_rate_and_oxygen_saturation() on
+			   the BUFFER_SIZE samples at FS that end at each stream output
+Outputs     :  p_batch - outputs, ul_ns - time in the algorithm
+Returns     :  NULL
+Notes       :  The window copy is not timed, the heart rate task fills its
+			   buffers as the samples come
+----------------------------------------------------------------------------*/
+static void* batch_path(void *p_arg)
+{
+    replay_t *p_replay = (replay_t *) p_arg;
+    const trace_t *p_trace = p_replay->p_trace_fs;
+    const uint32_t un_rate = p_replay->p_trace->un_sample_rate;
+    window_t window;
+
+    for (uint32_t w = 0; w < p_replay->p_stream->size(); w++)
+    {
+        const uint32_t un_sample = (*p_replay->p_stream)[w].un_sample;
+        const uint32_t un_end = (uint32_t) ((uint64_t) (un_sample + 1) * FS / un_rate);
+        if (un_end < BUFFER_SIZE || un_end > p_trace->ir.size()) {
+            continue;
+        }
+        memcpy(aun_ir_buffer, &p_trace->ir[un_end - BUFFER_SIZE], sizeof(aun_ir_buffer));
+        memcpy(aun_red_buffer, &p_trace->red[un_end - BUFFER_SIZE], sizeof(aun_red_buffer));
+
+        const uint64_t ul_start = now_ns();
+        maxim_heart_rate_and_oxygen_saturation(aun_ir_buffer, BUFFER_SIZE, aun_red_buffer,
+                                               &window.n_spo2, &window.ch_spo2_valid, &window.n_hr, &window.ch_hr_valid);
+        p_replay->ul_ns += now_ns() - ul_start;
+        window.un_sample = un_sample;
+        p_replay->p_batch->push_back(window);
+    }
+    return NULL;
+}
+
+/*----------------------------------------------------------------------------
+Function    :  add_result ()
+Inputs      :  n_spo2, ch_spo2_valid, n_hr, ch_hr_valid - one output
+			   n_hr_label, n_spo2_label                 - reference readings
+Processing  :  This function counts a valid output and its error
+Outputs     :  *p_stats - updated counts
+Returns     :  None
+Notes       :  None
+----------------------------------------------------------------------------*/
+static void add_result(int32_t n_spo2, int8_t ch_spo2_valid, int32_t n_hr, int8_t ch_hr_valid,
+                       int32_t n_hr_label, int32_t n_spo2_label, path_stats_t *p_stats)
+{
+    if (ch_hr_valid) {
+        p_stats->un_hr_valid++;
+        if (PPG_TRACE_NO_LABEL != n_hr_label) {
+            p_stats->ul_hr_error += abs(n_hr - n_hr_label);
+        }
+    }
+    if (ch_spo2_valid) {
+        p_stats->un_spo2_valid++;
+        if (PPG_TRACE_NO_LABEL != n_spo2_label) {
+            p_stats->ul_spo2_error += abs(n_spo2 - n_spo2_label);
+        }
+    }
+}
+
+/*----------------------------------------------------------------------------
+Function    :  print_path ()
+Inputs      :  p_out     - where to print
+			   pch_name  - path name
+			   p_stats   - counts of the path
+			   un_calls  - number of outputs
+			   p_trace   - labels
+Processing  :  This function prints the valid counts and mean errors of a path
+Outputs     :  None
+Returns     :  None
+Notes       :  None
+----------------------------------------------------------------------------*/
+static void print_path(FILE *p_out, const char *pch_name, const path_stats_t *p_stats, uint32_t un_calls,
+                       const trace_t *p_trace)
+{
+    fprintf(p_out, "%-7s : HR %u/%u valid", pch_name, p_stats->un_hr_valid, un_calls);
+    if (p_stats->un_hr_valid && PPG_TRACE_NO_LABEL != p_trace->n_hr_label) {
+        fprintf(p_out, " (mean error %.2f bpm)", (double) p_stats->ul_hr_error / p_stats->un_hr_valid);
+    }
+    fprintf(p_out, ", SpO2 %u/%u valid", p_stats->un_spo2_valid, un_calls);
+    if (p_stats->un_spo2_valid && PPG_TRACE_NO_LABEL != p_trace->n_spo2_label) {
+        fprintf(p_out, " (mean error %.2f %%)", (double) p_stats->ul_spo2_error / p_stats->un_spo2_valid);
+    }
+    fprintf(p_out, "\n");
+}
+
+int main(int argc, char **argv)
+{
+    trace_t trace, trace_fs;
+    const char *pch_spool = NULL;
+    bool b_series = false;
+    int n_arg = 1;
+
+    trace.un_sample_rate = FS;
+    trace.n_hr_label = PPG_TRACE_NO_LABEL;
+    trace.n_spo2_label = PPG_TRACE_NO_LABEL;
+    trace.pch_kind = "";
+
+    for (; n_arg < argc; n_arg++) {
+        if (0 == strcmp(argv[n_arg], "--series")) {
+            b_series = true;
+        }
+        else if (0 == strcmp(argv[n_arg], "--spool") && n_arg + 1 < argc) {
+            pch_spool = argv[++n_arg];
+        }
+        else {
+            break;
+        }
+    }
+    argc -= n_arg - 1;
+    argv += n_arg - 1;
+
+    if (argc >= 5 && 0 == strcmp(argv[1], "--synth")) {
+        synth_trace(atoi(argv[2]), atoi(argv[3]), atoi(argv[4]), (argc >= 6) ? atof(argv[5]) : 2.0,
+                    (argc >= 7) ? atoi(argv[6]) : 1, (argc >= 8) ? atoi(argv[7]) : FS, &trace);
+    }
+    else if (argc >= 2 && '-' != argv[1][0]) {
+        if (!load_trace(argv[1], &trace)) {
+            fprintf(stderr, "Failed to open: %s\n", argv[1]);
+            return 1;
+        }
+        if (argc >= 3) {
+            trace.n_hr_label = atoi(argv[2]);
+        }
+        if (argc >= 4) {
+            trace.n_spo2_label = atoi(argv[3]);
+        }
+    }
+    else {
+        fprintf(stderr, "Usage: ppg_replay [--series] [--spool <file>] <trace> [reference HR] [reference SpO2]\n"
+                        "       ppg_replay [--series] [--spool <file>] --synth <seconds> <HR> <SpO2> [noise %%] [seed] [sps]\n");
+        return 1;
+    }
+
+    replay_t replay;
+    replay.p_engine = ppg_engine_create(trace.un_sample_rate);
+    if (NULL == replay.p_engine) {
+        fprintf(stderr, "No engine for %u sps\n", trace.un_sample_rate);
+        return 1;
+    }
+    if (NULL != pch_spool && !save_spool(pch_spool, &trace)) {
+        fprintf(stderr, "Unable to write '%s'\n", pch_spool);
+        return 1;
+    }
+    resample_to_fs(&trace, &trace_fs);
+
+    // Same schedule as the heart rate task and 'spoolrun' : first result once
+    // a window of samples is in, then one every second
+    const uint32_t un_samples = trace.ir.size();
+    const uint32_t un_rate = trace.un_sample_rate;
+    std::vector<window_t> stream_out, batch_out;
+    path_stats_t batch, stream, idle;
+    uint32_t un_calls = 0, un_hr_diff = 0, un_hr_far = 0, un_spo2_diff = 0;
+    FILE *p_report = b_series ? stderr : stdout;
+
+    memset(&batch, 0, sizeof(batch));
+    memset(&stream, 0, sizeof(stream));
+    memset(&idle, 0, sizeof(idle));
+    stream_out.reserve(un_samples / un_rate + 1);
+    batch_out.reserve(un_samples / un_rate + 1);
+    replay.p_trace = &trace;
+    replay.p_trace_fs = &trace_fs;
+    replay.p_stream = &stream_out;
+    replay.p_batch = &batch_out;
+    replay.p_engine->setOutputInterval(un_rate);
+
+    replay.ul_ns = 0;
+    const bool b_ok = run_path(idle_path, NULL, &idle) &&
+                      run_path(stream_path, &replay, &stream) &&
+                      (stream.ul_ns = replay.ul_ns, replay.ul_ns = 0, run_path(batch_path, &replay, &batch));
+    batch.ul_ns = replay.ul_ns;
+    delete replay.p_engine;
+    if (!b_ok) {
+        fprintf(stderr, "Unable to start the replay threads\n");
+        return 1;
+    }
+
+    if (b_series) {
+        printf("sample,hr,hr_valid,spo2,spo2_valid,batch_hr,batch_hr_valid,batch_spo2,batch_spo2_valid\n");
+    }
+    for (uint32_t w = 0, b = 0; w < stream_out.size() && b < batch_out.size(); w++)
+    {
+        const window_t &s_out = stream_out[w];
+        if (s_out.un_sample != batch_out[b].un_sample) {
+            continue;
+        }
+        const window_t &b_out = batch_out[b++];
+        un_calls++;
+
+        add_result(b_out.n_spo2, b_out.ch_spo2_valid, b_out.n_hr, b_out.ch_hr_valid,
+                   trace.n_hr_label, trace.n_spo2_label, &batch);
+        add_result(s_out.n_spo2, s_out.ch_spo2_valid, s_out.n_hr, s_out.ch_hr_valid,
+                   trace.n_hr_label, trace.n_spo2_label, &stream);
+        if (b_series) {
+            printf("%u,%i,%i,%i,%i,%i,%i,%i,%i\n", s_out.un_sample + 1, s_out.n_hr, s_out.ch_hr_valid,
+                   s_out.n_spo2, s_out.ch_spo2_valid, b_out.n_hr, b_out.ch_hr_valid, b_out.n_spo2, b_out.ch_spo2_valid);
+        }
+
+        // Invalid outputs hold -999, so a validity change always counts
+        if (b_out.n_hr != s_out.n_hr) {
+            un_hr_diff++;
+            if (b_out.ch_hr_valid != s_out.ch_hr_valid || abs(b_out.n_hr - s_out.n_hr) > 1) {
+                un_hr_far++;
+            }
+        }
+        if (b_out.n_spo2 != s_out.n_spo2) {
+            un_spo2_diff++;
+        }
+    }
+
+    fprintf(p_report, "Trace   : %u samples (%s) at %u sps, %u outputs", un_samples, trace.pch_kind, un_rate, un_calls);
+    if (FS != un_rate) {
+        fprintf(p_report, ", %s to %u sps for the batch path", (un_rate > FS) ? "averaged" : "interpolated", FS);
+    }
+    fprintf(p_report, "\n");
+    if (0 == un_calls) {
+        return 0;
+    }
+    fprintf(p_report, "Time    : batch %llu ns/call, stream %llu ns/call (%llu ns/sample)\n",
+            (unsigned long long) (batch.ul_ns / un_calls), (unsigned long long) (stream.ul_ns / un_calls),
+            (unsigned long long) (stream.ul_ns / un_samples));
+    fprintf(p_report, "Speed   : batch %llu windows/sec, stream %llu windows/sec (%llux real time)\n",
+            (unsigned long long) (un_calls * 1000000000ULL / (batch.ul_ns + 1)),
+            (unsigned long long) (un_calls * 1000000000ULL / (stream.ul_ns + 1)),
+            (unsigned long long) ((uint64_t) un_samples * 1000000000ULL / un_rate / (stream.ul_ns + 1)));
+    fprintf(p_report, "Memory  : batch %u allocations, %u bytes of stack; stream %u allocations, %u bytes of stack\n",
+            batch.un_allocs, batch.un_stack_bytes - idle.un_stack_bytes,
+            stream.un_allocs, stream.un_stack_bytes - idle.un_stack_bytes);
+    print_path(p_report, "Batch", &batch, un_calls, &trace);
+    print_path(p_report, "Stream", &stream, un_calls, &trace);
+    fprintf(p_report, "Differ  : HR in %u/%u outputs (%u by more than 1 bpm or validity), SpO2 in %u/%u\n",
+            un_hr_diff, un_calls, un_hr_far, un_spo2_diff, un_calls);
+    return 0;
+}
@@ -0,0 +1,245 @@
+/*****************************************************************************
+$Work file     : step_replay.cpp $
+Description    : Host tool that replays an accelerometer trace through the step
+				 detector and a sorted-window reference, and checks the steps
+Project(s)     : Smart Health Gear
+Compiler       : GCC (PC)
+OS			   : Linux (host)
+Original Author: $ agent
+$Author        : $ agent
+$Date          : $ 17 Oct 2026
+$Revision      : 1.0 $
+
+Usage :
+	step_replay <trace> [expected steps]
+	step_replay --synth <trace to write> <seconds> [seed]
+
+The trace is a file written by 'accrec' : X, Y, Z int16_t records (1 g is
+1024) at STEP_SAMPLE_RATE_HZ, with no header.  'stepplay' replays the same
+files on the board.  The exit status is 1 when the two detectors disagree or
+the steps are not the expected count.
+
+--synth writes a wrist trace in that format : standing still, then walking
+with one arm swing per second (jittered period and amplitude, sensor noise),
+then still again.  traces/walk_60s.acc was made with '--synth 60 1'.
+*****************************************************************************/
+
+/****************************************************************************/
+/*                       INCLUDE FILES                                      */
+/****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <vector>
+#include <algorithm>
+#include "step_detect.hpp"
+
+/****************************************************************************/
+/*                        Type Definitions                                  */
+/****************************************************************************/
+/// Reference step detection : sort the last window of every axis at every tick,
+/// as the step counter did before StepDetector ('stepplay' does the same)
+typedef struct {
+    int16_t  an_ring[3][STEP_WINDOW_SAMPLES];
+    int16_t  an_mid[3][3];
+    uint32_t un_count;
+    uint32_t un_ticks;
+    uint32_t un_steps;
+} sorted_detector_t;
+
+/****************************************************************************/
+/*                       Function definitions                               */
+/****************************************************************************/
+/*----------------------------------------------------------------------------
+Function    :  now_ns ()
+Inputs      :  None
+Processing  :  This function reads the monotonic clock
+Outputs     :  None
+Returns     :  Time in nanoseconds
+Notes       :  None
+----------------------------------------------------------------------------*/
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/*----------------------------------------------------------------------------
+Function    :  sorted_add ()
+Inputs      :  pn_xyz - X, Y and Z acceleration
+Processing  :  This function adds a sample to the reference detector and, at
+			   every tick, sorts each window for its mid-range and checks X
+			   for a peak or a valley
+Outputs     :  *p_ref - windows, mid-ranges and counts
+Returns     :  true at the end of a tick
+Notes       :  None
+----------------------------------------------------------------------------*/
+static bool sorted_add(sorted_detector_t *p_ref, const int16_t *pn_xyz)
+{
+    int16_t an_sorted[STEP_WINDOW_SAMPLES];
+
+    for (int a = 0; a < 3; a++) {
+        p_ref->an_ring[a][p_ref->un_count % STEP_WINDOW_SAMPLES] = pn_xyz[a];
+    }
+    p_ref->un_count++;
+    if (p_ref->un_count < STEP_WINDOW_SAMPLES || 0 != (p_ref->un_count - STEP_WINDOW_SAMPLES) % STEP_TICK_SAMPLES) {
+        return false;
+    }
+    p_ref->un_ticks++;
+
+    for (int a = 0; a < 3; a++) {
+        memcpy(an_sorted, p_ref->an_ring[a], sizeof(an_sorted));
+        std::sort(an_sorted, an_sorted + STEP_WINDOW_SAMPLES);
+        p_ref->an_mid[2][a] = p_ref->an_mid[1][a];
+        p_ref->an_mid[1][a] = p_ref->an_mid[0][a];
+        p_ref->an_mid[0][a] = (an_sorted[0] + an_sorted[STEP_WINDOW_SAMPLES - 1]) / 2;
+    }
+
+    const int16_t n_th = p_ref->an_mid[0][0], n_prev = p_ref->an_mid[1][0], n_old = p_ref->an_mid[2][0];
+    if (p_ref->un_ticks >= 3 &&
+        ((n_old + STEP_FORWARD_LEVEL < n_prev && n_th + STEP_FORWARD_LEVEL < n_prev) ||
+         (n_old > n_prev + STEP_BACK_LEVEL && n_th > n_prev + STEP_BACK_LEVEL))) {
+        p_ref->un_steps++;
+    }
+    return true;
+}
+
+/*----------------------------------------------------------------------------
+Function    :  synth_walk ()
+Inputs      :  pch_path   - trace file to write
+			   un_seconds - trace length
+			   un_seed    - random seed
+Processing  :  This function writes a wrist trace in the 'accrec' format : a
+			   still first and last sixth, and arm swings in between, mostly
+			   on X, with gravity on Y and Z and 6 counts of sensor noise
+Outputs     :  None
+Returns     :  Number of arm swings, or -1 if the file was not written
+Notes       :  None
+----------------------------------------------------------------------------*/
+static int synth_walk(const char *pch_path, uint32_t un_seconds, uint32_t un_seed)
+{
+    FILE *p_file = fopen(pch_path, "wb");
+    const uint32_t un_total = un_seconds * STEP_SAMPLE_RATE_HZ;
+    const uint32_t un_walk_start = un_total / 6, un_walk_end = un_total - un_total / 6;
+    uint32_t un_state = un_seed ? un_seed : 1;
+    double f_phase = 0.0, f_period = 1.0, f_amplitude = 250.0;
+    int n_swings = 0;
+    bool b_ok = (NULL != p_file);
+
+    for (uint32_t n = 0; b_ok && n < un_total; n++)
+    {
+        double af_noise[3];
+        for (int a = 0; a < 3; a++) {
+            // sum of 4 uniform draws, about normal with a standard deviation of 6
+            af_noise[a] = 0.0;
+            for (int k = 0; k < 4; k++) {
+                un_state = un_state * 1103515245 + 12345;
+                af_noise[a] += ((un_state >> 16) % 1000) / 1000.0 - 0.5;
+            }
+            af_noise[a] *= 6.0 / 0.577;
+        }
+
+        double f_swing = 0.0;
+        if (n >= un_walk_start && n < un_walk_end) {
+            f_swing = f_amplitude * sin(2.0 * M_PI * f_phase);
+            f_phase += 1.0 / (f_period * STEP_SAMPLE_RATE_HZ);
+            if (f_phase >= 1.0) {
+                f_phase -= 1.0;
+                n_swings++;
+                un_state = un_state * 1103515245 + 12345;
+                f_period = 1.0 + ((int) ((un_state >> 16) % 101) - 50) / 1000.0;
+                f_amplitude = 250.0 + ((int) ((un_state >> 8) % 51) - 25);
+            }
+        }
+
+        const int16_t an_xyz[3] = {
+            (int16_t) lround(40.0 + f_swing + af_noise[0]),
+            (int16_t) lround(200.0 + 0.2 * f_swing + af_noise[1]),
+            (int16_t) lround(1000.0 - 0.1 * fabs(f_swing) + af_noise[2]),
+        };
+        b_ok = (1 == fwrite(an_xyz, sizeof(an_xyz), 1, p_file));
+    }
+    if (NULL != p_file && 0 != fclose(p_file)) {
+        b_ok = false;
+    }
+    return b_ok ? n_swings : -1;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc >= 4 && 0 == strcmp(argv[1], "--synth")) {
+        const int n_swings = synth_walk(argv[2], atoi(argv[3]), (argc >= 5) ? atoi(argv[4]) : 1);
+        if (n_swings < 0) {
+            fprintf(stderr, "Unable to write '%s'\n", argv[2]);
+            return 1;
+        }
+        printf("%s : %s sec, %i arm swings\n", argv[2], argv[3], n_swings);
+        return 0;
+    }
+    if (argc < 2 || '-' == argv[1][0]) {
+        fprintf(stderr, "Usage: step_replay <trace recorded by accrec> [expected steps]\n"
+                        "       step_replay --synth <trace to write> <seconds> [seed]\n");
+        return 1;
+    }
+
+    FILE *p_file = fopen(argv[1], "rb");
+    std::vector<int16_t> trace;
+    int16_t an_xyz[3];
+    if (NULL == p_file) {
+        fprintf(stderr, "Failed to open: %s\n", argv[1]);
+        return 1;
+    }
+    while (1 == fread(an_xyz, sizeof(an_xyz), 1, p_file)) {
+        trace.insert(trace.end(), an_xyz, an_xyz + 3);
+    }
+    fclose(p_file);
+
+    const uint32_t un_samples = trace.size() / 3;
+    StepDetector detector;
+    sorted_detector_t ref;
+    forBack_Count step;
+    uint32_t un_mismatch = 0;
+    memset(&ref, 0, sizeof(ref));
+
+    // Timed separately, then run side by side to compare every tick
+    uint64_t ul_start = now_ns();
+    for (uint32_t n = 0; n < un_samples; n++) {
+        detector.addSample(&trace[3 * n], step);
+    }
+    const uint64_t ul_sliding_ns = now_ns() - ul_start;
+
+    ul_start = now_ns();
+    for (uint32_t n = 0; n < un_samples; n++) {
+        sorted_add(&ref, &trace[3 * n]);
+    }
+    const uint64_t ul_sorted_ns = now_ns() - ul_start;
+
+    detector.reset();
+    memset(&ref, 0, sizeof(ref));
+    for (uint32_t n = 0; n < un_samples; n++) {
+        const bool b_tick = detector.addSample(&trace[3 * n], step);
+        if (b_tick != sorted_add(&ref, &trace[3 * n]) ||
+            (b_tick && (ref.an_mid[0][0] != detector.getMidRange(0) || ref.an_mid[0][1] != detector.getMidRange(1) ||
+                        ref.an_mid[0][2] != detector.getMidRange(2)))) {
+            un_mismatch++;
+        }
+    }
+
+    printf("Trace   : %u samples (%u sec), %u ticks\n", un_samples, un_samples / STEP_SAMPLE_RATE_HZ, detector.getTicks());
+    printf("Steps   : sliding min/max %u, sorted window %u, %u ticks differ\n", detector.getSteps(), ref.un_steps,
+           un_mismatch);
+    if (un_samples) {
+        printf("Time    : sliding %llu ns/sample, sorted %llu ns/sample\n",
+               (unsigned long long) (ul_sliding_ns / un_samples), (unsigned long long) (ul_sorted_ns / un_samples));
+    }
+
+    bool b_ok = (detector.getSteps() == ref.un_steps && 0 == un_mismatch);
+    if (argc >= 3 && (uint32_t) atoi(argv[2]) != detector.getSteps()) {
+        printf("Expected %s steps\n", argv[2]);
+        b_ok = false;
+    }
+    return b_ok ? 0 : 1;
+}
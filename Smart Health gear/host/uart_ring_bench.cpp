@@ -0,0 +1,346 @@
+/*****************************************************************************
+$Work file     : uart_ring_bench.cpp $
+Description    : Host benchmark of the UART buffers : ByteRing one char and one
+				 FIFO (16 chars) at a time against a locked queue of chars
+Project(s)     : Smart Health Gear
+Compiler       : GCC (PC)
+OS			   : Linux (host)
+Original Author: $ agent
+$Author        : $ agent
+$Date          : $ 17 Oct 2026
+$Revision      : 1.0 $
+
+Usage :
+	uart_ring_bench [bytes]
+
+ByteRing (L3_Utils/byte_ring.hpp) is used as is.  The queue stands in for
+the FreeRTOS queue of the old UART driver : one item of one char copied per
+call under a lock, as xQueueSendFromISR() and xQueueReceive() do in their
+critical sections.
+
+Two runs :
+  loop     the loop of 'uartbench' : 16 chars in, 16 chars out, one thread
+  threads  an "ISR" thread writes and a "task" thread reads, both on one CPU
+           like the board (ByteRing only needs a compiler barrier there)
+
+The ns per byte are scaled to the CPU share at the byte rate of 115200 and
+921600 bps (10 bits per char).  They are host numbers, 'uartbench' gives the
+ones of the board.  Every byte read is checked.  The exit status is 1 when a
+byte is wrong or the ring x16 is not faster than the queue in the loop.
+*****************************************************************************/
+
+/****************************************************************************/
+/*                       INCLUDE FILES                                      */
+/****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sched.h>
+#include <pthread.h>
+#include "byte_ring.hpp"
+
+/****************************************************************************/
+/*                        MACRO Definitions                                 */
+/****************************************************************************/
+// One UART FIFO, and the depth of the rings and the queue
+#define SPAN                    (16)
+#define KINDS                   (3)
+
+/****************************************************************************/
+/*                       Class declarations                                 */
+/****************************************************************************/
+/**
+ * Queue of one byte items : every send and receive takes the lock and copies
+ * one item, the receiver can block until an item arrives.
+ */
+class CharQueue
+{
+    public:
+        CharQueue() : mHead(0), mTail(0), mCount(0)
+        {
+            pthread_mutex_init(&mLock, NULL);
+            pthread_cond_init(&mNotEmpty, NULL);
+        }
+        ~CharQueue()
+        {
+            pthread_cond_destroy(&mNotEmpty);
+            pthread_mutex_destroy(&mLock);
+        }
+
+        /// @returns false if the queue is full
+        bool send(const void *pItem)
+        {
+            pthread_mutex_lock(&mLock);
+            const bool b_room = (mCount < SPAN);
+            if (b_room) {
+                memcpy(&mItems[mHead], pItem, sizeof(mItems[0]));
+                mHead = (mHead + 1) % SPAN;
+                mCount++;
+                pthread_cond_signal(&mNotEmpty);
+            }
+            pthread_mutex_unlock(&mLock);
+            return b_room;
+        }
+
+        /// @returns false if the queue is empty and b_wait is false
+        bool receive(void *pItem, bool b_wait)
+        {
+            pthread_mutex_lock(&mLock);
+            while (b_wait && 0 == mCount) {
+                pthread_cond_wait(&mNotEmpty, &mLock);
+            }
+            const bool b_item = (0 != mCount);
+            if (b_item) {
+                memcpy(pItem, &mItems[mTail], sizeof(mItems[0]));
+                mTail = (mTail + 1) % SPAN;
+                mCount--;
+            }
+            pthread_mutex_unlock(&mLock);
+            return b_item;
+        }
+
+    private:
+        pthread_mutex_t mLock;
+        pthread_cond_t  mNotEmpty;
+        uint8_t  mItems[SPAN];
+        uint32_t mHead;
+        uint32_t mTail;
+        uint32_t mCount;
+};
+
+/****************************************************************************/
+/*                        Type Definitions                                  */
+/****************************************************************************/
+// One side of the threads run
+typedef struct {
+	int        n_kind;          // 0 queue, 1 ring, 2 ring x16
+	uint32_t   un_total;
+	CharQueue *p_queue;
+	ByteRing  *p_ring;
+	uint32_t   un_wrong;        // reader : bytes out of sequence
+} side_t;
+
+/****************************************************************************/
+/*                       Function definitions                               */
+/****************************************************************************/
+/*----------------------------------------------------------------------------
+Function    :  now_ns ()
+Inputs      :  None
+Processing  :  This function reads the monotonic clock
+Outputs     :  None
+Returns     :  Time in nanoseconds
+Notes       :  None
+----------------------------------------------------------------------------*/
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/*----------------------------------------------------------------------------
+Function    :  run_loop ()
+Inputs      :  n_kind   - 0 queue, 1 ring, 2 ring x16
+			   un_total - bytes to move
+Processing  :  This function moves the bytes in and out SPAN at a time on one
+			   thread, as 'uartbench' does with the scheduler suspended
+Outputs     :  pun_wrong - bytes read out of sequence
+Returns     :  Time in nanoseconds
+Notes       :  None
+----------------------------------------------------------------------------*/
+static uint64_t run_loop(int n_kind, uint32_t un_total, uint32_t *pun_wrong)
+{
+    CharQueue queue;
+    ByteRing ring;
+    uint8_t auch_in[SPAN], auch_out[SPAN];
+    uint8_t uch_next = 0;
+
+    ring.init(SPAN);
+    *pun_wrong = 0;
+    const uint64_t ul_start = now_ns();
+    for (uint32_t i = 0; i < un_total; i += SPAN) {
+        for (uint32_t k = 0; k < SPAN; k++) {
+            auch_in[k] = (uint8_t) (i + k);
+        }
+        if (0 == n_kind) {
+            for (uint32_t k = 0; k < SPAN; k++) {
+                queue.send(&auch_in[k]);
+            }
+            for (uint32_t k = 0; k < SPAN; k++) {
+                queue.receive(&auch_out[k], false);
+            }
+        }
+        else if (1 == n_kind) {
+            for (uint32_t k = 0; k < SPAN; k++) {
+                ring.put(auch_in[k]);
+            }
+            for (uint32_t k = 0; k < SPAN; k++) {
+                ring.get(&auch_out[k]);
+            }
+        }
+        else {
+            ring.write(auch_in, SPAN);
+            ring.read(auch_out, SPAN);
+        }
+        for (uint32_t k = 0; k < SPAN; k++) {
+            *pun_wrong += (auch_out[k] != uch_next++);
+        }
+    }
+    return now_ns() - ul_start;
+}
+
+/*----------------------------------------------------------------------------
+Function    :  pin_to_cpu0 ()
+Inputs      :  None
+Processing  :  This function keeps the calling thread on the first CPU
+Outputs     :  None
+Returns     :  None
+Notes       :  The board has one core : the ISR and the task never run at once
+----------------------------------------------------------------------------*/
+static void pin_to_cpu0(void)
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(0, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+/*----------------------------------------------------------------------------
+Function    :  isr_side ()
+Inputs      :  p - side_t of the run
+Processing  :  This function writes the bytes, it yields when the ring or the
+			   queue is full as the UART would hold them in its FIFO
+Outputs     :  None
+Returns     :  NULL
+Notes       :  Thread
+----------------------------------------------------------------------------*/
+static void *isr_side(void *p)
+{
+    side_t *p_side = (side_t *) p;
+    uint8_t auch_in[SPAN];
+
+    pin_to_cpu0();
+    for (uint32_t i = 0; i < p_side->un_total; i += SPAN) {
+        for (uint32_t k = 0; k < SPAN; k++) {
+            auch_in[k] = (uint8_t) (i + k);
+        }
+        for (uint32_t k = 0; k < SPAN; ) {
+            uint32_t n;
+            if (0 == p_side->n_kind) {
+                n = p_side->p_queue->send(&auch_in[k]) ? 1 : 0;
+            }
+            else if (1 == p_side->n_kind) {
+                n = p_side->p_ring->put(auch_in[k]) ? 1 : 0;
+            }
+            else {
+                n = p_side->p_ring->write(&auch_in[k], SPAN - k);
+            }
+            k += n;
+            if (0 == n) {
+                sched_yield();
+            }
+        }
+    }
+    return NULL;
+}
+
+/*----------------------------------------------------------------------------
+Function    :  task_side ()
+Inputs      :  p - side_t of the run
+Processing  :  This function reads the bytes and checks their sequence.  The
+			   queue reader blocks, the ring reader yields when it is empty.
+Outputs     :  un_wrong of the side
+Returns     :  NULL
+Notes       :  Thread
+----------------------------------------------------------------------------*/
+static void *task_side(void *p)
+{
+    side_t *p_side = (side_t *) p;
+    uint8_t auch_out[SPAN];
+    uint8_t uch_next = 0;
+
+    pin_to_cpu0();
+    for (uint32_t i = 0; i < p_side->un_total; ) {
+        uint32_t n;
+        if (0 == p_side->n_kind) {
+            n = p_side->p_queue->receive(auch_out, true) ? 1 : 0;
+        }
+        else if (1 == p_side->n_kind) {
+            n = p_side->p_ring->get(auch_out) ? 1 : 0;
+        }
+        else {
+            n = p_side->p_ring->read(auch_out, SPAN);
+        }
+        for (uint32_t k = 0; k < n; k++) {
+            p_side->un_wrong += (auch_out[k] != uch_next++);
+        }
+        i += n;
+        if (0 == n) {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+/*----------------------------------------------------------------------------
+Function    :  run_threads ()
+Inputs      :  n_kind   - 0 queue, 1 ring, 2 ring x16
+			   un_total - bytes to move
+Processing  :  This function moves the bytes from the ISR thread to the task
+			   thread
+Outputs     :  pun_wrong - bytes read out of sequence
+Returns     :  Time in nanoseconds
+Notes       :  None
+----------------------------------------------------------------------------*/
+static uint64_t run_threads(int n_kind, uint32_t un_total, uint32_t *pun_wrong)
+{
+    CharQueue queue;
+    ByteRing ring;
+    side_t side = { n_kind, un_total, &queue, &ring, 0 };
+    pthread_t isr, task;
+
+    ring.init(SPAN);
+    const uint64_t ul_start = now_ns();
+    pthread_create(&task, NULL, task_side, &side);
+    pthread_create(&isr, NULL, isr_side, &side);
+    pthread_join(isr, NULL);
+    pthread_join(task, NULL);
+    *pun_wrong = side.un_wrong;
+    return now_ns() - ul_start;
+}
+
+int main(int argc, char *argv[])
+{
+    const uint32_t un_total = ((argc > 1) ? (uint32_t) atoi(argv[1]) : 1u << 20) / SPAN * SPAN;
+    const char *apch_kind[KINDS] = { "queue", "ring", "ring x16" };
+    const char *apch_run[2] = { "loop", "threads" };
+    uint64_t aul_ns[2][KINDS];
+    int n_status = 0;
+
+    if (0 == un_total) {
+        fprintf(stderr, "usage: uart_ring_bench [bytes]\n");
+        return 2;
+    }
+    printf("%u bytes in and out, CPU time at the line rate:\n", un_total);
+    for (int r = 0; r < 2; r++) {
+        for (int k = 0; k < KINDS; k++) {
+            uint32_t un_wrong = 0;
+            aul_ns[r][k] = (0 == r) ? run_loop(k, un_total, &un_wrong) : run_threads(k, un_total, &un_wrong);
+
+            // 10 bits per char on the line, so bps / 10 bytes every second
+            const double f_ns_byte = (double) aul_ns[r][k] / un_total;
+            printf("%-7s %-8s : %7.1f ns/byte, %6.3f%% @ 115200, %6.3f%% @ 921600, %.1fx the queue\n",
+                   apch_run[r], apch_kind[k], f_ns_byte, f_ns_byte * 11520 * 1e-7, f_ns_byte * 92160 * 1e-7,
+                   (double) aul_ns[r][0] / aul_ns[r][k]);
+            if (0 != un_wrong) {
+                printf("%s %s : %u bytes out of sequence\n", apch_run[r], apch_kind[k], un_wrong);
+                n_status = 1;
+            }
+        }
+    }
+    if (aul_ns[0][2] >= aul_ns[0][0]) {
+        n_status = 1;
+    }
+    return n_status;
+}
@@ -0,0 +1,301 @@
+/*****************************************************************************
+$Work file     : vitals_link_bench.cpp $
+Description    : Host benchmark of the Bluetooth vitals link : the ASCII frames
+				 against the binary frames sent through a pseudo terminal and
+				 decoded on the other side
+Project(s)     : Smart Health Gear
+Compiler       : GCC (PC)
+OS			   : Linux (host)
+Original Author: $ agent
+$Author        : $ agent
+$Date          : $ 17 Oct 2026
+$Revision      : 1.0 $
+
+Usage :
+	vitals_link_bench [seconds]
+
+The vitals are those of 'btlink bench' : heart rate and HRV every second,
+SpO2 every 5 sec, temperature every 30 sec and steps at 2 Hz, one tick every
+100 msec like the display task.  The ASCII pass counts the old frames.  The
+binary passes (no batch, 1 sec batches) write the frames of VitalsEncoder to
+the master side of a raw pty; a thread reads the slave side, as the phone
+reads the HC-05, and checks every decoded record against the vitals of its
+tick.
+
+The bytes/sec and the share of 9600 baud are those of the simulated
+seconds.  The latency is the batch wait plus the frame on the air at 960
+bytes/sec; the pty latency is the host time from the write of a frame to
+its decode.  The exit status is 1 when a record is wrong or missing, or when
+the binary link is not smaller than the ASCII one.
+*****************************************************************************/
+
+/****************************************************************************/
+/*                       INCLUDE FILES                                      */
+/****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+#include <pthread.h>
+#include <time.h>
+#include <vector>
+#include "vitals_link.hpp"
+
+/****************************************************************************/
+/*                        MACRO Definitions                                 */
+/****************************************************************************/
+// Display task tick
+#define TICK_MS                 (100)
+// HC-05 at 9600 baud, 10 bits per byte
+#define LINK_BYTES_PER_SEC      (960)
+
+/****************************************************************************/
+/*                        Type Definitions                                  */
+/****************************************************************************/
+// Reader side of a pass
+typedef struct {
+	int                          n_fd;
+	const std::vector<vitals_t> *p_expected;      // vitals of every tick
+	std::vector<uint64_t>        sent_ns;         // write time of every frame
+	uint32_t                     un_frames;
+	uint32_t                     un_records;
+	uint32_t                     un_wrong;
+	uint64_t                     ul_latency_ns;
+	uint64_t                     ul_max_latency_ns;
+	VitalsDecoder                dec;
+	pthread_mutex_t              lock;
+} reader_t;
+
+/****************************************************************************/
+/*                       Function definitions                               */
+/****************************************************************************/
+/*----------------------------------------------------------------------------
+Function    :  now_ns ()
+Inputs      :  None
+Processing  :  This function reads the monotonic clock
+Outputs     :  None
+Returns     :  Time in nanoseconds
+Notes       :  None
+----------------------------------------------------------------------------*/
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/*----------------------------------------------------------------------------
+Function    :  simulate ()
+Inputs      :  v  - vitals of the tick before
+			   t  - tick
+Processing  :  This function updates the vitals as 'btlink bench' does
+Outputs     :  v  - vitals of the tick
+Returns     :  None
+Notes       :  None
+----------------------------------------------------------------------------*/
+static void simulate(vitals_t &v, uint32_t t)
+{
+    v.an_value[VLINK_STEPS] += (t % 5) ? 0 : 1;
+    if (0 == t % 10) {
+        v.an_value[VLINK_HEART_RATE] = 70 + (t / 10) % 7;
+        v.an_value[VLINK_RMSSD_X10] = 400 + (t / 10) % 31;
+        v.an_value[VLINK_SDNN_X10] = 500 + (t / 10) % 17;
+    }
+    v.an_value[VLINK_OXYGEN] = 96 + (t / 50) % 3;
+    v.an_value[VLINK_BODY_TEMP] = 36 + (t / 300) % 2;
+}
+
+/*----------------------------------------------------------------------------
+Function    :  open_pty ()
+Inputs      :  None
+Processing  :  This function opens a pseudo terminal, the slave side in raw
+			   mode so that every byte goes through unchanged
+Outputs     :  pn_master, pn_slave - file descriptors
+Returns     :  true upon success
+Notes       :  None
+----------------------------------------------------------------------------*/
+static bool open_pty(int *pn_master, int *pn_slave)
+{
+    struct termios tio;
+    *pn_master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (*pn_master < 0 || 0 != grantpt(*pn_master) || 0 != unlockpt(*pn_master)) {
+        return false;
+    }
+    *pn_slave = open(ptsname(*pn_master), O_RDWR | O_NOCTTY);
+    if (*pn_slave < 0 || 0 != tcgetattr(*pn_slave, &tio)) {
+        return false;
+    }
+    cfmakeraw(&tio);
+    return 0 == tcsetattr(*pn_slave, TCSANOW, &tio);
+}
+
+/*----------------------------------------------------------------------------
+Function    :  read_link ()
+Inputs      :  p - reader_t of the pass
+Processing  :  This function decodes the bytes of the slave side until it is
+			   closed, and checks the records against the vitals of their tick
+Outputs     :  Counters of the reader
+Returns     :  NULL
+Notes       :  Thread
+----------------------------------------------------------------------------*/
+static void *read_link(void *p)
+{
+    reader_t *p_reader = (reader_t *) p;
+    uint8_t auch_buf[256];
+    vlink_record_t rec;
+    ssize_t n;
+
+    while ((n = read(p_reader->n_fd, auch_buf, sizeof(auch_buf))) > 0) {
+        for (ssize_t i = 0; i < n; i++) {
+            if (!p_reader->dec.feed(auch_buf[i])) {
+                continue;
+            }
+            pthread_mutex_lock(&p_reader->lock);
+            const uint64_t ul_ns = now_ns() - p_reader->sent_ns[p_reader->un_frames];
+            p_reader->un_frames++;
+            pthread_mutex_unlock(&p_reader->lock);
+            p_reader->ul_latency_ns += ul_ns;
+            if (ul_ns > p_reader->ul_max_latency_ns) {
+                p_reader->ul_max_latency_ns = ul_ns;
+            }
+            while (p_reader->dec.nextRecord(rec)) {
+                const uint32_t t = rec.un_time_ms / TICK_MS;
+                p_reader->un_records++;
+                if (t >= p_reader->p_expected->size() ||
+                    0 != memcmp(&rec.vitals, &(*p_reader->p_expected)[t], sizeof(vitals_t))) {
+                    p_reader->un_wrong++;
+                }
+            }
+        }
+    }
+    return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+    const int n_secs = (argc > 1) ? atoi(argv[1]) : 600;
+    const uint32_t un_ticks = (uint32_t) n_secs * (1000 / TICK_MS);
+    const uint32_t aun_batch_ms[] = { 0, 1000 };
+    std::vector<vitals_t> expected(un_ticks);
+    uint32_t un_ascii_bytes = 0;
+    uint8_t auch_frame[2 * VLINK_MAX_FRAME];
+    char ach_ascii[48];
+    int n_status = 0;
+
+    if (n_secs < 1) {
+        fprintf(stderr, "usage: vitals_link_bench [seconds]\n");
+        return 2;
+    }
+
+    // The old loop sent the ASCII frame every tick and the HRV one every second
+    vitals_t v = { { 72, 97, 36, 0, 420, 510, 90 } };
+    uint64_t ul_start = now_ns();
+    for (uint32_t t = 0; t < un_ticks; t++) {
+        simulate(v, t);
+        expected[t] = v;
+        un_ascii_bytes += snprintf(ach_ascii, sizeof(ach_ascii), "#%3d+%3d+%3d+%4d+~", (int) v.an_value[0],
+                                   (int) v.an_value[1], (int) v.an_value[2], (int) v.an_value[3]);
+        if (0 == t % 10) {
+            un_ascii_bytes += snprintf(ach_ascii, sizeof(ach_ascii), "%%%5u+%5u+%4u+%u+~", (unsigned) v.an_value[5],
+                                       (unsigned) v.an_value[4], (unsigned) v.an_value[6], 1u);
+        }
+    }
+    printf("ASCII every 100 ms : %6u bytes/sec, %3u%% of 9600 baud, %4.0f ns per tick\n",
+           un_ascii_bytes / n_secs, un_ascii_bytes / n_secs * 100 / LINK_BYTES_PER_SEC,
+           (double) (now_ns() - ul_start) / un_ticks);
+
+    for (uint32_t b = 0; b < sizeof(aun_batch_ms) / sizeof(aun_batch_ms[0]); b++)
+    {
+        int n_master, n_slave;
+        if (!open_pty(&n_master, &n_slave)) {
+            perror("pty");
+            return 2;
+        }
+
+        VitalsEncoder enc;
+        enc.setBatchMs(aun_batch_ms[b]);
+        reader_t reader;
+        reader.n_fd = n_slave;
+        reader.p_expected = &expected;
+        reader.sent_ns.reserve(un_ticks + 1);
+        reader.un_frames = reader.un_records = reader.un_wrong = 0;
+        reader.ul_latency_ns = reader.ul_max_latency_ns = 0;
+        pthread_mutex_init(&reader.lock, NULL);
+        pthread_t thread;
+        pthread_create(&thread, NULL, read_link, &reader);
+
+        uint64_t ul_code_ns = 0;
+        for (uint32_t t = 0; t <= un_ticks; t++) {
+            const uint32_t un_ms = t * TICK_MS;
+            ul_start = now_ns();
+            uint32_t un_len = 0, un_first = 0;
+            if (t < un_ticks) {
+                un_first = enc.addVitals(expected[t], un_ms, auch_frame);
+                un_len = un_first;
+                if (enc.flushDue(un_ms)) {
+                    un_len += enc.flush(un_ms, auch_frame + un_len);
+                }
+            }
+            else {
+                // The rest of the batch
+                un_len = enc.flush(un_ms, auch_frame);
+            }
+            ul_code_ns += now_ns() - ul_start;
+
+            // One write time per frame, the reader takes them in order
+            pthread_mutex_lock(&reader.lock);
+            const uint64_t ul_now = now_ns();
+            if (0 != un_first) {
+                reader.sent_ns.push_back(ul_now);
+            }
+            if (un_len != un_first) {
+                reader.sent_ns.push_back(ul_now);
+            }
+            pthread_mutex_unlock(&reader.lock);
+            for (uint32_t n = 0; n < un_len; ) {
+                const ssize_t w = write(n_master, auch_frame + n, un_len - n);
+                if (w <= 0) {
+                    perror("write");
+                    return 2;
+                }
+                n += w;
+            }
+        }
+
+        // Wait for the reader to take every frame, then hang up
+        for (int i = 0; i < 1000; i++) {
+            pthread_mutex_lock(&reader.lock);
+            const bool b_done = (reader.un_frames >= enc.getFrames());
+            pthread_mutex_unlock(&reader.lock);
+            if (b_done) {
+                break;
+            }
+            usleep(1000);
+        }
+        close(n_master);
+        pthread_join(thread, NULL);
+        close(n_slave);
+
+        const uint32_t un_frame_ms = enc.getFrames() ? (enc.getBytes() * 1000 / LINK_BYTES_PER_SEC / enc.getFrames()) : 0;
+        printf("Binary, batch %4u : %6u bytes/sec, %3u%% of 9600 baud, %4.0f ns per tick, "
+               "%u records in %u frames, latency %u ms, pty latency %.0f us avg %.0f us max\n",
+               enc.getBatchMs(), enc.getBytes() / n_secs, enc.getBytes() / n_secs * 100 / LINK_BYTES_PER_SEC,
+               (double) ul_code_ns / un_ticks, enc.getRecords(), enc.getFrames(),
+               enc.getAvgBatchWaitMs() + un_frame_ms,
+               reader.un_frames ? 1e-3 * reader.ul_latency_ns / reader.un_frames : 0.0,
+               1e-3 * reader.ul_max_latency_ns);
+
+        if (reader.un_frames != enc.getFrames() || reader.un_records != enc.getRecords() ||
+            0 != reader.un_wrong || 0 != reader.dec.getCrcErrors() || 0 != reader.dec.getLostFrames() ||
+            enc.getBytes() * 4 > un_ascii_bytes) {
+            printf("Decoded %u/%u frames, %u/%u records, %u wrong, %u CRC errors, %u lost\n",
+                   reader.un_frames, enc.getFrames(), reader.un_records, enc.getRecords(), reader.un_wrong,
+                   reader.dec.getCrcErrors(), reader.dec.getLostFrames());
+            n_status = 1;
+        }
+        pthread_mutex_destroy(&reader.lock);
+    }
+    return n_status;
+}
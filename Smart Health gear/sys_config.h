@@ -56,6 +56,7 @@ extern "C" {
 #define SYS_CFG_SPI1_CLK_MHZ            24          ///< Max speed of SPI1 for SD Card and Flash memory
 #define SYS_CFG_SPI0_CLK_MHZ            8           ///< Nordic wireless requires 1-8Mhz max
 #define SYS_CFG_I2C2_CLK_KHZ            100         ///< 100Khz is standard I2C speed
+#define SYS_CFG_I2C_FAST_CLK_KHZ        400         ///< Rate of the fast-mode devices, see I2C_Base::setDeviceSpeed()
 
 /// If defined, a boot message is logged to this file
 //#define SYS_CFG_LOG_BOOT_INFO_FILENAME        "boot.csv"
@@ -135,6 +136,14 @@ unsigned int sys_get_cpu_clock();
 #define SYS_CFG_UART0_TXQ_SIZE      256   ///< UART0 transmit queue size before blocking starts to occur
 /** @} */
 
+/**
+ * @{ UART data by GPDMA instead of the FIFO interrupts, for rates of 1Mbps and more.
+ * The GPDMA has 5 channels for the UARTs, and each UART takes one for Rx and one for Tx.
+ */
+#define SYS_CFG_UART0_DMA           0     ///< If non-zero, the terminal on UART0 uses the GPDMA
+#define SYS_CFG_UART3_DMA           0     ///< If non-zero, the HC-05 vitals link on UART3 uses the GPDMA
+/** @} */
+
 
 
 /**